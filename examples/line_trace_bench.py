@@ -0,0 +1,136 @@
+"""Batch line trace throughput benchmark (TongSIM).
+
+Casts lidar-like ray fans from ORIGIN with ``single_line_trace_by_object`` and
+``multi_line_trace_by_object`` and reports rays per second at several batch sizes.
+Each size runs with the server-side parallel trace path on and off (console
+variable ``tongsim.Trace.ParallelLineTraces``) and with three request formats:
+per-job messages with full actor state, packed distance-only columns, and packed
+columns with the query fields sent once as a shared query group.
+
+Timings are end to end: request building, tracing, response serialization and
+Python-side decoding. The server caps one call at 20000 rays, so larger batches
+are sent as consecutive calls.
+
+Run against a level that uses the default (CPU) Chaos scene:
+    uv run ./examples/line_trace_bench.py
+"""
+
+from __future__ import annotations
+
+import math
+import time
+
+import tongsim as ts
+from tongsim.core.world_context import WorldContext
+from tongsim.type.rl_demo import CollisionObjectType, LineTraceResultDetail
+
+# ====== Config ======
+GRPC_ENDPOINT = "127.0.0.1:5726"
+ORIGIN = ts.Vector3(200, -2000, 150)  # ray origin; place it inside your level
+RANGE = 5000.0  # ray length (UU)
+RAY_COUNTS = (1_000, 10_000, 100_000)
+ROUNDS = 3
+MAX_JOBS_PER_CALL = 20_000  # server hard limit per call
+OBJECT_TYPES = [
+    CollisionObjectType.OBJECT_WORLD_STATIC,
+    CollisionObjectType.OBJECT_WORLD_DYNAMIC,
+    CollisionObjectType.OBJECT_PAWN,
+]
+PACKED = {"result_detail": LineTraceResultDetail.DISTANCE, "packed": True}
+# format name -> (trace options, jobs reference query group 0)
+FORMATS = {
+    "full": ({}, False),
+    "packed": (PACKED, False),
+    "grouped": ({**PACKED, "query_groups": [{"object_types": OBJECT_TYPES}]}, True),
+}
+# =====================
+
+
+def make_jobs(count: int, grouped: bool = False) -> list[dict]:
+    """Spread ``count`` rays over a 360 x 30 degree fan, like a spinning lidar."""
+    rings = 16
+    per_ring = max(1, math.ceil(count / rings))
+    jobs: list[dict] = []
+    for i in range(count):
+        ring, step = divmod(i, per_ring)
+        yaw = 2 * math.pi * step / per_ring
+        pitch = math.radians(-15 + 30 * ring / (rings - 1))
+        direction = ts.Vector3(
+            math.cos(pitch) * math.cos(yaw),
+            math.cos(pitch) * math.sin(yaw),
+            math.sin(pitch),
+        )
+        job = {"start": ORIGIN, "end": ORIGIN + direction * RANGE}
+        if grouped:
+            job["query_group"] = 0
+        else:
+            job["object_types"] = OBJECT_TYPES
+        jobs.append(job)
+    return jobs
+
+
+async def trace_all(
+    context: WorldContext, jobs: list[dict], multi: bool, **options
+) -> int:
+    """Send ``jobs`` in server-sized chunks and return the number of results."""
+    results = 0
+    for begin in range(0, len(jobs), MAX_JOBS_PER_CALL):
+        chunk = jobs[begin : begin + MAX_JOBS_PER_CALL]
+        trace = (
+            ts.UnaryAPI.multi_line_trace_by_object
+            if multi
+            else ts.UnaryAPI.single_line_trace_by_object
+        )
+        out = await trace(context.conn, chunk, timeout=60.0, **options)
+        # packed: one row per job (single) or per hit (multi)
+        results += out["count"] if isinstance(out, dict) else len(out)
+    return results
+
+
+async def run_bench(context: WorldContext) -> None:
+    print(
+        f"{'trace':<7}{'rays':>9}{'mode':>10}{'format':>8}"
+        f"{'best ms':>11}{'rays/s':>13}{'results':>9}"
+    )
+    for multi in (False, True):
+        name = "multi" if multi else "single"
+        for count in RAY_COUNTS:
+            jobs = {grouped: make_jobs(count, grouped) for grouped in (False, True)}
+            for parallel in (True, False):
+                await ts.UnaryAPI.exec_console_command(
+                    context.conn,
+                    f"tongsim.Trace.ParallelLineTraces {int(parallel)}",
+                    write_to_log=False,
+                )
+                mode = "parallel" if parallel else "serial"
+                for fmt, (options, grouped) in FORMATS.items():
+                    fmt_jobs = jobs[grouped]
+                    # warm up
+                    await trace_all(context, fmt_jobs[:100], multi, **options)
+
+                    best = math.inf
+                    results = 0
+                    for _ in range(ROUNDS):
+                        t0 = time.perf_counter()
+                        results = await trace_all(context, fmt_jobs, multi, **options)
+                        best = min(best, time.perf_counter() - t0)
+                    print(
+                        f"{name:<7}{count:>9}{mode:>10}{fmt:>8}{best * 1e3:>11.1f}"
+                        f"{count / best:>13.0f}{results:>9}"
+                    )
+
+    # Leave the default (parallel) path enabled.
+    await ts.UnaryAPI.exec_console_command(
+        context.conn, "tongsim.Trace.ParallelLineTraces 1", write_to_log=False
+    )
+
+
+def main() -> None:
+    print("[INFO] Connecting to TongSim ...")
+    with ts.TongSim(grpc_endpoint=GRPC_ENDPOINT) as ue:
+        ue.context.sync_run(run_bench(ue.context))
+    print("[INFO] Done.")
+
+
+if __name__ == "__main__":
+    main()
@@ -4,12 +4,17 @@ This script demonstrates two common utilities exposed by the TongSIM Python SDK:
 
 1. Running a UE console command via `UnaryAPI.exec_console_command`
 2. Querying a navigation path via `UnaryAPI.query_navigation_path`
+3. Batch reachability checks via `UnaryAPI.batch_query_navigation_path`
 
 Update `START` / `END` to points that are on (or near) a valid NavMesh in your map.
 """
 
 from __future__ import annotations
 
+import math
+import random
+import time
+
 import tongsim as ts
 from tongsim.core.world_context import WorldContext
 
@@ -20,6 +25,10 @@ GRPC_ENDPOINT = "127.0.0.1:5726"
 START = ts.Vector3(200, -2000, 0)
 END = ts.Vector3(1200, -2000, 0)
 
+# Batch reachability: random goals within BATCH_RADIUS of START
+BATCH_SIZE = 2000
+BATCH_RADIUS = 3000.0
+
 
 async def test_exec_console_command(context: WorldContext) -> None:
     print("\n[1] ExecConsoleCommand: 'stat fps'")
@@ -71,9 +80,43 @@ async def test_query_navigation_path(context: WorldContext) -> None:
     print(f"  - strict.path_length: {resp2['path_length']:.3f}")
 
 
+async def test_batch_query_navigation_path(context: WorldContext) -> None:
+    print(f"\n[3] BatchQueryNavigationPath: {BATCH_SIZE} reachability checks")
+    rng = random.Random(0)
+    queries = []
+    for _ in range(BATCH_SIZE):
+        angle = rng.uniform(0.0, 2 * math.pi)
+        radius = BATCH_RADIUS * math.sqrt(rng.random())
+        goal = START + ts.Vector3(math.cos(angle) * radius, math.sin(angle) * radius, 0)
+        queries.append((START, goal))
+
+    t0 = time.perf_counter()
+    reachable = 0
+    results = 0
+    async for r in ts.UnaryAPI.batch_query_navigation_path(
+        context.conn,
+        queries,
+        allow_partial=False,
+        require_navigable_end_location=True,
+        omit_path_points=True,
+    ):
+        results += 1
+        reachable += r["success"]
+    elapsed = time.perf_counter() - t0
+    print(f"  - results: {results}, reachable: {reachable}")
+    print(f"  - elapsed: {elapsed * 1e3:.1f} ms ({results / elapsed:.0f} queries/s)")
+
+    # One full path with a simplified corridor
+    async for r in ts.UnaryAPI.batch_query_navigation_path(
+        context.conn, [(START, END)], simplify_tolerance=50.0
+    ):
+        print(f"  - simplified path: {len(r['points'])} points, success={r['success']}")
+
+
 async def run_all(context: WorldContext) -> None:
     await test_exec_console_command(context)
     await test_query_navigation_path(context)
+    await test_batch_query_navigation_path(context)
 
 
 def main() -> None:
@@ -1,7 +1,8 @@
 from .bidi_stream import BidiStream, BidiStreamReader, BidiStreamWriter
 from .capture_api import CaptureAPI
 from .core import GrpcConnection
-from .unary_api import UnaryAPI
+from .unary_api import StateStringTable, UnaryAPI, apply_state_delta
+from .voxel_codec import decode_voxel_buffer
 
 __all__ = [
     "BidiStream",
@@ -9,5 +10,8 @@ __all__ = [
     "BidiStreamWriter",
     "CaptureAPI",
     "GrpcConnection",
+    "StateStringTable",
     "UnaryAPI",
+    "apply_state_delta",
+    "decode_voxel_buffer",
 ]
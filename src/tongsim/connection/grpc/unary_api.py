@@ -1,5 +1,12 @@
+from collections.abc import AsyncIterator
+
 from tongsim.math import Transform, Vector3
-from tongsim.type.rl_demo import RLDemoHandType, RLDemoOrientationMode
+from tongsim.type.rl_demo import (
+    LineTraceResultDetail,
+    RLDemoHandType,
+    RLDemoOrientationMode,
+)
+from tongsim.type.voxel import VoxelCompression, VoxelEncoding
 from tongsim_lite_protobuf.arena_pb2 import (
     DestroyActorInArenaRequest,
     DestroyArenaRequest,
@@ -26,8 +33,12 @@ from tongsim_lite_protobuf.common_pb2 import Empty
 from tongsim_lite_protobuf.demo_rl_pb2 import (
     ActorState,
     BatchMultiLineTraceByObjectRequest,
+    BatchQueryNavigationPathRequest,
+    BatchQueryNavigationPathResponse,
     BatchSingleLineTraceByObjectRequest,
     DemoRLState,
+    DemoRLStateColumns,
+    DemoRLStateDelta,
     DestroyActorRequest,
     DropObjectRequest,
     DropObjectResponse,
@@ -37,25 +48,40 @@ from tongsim_lite_protobuf.demo_rl_pb2 import (
     GetActorStateResponse,
     GetActorTransformRequest,
     GetActorTransformResponse,
+    LineTraceByObjectJob,
+    LineTraceQueryGroup,
+    LineTraceResultColumns,
     NavigateToLocationRequest,
     NavigateToLocationResponse,
     PickUpObjectRequest,
     PickUpObjectResponse,
     QueryNavigationPathRequest,
     QueryNavigationPathResponse,
+    QueryStateColumnsRequest,
     SetActorTransformRequest,
     SimpleMoveTowardsRequest,
     SimpleMoveTowardsResponse,
     SpawnActorRequest,
     SpawnActorResponse,
+    SubscribeStateRequest,
+    TraceRayPatternRequest,
+    TraceRayPatternResponse,
 )
 from tongsim_lite_protobuf.demo_rl_pb2_grpc import DemoRLServiceStub
 from tongsim_lite_protobuf.object_pb2 import ObjectId
-from tongsim_lite_protobuf.voxel_pb2 import QueryVoxelRequest, Voxel
+from tongsim_lite_protobuf.server_pb2 import GetServerMetricsRequest, ServerMetrics
+from tongsim_lite_protobuf.server_pb2_grpc import ServerServiceStub
+from tongsim_lite_protobuf.voxel_pb2 import (
+    BatchQueryVoxelRequest,
+    BatchVoxel,
+    QueryVoxelRequest,
+    Voxel,
+)
 from tongsim_lite_protobuf.voxel_pb2_grpc import VoxelServiceStub
 
 from .core import GrpcConnection
-from .utils import proto_to_sdk, safe_async_rpc, sdk_to_proto
+from .utils import proto_to_sdk, safe_async_rpc, safe_unary_stream, sdk_to_proto
+from .voxel_codec import decode_voxel_buffer
 
 # --------------------------
 # GUID helpers (UE FGuid LE)
@@ -155,6 +181,99 @@ def _actor_state_to_dict(actor: ActorState) -> dict:
     }
 
 
+def _fill_line_trace_query(out, query: dict) -> None:
+    """Copy ``object_types``, ``trace_complex`` and ``actors_to_ignore`` into ``out``."""
+    for ot in query.get("object_types", []):
+        out.object_types.append(int(ot))
+    if "trace_complex" in query and query["trace_complex"] is not None:
+        out.trace_complex = bool(query["trace_complex"])
+    for ig in query.get("actors_to_ignore", []) or []:
+        out.actors_to_ignore.add().CopyFrom(_to_object_id(ig))
+
+
+def _fill_line_trace_request(
+    req, jobs: list[dict], query_groups: list[dict] | None
+) -> None:
+    """Fill ``jobs`` and ``query_groups`` of a batch line trace request.
+
+    A job with a ``query_group`` index uses that group's query fields instead of
+    its own.
+    """
+    for g in query_groups or []:
+        group: LineTraceQueryGroup = req.query_groups.add()
+        _fill_line_trace_query(group, g)
+    for j in jobs:
+        job: LineTraceByObjectJob = req.jobs.add()
+        job.start.CopyFrom(sdk_to_proto(j["start"]))
+        job.end.CopyFrom(sdk_to_proto(j["end"]))
+        if j.get("query_group") is not None:
+            job.query_group = int(j["query_group"])
+        else:
+            _fill_line_trace_query(job, j)
+
+
+def _line_trace_columns_to_dict(columns: LineTraceResultColumns) -> dict:
+    """Wrap packed line trace columns without copying; absent columns are empty."""
+    ids = columns.actor_ids
+    return {
+        "count": int(columns.count),
+        "distances": memoryview(columns.distances).cast("f"),
+        "impact_points": memoryview(columns.impact_points).cast("f"),
+        "impact_normals": memoryview(columns.impact_normals).cast("f"),
+        "actor_ids": [
+            _fguid_bytes_to_str(ids[i : i + 16]) for i in range(0, len(ids), 16)
+        ],
+        "hit_counts": memoryview(columns.hit_counts).cast("I"),
+    }
+
+
+def apply_state_delta(states: dict[str, dict], delta: dict) -> dict[str, dict]:
+    """
+    Apply one ``subscribe_state`` delta to a client-side actor cache in place.
+
+    Args:
+        states: Actor states keyed by id, as built by previous deltas.
+        delta: A dictionary yielded by ``UnaryAPI.subscribe_state``.
+
+    Returns:
+        dict[str, dict]: The updated ``states`` mapping.
+    """
+    if delta["keyframe"]:
+        states.clear()
+    for actor in delta["spawned"]:
+        states[actor["id"]] = actor
+    for actor in delta["updated"]:
+        states[actor["id"]] = actor
+    for actor_id in delta["destroyed"]:
+        states.pop(actor_id, None)
+    return states
+
+
+class StateStringTable:
+    """
+    Client-side cache of the string table used by ``query_state_columns``.
+
+    Reuse one instance across calls so names and class paths are only sent
+    once; the server then ships just the strings added since the last call.
+    """
+
+    def __init__(self) -> None:
+        self.epoch = 0
+        self.strings: list[str] = []
+
+    def apply(self, resp: DemoRLStateColumns) -> None:
+        """Merge the string increment carried by one response."""
+        if resp.string_table_epoch != self.epoch or resp.string_table_offset > len(self.strings):
+            self.epoch = resp.string_table_epoch
+            self.strings = []
+        del self.strings[resp.string_table_offset :]
+        self.strings.extend(resp.strings)
+
+    def lookup(self, ids) -> list[str]:
+        """Map a column of string indices to their values."""
+        return [self.strings[i] for i in ids]
+
+
 # --------------------------
 # Public gRPC unary wrappers
 # --------------------------
@@ -181,6 +300,47 @@ class UnaryAPI:
             result.append(_actor_state_to_dict(actor))
         return result
 
+    @staticmethod
+    @safe_unary_stream()
+    async def subscribe_state(
+        conn: GrpcConnection,
+        tick_interval: int = 1,
+        keyframe_interval: int = 0,
+        send_empty: bool = False,
+    ) -> AsyncIterator[dict]:
+        """
+        Stream actor state changes instead of polling ``query_info``.
+
+        The first message is a keyframe holding every live actor. Later messages
+        carry only actors spawned, changed or destroyed since the previous one;
+        feed them to ``apply_state_delta`` to keep a full snapshot.
+
+        Args:
+            tick_interval: Push once every N game ticks.
+            keyframe_interval: Send a full keyframe every N messages (0: first only).
+            send_empty: Also emit a message when nothing changed.
+
+        Yields:
+            dict: ``sequence``, ``frame``, ``keyframe``, ``spawned`` and ``updated``
+                (lists of actor dicts) and ``destroyed`` (list of actor ids).
+        """
+        stub = conn.get_stub(DemoRLServiceStub)
+        req = SubscribeStateRequest(
+            tick_interval=tick_interval,
+            keyframe_interval=keyframe_interval,
+            send_empty=send_empty,
+        )
+        delta: DemoRLStateDelta
+        async for delta in stub.SubscribeState(req):
+            yield {
+                "sequence": int(delta.sequence),
+                "frame": int(delta.frame),
+                "keyframe": bool(delta.keyframe),
+                "spawned": [_actor_state_to_dict(a) for a in delta.spawned],
+                "updated": [_actor_state_to_dict(a) for a in delta.updated],
+                "destroyed": [_fguid_bytes_to_str(oid.guid) for oid in delta.destroyed],
+            }
+
     @staticmethod
     @safe_async_rpc(default=False)
     async def reset_level(conn: GrpcConnection, timeout: float = 60.0) -> bool:
@@ -335,6 +495,9 @@ class UnaryAPI:
         box_extent: Vector3,
         actors_to_ignore: list[str] | None = None,
         timeout: float = 5.0,
+        encoding: VoxelEncoding = VoxelEncoding.DENSE,
+        compression: VoxelCompression = VoxelCompression.NONE,
+        use_voxel_map: bool = False,
     ) -> bytes:
         """
         Query voxel occupancy around a transform and return the raw buffer.
@@ -347,9 +510,16 @@ class UnaryAPI:
             box_extent (Vector3): Half-extent of the query box in world units.
             actors_to_ignore (list[str] | None): Optional actor IDs excluded from sampling.
             timeout (float): RPC timeout in seconds.
+            encoding (VoxelEncoding): Wire encoding; ``AUTO`` lets the server pick
+                the smallest one. Sparse scenes transfer far less than ``DENSE``.
+            compression (VoxelCompression): Optional compression of the encoded buffer.
+            use_voxel_map (bool): Serve the query from the world's persistent voxel
+                map, which only revoxelizes what moved since the last query. The box
+                must be axis-aligned and is snapped to the voxel lattice; otherwise
+                the server falls back to a fresh voxelization.
 
         Returns:
-            bytes: Serialized voxel data provided by the service.
+            bytes: Dense voxel buffer; other encodings are decoded back to it.
         """
         if actors_to_ignore is None:
             actors_to_ignore = []
@@ -362,9 +532,132 @@ class UnaryAPI:
             voxel_num_z=voxel_num_z,
             extent=sdk_to_proto(box_extent),
             ActorsToIgnore=[_to_object_id(actor_id) for actor_id in actors_to_ignore],
+            encoding=encoding,
+            compression=compression,
+            use_voxel_map=use_voxel_map,
         )
         resp: Voxel = await stub.QueryVoxel(req, timeout=2.0)
-        return resp.voxel_buffer
+        return decode_voxel_buffer(
+            resp.voxel_buffer,
+            (voxel_num_x, voxel_num_y, voxel_num_z),
+            resp.encoding,
+            resp.compression,
+            resp.raw_size,
+        )
+
+    @staticmethod
+    @safe_async_rpc(default=None)
+    async def batch_query_voxel(
+        conn: GrpcConnection,
+        queries: list[dict],
+        timeout: float = 5.0,
+    ) -> list[bytes]:
+        """
+        Query voxel occupancy for several boxes in a single round trip.
+
+        Collision gathering is shared between the boxes on the server and the
+        boxes are voxelized in parallel, so this is much cheaper than calling
+        ``query_voxel`` once per box.
+
+        Args:
+            queries (list[dict]): One dict per box with the keyword arguments of
+                ``query_voxel``: ``transform``, ``voxel_num_x``, ``voxel_num_y``,
+                ``voxel_num_z``, ``box_extent`` and optional ``actors_to_ignore``,
+                ``encoding``, ``compression`` and ``use_voxel_map``.
+            timeout (float): RPC timeout in seconds.
+
+        Returns:
+            list[bytes]: Dense voxel buffers in the same order as ``queries``, each
+            laid out like the result of ``query_voxel``.
+        """
+        stub = conn.get_stub(VoxelServiceStub)
+        req = BatchQueryVoxelRequest(
+            queries=[
+                QueryVoxelRequest(
+                    transform=sdk_to_proto(q["transform"]),
+                    voxel_num_x=q["voxel_num_x"],
+                    voxel_num_y=q["voxel_num_y"],
+                    voxel_num_z=q["voxel_num_z"],
+                    extent=sdk_to_proto(q["box_extent"]),
+                    ActorsToIgnore=[
+                        _to_object_id(actor_id)
+                        for actor_id in q.get("actors_to_ignore") or []
+                    ],
+                    encoding=q.get("encoding", VoxelEncoding.DENSE),
+                    compression=q.get("compression", VoxelCompression.NONE),
+                    use_voxel_map=q.get("use_voxel_map", False),
+                )
+                for q in queries
+            ]
+        )
+        resp: BatchVoxel = await stub.BatchQueryVoxel(req, timeout=timeout)
+        return [
+            decode_voxel_buffer(
+                buffer,
+                (q["voxel_num_x"], q["voxel_num_y"], q["voxel_num_z"]),
+                resp.encodings[i],
+                resp.compressions[i],
+                resp.raw_sizes[i],
+            )
+            for i, (q, buffer) in enumerate(
+                zip(queries, resp.voxel_buffers, strict=True)
+            )
+        ]
+
+    @staticmethod
+    @safe_async_rpc(default=None)
+    async def query_state_columns(
+        conn: GrpcConnection,
+        class_filter: list[str] | None = None,
+        tag_filter: list[str] | None = None,
+        string_table: StateStringTable | None = None,
+    ) -> dict:
+        """
+        Fetch actor state as packed columns instead of per-actor messages.
+
+        Float columns are little-endian ``memoryview`` objects that can be wrapped
+        without copying, e.g. ``np.asarray(cols["locations"]).reshape(-1, 3)``.
+
+        Args:
+            class_filter (list[str] | None): Keep only actors of these classes or their
+                subclasses (class path or class name).
+            tag_filter (list[str] | None): Keep only actors carrying any of these tags.
+            string_table (StateStringTable | None): Cache reused across calls so only
+                new strings are transferred; a fresh one is used when omitted.
+
+        Returns:
+            dict: ``count``; ``ids`` (list of GUID strings); ``locations`` (3N),
+                ``rotations`` (3N roll/pitch/yaw degrees), ``bounds`` (6N min/max) and
+                ``speeds`` (N) as float32 memoryviews; ``name_ids``, ``class_ids`` and
+                ``tag_ids`` as uint32 memoryviews indexing ``string_table.strings``;
+                ``string_table``.
+        """
+        if string_table is None:
+            string_table = StateStringTable()
+
+        stub = conn.get_stub(DemoRLServiceStub)
+        req = QueryStateColumnsRequest(
+            class_filter=class_filter or [],
+            tag_filter=tag_filter or [],
+            string_table_epoch=string_table.epoch,
+            known_string_count=len(string_table.strings),
+        )
+        resp: DemoRLStateColumns = await stub.QueryStateColumns(req)
+        string_table.apply(resp)
+
+        ids = resp.ids
+        return {
+            "count": int(resp.count),
+            "ids": [_fguid_bytes_to_str(ids[i : i + 16]) for i in range(0, len(ids), 16)],
+            "locations": memoryview(resp.locations).cast("f"),
+            "rotations": memoryview(resp.rotations).cast("f"),
+            "bounds": memoryview(resp.bounds).cast("f"),
+            "speeds": memoryview(resp.speeds).cast("f"),
+            "name_ids": memoryview(resp.name_ids).cast("I"),
+            "class_ids": memoryview(resp.class_ids).cast("I"),
+            "tag_ids": memoryview(resp.tag_ids).cast("I"),
+            "string_table": string_table,
+        }
 
     @staticmethod
     @safe_async_rpc(default=False)
@@ -434,6 +727,70 @@ class UnaryAPI:
             else 0.0,
         }
 
+    @staticmethod
+    @safe_unary_stream()
+    async def batch_query_navigation_path(
+        conn: GrpcConnection,
+        queries: list[tuple[Vector3, Vector3]],
+        allow_partial: bool = True,
+        require_navigable_end_location: bool = False,
+        cost_limit: float | None = None,
+        *,
+        omit_path_points: bool = False,
+        simplify_tolerance: float = 0.0,
+        max_in_flight: int = 0,
+    ) -> AsyncIterator[dict]:
+        """
+        Solve many navigation paths at once; results stream back as they complete.
+
+        Queries run on the navigation worker thread with ``FindPathAsync``. Results
+        arrive in completion order, so match them by ``query_index``. Stopping the
+        iteration cancels the RPC and aborts queries still in flight.
+
+        Args:
+            queries (list[tuple[Vector3, Vector3]]): ``(start, end)`` pairs.
+            allow_partial (bool): Accept partial paths when the goal is unreachable.
+            require_navigable_end_location (bool): Fail queries whose end cannot be
+                projected onto the NavMesh.
+            cost_limit (float | None): Optional maximum path cost.
+            omit_path_points (bool): Only report reachability, cost and length.
+            simplify_tolerance (float): Drop path points closer than this (UU) to the
+                simplified polyline; ``path_length`` is measured before simplifying.
+            max_in_flight (int): Queries submitted to the worker at once (0: default).
+
+        Yields:
+            dict: ``query_index``, ``success``, ``message`` (failure reason),
+                ``points`` (list[Vector3]), ``is_partial``, ``path_cost`` and
+                ``path_length``.
+        """
+        stub = conn.get_stub(DemoRLServiceStub)
+        req = BatchQueryNavigationPathRequest(
+            allow_partial=allow_partial,
+            require_navigable_end_location=require_navigable_end_location,
+            omit_path_points=omit_path_points,
+            simplify_tolerance=simplify_tolerance,
+            max_in_flight=max_in_flight,
+        )
+        if cost_limit is not None and cost_limit > 0:
+            req.cost_limit = float(cost_limit)
+        for start, end in queries:
+            q = req.queries.add()
+            q.start.CopyFrom(sdk_to_proto(start))
+            q.end.CopyFrom(sdk_to_proto(end))
+
+        resp: BatchQueryNavigationPathResponse
+        async for resp in stub.BatchQueryNavigationPath(req):
+            for r in resp.results:
+                yield {
+                    "query_index": int(r.query_index),
+                    "success": bool(r.success),
+                    "message": r.message,
+                    "points": [proto_to_sdk(p) for p in r.path_points],
+                    "is_partial": bool(r.is_partial),
+                    "path_cost": float(r.path_cost),
+                    "path_length": float(r.path_length),
+                }
+
     @staticmethod
     @safe_async_rpc(default=None)
     async def navigate_to_location(
@@ -825,33 +1182,45 @@ class UnaryAPI:
         conn: GrpcConnection,
         jobs: list[dict],
         timeout: float = 5.0,
-    ) -> list[dict]:
+        *,
+        result_detail: LineTraceResultDetail = LineTraceResultDetail.FULL,
+        packed: bool = False,
+        query_groups: list[dict] | None = None,
+    ) -> list[dict] | dict:
         """
         Run batch SingleLineTraceByObject requests and return hit summaries.
 
         Args:
             jobs (list[dict]): Each job describes ``start``/``end`` vectors, collision object types,
-                optional ``trace_complex`` flag and ``actors_to_ignore`` collection.
+                optional ``trace_complex`` flag and ``actors_to_ignore`` collection, or
+                refers to ``query_groups`` by a ``query_group`` index.
             timeout (float): RPC timeout in seconds.
+            result_detail (LineTraceResultDetail): Fields returned per hit; anything
+                but ``FULL`` skips reading actor state on the server.
+            packed (bool): Return one set of columns for the whole batch instead of
+                per-job dicts.
+            query_groups (list[dict] | None): Shared ``object_types``,
+                ``trace_complex`` and ``actors_to_ignore`` resolved once per call; the
+                server also caches resolved ignore lists across calls.
 
         Returns:
             list[dict]: Per-job results including ``job_index``, ``blocking_hit``, ``distance``, ``impact_point``
-                and optional ``actor_state``.
-        """
-        req = BatchSingleLineTraceByObjectRequest()
-        for j in jobs:
-            job = req.jobs.add()
-            job.start.CopyFrom(sdk_to_proto(j["start"]))
-            job.end.CopyFrom(sdk_to_proto(j["end"]))
-            for ot in j.get("object_types", []):
-                job.object_types.append(int(ot))
-            if "trace_complex" in j and j["trace_complex"] is not None:
-                job.trace_complex = bool(j["trace_complex"])
-            for ig in j.get("actors_to_ignore", []) or []:
-                job.actors_to_ignore.add().CopyFrom(_to_object_id(ig))
+                and, depending on ``result_detail``, ``impact_normal``, ``actor_id``
+                or ``actor_state``.
+            dict: When ``packed``: ``count`` and little-endian memoryviews
+                ``distances`` (N, -1 for a miss), ``impact_points`` and
+                ``impact_normals`` (3N, empty unless requested), plus ``actor_ids``
+                (GUID strings, all zero for a miss).
+        """
+        req = BatchSingleLineTraceByObjectRequest(
+            result_detail=int(result_detail), packed=packed
+        )
+        _fill_line_trace_request(req, jobs, query_groups)
 
         stub = conn.get_stub(DemoRLServiceStub)
         resp = await stub.BatchSingleLineTraceByObject(req, timeout=timeout)
+        if packed:
+            return _line_trace_columns_to_dict(resp.columns)
 
         out: list[dict] = []
         for r in resp.results:
@@ -861,6 +1230,10 @@ class UnaryAPI:
                 "distance": float(r.distance),
                 "impact_point": proto_to_sdk(r.impact_point),
             }
+            if r.HasField("impact_normal"):
+                item["impact_normal"] = proto_to_sdk(r.impact_normal)
+            if r.HasField("actor_id"):
+                item["actor_id"] = _fguid_bytes_to_str(r.actor_id.guid)
             if r.HasField("actor_state"):
                 item["actor_state"] = _actor_state_to_dict(r.actor_state)
             out.append(item)
@@ -874,35 +1247,44 @@ class UnaryAPI:
         timeout: float = 5.0,
         *,
         enable_debug_draw: bool = False,
-    ) -> list[dict]:
+        result_detail: LineTraceResultDetail = LineTraceResultDetail.FULL,
+        packed: bool = False,
+        query_groups: list[dict] | None = None,
+    ) -> list[dict] | dict:
         """
         Run batch MultiLineTraceByObject requests and collect ordered hit lists.
 
         Args:
             jobs (list[dict]): Each job describes ``start``/``end`` vectors, collision object types,
-                optional ``trace_complex`` flag and ``actors_to_ignore`` collection.
+                optional ``trace_complex`` flag and ``actors_to_ignore`` collection, or
+                refers to ``query_groups`` by a ``query_group`` index.
             timeout (float): RPC timeout in seconds.
             enable_debug_draw (bool): Whether to render debug lines in UE.
+            result_detail (LineTraceResultDetail): Fields returned per hit; anything
+                but ``FULL`` skips reading actor state on the server.
+            packed (bool): Return one set of columns for all hits instead of per-job
+                dicts.
+            query_groups (list[dict] | None): Shared query fields, see
+                ``single_line_trace_by_object``.
 
         Returns:
             list[dict]: Per-job results with ``job_index`` and ``hits`` entries containing ``distance``,
-                ``impact_point``, ``impact_normal`` and optional ``actor_state``.
-        """
-        req = BatchMultiLineTraceByObjectRequest()
-        req.enable_debug_draw = bool(enable_debug_draw)
-        for j in jobs:
-            job = req.jobs.add()
-            job.start.CopyFrom(sdk_to_proto(j["start"]))
-            job.end.CopyFrom(sdk_to_proto(j["end"]))
-            for ot in j.get("object_types", []):
-                job.object_types.append(int(ot))
-            if "trace_complex" in j and j["trace_complex"] is not None:
-                job.trace_complex = bool(j["trace_complex"])
-            for ig in j.get("actors_to_ignore", []) or []:
-                job.actors_to_ignore.add().CopyFrom(_to_object_id(ig))
+                ``impact_point``, ``impact_normal`` and, depending on ``result_detail``,
+                ``actor_id`` or ``actor_state``.
+            dict: When ``packed``: the columns of ``single_line_trace_by_object`` with
+                one row per hit in job order, plus ``hit_counts`` (uint32 per job).
+        """
+        req = BatchMultiLineTraceByObjectRequest(
+            enable_debug_draw=bool(enable_debug_draw),
+            result_detail=int(result_detail),
+            packed=packed,
+        )
+        _fill_line_trace_request(req, jobs, query_groups)
 
         stub = conn.get_stub(DemoRLServiceStub)
         resp = await stub.BatchMultiLineTraceByObject(req, timeout=timeout)
+        if packed:
+            return _line_trace_columns_to_dict(resp.columns)
 
         out: list[dict] = []
         for r in resp.results:
@@ -913,8 +1295,154 @@ class UnaryAPI:
                     "impact_point": proto_to_sdk(h.impact_point),
                     "impact_normal": proto_to_sdk(h.impact_normal),
                 }
+                if h.HasField("actor_id"):
+                    hit["actor_id"] = _fguid_bytes_to_str(h.actor_id.guid)
                 if hasattr(h, "actor_state") and h.HasField("actor_state"):
                     hit["actor_state"] = _actor_state_to_dict(h.actor_state)
                 item["hits"].append(hit)
             out.append(item)
         return out
+
+    @staticmethod
+    @safe_async_rpc(default=None)
+    async def trace_ray_pattern(
+        conn: GrpcConnection,
+        *,
+        actor_id: bytes | str | dict | None = None,
+        pose: Transform | None = None,
+        sensor_offset: Transform | None = None,
+        horizontal_fov: float = 360.0,
+        vertical_fov: float = 30.0,
+        horizontal_resolution: int = 1024,
+        vertical_resolution: int = 16,
+        max_range: float = 5000.0,
+        query: dict,
+        result_detail: LineTraceResultDetail = LineTraceResultDetail.DISTANCE,
+        range_noise_stddev: float = 0.0,
+        noise_seed: int | None = None,
+        timeout: float = 5.0,
+    ) -> dict | None:
+        """
+        Trace a lidar-like ray pattern generated on the server and return a range image.
+
+        Rays go through the cell centers of a ``vertical_resolution`` x
+        ``horizontal_resolution`` grid spanning the fields of view, in the sensor frame
+        (+X forward, +Z up, positive yaw to the right).
+
+        Args:
+            actor_id (bytes | str | dict | None): Sensor follows this actor, which is
+                excluded from the traces. Exactly one of ``actor_id`` and ``pose``.
+            pose (Transform | None): World sensor pose.
+            sensor_offset (Transform | None): Sensor pose relative to ``actor_id``.
+            horizontal_fov (float): Degrees, (0, 360].
+            vertical_fov (float): Degrees, (0, 180].
+            horizontal_resolution (int): Columns of the range image.
+            vertical_resolution (int): Rows of the range image.
+            max_range (float): Ray length (UU).
+            query (dict): ``object_types`` (at least one), optional ``trace_complex``
+                and ``actors_to_ignore``, as in a line trace query group.
+            result_detail (LineTraceResultDetail): Columns to return; ``FULL`` returns
+                every column but no actor state.
+            range_noise_stddev (float): Gaussian range noise (UU); 0 disables noise.
+            noise_seed (int | None): Fixed seed for reproducible noise; by default the
+                noise changes every frame.
+            timeout (float): RPC timeout in seconds.
+
+        Returns:
+            dict | None: ``rows``, ``cols``, ``sensor_pose`` and the packed columns of
+                ``single_line_trace_by_object`` in row-major order (row 0 is the
+                highest elevation, column 0 the leftmost); a miss has distance -1.
+        """
+        if (actor_id is None) == (pose is None):
+            raise ValueError("Pass exactly one of actor_id and pose.")
+
+        req = TraceRayPatternRequest(
+            horizontal_fov=horizontal_fov,
+            vertical_fov=vertical_fov,
+            horizontal_resolution=horizontal_resolution,
+            vertical_resolution=vertical_resolution,
+            max_range=max_range,
+            result_detail=int(result_detail),
+            range_noise_stddev=range_noise_stddev,
+        )
+        if actor_id is not None:
+            req.actor_id.CopyFrom(_to_object_id(actor_id))
+            if sensor_offset is not None:
+                req.sensor_offset.CopyFrom(sdk_to_proto(sensor_offset))
+        else:
+            req.pose.CopyFrom(sdk_to_proto(pose))
+        if noise_seed is not None:
+            req.noise_seed = int(noise_seed)
+        _fill_line_trace_query(req.query, query)
+
+        stub = conn.get_stub(DemoRLServiceStub)
+        resp: TraceRayPatternResponse = await stub.TraceRayPattern(req, timeout=timeout)
+        out = _line_trace_columns_to_dict(resp.columns)
+        out.update(
+            rows=int(resp.rows),
+            cols=int(resp.cols),
+            sensor_pose=proto_to_sdk(resp.sensor_pose),
+        )
+        return out
+
+    # ------------------------------
+    # Server metrics
+    # ------------------------------
+
+    @staticmethod
+    @safe_async_rpc(default=None)
+    async def get_server_metrics(
+        conn: GrpcConnection,
+        include_idle_routes: bool = False,
+        reset: bool = False,
+        timeout: float = 2.0,
+    ) -> dict | None:
+        """
+        Fetch per-method latency histograms and queue gauges from the server.
+
+        Latencies are in microseconds, split into ``queue_wait``, ``handler``,
+        ``serialize`` and ``write_drain`` phases. Pass ``reset=True`` to clear the
+        histograms after this snapshot.
+        """
+        stub = conn.get_stub(ServerServiceStub)
+        req = GetServerMetricsRequest(
+            include_idle_routes=include_idle_routes, reset=reset
+        )
+        resp: ServerMetrics = await stub.GetServerMetrics(req, timeout=timeout)
+
+        def _latency(s) -> dict:
+            return {
+                "count": int(s.count),
+                "mean_us": float(s.mean_us),
+                "p50_us": int(s.p50_us),
+                "p90_us": int(s.p90_us),
+                "p99_us": int(s.p99_us),
+                "max_us": int(s.max_us),
+            }
+
+        return {
+            "event_queue_depth": int(resp.event_queue_depth),
+            "calls_in_flight": int(resp.calls_in_flight),
+            "write_queue_length": int(resp.write_queue_length),
+            "cq_worker_num": int(resp.cq_worker_num),
+            "lane_pool_thread_num": int(resp.lane_pool_thread_num),
+            "routes": [
+                {
+                    "method": r.method,
+                    "calls": int(r.calls),
+                    "failed_calls": int(r.failed_calls),
+                    "queue_wait": _latency(r.queue_wait),
+                    "handler": _latency(r.handler),
+                    "serialize": _latency(r.serialize),
+                    "write_drain": _latency(r.write_drain),
+                }
+                for r in resp.routes
+            ],
+            "object_pool": {
+                "pooled_allocs": int(resp.object_pool.pooled_allocs),
+                "heap_allocs": int(resp.object_pool.heap_allocs),
+                "frees": int(resp.object_pool.frees),
+                "cached_blocks": int(resp.object_pool.cached_blocks),
+                "cached_bytes": int(resp.object_pool.cached_bytes),
+            },
+        }
@@ -0,0 +1,174 @@
+"""
+Decoders for the compact voxel buffer encodings of ``VoxelService``.
+
+The dense layout is ``X * Y`` columns with x outer, each column holding the Z
+bits LSB-first padded to whole bytes. The other encodings index voxels linearly
+as ``(x * Y + y) * Z + z``; see ``voxel.proto`` for the exact formats.
+"""
+
+import struct
+import zlib
+
+from tongsim.type.voxel import VoxelCompression, VoxelEncoding
+
+__all__ = ["decode_voxel_buffer", "decompress_voxel_buffer"]
+
+_BRICK = 8
+_BRICK_BYTES = _BRICK * _BRICK
+
+
+def decompress_voxel_buffer(
+    buffer: bytes, compression: VoxelCompression, raw_size: int
+) -> bytes:
+    """Undo the compression pass and return the encoded buffer."""
+    compression = VoxelCompression(compression)
+    if compression == VoxelCompression.NONE:
+        return bytes(buffer)
+    if compression == VoxelCompression.ZLIB:
+        return zlib.decompress(buffer)
+    try:
+        import lz4.block
+    except ImportError as e:
+        raise ImportError(
+            "LZ4 voxel buffers need the optional 'lz4' package (pip install lz4)"
+        ) from e
+    return lz4.block.decompress(buffer, uncompressed_size=raw_size)
+
+
+def decode_voxel_buffer(
+    buffer: bytes,
+    voxel_num: tuple[int, int, int],
+    encoding: VoxelEncoding = VoxelEncoding.DENSE,
+    compression: VoxelCompression = VoxelCompression.NONE,
+    raw_size: int = 0,
+) -> bytes:
+    """
+    Decode a voxel buffer returned by the service into the dense layout.
+
+    Args:
+        buffer (bytes): ``voxel_buffer`` as received.
+        voxel_num (tuple[int, int, int]): Voxel counts along X, Y and Z.
+        encoding (VoxelEncoding): Encoding reported by the server.
+        compression (VoxelCompression): Compression reported by the server.
+        raw_size (int): Buffer size before compression, reported by the server.
+
+    Returns:
+        bytes: Dense voxel buffer, identical to a ``DENSE`` query.
+    """
+    x, y, z = voxel_num
+    data = decompress_voxel_buffer(buffer, compression, raw_size)
+    encoding = VoxelEncoding(encoding)
+    z_bytes = (z + 7) // 8
+    dense_size = x * y * z_bytes
+    if encoding == VoxelEncoding.DENSE:
+        if len(data) != dense_size:
+            raise ValueError(
+                f"dense voxel buffer has {len(data)} bytes, expected {dense_size}"
+            )
+        return data
+    if encoding == VoxelEncoding.RLE_Z:
+        return _decode_rle_z(data, x, y, z)
+    if encoding == VoxelEncoding.SPARSE:
+        return _decode_sparse(data, x, y, z)
+    if encoding == VoxelEncoding.BRICK:
+        return _decode_brick(data, x, y, z)
+    raise ValueError(f"cannot decode voxel encoding {encoding.name}")
+
+
+def _fill_bits(bits: bytearray, begin: int, end: int) -> None:
+    """Set bits [begin, end) of a LSB-first bit array."""
+    first, last = begin >> 3, end >> 3
+    if first == last:
+        bits[first] |= ((1 << (end - begin)) - 1) << (begin & 7)
+        return
+    bits[first] |= (0xFF << (begin & 7)) & 0xFF
+    bits[first + 1 : last] = b"\xff" * (last - first - 1)
+    if end & 7:
+        bits[last] |= (1 << (end & 7)) - 1
+
+
+def _linear_to_dense(bits: bytearray, x: int, y: int, z: int) -> bytes:
+    """Repack a linear bit array into columns padded to whole bytes."""
+    if z % 8 == 0:
+        return bytes(bits)
+    z_bytes = (z + 7) // 8
+    mask = (1 << z) - 1
+    dense = bytearray(x * y * z_bytes)
+    for column in range(x * y):
+        begin = column * z
+        if not any(bits[begin >> 3 : ((begin + z) >> 3) + 1]):
+            continue
+        chunk = int.from_bytes(bits[begin >> 3 : ((begin + z) >> 3) + 1], "little")
+        value = (chunk >> (begin & 7)) & mask
+        dense[column * z_bytes : (column + 1) * z_bytes] = value.to_bytes(
+            z_bytes, "little"
+        )
+    return bytes(dense)
+
+
+def _decode_rle_z(data: bytes, x: int, y: int, z: int) -> bytes:
+    count = x * y * z
+    # One spare byte so the column repacking can always read one byte past a column
+    bits = bytearray((count + 7) // 8 + 1)
+    position = 0
+    occupied = False
+    run = shift = 0
+    for byte in data:
+        run |= (byte & 0x7F) << shift
+        if byte & 0x80:
+            shift += 7
+            continue
+        if run > count - position:
+            raise ValueError("RLE voxel buffer overruns the grid")
+        if occupied and run:
+            _fill_bits(bits, position, position + run)
+        position += run
+        occupied = not occupied
+        run = shift = 0
+    if shift:
+        raise ValueError("RLE voxel buffer ends inside a varint")
+    return _linear_to_dense(bits, x, y, z)[: x * y * ((z + 7) // 8)]
+
+
+def _decode_sparse(data: bytes, x: int, y: int, z: int) -> bytes:
+    if len(data) % 4:
+        raise ValueError("sparse voxel buffer size must be a multiple of 4")
+    count = x * y * z
+    z_bytes = (z + 7) // 8
+    dense = bytearray(x * y * z_bytes)
+    for (index,) in struct.iter_unpack("<I", data):
+        if index >= count:
+            raise ValueError("sparse voxel index out of range")
+        column, voxel_z = divmod(index, z)
+        dense[column * z_bytes + (voxel_z >> 3)] |= 1 << (voxel_z & 7)
+    return bytes(dense)
+
+
+def _decode_brick(data: bytes, x: int, y: int, z: int) -> bytes:
+    z_bytes = (z + 7) // 8
+    bricks_x = (x + _BRICK - 1) // _BRICK
+    bricks_y = (y + _BRICK - 1) // _BRICK
+    brick_count = bricks_x * bricks_y * z_bytes
+    mask_bytes = (brick_count + 7) // 8
+    if len(data) < mask_bytes:
+        raise ValueError("brick voxel buffer is shorter than its mask")
+
+    dense = bytearray(x * y * z_bytes)
+    offset = mask_bytes
+    for index in range(brick_count):
+        if not data[index >> 3] & (1 << (index & 7)):
+            continue
+        if offset + _BRICK_BYTES > len(data):
+            raise ValueError("brick voxel buffer is truncated")
+        bx, rest = divmod(index, bricks_y * z_bytes)
+        by, bz = divmod(rest, z_bytes)
+        rows = min(_BRICK, y - by * _BRICK)
+        for lx in range(min(_BRICK, x - bx * _BRICK)):
+            # Byte ly of row lx goes to column (x, by * 8 + ly), Z byte bz
+            start = ((bx * _BRICK + lx) * y + by * _BRICK) * z_bytes + bz
+            row = offset + lx * _BRICK
+            dense[start : start + rows * z_bytes : z_bytes] = data[row : row + rows]
+        offset += _BRICK_BYTES
+    if offset != len(data):
+        raise ValueError("brick voxel buffer has trailing bytes")
+    return bytes(dense)
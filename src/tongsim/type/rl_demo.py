@@ -28,6 +28,19 @@ class CollisionObjectType(IntEnum):
     OBJECT_DESTRUCTIBLE = 5
 
 
+class LineTraceResultDetail(IntEnum):
+    """Fields returned per hit by the batch line traces, values match ``demo_rl.proto``.
+
+    Only ``FULL`` reads the hit actor's state on the server.
+    """
+
+    FULL = 0
+    DISTANCE = 1
+    DISTANCE_NORMAL = 2
+    # Distance, impact point and the hit actor's id.
+    ID_LOCATION = 3
+
+
 class RLDemoHandType(IntEnum):
     """Hand selection for DemoRL manipulation actions."""
 
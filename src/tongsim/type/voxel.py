@@ -0,0 +1,24 @@
+from enum import IntEnum
+
+
+class VoxelEncoding(IntEnum):
+    """Wire encoding of a voxel buffer, values match ``voxel.proto``.
+
+    Every encoding decodes back to the dense layout returned by default.
+    """
+
+    DENSE = 0
+    RLE_Z = 1
+    SPARSE = 2
+    BRICK = 3
+    # Request only: the server picks the smallest encoding for each grid.
+    AUTO = 4
+
+
+class VoxelCompression(IntEnum):
+    """General-purpose compression applied after the encoding."""
+
+    NONE = 0
+    # Needs the optional ``lz4`` package on the client.
+    LZ4 = 1
+    ZLIB = 2
@@ -50,6 +50,7 @@ void FTSCommandLineParams::InitializeCommandLineParams()
 void FTSCommandLineParams::ParseCommandLines()
 {
 	using namespace TongSimCommandLineHelper;
+	bParsed = true;
 
 	// Distribution
 	ParseParam(TEXT("TongSimClient"), bIsTongSimClient);
@@ -79,4 +80,11 @@ void FTSCommandLineParams::ParseCommandLines()
 
 	// TTS and Avatar
 	ParseValue(TEXT("TongOSHttpURL="), TongOS_U_HttpURL, FString("http://10.2.161.4/tongos_u"));
+
+	// gRPC server
+	ParseValue(TEXT("GrpcHost="), GrpcHost, FString());
+	ParseValue(TEXT("GrpcPort="), GrpcPort, -1);
+	ParseValue(TEXT("GrpcUnixSocket="), GrpcUnixSocket, FString());
+	ParseValue(TEXT("GrpcWorkers="), GrpcWorkerNum, -1);
+	ParseValue(TEXT("GrpcMaxMessageMB="), GrpcMaxMessageMB, 0);
 }
@@ -7,7 +7,15 @@
 struct TONGSIMGAMEPLAY_API FTSCommandLineParams
 {
 public:
-	static const FTSCommandLineParams& Get() { return CommandLineParams;}
+	static const FTSCommandLineParams& Get()
+	{
+		// 部分模块（如 gRPC server）在 AssetManager 初始化之前就需要读取参数
+		if (!CommandLineParams.bParsed)
+		{
+			InitializeCommandLineParams();
+		}
+		return CommandLineParams;
+	}
 
 	static void InitializeCommandLineParams();
 
@@ -29,7 +37,15 @@ public:
 
 	FString TongOS_U_HttpURL;
 
+	/* gRPC server，未指定时使用 UTSGrpcSettings */
+	FString GrpcHost;
+	int GrpcPort = -1;
+	FString GrpcUnixSocket;
+	int GrpcWorkerNum = -1;
+	int GrpcMaxMessageMB = 0;
+
 private:
+	bool bParsed = false;
 	void ParseCommandLines();
 	static FTSCommandLineParams CommandLineParams;
 };
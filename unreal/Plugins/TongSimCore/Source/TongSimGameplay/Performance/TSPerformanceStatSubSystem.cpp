@@ -87,7 +87,7 @@ void FTSPerformanceStatCache::StopCharting()
 
 double FTSPerformanceStatCache::GetCachedStat(ETongSimPerformanceStat Stat) const
 {
-	static_assert((int32)ETongSimPerformanceStat::Count == 15, "Need to update this function to deal with new performance stats");
+	static_assert((int32)ETongSimPerformanceStat::Count == 19, "Need to update this function to deal with new performance stats");
 	switch (Stat)
 	{
 	case ETongSimPerformanceStat::ClientFPS:
@@ -120,16 +120,37 @@ double FTSPerformanceStatCache::GetCachedStat(ETongSimPerformanceStat Stat) cons
 		return CachedPacketSizeIncoming;
 	case ETongSimPerformanceStat::PacketSize_Outgoing:
 		return CachedPacketSizeOutgoing;
+	case ETongSimPerformanceStat::RpcEventQueueDepth:
+	case ETongSimPerformanceStat::RpcCallsInFlight:
+	case ETongSimPerformanceStat::RpcWriteQueueLength:
+	case ETongSimPerformanceStat::RpcCallRate:
+		return CachedExternalStats[static_cast<int32>(Stat)];
 	}
 
 	return 0.0f;
 }
 
+void FTSPerformanceStatCache::SetExternalStat(ETongSimPerformanceStat Stat, double Value)
+{
+	if (Stat < ETongSimPerformanceStat::Count)
+	{
+		CachedExternalStats[static_cast<int32>(Stat)] = Value;
+	}
+}
+
 double UTSPerformanceStatSubSystem::GetCachedStat(ETongSimPerformanceStat Stat) const
 {
 	return Tracker->GetCachedStat(Stat);
 }
 
+void UTSPerformanceStatSubSystem::SetExternalStat(ETongSimPerformanceStat Stat, double Value)
+{
+	if (Tracker)
+	{
+		Tracker->SetExternalStat(Stat, Value);
+	}
+}
+
 void UTSPerformanceStatSubSystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
@@ -56,6 +56,18 @@ enum class ETongSimPerformanceStat : uint8
 	// The avg. size (in bytes) of packets sent
 	PacketSize_Outgoing,
 
+	// gRPC events waiting for the game thread (pushed by TongosGrpc)
+	RpcEventQueueDepth,
+
+	// gRPC calls accepted or pending on the completion queues
+	RpcCallsInFlight,
+
+	// gRPC responses queued behind an in-flight write
+	RpcWriteQueueLength,
+
+	// gRPC calls started per second
+	RpcCallRate,
+
 	// New stats should go above here
 	Count UMETA(Hidden)
 };
@@ -80,6 +92,9 @@ public:
 
 	double GetCachedStat(ETongSimPerformanceStat Stat) const;
 
+	// Stats owned by other modules that cannot be sampled from FFrameData
+	void SetExternalStat(ETongSimPerformanceStat Stat, double Value);
+
 protected:
 	IPerformanceDataConsumer::FFrameData CachedData;
 	UTSPerformanceStatSubSystem* MySubsystem;
@@ -93,6 +108,8 @@ protected:
 	float CachedPacketSizeIncoming = 0.0f;
 	float CachedPacketSizeOutgoing = 0.0f;
 
+	double CachedExternalStats[static_cast<int32>(ETongSimPerformanceStat::Count)] = {};
+
 private:
 	bool bLogPerformance = false;
 	float LogIntervalInSec = 10.f;
@@ -116,6 +133,9 @@ public:
 
 	static UTSPerformanceStatSubSystem* GetInstance();
 
+	/** 由其他模块（如 TongosGrpc）推送的统计值，需在游戏线程调用 */
+	void SetExternalStat(ETongSimPerformanceStat Stat, double Value);
+
 protected:
 	TSharedPtr<FTSPerformanceStatCache> Tracker;
 
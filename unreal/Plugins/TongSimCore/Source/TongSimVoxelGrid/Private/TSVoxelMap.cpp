@@ -0,0 +1,506 @@
+#include "TSVoxelMap.h"
+
+#include "TSVoxelGridFuncLib.h"
+#include "TSVoxelSourceCache.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Actor.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(TSVoxelMap)
+
+namespace TSVoxelMap
+{
+	static int32 MaxRegions = 4096;
+	static FAutoConsoleVariableRef CVarMaxRegions(TEXT("tongsim.Voxel.MapMaxRegions"),
+		MaxRegions,
+		TEXT("Maximum number of voxelized regions (64^3 voxels each) kept by the persistent voxel map before it is reset."));
+
+	// 单个体素盒每个轴最多 65534 个体素（FVoxelBox 的半数是 uint16）
+	constexpr int64 MaxVoxelsPerAxis = 65534;
+
+	// 算术右移，负坐标也向下取整
+	FIntVector Shift(const FIntVector& V, int32 Bits)
+	{
+		return FIntVector(V.X >> Bits, V.Y >> Bits, V.Z >> Bits);
+	}
+
+	bool IsZero(const uint8* Bytes, int32 Num)
+	{
+		for (int32 i = 0; i < Num; ++i)
+		{
+			if (Bytes[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+void UTSVoxelMap::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	UTSVoxelSourceCache* SourceCache = Collection.InitializeDependency<UTSVoxelSourceCache>();
+	if (SourceCache)
+	{
+		SourceChangedHandle = SourceCache->OnSourceChanged.AddUObject(this, &ThisClass::HandleSourceChanged);
+	}
+}
+
+void UTSVoxelMap::Deinitialize()
+{
+	if (UTSVoxelSourceCache* SourceCache = UWorld::GetSubsystem<UTSVoxelSourceCache>(GetWorld()))
+	{
+		SourceCache->OnSourceChanged.Remove(SourceChangedHandle);
+	}
+	Reset();
+	SkeletalBounds.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTSVoxelMap::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTSVoxelMap::Reset()
+{
+	Bricks.Empty();
+	ReadyRegions.Empty();
+	DirtyRanges.Empty();
+}
+
+bool UTSVoxelMap::QueryVoxelGrids(const FVoxelGridQueryParam& QueryParam, TArray<uint8>& VoxelGrids)
+{
+	check(IsInGameThread());
+	UTSVoxelSourceCache* SourceCache = GetWorld()->GetSubsystem<UTSVoxelSourceCache>();
+	const FVoxelBox& GridBox = QueryParam.GridBox;
+	if (!SourceCache || !QueryParam.IsValid() || !QueryParam.bUseWorldSourceCache
+		|| !GridBox.GetBoxTransform().GetRotation().Equals(FQuat::Identity, UE_KINDA_SMALL_NUMBER))
+	{
+		return false;
+	}
+
+	const FVector GridSize = GridBox.GetGridSize();
+	if (!GridSize.Equals(VoxelSize, GridSize.GetMin() * UE_KINDA_SMALL_NUMBER))
+	{
+		UE_LOG(LogTemp, Log, TEXT("Voxel map rebuilt for voxel size %s."), *GridSize.ToString());
+		Reset();
+		VoxelSize = GridSize;
+	}
+
+	// 盒子的最小角吸附到最近的格点
+	const FIntVector Num(GridBox.GetGridHalfNumX() * 2, GridBox.GetGridHalfNumY() * 2, GridBox.GetGridHalfNumZ() * 2);
+	const FVector MinCorner = (GridBox.GetBoxTransform().GetLocation() - GridBox.GetBoxSize() / 2) / VoxelSize;
+	const FIntVector MinVoxel(FMath::RoundToInt32(MinCorner.X), FMath::RoundToInt32(MinCorner.Y), FMath::RoundToInt32(MinCorner.Z));
+	const FBrickRange QueryBricks{
+		TSVoxelMap::Shift(MinVoxel, BrickShift), TSVoxelMap::Shift(MinVoxel + Num - FIntVector(1), BrickShift)
+	};
+
+	const FIntVector QueryRegions = TSVoxelMap::Shift(QueryBricks.Max, RegionShift) - TSVoxelMap::Shift(QueryBricks.Min, RegionShift) + FIntVector(1);
+	const int64 NumQueryRegions = static_cast<int64>(QueryRegions.X) * QueryRegions.Y * QueryRegions.Z;
+	if (NumQueryRegions > TSVoxelMap::MaxRegions)
+	{
+		return false;
+	}
+	if (ReadyRegions.Num() + NumQueryRegions > TSVoxelMap::MaxRegions)
+	{
+		Reset();
+	}
+
+	Update(*SourceCache, QueryBricks);
+
+	TMap<FIntVector, TStaticArray<uint8, BrickBytes>> Overrides;
+	if (!QueryParam.IgnoredActors.IsEmpty())
+	{
+		BuildOverrides(QueryParam, QueryBricks, Overrides);
+	}
+	ReadGrids(MinVoxel, Num, Overrides, VoxelGrids);
+	return true;
+}
+
+void UTSVoxelMap::HandleSourceChanged(const FBox& OldBounds, const FBox& NewBounds, bool bStatic)
+{
+	if (bStatic)
+	{
+		// 静态碰撞体只在关卡加载/卸载、生成/销毁时变化，直接作废所在区域，下次查询时重建
+		InvalidateRegions(OldBounds);
+		InvalidateRegions(NewBounds);
+		return;
+	}
+	AddDirtyRange(OldBounds);
+	AddDirtyRange(NewBounds);
+}
+
+void UTSVoxelMap::AddDirtyRange(const FBox& WorldBounds)
+{
+	FBrickRange Range;
+	if (ToBrickRange(WorldBounds, Range) && IsAnyRegionReady(Range))
+	{
+		const FIntVector Num = (Range.Max - Range.Min + FIntVector(1)) * BrickSize;
+		if (Num.GetMax() > TSVoxelMap::MaxVoxelsPerAxis)
+		{
+			// 超大的动态物体没法按一个体素盒重算，整张地图重建
+			Reset();
+			return;
+		}
+		DirtyRanges.AddUnique(Range);
+	}
+}
+
+void UTSVoxelMap::InvalidateRegions(const FBox& WorldBounds)
+{
+	FBrickRange Range;
+	if (!ToBrickRange(WorldBounds, Range) || ReadyRegions.IsEmpty())
+	{
+		return;
+	}
+
+	const FIntVector Min = TSVoxelMap::Shift(Range.Min, RegionShift);
+	const FIntVector Max = TSVoxelMap::Shift(Range.Max, RegionShift);
+	TArray<FIntVector> Invalidated;
+	for (const FIntVector& Region : ReadyRegions)
+	{
+		if (Region.X >= Min.X && Region.X <= Max.X && Region.Y >= Min.Y && Region.Y <= Max.Y && Region.Z >= Min.Z && Region.Z <= Max.Z)
+		{
+			Invalidated.Add(Region);
+		}
+	}
+
+	const int32 RegionBricks = 1 << RegionShift;
+	for (const FIntVector& Region : Invalidated)
+	{
+		ReadyRegions.Remove(Region);
+		const FIntVector First = Region * RegionBricks;
+		for (int32 X = 0; X < RegionBricks; ++X)
+		{
+			for (int32 Y = 0; Y < RegionBricks; ++Y)
+			{
+				for (int32 Z = 0; Z < RegionBricks; ++Z)
+				{
+					Bricks.Remove(First + FIntVector(X, Y, Z));
+				}
+			}
+		}
+	}
+}
+
+void UTSVoxelMap::Update(UTSVoxelSourceCache& SourceCache, const FBrickRange& QueryBricks)
+{
+	// 移动过的组件在这里通过 HandleSourceChanged 标脏
+	SourceCache.Flush();
+
+	TArray<TObjectPtr<USkeletalMeshComponent>> SkeletalMeshComponents;
+	SourceCache.GatherSkeletalMeshComponents(SkeletalMeshComponents);
+	TMap<TObjectKey<USkeletalMeshComponent>, FBox> NewSkeletalBounds;
+	NewSkeletalBounds.Reserve(SkeletalMeshComponents.Num());
+	for (USkeletalMeshComponent* Component : SkeletalMeshComponents)
+	{
+		if (!CollisionEnabledHasPhysics(Component->GetCollisionEnabled()))
+		{
+			continue;
+		}
+		const FBox Bounds = Component->Bounds.GetBox();
+		FBox PreviousBounds;
+		if (SkeletalBounds.RemoveAndCopyValue(Component, PreviousBounds))
+		{
+			AddDirtyRange(PreviousBounds);
+		}
+		AddDirtyRange(Bounds);
+		NewSkeletalBounds.Add(Component, Bounds);
+	}
+	// 剩下的是已经销毁或关闭碰撞的骨骼网格体，清掉它们上次占用的块
+	for (const TPair<TObjectKey<USkeletalMeshComponent>, FBox>& Stale : SkeletalBounds)
+	{
+		AddDirtyRange(Stale.Value);
+	}
+	SkeletalBounds = MoveTemp(NewSkeletalBounds);
+
+	// 查询覆盖、还没体素化的区域两层都要算
+	TArray<FBrickRange> NewRegions;
+	const FIntVector RegionMin = TSVoxelMap::Shift(QueryBricks.Min, RegionShift);
+	const FIntVector RegionMax = TSVoxelMap::Shift(QueryBricks.Max, RegionShift);
+	const int32 RegionBricks = 1 << RegionShift;
+	for (int32 X = RegionMin.X; X <= RegionMax.X; ++X)
+	{
+		for (int32 Y = RegionMin.Y; Y <= RegionMax.Y; ++Y)
+		{
+			for (int32 Z = RegionMin.Z; Z <= RegionMax.Z; ++Z)
+			{
+				const FIntVector Region(X, Y, Z);
+				bool bAlreadyReady = false;
+				ReadyRegions.Add(Region, &bAlreadyReady);
+				if (!bAlreadyReady)
+				{
+					NewRegions.Add({Region * RegionBricks, Region * RegionBricks + FIntVector(RegionBricks - 1)});
+				}
+			}
+		}
+	}
+
+	TArray<FBrickRange> DynamicRanges = MoveTemp(DirtyRanges);
+	DirtyRanges.Reset();
+	DynamicRanges.Append(NewRegions);
+	Rasterize(NewRegions, DynamicRanges);
+}
+
+void UTSVoxelMap::Rasterize(const TArray<FBrickRange>& StaticRanges, const TArray<FBrickRange>& DynamicRanges)
+{
+	if (StaticRanges.IsEmpty() && DynamicRanges.IsEmpty())
+	{
+		return;
+	}
+
+	// 所有范围一次批量体素化，共用碰撞体筛选并在各范围之间并行
+	TArray<FVoxelGridQueryParam> Params;
+	Params.Reserve(StaticRanges.Num() + DynamicRanges.Num());
+	for (const FBrickRange& Range : StaticRanges)
+	{
+		Params.Add_GetRef(MakeRangeParam(Range)).SourceFilter = EVoxelSourceFilter::Static;
+	}
+	for (const FBrickRange& Range : DynamicRanges)
+	{
+		Params.Add_GetRef(MakeRangeParam(Range)).SourceFilter = EVoxelSourceFilter::Dynamic;
+	}
+	TArray<TArray<uint8>> Grids;
+	TSVoxelGridFuncLib::BatchQueryVoxelGrids(Params, Grids);
+
+	for (int32 i = 0; i < Params.Num(); ++i)
+	{
+		const bool bStatic = i < StaticRanges.Num();
+		const FBrickRange& Range = bStatic ? StaticRanges[i] : DynamicRanges[i - StaticRanges.Num()];
+		const FIntVector Num = (Range.Max - Range.Min + FIntVector(1)) * BrickSize;
+		const int32 ZBytes = Num.Z / 8;
+		const uint8* Grid = Grids[i].GetData();
+		for (int32 BX = Range.Min.X; BX <= Range.Max.X; ++BX)
+		{
+			for (int32 BY = Range.Min.Y; BY <= Range.Max.Y; ++BY)
+			{
+				for (int32 BZ = Range.Min.Z; BZ <= Range.Max.Z; ++BZ)
+				{
+					uint8 Bytes[BrickBytes];
+					uint8 Any = 0;
+					for (int32 LX = 0; LX < BrickSize; ++LX)
+					{
+						const int32 X = (BX - Range.Min.X) * BrickSize + LX;
+						for (int32 LY = 0; LY < BrickSize; ++LY)
+						{
+							const int32 Y = (BY - Range.Min.Y) * BrickSize + LY;
+							Bytes[LX * BrickSize + LY] = Grid[(static_cast<int64>(X) * Num.Y + Y) * ZBytes + (BZ - Range.Min.Z)];
+							Any |= Bytes[LX * BrickSize + LY];
+						}
+					}
+
+					const FIntVector Key(BX, BY, BZ);
+					FBrick* Brick = Any ? &Bricks.FindOrAdd(Key) : Bricks.Find(Key);
+					if (!Brick)
+					{
+						continue;
+					}
+					FMemory::Memcpy(bStatic ? Brick->Static : Brick->Dynamic, Bytes, BrickBytes);
+					if (!Any && TSVoxelMap::IsZero(Brick->Static, BrickBytes) && TSVoxelMap::IsZero(Brick->Dynamic, BrickBytes))
+					{
+						Bricks.Remove(Key);
+					}
+				}
+			}
+		}
+	}
+}
+
+void UTSVoxelMap::BuildOverrides(const FVoxelGridQueryParam& QueryParam, const FBrickRange& QueryBricks,
+                                 TMap<FIntVector, TStaticArray<uint8, BrickBytes>>& OutOverrides)
+{
+	// 被忽略 Actor 覆盖的块不用地图里的数据，按本次查询排除这些 Actor 后重新体素化
+	TArray<FVoxelGridQueryParam> Params;
+	TArray<FBrickRange> Ranges;
+	for (const TObjectPtr<AActor>& Actor : QueryParam.IgnoredActors)
+	{
+		FBrickRange Range;
+		if (!IsValid(Actor) || !ToBrickRange(Actor->GetComponentsBoundingBox(), Range))
+		{
+			continue;
+		}
+		Range.Min = FIntVector(FMath::Max(Range.Min.X, QueryBricks.Min.X), FMath::Max(Range.Min.Y, QueryBricks.Min.Y), FMath::Max(Range.Min.Z, QueryBricks.Min.Z));
+		Range.Max = FIntVector(FMath::Min(Range.Max.X, QueryBricks.Max.X), FMath::Min(Range.Max.Y, QueryBricks.Max.Y), FMath::Min(Range.Max.Z, QueryBricks.Max.Z));
+		if (Range.Min.X > Range.Max.X || Range.Min.Y > Range.Max.Y || Range.Min.Z > Range.Max.Z)
+		{
+			continue;
+		}
+		FVoxelGridQueryParam& Param = Params.Add_GetRef(MakeRangeParam(Range));
+		Param.IgnoredActors = QueryParam.IgnoredActors;
+		Ranges.Add(Range);
+	}
+	if (Params.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<TArray<uint8>> Grids;
+	TSVoxelGridFuncLib::BatchQueryVoxelGrids(Params, Grids);
+	for (int32 i = 0; i < Ranges.Num(); ++i)
+	{
+		const FBrickRange& Range = Ranges[i];
+		const FIntVector Num = (Range.Max - Range.Min + FIntVector(1)) * BrickSize;
+		const int32 ZBytes = Num.Z / 8;
+		const uint8* Grid = Grids[i].GetData();
+		for (int32 BX = Range.Min.X; BX <= Range.Max.X; ++BX)
+		{
+			for (int32 BY = Range.Min.Y; BY <= Range.Max.Y; ++BY)
+			{
+				for (int32 BZ = Range.Min.Z; BZ <= Range.Max.Z; ++BZ)
+				{
+					TStaticArray<uint8, BrickBytes>& Bytes = OutOverrides.Add(FIntVector(BX, BY, BZ));
+					for (int32 LX = 0; LX < BrickSize; ++LX)
+					{
+						const int32 X = (BX - Range.Min.X) * BrickSize + LX;
+						for (int32 LY = 0; LY < BrickSize; ++LY)
+						{
+							const int32 Y = (BY - Range.Min.Y) * BrickSize + LY;
+							Bytes[LX * BrickSize + LY] = Grid[(static_cast<int64>(X) * Num.Y + Y) * ZBytes + (BZ - Range.Min.Z)];
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void UTSVoxelMap::ReadGrids(const FIntVector& MinVoxel, const FIntVector& Num,
+                            const TMap<FIntVector, TStaticArray<uint8, BrickBytes>>& Overrides,
+                            TArray<uint8>& VoxelGrids) const
+{
+	const int32 ZBytes = (Num.Z + 7) / 8;
+	VoxelGrids.SetNumZeroed(Num.X * Num.Y * ZBytes);
+
+	// 输出的第 j 个 Z 字节由块 BZ0+j 的高 (8-Shift) 位和块 BZ0+j+1 的低 Shift 位拼成
+	const int32 BZ0 = MinVoxel.Z >> BrickShift;
+	const int32 Shift = MinVoxel.Z & (BrickSize - 1);
+	const int32 NumBZ = ((MinVoxel.Z + Num.Z - 1) >> BrickShift) - BZ0 + 1;
+	const uint8 LastByteMask = Num.Z % 8 ? static_cast<uint8>((1u << (Num.Z % 8)) - 1) : 0xFF;
+	const FIntVector MaxVoxel = MinVoxel + Num - FIntVector(1);
+
+	TArray<const uint8*> StaticColumn, DynamicColumn;
+	StaticColumn.SetNumZeroed(NumBZ);
+	DynamicColumn.SetNumZeroed(NumBZ);
+	TArray<uint8> Column;
+	Column.SetNumZeroed(NumBZ + 1);
+
+	for (int32 BX = MinVoxel.X >> BrickShift; BX <= MaxVoxel.X >> BrickShift; ++BX)
+	{
+		for (int32 BY = MinVoxel.Y >> BrickShift; BY <= MaxVoxel.Y >> BrickShift; ++BY)
+		{
+			// 先找出这一摞块，再逐列拼字节
+			bool bAny = false;
+			for (int32 K = 0; K < NumBZ; ++K)
+			{
+				const FIntVector Key(BX, BY, BZ0 + K);
+				if (const TStaticArray<uint8, BrickBytes>* Override = Overrides.Find(Key))
+				{
+					StaticColumn[K] = Override->GetData();
+					DynamicColumn[K] = nullptr;
+				}
+				else if (const FBrick* Brick = Bricks.Find(Key))
+				{
+					StaticColumn[K] = Brick->Static;
+					DynamicColumn[K] = Brick->Dynamic;
+				}
+				else
+				{
+					StaticColumn[K] = DynamicColumn[K] = nullptr;
+				}
+				bAny |= StaticColumn[K] != nullptr;
+			}
+			if (!bAny)
+			{
+				continue;
+			}
+
+			for (int32 LX = 0; LX < BrickSize; ++LX)
+			{
+				const int32 X = BX * BrickSize + LX - MinVoxel.X;
+				if (X < 0 || X >= Num.X)
+				{
+					continue;
+				}
+				for (int32 LY = 0; LY < BrickSize; ++LY)
+				{
+					const int32 Y = BY * BrickSize + LY - MinVoxel.Y;
+					if (Y < 0 || Y >= Num.Y)
+					{
+						continue;
+					}
+					const int32 Index = LX * BrickSize + LY;
+					for (int32 K = 0; K < NumBZ; ++K)
+					{
+						Column[K] = (StaticColumn[K] ? StaticColumn[K][Index] : 0) | (DynamicColumn[K] ? DynamicColumn[K][Index] : 0);
+					}
+					uint8* Out = VoxelGrids.GetData() + (static_cast<int64>(X) * Num.Y + Y) * ZBytes;
+					for (int32 J = 0; J < ZBytes; ++J)
+					{
+						Out[J] = static_cast<uint8>(Column[J] >> Shift | (Shift ? Column[J + 1] << (8 - Shift) : 0));
+					}
+					Out[ZBytes - 1] &= LastByteMask;
+				}
+			}
+		}
+	}
+}
+
+bool UTSVoxelMap::ToBrickRange(const FBox& WorldBounds, FBrickRange& OutRange) const
+{
+	if (!WorldBounds.IsValid || VoxelSize.IsZero())
+	{
+		return false;
+	}
+	const FVector Min = WorldBounds.Min / VoxelSize;
+	const FVector Max = WorldBounds.Max / VoxelSize;
+	OutRange.Min = TSVoxelMap::Shift(FIntVector(FMath::FloorToInt32(Min.X), FMath::FloorToInt32(Min.Y), FMath::FloorToInt32(Min.Z)), BrickShift);
+	OutRange.Max = TSVoxelMap::Shift(FIntVector(FMath::FloorToInt32(Max.X), FMath::FloorToInt32(Max.Y), FMath::FloorToInt32(Max.Z)), BrickShift);
+	return true;
+}
+
+bool UTSVoxelMap::IsAnyRegionReady(const FBrickRange& Range) const
+{
+	const FIntVector Min = TSVoxelMap::Shift(Range.Min, RegionShift);
+	const FIntVector Max = TSVoxelMap::Shift(Range.Max, RegionShift);
+	const FIntVector Span = Max - Min + FIntVector(1);
+	if (static_cast<int64>(Span.X) * Span.Y * Span.Z > ReadyRegions.Num())
+	{
+		for (const FIntVector& Region : ReadyRegions)
+		{
+			if (Region.X >= Min.X && Region.X <= Max.X && Region.Y >= Min.Y && Region.Y <= Max.Y && Region.Z >= Min.Z && Region.Z <= Max.Z)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	for (int32 X = Min.X; X <= Max.X; ++X)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			for (int32 Z = Min.Z; Z <= Max.Z; ++Z)
+			{
+				if (ReadyRegions.Contains(FIntVector(X, Y, Z)))
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+FVoxelGridQueryParam UTSVoxelMap::MakeRangeParam(const FBrickRange& Range) const
+{
+	// 体素盒与地图格点对齐：盒内第 i 个体素就是格点 Range.Min*8 + i
+	const FIntVector Num = (Range.Max - Range.Min + FIntVector(1)) * BrickSize;
+	const FVector Center = (FVector(Range.Min * BrickSize) + FVector(Num) / 2) * VoxelSize;
+	FVoxelGridQueryParam Param{GetWorld()};
+	Param.GridBox = FVoxelBox{FTransform(Center), static_cast<uint32>(Num.X / 2), static_cast<uint32>(Num.Y / 2),
+	                          static_cast<uint32>(Num.Z / 2), FVector(Num) * VoxelSize};
+	Param.bUseWorldSourceCache = true;
+	return Param;
+}
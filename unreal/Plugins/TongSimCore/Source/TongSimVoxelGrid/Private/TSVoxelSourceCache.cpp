@@ -0,0 +1,383 @@
+#include "TSVoxelSourceCache.h"
+
+#include "EngineUtils.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(TSVoxelSourceCache)
+
+namespace TSVoxelSourceCache
+{
+	static float CellSize = 1000.f;
+	static FAutoConsoleVariableRef CVarCellSize(TEXT("tongsim.Voxel.SourceCellSize"),
+		CellSize,
+		TEXT("Cell size (UU) of the voxel source hash grid. Takes effect for worlds created afterwards."));
+
+	// 跨格超过该数量的组件（地面、大墙体）不进网格，避免一次移动改很多格子
+	constexpr int64 MaxCellsPerEntry = 64;
+}
+
+void UTSVoxelSourceCache::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CellSize = FMath::Max(static_cast<double>(TSVoxelSourceCache::CellSize), 1.);
+	CreatePhysicsHandle = UActorComponent::GlobalCreatePhysicsDelegate.AddUObject(this, &ThisClass::HandleCreatePhysicsState);
+	DestroyPhysicsHandle = UActorComponent::GlobalDestroyPhysicsDelegate.AddUObject(this, &ThisClass::HandleDestroyPhysicsState);
+}
+
+void UTSVoxelSourceCache::Deinitialize()
+{
+	UActorComponent::GlobalCreatePhysicsDelegate.Remove(CreatePhysicsHandle);
+	UActorComponent::GlobalDestroyPhysicsDelegate.Remove(DestroyPhysicsHandle);
+
+	for (const FEntry& Entry : Entries)
+	{
+		if (UPrimitiveComponent* Component = Entry.Component.Get())
+		{
+			Component->TransformUpdated.RemoveAll(this);
+		}
+	}
+	Entries.Empty();
+	ComponentToEntry.Empty();
+	Cells.Empty();
+	LooseEntries.Empty();
+	DirtyEntries.Empty();
+	BodySetupBounds.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTSVoxelSourceCache::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTSVoxelSourceCache::GatherCandidates(const FBox& WorldBox, const TSet<TObjectPtr<AActor>>& IgnoredActors,
+                                           TArray<TObjectPtr<UPrimitiveComponent>>& OutPrimitiveComponents,
+                                           TArray<TObjectPtr<USkeletalMeshComponent>>& OutSkeletalMeshComponents)
+{
+	check(IsInGameThread());
+	Flush();
+
+	// 同一组件可能跨多个格子，用查询序号去重
+	++QueryStamp;
+	auto Visit = [&](int32 EntryIndex)
+	{
+		FEntry& Entry = Entries[EntryIndex];
+		if (Entry.QueryStamp == QueryStamp)
+		{
+			return;
+		}
+		Entry.QueryStamp = QueryStamp;
+
+		UPrimitiveComponent* Component = Entry.Component.Get();
+		if (!Component)
+		{
+			return;
+		}
+		const FBox Bounds = Entry.bSkeletal ? Component->Bounds.GetBox() : Entry.Bounds;
+		if (!Bounds.Intersect(WorldBox) || IgnoredActors.Contains(Component->GetOwner()))
+		{
+			return;
+		}
+
+		OutPrimitiveComponents.Add(Component);
+		if (Entry.bSkeletal)
+		{
+			OutSkeletalMeshComponents.Add(CastChecked<USkeletalMeshComponent>(Component));
+		}
+	};
+
+	const FIntVector Min = ToCell(WorldBox.Min);
+	const FIntVector Max = ToCell(WorldBox.Max);
+	const int64 NumQueryCells = static_cast<int64>(Max.X - Min.X + 1) * (Max.Y - Min.Y + 1) * (Max.Z - Min.Z + 1);
+	if (NumQueryCells > Cells.Num())
+	{
+		// 查询盒比已占用的格子还多时直接遍历占用的格子
+		for (const TPair<FIntVector, TArray<int32>>& Cell : Cells)
+		{
+			const FIntVector& Key = Cell.Key;
+			if (Key.X >= Min.X && Key.X <= Max.X && Key.Y >= Min.Y && Key.Y <= Max.Y && Key.Z >= Min.Z && Key.Z <= Max.Z)
+			{
+				for (const int32 EntryIndex : Cell.Value)
+				{
+					Visit(EntryIndex);
+				}
+			}
+		}
+	}
+	else
+	{
+		for (int32 X = Min.X; X <= Max.X; ++X)
+		{
+			for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+			{
+				for (int32 Z = Min.Z; Z <= Max.Z; ++Z)
+				{
+					if (const TArray<int32>* Cell = Cells.Find(FIntVector(X, Y, Z)))
+					{
+						for (const int32 EntryIndex : *Cell)
+						{
+							Visit(EntryIndex);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (const int32 EntryIndex : LooseEntries)
+	{
+		Visit(EntryIndex);
+	}
+}
+
+FBox UTSVoxelSourceCache::GetBodySetupBounds(UBodySetup* BodySetup)
+{
+	if (!BodySetup)
+	{
+		return FBox(ForceInit);
+	}
+	if (const FBox* Found = BodySetupBounds.Find(BodySetup))
+	{
+		return *Found;
+	}
+	return BodySetupBounds.Add(BodySetup, BodySetup->AggGeom.CalcAABB(FTransform::Identity));
+}
+
+void UTSVoxelSourceCache::Flush()
+{
+	ScanWorldOnce();
+	FlushDirty();
+}
+
+void UTSVoxelSourceCache::GatherSkeletalMeshComponents(TArray<TObjectPtr<USkeletalMeshComponent>>& OutSkeletalMeshComponents) const
+{
+	for (const int32 EntryIndex : LooseEntries)
+	{
+		const FEntry& Entry = Entries[EntryIndex];
+		if (Entry.bSkeletal)
+		{
+			if (UPrimitiveComponent* Component = Entry.Component.Get())
+			{
+				OutSkeletalMeshComponents.Add(CastChecked<USkeletalMeshComponent>(Component));
+			}
+		}
+	}
+}
+
+bool UTSVoxelSourceCache::IsStaticSource(const UPrimitiveComponent* Component)
+{
+	return Component->Mobility != EComponentMobility::Movable && !Component->IsA<USkinnedMeshComponent>();
+}
+
+void UTSVoxelSourceCache::HandleCreatePhysicsState(UActorComponent* Component)
+{
+	if (Component && Component->GetWorld() == GetWorld())
+	{
+		AddComponent(Cast<UPrimitiveComponent>(Component));
+	}
+}
+
+void UTSVoxelSourceCache::HandleDestroyPhysicsState(UActorComponent* Component)
+{
+	if (Component && Component->GetWorld() == GetWorld())
+	{
+		RemoveComponent(Cast<UPrimitiveComponent>(Component));
+	}
+}
+
+void UTSVoxelSourceCache::HandleTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (const int32* EntryIndex = ComponentToEntry.Find(Cast<UPrimitiveComponent>(Component)))
+	{
+		FEntry& Entry = Entries[*EntryIndex];
+		if (!Entry.bDirty)
+		{
+			Entry.bDirty = true;
+			DirtyEntries.Add(*EntryIndex);
+		}
+	}
+}
+
+void UTSVoxelSourceCache::ScanWorldOnce()
+{
+	if (bScanned)
+	{
+		return;
+	}
+	bScanned = true;
+
+	// 子系统创建之前就已经建立物理状态的组件只能补扫一次，之后全靠回调
+	TArray<UPrimitiveComponent*> Components;
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		It->GetComponents(Components);
+		for (UPrimitiveComponent* Component : Components)
+		{
+			if (Component->IsPhysicsStateCreated())
+			{
+				AddComponent(Component);
+			}
+		}
+	}
+}
+
+void UTSVoxelSourceCache::AddComponent(UPrimitiveComponent* Component)
+{
+	if (!IsValid(Component) || ComponentToEntry.Contains(Component))
+	{
+		return;
+	}
+
+	FEntry Entry;
+	Entry.Component = Component;
+	Entry.bSkeletal = Component->IsA<USkeletalMeshComponent>();
+	if (!Entry.bSkeletal && !ComputeBounds(Component, Entry.Bounds))
+	{
+		// 没有简单碰撞的组件不会占用体素
+		return;
+	}
+
+	const int32 EntryIndex = Entries.Add(Entry);
+	ComponentToEntry.Add(Component, EntryIndex);
+	LinkEntry(EntryIndex);
+	if (!Entry.bSkeletal)
+	{
+		Component->TransformUpdated.AddUObject(this, &ThisClass::HandleTransformUpdated);
+		OnSourceChanged.Broadcast(FBox(ForceInit), Entry.Bounds, IsStaticSource(Component));
+	}
+}
+
+void UTSVoxelSourceCache::RemoveComponent(UPrimitiveComponent* Component)
+{
+	int32 EntryIndex = INDEX_NONE;
+	if (!Component || !ComponentToEntry.RemoveAndCopyValue(Component, EntryIndex))
+	{
+		return;
+	}
+	Component->TransformUpdated.RemoveAll(this);
+	const FEntry Entry = Entries[EntryIndex];
+	RemoveEntry(EntryIndex);
+	if (!Entry.bSkeletal)
+	{
+		OnSourceChanged.Broadcast(Entry.Bounds, FBox(ForceInit), IsStaticSource(Component));
+	}
+}
+
+void UTSVoxelSourceCache::RemoveEntry(int32 EntryIndex)
+{
+	UnlinkEntry(EntryIndex);
+	if (Entries[EntryIndex].bDirty)
+	{
+		DirtyEntries.RemoveSingleSwap(EntryIndex);
+	}
+	Entries.RemoveAt(EntryIndex);
+}
+
+void UTSVoxelSourceCache::FlushDirty()
+{
+	for (const int32 EntryIndex : DirtyEntries)
+	{
+		FEntry& Entry = Entries[EntryIndex];
+		Entry.bDirty = false;
+		UPrimitiveComponent* Component = Entry.Component.Get();
+		FBox Bounds;
+		if (!Component || !ComputeBounds(Component, Bounds))
+		{
+			continue;
+		}
+
+		if (Bounds == Entry.Bounds)
+		{
+			continue;
+		}
+		OnSourceChanged.Broadcast(Entry.Bounds, Bounds, IsStaticSource(Component));
+		Entry.Bounds = Bounds;
+		const FIntVector NewMin = ToCell(Bounds.Min);
+		const FIntVector NewMax = ToCell(Bounds.Max);
+		// 小范围移动通常不跨格，只更新包围盒
+		if (Entry.bLoose || NewMin != Entry.CellMin || NewMax != Entry.CellMax)
+		{
+			UnlinkEntry(EntryIndex);
+			LinkEntry(EntryIndex);
+		}
+	}
+	DirtyEntries.Reset();
+}
+
+bool UTSVoxelSourceCache::ComputeBounds(UPrimitiveComponent* Component, FBox& OutBounds)
+{
+	const FBox LocalBounds = GetBodySetupBounds(Component->GetBodySetup());
+	if (!LocalBounds.IsValid)
+	{
+		return false;
+	}
+	OutBounds = LocalBounds.TransformBy(Component->GetComponentTransform());
+	return true;
+}
+
+void UTSVoxelSourceCache::LinkEntry(int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+	Entry.CellMin = ToCell(Entry.Bounds.Min);
+	Entry.CellMax = ToCell(Entry.Bounds.Max);
+	const FIntVector Span = Entry.CellMax - Entry.CellMin + FIntVector(1);
+	Entry.bLoose = Entry.bSkeletal || static_cast<int64>(Span.X) * Span.Y * Span.Z > TSVoxelSourceCache::MaxCellsPerEntry;
+	if (Entry.bLoose)
+	{
+		LooseEntries.Add(EntryIndex);
+		return;
+	}
+
+	for (int32 X = Entry.CellMin.X; X <= Entry.CellMax.X; ++X)
+	{
+		for (int32 Y = Entry.CellMin.Y; Y <= Entry.CellMax.Y; ++Y)
+		{
+			for (int32 Z = Entry.CellMin.Z; Z <= Entry.CellMax.Z; ++Z)
+			{
+				Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(EntryIndex);
+			}
+		}
+	}
+}
+
+void UTSVoxelSourceCache::UnlinkEntry(int32 EntryIndex)
+{
+	const FEntry& Entry = Entries[EntryIndex];
+	if (Entry.bLoose)
+	{
+		LooseEntries.RemoveSingleSwap(EntryIndex);
+		return;
+	}
+
+	for (int32 X = Entry.CellMin.X; X <= Entry.CellMax.X; ++X)
+	{
+		for (int32 Y = Entry.CellMin.Y; Y <= Entry.CellMax.Y; ++Y)
+		{
+			for (int32 Z = Entry.CellMin.Z; Z <= Entry.CellMax.Z; ++Z)
+			{
+				const FIntVector Key(X, Y, Z);
+				if (TArray<int32>* Cell = Cells.Find(Key))
+				{
+					Cell->RemoveSingleSwap(EntryIndex);
+					if (Cell->IsEmpty())
+					{
+						Cells.Remove(Key);
+					}
+				}
+			}
+		}
+	}
+}
+
+FIntVector UTSVoxelSourceCache::ToCell(const FVector& Position) const
+{
+	return FIntVector(
+		FMath::FloorToInt32(Position.X / CellSize),
+		FMath::FloorToInt32(Position.Y / CellSize),
+		FMath::FloorToInt32(Position.Z / CellSize));
+}
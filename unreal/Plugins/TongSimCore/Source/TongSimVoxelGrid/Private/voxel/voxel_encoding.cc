@@ -0,0 +1,507 @@
+#include "voxel/voxel_encoding.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+namespace tsvoxel
+{
+	namespace
+	{
+		constexpr int kBrickSize = 8;
+		constexpr size_t kBrickBytes = kBrickSize * kBrickSize;
+
+		uint8_t lowMask(int bits)
+		{
+			return bits >= 8 ? 0xFF : static_cast<uint8_t>((1u << bits) - 1);
+		}
+
+		struct BrickDims
+		{
+			int x = 0;
+			int y = 0;
+			int z = 0;
+
+			explicit BrickDims(const GridDims& dims)
+				: x((dims.x + kBrickSize - 1) / kBrickSize), y((dims.y + kBrickSize - 1) / kBrickSize), z(dims.zBytes())
+			{
+			}
+
+			size_t count() const { return static_cast<size_t>(x) * y * z; }
+			size_t maskBytes() const { return (count() + 7) / 8; }
+		};
+
+		// 遍历每列的每个字节，value 已去掉 Z 方向补齐的位
+		template <typename Visitor>
+		void forEachByte(const uint8_t* dense, const GridDims& dims, Visitor&& visitor)
+		{
+			const int z_bytes = dims.zBytes();
+			const int last_bits = dims.z - (z_bytes - 1) * 8;
+			for (int x = 0; x < dims.x; ++x)
+			{
+				for (int y = 0; y < dims.y; ++y)
+				{
+					const uint8_t* column = dense + (static_cast<size_t>(x) * dims.y + y) * z_bytes;
+					for (int b = 0; b < z_bytes; ++b)
+					{
+						const int bits = b + 1 == z_bytes ? last_bits : 8;
+						visitor(x, y, b, bits, static_cast<uint8_t>(column[b] & lowMask(bits)));
+					}
+				}
+			}
+		}
+
+		// 目标没有 POPCNT 指令时（如默认的 x86-64 GCC/Clang）std::popcount 会变成库函数调用，位流统计每个字要数两次
+		int popcount64(uint64_t value)
+		{
+#if defined(__POPCNT__) || defined(__aarch64__) || defined(_M_ARM64)
+			return std::popcount(value);
+#else
+			value = value - ((value >> 1) & 0x5555555555555555ull);
+			value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+			value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+			return static_cast<int>((value * 0x0101010101010101ull) >> 56);
+#endif
+		}
+
+		// 统计一段连续位流（从 data 第 0 字节的最低位开始，共 bits 位）的占用数和状态变化数
+		// previous 是位流之前最后一位的状态，返回时更新为本段最后一位；按 8 字节一组处理，与前一位同状态的整组直接跳过
+		void accumulateBits(const uint8_t* data, size_t bits, uint64_t& previous, GridStats& stats)
+		{
+			const size_t words = bits / 64;
+			for (size_t i = 0; i < words; ++i)
+			{
+				uint64_t word;
+				std::memcpy(&word, data + i * 8, 8);
+				if (word == 0 - previous)
+				{
+					stats.occupied += previous * 64;
+					continue;
+				}
+				stats.occupied += static_cast<uint64_t>(popcount64(word));
+				stats.runs += static_cast<uint64_t>(popcount64(word ^ ((word << 1) | previous)));
+				previous = word >> 63;
+			}
+			const int tail = static_cast<int>(bits % 64);
+			if (tail == 0)
+			{
+				return;
+			}
+			uint64_t word = 0;
+			std::memcpy(&word, data + words * 8, (tail + 7) / 8);
+			const uint64_t mask = (uint64_t{1} << tail) - 1;
+			word &= mask;
+			stats.occupied += static_cast<uint64_t>(popcount64(word));
+			stats.runs += static_cast<uint64_t>(popcount64((word ^ ((word << 1) | previous)) & mask));
+			previous = (word >> (tail - 1)) & 1;
+		}
+
+		// dst |= src，按 8 字节一组
+		void orBytes(uint8_t* dst, const uint8_t* src, int size)
+		{
+			int i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				uint64_t a;
+				uint64_t b;
+				std::memcpy(&a, dst + i, 8);
+				std::memcpy(&b, src + i, 8);
+				a |= b;
+				std::memcpy(dst + i, &a, 8);
+			}
+			for (; i < size; ++i)
+			{
+				dst[i] |= src[i];
+			}
+		}
+
+		void writeVarint(std::vector<uint8_t>& out, uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				out.push_back(static_cast<uint8_t>(value) | 0x80);
+				value >>= 7;
+			}
+			out.push_back(static_cast<uint8_t>(value));
+		}
+
+		bool readVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value)
+		{
+			value = 0;
+			for (int shift = 0; shift < 64 && data < end; shift += 7)
+			{
+				const uint8_t byte = *data++;
+				value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if (!(byte & 0x80))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void setVoxel(uint8_t* dense, const GridDims& dims, uint64_t index)
+		{
+			const uint64_t column = index / dims.z;
+			const int z = static_cast<int>(index % dims.z);
+			dense[column * dims.zBytes() + z / 8] |= static_cast<uint8_t>(1u << (z % 8));
+		}
+
+		void encodeRleZ(const uint8_t* dense, const GridDims& dims, std::vector<uint8_t>& out)
+		{
+			bool occupied = false;
+			uint64_t run = 0;
+			forEachByte(dense, dims, [&](int, int, int, int bits, uint8_t value)
+			{
+				// 整字节与当前段同状态时直接累加，稀疏场景下绝大部分字节走这里
+				if (value == (occupied ? lowMask(bits) : 0))
+				{
+					run += bits;
+					return;
+				}
+				for (int i = 0; i < bits; ++i)
+				{
+					const bool bit = (value >> i) & 1;
+					if (bit != occupied)
+					{
+						writeVarint(out, run);
+						run = 0;
+						occupied = bit;
+					}
+					++run;
+				}
+			});
+			if (occupied)
+			{
+				writeVarint(out, run);
+			}
+		}
+
+		void encodeSparse(const uint8_t* dense, const GridDims& dims, std::vector<uint8_t>& out)
+		{
+			const int z_bytes = dims.zBytes();
+			const int last_bits = dims.z - (z_bytes - 1) * 8;
+			const size_t columns = static_cast<size_t>(dims.x) * dims.y;
+			for (size_t column = 0; column < columns; ++column)
+			{
+				const uint8_t* data = dense + column * z_bytes;
+				const uint64_t base = static_cast<uint64_t>(column) * dims.z;
+				int b = 0;
+				while (b < z_bytes)
+				{
+					// 整组 8 字节都为空时跳过，空场景下几乎只走这里
+					if (b + 8 <= z_bytes)
+					{
+						uint64_t word;
+						std::memcpy(&word, data + b, 8);
+						if (word == 0)
+						{
+							b += 8;
+							continue;
+						}
+					}
+					uint8_t value = static_cast<uint8_t>(data[b] & lowMask(b + 1 == z_bytes ? last_bits : 8));
+					while (value)
+					{
+						const uint32_t index = static_cast<uint32_t>(base + b * 8 + std::countr_zero(value));
+						value &= value - 1;
+						const uint8_t bytes[4] = {
+							static_cast<uint8_t>(index), static_cast<uint8_t>(index >> 8),
+							static_cast<uint8_t>(index >> 16), static_cast<uint8_t>(index >> 24)
+						};
+						out.insert(out.end(), bytes, bytes + 4);
+					}
+					++b;
+				}
+			}
+		}
+
+		void encodeBrick(const uint8_t* dense, const GridDims& dims, std::vector<uint8_t>& out)
+		{
+			const BrickDims bricks(dims);
+			const int z_bytes = dims.zBytes();
+			out.assign(bricks.maskBytes(), 0);
+			uint8_t block[kBrickBytes];
+			size_t index = 0;
+			for (int bx = 0; bx < bricks.x; ++bx)
+			{
+				for (int by = 0; by < bricks.y; ++by)
+				{
+					for (int bz = 0; bz < bricks.z; ++bz, ++index)
+					{
+						uint8_t any = 0;
+						for (int lx = 0; lx < kBrickSize; ++lx)
+						{
+							const int x = bx * kBrickSize + lx;
+							for (int ly = 0; ly < kBrickSize; ++ly)
+							{
+								const int y = by * kBrickSize + ly;
+								const uint8_t value = x < dims.x && y < dims.y
+									                      ? dense[(static_cast<size_t>(x) * dims.y + y) * z_bytes + bz]
+									                      : 0;
+								block[lx * kBrickSize + ly] = value;
+								any |= value;
+							}
+						}
+						if (any)
+						{
+							out[index / 8] |= static_cast<uint8_t>(1u << (index % 8));
+							out.insert(out.end(), block, block + kBrickBytes);
+						}
+					}
+				}
+			}
+		}
+
+		bool decodeRleZ(const uint8_t* data, size_t size, const GridDims& dims, uint8_t* dense)
+		{
+			const uint8_t* end = data + size;
+			const uint64_t count = dims.voxelCount();
+			uint64_t position = 0;
+			bool occupied = false;
+			while (data < end)
+			{
+				uint64_t run = 0;
+				if (!readVarint(data, end, run) || run > count - position)
+				{
+					return false;
+				}
+				if (occupied)
+				{
+					for (uint64_t i = position; i < position + run; ++i)
+					{
+						setVoxel(dense, dims, i);
+					}
+				}
+				position += run;
+				occupied = !occupied;
+			}
+			return true;
+		}
+
+		bool decodeSparse(const uint8_t* data, size_t size, const GridDims& dims, uint8_t* dense)
+		{
+			if (size % 4 != 0)
+			{
+				return false;
+			}
+			const uint64_t count = dims.voxelCount();
+			for (size_t i = 0; i < size; i += 4)
+			{
+				const uint32_t index = static_cast<uint32_t>(data[i]) | static_cast<uint32_t>(data[i + 1]) << 8 |
+					static_cast<uint32_t>(data[i + 2]) << 16 | static_cast<uint32_t>(data[i + 3]) << 24;
+				if (index >= count)
+				{
+					return false;
+				}
+				setVoxel(dense, dims, index);
+			}
+			return true;
+		}
+
+		bool decodeBrick(const uint8_t* data, size_t size, const GridDims& dims, uint8_t* dense)
+		{
+			const BrickDims bricks(dims);
+			const int z_bytes = dims.zBytes();
+			if (size < bricks.maskBytes())
+			{
+				return false;
+			}
+			const uint8_t* block = data + bricks.maskBytes();
+			const uint8_t* end = data + size;
+			size_t index = 0;
+			for (int bx = 0; bx < bricks.x; ++bx)
+			{
+				for (int by = 0; by < bricks.y; ++by)
+				{
+					for (int bz = 0; bz < bricks.z; ++bz, ++index)
+					{
+						if (!(data[index / 8] & (1u << (index % 8))))
+						{
+							continue;
+						}
+						if (static_cast<size_t>(end - block) < kBrickBytes)
+						{
+							return false;
+						}
+						for (int lx = 0; lx < kBrickSize; ++lx)
+						{
+							const int x = bx * kBrickSize + lx;
+							for (int ly = 0; ly < kBrickSize && x < dims.x; ++ly)
+							{
+								const int y = by * kBrickSize + ly;
+								if (y < dims.y)
+								{
+									dense[(static_cast<size_t>(x) * dims.y + y) * z_bytes + bz] = block[lx * kBrickSize + ly];
+								}
+							}
+						}
+						block += kBrickBytes;
+					}
+				}
+			}
+			return block == end;
+		}
+	}
+
+	GridStats computeStats(const uint8_t* dense, const GridDims& dims)
+	{
+		GridStats stats;
+		if (dims.denseSize() == 0)
+		{
+			return stats;
+		}
+
+		const int z_bytes = dims.zBytes();
+		const uint8_t last_mask = lowMask(dims.z - (z_bytes - 1) * 8);
+		// 开头的空段长度可能为 0，但编码时总会写出
+		stats.runs = 1;
+		uint64_t previous = 0;
+		if (dims.z % 8 == 0)
+		{
+			// 没有补齐位：整个缓冲就是一条连续的位流
+			accumulateBits(dense, dims.denseSize() * 8, previous, stats);
+		}
+		else
+		{
+			const size_t columns = static_cast<size_t>(dims.x) * dims.y;
+			for (size_t column = 0; column < columns; ++column)
+			{
+				accumulateBits(dense + column * z_bytes, static_cast<size_t>(dims.z), previous, stats);
+			}
+		}
+		// 末尾的空段不写出
+		if (!previous)
+		{
+			--stats.runs;
+		}
+
+		// 块占用：一个 X 条带内把每列的字节按位或进所在 Y 块的累加行，条带结束后数非零字节
+		const BrickDims bricks(dims);
+		std::vector<uint8_t> stripe(static_cast<size_t>(bricks.y) * z_bytes);
+		for (int bx = 0; bx < bricks.x; ++bx)
+		{
+			std::fill(stripe.begin(), stripe.end(), 0);
+			const int x_end = std::min(dims.x, (bx + 1) * kBrickSize);
+			for (int x = bx * kBrickSize; x < x_end; ++x)
+			{
+				const uint8_t* row = dense + static_cast<size_t>(x) * dims.y * z_bytes;
+				for (int by = 0; by < bricks.y; ++by)
+				{
+					uint8_t* acc = stripe.data() + static_cast<size_t>(by) * z_bytes;
+					const int y_end = std::min(dims.y, (by + 1) * kBrickSize);
+					for (int y = by * kBrickSize; y < y_end; ++y)
+					{
+						orBytes(acc, row + static_cast<size_t>(y) * z_bytes, z_bytes);
+					}
+				}
+			}
+			for (int by = 0; by < bricks.y; ++by)
+			{
+				uint8_t* acc = stripe.data() + static_cast<size_t>(by) * z_bytes;
+				acc[z_bytes - 1] &= last_mask;
+			}
+			stats.non_empty_bricks += static_cast<uint64_t>(stripe.size() - std::count(stripe.begin(), stripe.end(), 0));
+		}
+		return stats;
+	}
+
+	size_t estimateSize(Encoding encoding, const GridStats& stats, const GridDims& dims)
+	{
+		switch (encoding)
+		{
+		case Encoding::kRleZ:
+			return stats.runs * 2;
+		case Encoding::kSparse:
+			return stats.occupied * 4;
+		case Encoding::kBrick:
+			return BrickDims(dims).maskBytes() + stats.non_empty_bricks * kBrickBytes;
+		default:
+			return dims.denseSize();
+		}
+	}
+
+	Encoding chooseEncoding(const GridStats& stats, const GridDims& dims)
+	{
+		const bool sparse_fits = dims.voxelCount() <= static_cast<uint64_t>(std::numeric_limits<uint32_t>::max()) + 1;
+		// 大小相同时优先解码更便宜的编码
+		Encoding best = Encoding::kDense;
+		size_t best_size = estimateSize(Encoding::kDense, stats, dims);
+		for (const Encoding candidate : {Encoding::kBrick, Encoding::kSparse, Encoding::kRleZ})
+		{
+			if (candidate == Encoding::kSparse && !sparse_fits)
+			{
+				continue;
+			}
+			const size_t size = estimateSize(candidate, stats, dims);
+			if (size < best_size)
+			{
+				best = candidate;
+				best_size = size;
+			}
+		}
+		return best;
+	}
+
+	Encoding encode(Encoding encoding, const uint8_t* dense, const GridDims& dims, std::vector<uint8_t>& out)
+	{
+		out.clear();
+		if (encoding == Encoding::kAuto)
+		{
+			encoding = chooseEncoding(computeStats(dense, dims), dims);
+		}
+		if (encoding == Encoding::kSparse && dims.voxelCount() > static_cast<uint64_t>(std::numeric_limits<uint32_t>::max()) + 1)
+		{
+			encoding = Encoding::kBrick;
+		}
+		if (dims.denseSize() == 0)
+		{
+			return encoding;
+		}
+
+		switch (encoding)
+		{
+		case Encoding::kRleZ:
+			encodeRleZ(dense, dims, out);
+			break;
+		case Encoding::kSparse:
+			encodeSparse(dense, dims, out);
+			break;
+		case Encoding::kBrick:
+			encodeBrick(dense, dims, out);
+			break;
+		default:
+			encoding = Encoding::kDense;
+			out.assign(dense, dense + dims.denseSize());
+			break;
+		}
+		return encoding;
+	}
+
+	bool decode(Encoding encoding, const uint8_t* data, size_t size, const GridDims& dims, std::vector<uint8_t>& dense)
+	{
+		dense.assign(dims.denseSize(), 0);
+		if (dense.empty())
+		{
+			return size == 0;
+		}
+		switch (encoding)
+		{
+		case Encoding::kDense:
+			if (size != dense.size())
+			{
+				return false;
+			}
+			std::memcpy(dense.data(), data, size);
+			return true;
+		case Encoding::kRleZ:
+			return decodeRleZ(data, size, dims, dense.data());
+		case Encoding::kSparse:
+			return decodeSparse(data, size, dims, dense.data());
+		case Encoding::kBrick:
+			return decodeBrick(data, size, dims, dense.data());
+		default:
+			return false;
+		}
+	}
+}
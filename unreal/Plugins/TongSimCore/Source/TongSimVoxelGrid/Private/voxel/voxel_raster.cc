@@ -0,0 +1,277 @@
+#include "voxel/voxel_raster.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace tsvoxel
+{
+	static_assert(std::endian::native == std::endian::little, "voxel columns are read as little-endian words");
+
+	namespace
+	{
+		constexpr double kInf = std::numeric_limits<double>::infinity();
+		// 轴与 Z 方向（或 X 平面）近似平行的阈值
+		constexpr double kParallel = 1e-9;
+		// 分离轴测试里给 |R| 加的余量，避免两条边近似平行时叉积退化成 0 向量误判为分离
+		constexpr double kAxisEpsilon = 1e-9;
+
+		// 位 [lo, hi)，0 <= lo < hi <= 64
+		uint64_t rangeMask(int lo, int hi)
+		{
+			const uint64_t upper = hi >= 64 ? ~uint64_t{0} : (uint64_t{1} << hi) - 1;
+			return upper & (~uint64_t{0} << lo);
+		}
+
+		double dot(const Vec3& a, const Vec3& b)
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+	}
+
+	void fillZRange(uint8_t* column, int z_bytes, int begin, int end)
+	{
+		begin = std::max(begin, 0);
+		end = std::min(end, z_bytes * 8);
+		if (begin >= end)
+		{
+			return;
+		}
+
+		// 区间落在一个 8 字节窗口内（Z 不超过 64 的列总是如此）：一次 64 位读改写；窗口不越过列尾
+		// 这个判断放在最前面，单字节区间也走这里，随机长度下少一个难预测的分支
+		if (z_bytes >= 8)
+		{
+			const int window = std::min(begin >> 3, z_bytes - 8);
+			const int base = window * 8;
+			if (end - base <= 64)
+			{
+				uint64_t word;
+				std::memcpy(&word, column + window, 8);
+				word |= rangeMask(begin - base, end - base);
+				std::memcpy(column + window, &word, 8);
+				return;
+			}
+		}
+
+		const int first = begin >> 3;
+		const int last = (end - 1) >> 3;
+		const uint8_t head = static_cast<uint8_t>(0xFF << (begin & 7));
+		const uint8_t tail = static_cast<uint8_t>(0xFF >> (7 - ((end - 1) & 7)));
+		if (first == last)
+		{
+			column[first] |= head & tail;
+			return;
+		}
+
+		// 跨窗口：首尾字节按位或，中间整字节直接写
+		column[first] |= head;
+		column[last] |= tail;
+		std::memset(column + first + 1, 0xFF, last - first - 1);
+	}
+
+	bool aabbObbOverlap(const Vec3& aabb_min, const Vec3& aabb_max, const OrientedBox& box)
+	{
+		const double ea[3] = {(aabb_max.x - aabb_min.x) / 2, (aabb_max.y - aabb_min.y) / 2, (aabb_max.z - aabb_min.z) / 2};
+		const double t[3] = {
+			box.center.x - (aabb_min.x + aabb_max.x) / 2,
+			box.center.y - (aabb_min.y + aabb_max.y) / 2,
+			box.center.z - (aabb_min.z + aabb_max.z) / 2,
+		};
+		const double* eb = box.half_extent;
+
+		// R[i][j]：有向盒第 j 轴在世界第 i 轴上的分量
+		double r[3][3];
+		double abs_r[3][3];
+		for (int j = 0; j < 3; ++j)
+		{
+			r[0][j] = box.axes[j].x;
+			r[1][j] = box.axes[j].y;
+			r[2][j] = box.axes[j].z;
+		}
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				abs_r[i][j] = std::abs(r[i][j]) + kAxisEpsilon;
+			}
+		}
+
+		// 轴对齐盒的三个面法线
+		for (int i = 0; i < 3; ++i)
+		{
+			const double rb = eb[0] * abs_r[i][0] + eb[1] * abs_r[i][1] + eb[2] * abs_r[i][2];
+			if (std::abs(t[i]) > ea[i] + rb)
+			{
+				return false;
+			}
+		}
+		// 有向盒的三个面法线
+		for (int j = 0; j < 3; ++j)
+		{
+			const double ra = ea[0] * abs_r[0][j] + ea[1] * abs_r[1][j] + ea[2] * abs_r[2][j];
+			if (std::abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) > ra + eb[j])
+			{
+				return false;
+			}
+		}
+		// 两两边方向的叉积
+		for (int i = 0; i < 3; ++i)
+		{
+			const int i1 = (i + 1) % 3;
+			const int i2 = (i + 2) % 3;
+			for (int j = 0; j < 3; ++j)
+			{
+				const int j1 = (j + 1) % 3;
+				const int j2 = (j + 2) % 3;
+				const double ra = ea[i1] * abs_r[i2][j] + ea[i2] * abs_r[i1][j];
+				const double rb = eb[j1] * abs_r[i][j2] + eb[j2] * abs_r[i][j1];
+				if (std::abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) > ra + rb)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void sphereSpans(const Vec3& center, double radius, const ScanRow& row, double* z_min, double* z_max)
+	{
+		const double dx = row.x - center.x;
+		const double base = radius * radius - dx * dx;
+		for (int i = 0; i < row.count; ++i)
+		{
+			const double dy = row.y0 + i * row.dy - center.y;
+			const double s = base - dy * dy;
+			const double h = std::sqrt(std::max(s, 0.0));
+			z_min[i] = s > 0 ? center.z - h : kInf;
+			z_max[i] = s > 0 ? center.z + h : -kInf;
+		}
+	}
+
+	void capsuleSpans(const Vec3& p0, const Vec3& p1, double radius, const ScanRow& row, double* z_min, double* z_max)
+	{
+		const Vec3 axis{p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+		const double length = std::sqrt(dot(axis, axis));
+		if (length < kParallel)
+		{
+			sphereSpans(p0, radius, row, z_min, z_max);
+			return;
+		}
+
+		const double r2 = radius * radius;
+		const Vec3 u{axis.x / length, axis.y / length, axis.z / length};
+		// 以 tau = z - p0.z 为参数，列上的点到轴线距离的平方是 a*tau^2 + 2*b*tau + c + r^2
+		const double a = 1 - u.z * u.z;
+		const bool vertical = a < kParallel;
+		const double inv_a = vertical ? 0 : 1 / a;
+		// 轴在 XY 平面内时投影与 tau 无关
+		const bool flat = std::abs(u.z) < kParallel;
+		const double inv_uz = flat ? 0 : 1 / u.z;
+		const double dx0 = row.x - p0.x;
+		const double dx1 = row.x - p1.x;
+
+		for (int i = 0; i < row.count; ++i)
+		{
+			const double y = row.y0 + i * row.dy;
+			const double dy0 = y - p0.y;
+			const double dy1 = y - p1.y;
+
+			// 两端的球
+			const double s0 = r2 - dx0 * dx0 - dy0 * dy0;
+			const double s1 = r2 - dx1 * dx1 - dy1 * dy1;
+			const double h0 = std::sqrt(std::max(s0, 0.0));
+			const double h1 = std::sqrt(std::max(s1, 0.0));
+			double lo = std::min(s0 > 0 ? p0.z - h0 : kInf, s1 > 0 ? p1.z - h1 : kInf);
+			double hi = std::max(s0 > 0 ? p0.z + h0 : -kInf, s1 > 0 ? p1.z + h1 : -kInf);
+
+			// 圆柱段：到轴线的距离不超过半径
+			const double proj = dx0 * u.x + dy0 * u.y;
+			const double px = dx0 - proj * u.x;
+			const double py = dy0 - proj * u.y;
+			const double pz = -proj * u.z;
+			const double b = pz;
+			const double c = px * px + py * py + pz * pz - r2;
+			const double disc = b * b - a * c;
+			const double root = std::sqrt(std::max(disc, 0.0));
+			double cyl_lo = vertical ? (c < 0 ? -kInf : kInf) : (disc > 0 ? (-b - root) * inv_a : kInf);
+			double cyl_hi = vertical ? (c < 0 ? kInf : -kInf) : (disc > 0 ? (-b + root) * inv_a : -kInf);
+
+			// 且在轴上的投影 proj + tau*u.z 落在 [0, length] 内
+			const bool between = proj >= 0 && proj <= length;
+			const double t0 = -proj * inv_uz;
+			const double t1 = (length - proj) * inv_uz;
+			cyl_lo = std::max(cyl_lo, flat ? (between ? -kInf : kInf) : std::min(t0, t1));
+			cyl_hi = std::min(cyl_hi, flat ? (between ? kInf : -kInf) : std::max(t0, t1));
+
+			// 胶囊体是凸的，三段区间的并仍是一个区间
+			const bool cylinder = cyl_lo <= cyl_hi;
+			z_min[i] = cylinder ? std::min(lo, p0.z + cyl_lo) : lo;
+			z_max[i] = cylinder ? std::max(hi, p0.z + cyl_hi) : hi;
+		}
+	}
+
+	void boxSpans(const OrientedBox& box, const ScanRow& row, double* z_min, double* z_max)
+	{
+		// 列上的点 (x, y_i, z) 在盒子第 k 轴上的坐标为 base[k] + i*step[k] + z*axes[k].z
+		double base[3];
+		double step[3];
+		double inv_z[3];
+		bool parallel[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			const Vec3& axis = box.axes[k];
+			base[k] = (row.x - box.center.x) * axis.x + (row.y0 - box.center.y) * axis.y - box.center.z * axis.z;
+			step[k] = row.dy * axis.y;
+			parallel[k] = std::abs(axis.z) < kParallel;
+			inv_z[k] = parallel[k] ? 0 : 1 / axis.z;
+		}
+
+		for (int i = 0; i < row.count; ++i)
+		{
+			double lo = -kInf;
+			double hi = kInf;
+			for (int k = 0; k < 3; ++k)
+			{
+				const double u = base[k] + i * step[k];
+				const double h = box.half_extent[k];
+				const double t0 = (-h - u) * inv_z[k];
+				const double t1 = (h - u) * inv_z[k];
+				const bool inside = std::abs(u) <= h;
+				lo = std::max(lo, parallel[k] ? (inside ? -kInf : kInf) : std::min(t0, t1));
+				hi = std::min(hi, parallel[k] ? (inside ? kInf : -kInf) : std::max(t0, t1));
+			}
+			z_min[i] = lo;
+			z_max[i] = hi;
+		}
+	}
+
+	void convexSpans(const HalfSpace* planes, int num_planes, const ScanRow& row, double* z_min, double* z_max)
+	{
+		for (int i = 0; i < row.count; ++i)
+		{
+			z_min[i] = -kInf;
+			z_max[i] = kInf;
+		}
+		// 按面逐个收紧，内层循环只有列
+		for (int k = 0; k < num_planes; ++k)
+		{
+			const Vec3& n = planes[k].normal;
+			// 列上的点满足 base + i*step + z*n.z <= 0
+			const double base = row.x * n.x + row.y0 * n.y - planes[k].offset;
+			const double step = row.dy * n.y;
+			const bool parallel = std::abs(n.z) < kParallel;
+			const bool upper = n.z > 0;
+			const double inv_z = parallel ? 0 : 1 / n.z;
+			for (int i = 0; i < row.count; ++i)
+			{
+				const double u = base + i * step;
+				const double t = -u * inv_z;
+				const bool inside = u <= 0;
+				z_min[i] = std::max(z_min[i], parallel ? (inside ? -kInf : kInf) : (upper ? -kInf : t));
+				z_max[i] = std::min(z_max[i], parallel ? (inside ? kInf : -kInf) : (upper ? t : kInf));
+			}
+		}
+	}
+}
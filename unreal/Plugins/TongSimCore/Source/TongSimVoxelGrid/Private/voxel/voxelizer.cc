@@ -0,0 +1,303 @@
+#include "voxel/voxelizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace tsvoxel
+{
+	namespace
+	{
+		// 每次批量计算的 Y 线数，Z 区间缓冲放在栈上
+		constexpr int kChunk = 256;
+		// 面积（叉积长度）小于此值的三角面视为退化
+		constexpr double kDegenerateFace = 1e-12;
+		// 凸包上共面的三角面只保留一个半空间
+		constexpr double kSamePlane = 1e-9;
+
+		Vec3 sub(const Vec3& a, const Vec3& b)
+		{
+			return {a.x - b.x, a.y - b.y, a.z - b.z};
+		}
+
+		Vec3 cross(const Vec3& a, const Vec3& b)
+		{
+			return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+		}
+
+		double dot(const Vec3& a, const Vec3& b)
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		// 索引 index 的体素中心，与 TSVoxelGridFuncLib::Get?From?Index 相同
+		double voxelCenter(int index, int num, double size)
+		{
+			return (index - num / 2 + 0.5) * size;
+		}
+
+		// 区间 [lo, hi] -> 索引区间，两端都 floor 后夹紧到网格内，与 TSVoxelGridFuncLib::Get?IndexRegionFrom?Region 相同
+		void indexRange(double lo, double hi, int num, double size, int& first, int& last)
+		{
+			const double max_index = num - 1;
+			first = static_cast<int>(std::clamp(std::floor(lo / size) + num / 2, 0.0, max_index));
+			last = static_cast<int>(std::clamp(std::floor(hi / size) + num / 2, 0.0, max_index));
+		}
+
+		// 线段 a-b 与平面 x 的交点并入 [y_lo, y_hi]；线段在平面内时两端都并入
+		void expandSlice(const Vec3& a, const Vec3& b, double x, double& y_lo, double& y_hi)
+		{
+			if ((a.x - x) * (b.x - x) > 0)
+			{
+				return;
+			}
+			if (a.x == b.x)
+			{
+				y_lo = std::min({y_lo, a.y, b.y});
+				y_hi = std::max({y_hi, a.y, b.y});
+				return;
+			}
+			const double y = a.y + (x - a.x) / (b.x - a.x) * (b.y - a.y);
+			y_lo = std::min(y_lo, y);
+			y_hi = std::max(y_hi, y);
+		}
+
+		// X 平面 x_index 上 Y 索引 [first_y, last_y] 的各列：spans 批量算出 Z 区间后逐列置位
+		template <typename Spans>
+		void scanPlane(const GridSpec& grid, int x_index, int first_y, int last_y, const Spans& spans, uint8_t* voxels)
+		{
+			double z_min[kChunk];
+			double z_max[kChunk];
+			const double x = voxelCenter(x_index, grid.num_x, grid.voxel_size.x);
+			for (int y_index = first_y; y_index <= last_y; y_index += kChunk)
+			{
+				const ScanRow row{
+					x, voxelCenter(y_index, grid.num_y, grid.voxel_size.y), grid.voxel_size.y,
+					std::min(kChunk, last_y - y_index + 1)
+				};
+				spans(row, z_min, z_max);
+				for (int i = 0; i < row.count; ++i)
+				{
+					rasterizeSegment(grid, x_index, y_index + i, z_min[i], z_max[i], voxels);
+				}
+			}
+		}
+	}
+
+	bool rasterizeSegment(const GridSpec& grid, int x_index, int y_index, double z_min, double z_max, uint8_t* voxels)
+	{
+		const double half_z = grid.num_z * grid.voxel_size.z / 2;
+		// 不相交（z_min > z_max 或 NaN）或整段在网格上下方时不写，否则会被夹到边界体素上
+		if (x_index < 0 || x_index >= grid.num_x || y_index < 0 || y_index >= grid.num_y
+			|| !(z_min <= z_max) || z_max < -half_z || z_min > half_z)
+		{
+			return false;
+		}
+
+		int first_z, last_z;
+		indexRange(z_min, z_max, grid.num_z, grid.voxel_size.z, first_z, last_z);
+		const int z_bytes = grid.zBytes();
+		uint8_t* column = voxels + (static_cast<size_t>(x_index) * grid.num_y + y_index) * z_bytes;
+		fillZRange(column, z_bytes, first_z, last_z + 1);
+		return true;
+	}
+
+	void rasterizeSphere(const GridSpec& grid, const Vec3& center, double radius, uint8_t* voxels)
+	{
+		const double r = std::abs(radius);
+		int first_x, last_x;
+		indexRange(center.x - r, center.x + r, grid.num_x, grid.voxel_size.x, first_x, last_x);
+		for (int x_index = first_x; x_index <= last_x; ++x_index)
+		{
+			const double dx = center.x - voxelCenter(x_index, grid.num_x, grid.voxel_size.x);
+			const double squared_ry = r * r - dx * dx;
+			if (squared_ry <= 0)
+			{
+				continue;
+			}
+			const double ry = std::sqrt(squared_ry);
+			int first_y, last_y;
+			indexRange(center.y - ry, center.y + ry, grid.num_y, grid.voxel_size.y, first_y, last_y);
+			scanPlane(grid, x_index, first_y, last_y, [&](const ScanRow& row, double* z_min, double* z_max)
+			{
+				sphereSpans(center, r, row, z_min, z_max);
+			}, voxels);
+		}
+	}
+
+	void rasterizeCapsule(const GridSpec& grid, const Vec3& p0, const Vec3& p1, double radius, uint8_t* voxels)
+	{
+		const double r = std::abs(radius);
+		const double min_x = std::min(p0.x, p1.x);
+		const double max_x = std::max(p0.x, p1.x);
+		const double min_y = std::min(p0.y, p1.y);
+		const double max_y = std::max(p0.y, p1.y);
+		int first_x, last_x;
+		indexRange(min_x - r, max_x + r, grid.num_x, grid.voxel_size.x, first_x, last_x);
+		for (int x_index = first_x; x_index <= last_x; ++x_index)
+		{
+			// 截面在轴线 Y 范围外扩 sqrt(r^2 - d^2) 之内，d 为平面到轴线 X 范围的距离
+			const double x = voxelCenter(x_index, grid.num_x, grid.voxel_size.x);
+			const double dx = std::max({0.0, min_x - x, x - max_x});
+			if (dx >= r)
+			{
+				continue;
+			}
+			const double half_y = std::sqrt(r * r - dx * dx);
+			int first_y, last_y;
+			indexRange(min_y - half_y, max_y + half_y, grid.num_y, grid.voxel_size.y, first_y, last_y);
+			scanPlane(grid, x_index, first_y, last_y, [&](const ScanRow& row, double* z_min, double* z_max)
+			{
+				capsuleSpans(p0, p1, r, row, z_min, z_max);
+			}, voxels);
+		}
+	}
+
+	bool rasterizeBox(const GridSpec& grid, const OrientedBox& box, uint8_t* voxels)
+	{
+		const Vec3 half_grid{
+			grid.num_x * grid.voxel_size.x / 2, grid.num_y * grid.voxel_size.y / 2, grid.num_z * grid.voxel_size.z / 2
+		};
+		if (!aabbObbOverlap({-half_grid.x, -half_grid.y, -half_grid.z}, half_grid, box))
+		{
+			return false;
+		}
+
+		// 角点 i 的第 k 位决定沿第 k 轴取正还是负；12 条棱连接只差一位的角点
+		static constexpr int kEdges[12][2] = {
+			{0, 1}, {2, 3}, {4, 5}, {6, 7}, {0, 2}, {1, 3}, {4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}
+		};
+		Vec3 corners[8];
+		for (int i = 0; i < 8; ++i)
+		{
+			Vec3 p = box.center;
+			for (int k = 0; k < 3; ++k)
+			{
+				const double h = (i >> k & 1 ? 1 : -1) * box.half_extent[k];
+				p = {p.x + box.axes[k].x * h, p.y + box.axes[k].y * h, p.z + box.axes[k].z * h};
+			}
+			corners[i] = p;
+		}
+
+		double reach_x = 0;
+		for (int k = 0; k < 3; ++k)
+		{
+			reach_x += std::abs(box.axes[k].x) * box.half_extent[k];
+		}
+		int first_x, last_x;
+		indexRange(box.center.x - reach_x, box.center.x + reach_x, grid.num_x, grid.voxel_size.x, first_x, last_x);
+		for (int x_index = first_x; x_index <= last_x; ++x_index)
+		{
+			// 截面最多是六边形，Y 范围要看全部 12 条棱
+			const double x = voxelCenter(x_index, grid.num_x, grid.voxel_size.x);
+			double y_lo = std::numeric_limits<double>::infinity();
+			double y_hi = -std::numeric_limits<double>::infinity();
+			for (const auto& edge : kEdges)
+			{
+				expandSlice(corners[edge[0]], corners[edge[1]], x, y_lo, y_hi);
+			}
+			if (y_lo > y_hi)
+			{
+				continue;
+			}
+			int first_y, last_y;
+			indexRange(y_lo, y_hi, grid.num_y, grid.voxel_size.y, first_y, last_y);
+			scanPlane(grid, x_index, first_y, last_y, [&](const ScanRow& row, double* z_min, double* z_max)
+			{
+				boxSpans(box, row, z_min, z_max);
+			}, voxels);
+		}
+		return true;
+	}
+
+	void rasterizeConvex(const GridSpec& grid, const Vec3* vertices, int num_vertices, const int32_t* indices,
+	                     int num_indices, uint8_t* voxels)
+	{
+		if (num_vertices <= 0)
+		{
+			return;
+		}
+		Vec3 centroid;
+		double min_x = vertices[0].x;
+		double max_x = vertices[0].x;
+		for (int i = 0; i < num_vertices; ++i)
+		{
+			centroid = {centroid.x + vertices[i].x, centroid.y + vertices[i].y, centroid.z + vertices[i].z};
+			min_x = std::min(min_x, vertices[i].x);
+			max_x = std::max(max_x, vertices[i].x);
+		}
+		centroid = {centroid.x / num_vertices, centroid.y / num_vertices, centroid.z / num_vertices};
+
+		// 每个面一个半空间，法线按质心翻到朝外
+		const auto valid = [&](int i) { return indices[i] >= 0 && indices[i] < num_vertices; };
+		std::vector<HalfSpace> planes;
+		planes.reserve(num_indices / 3);
+		for (int i = 0; i + 2 < num_indices; i += 3)
+		{
+			if (!valid(i) || !valid(i + 1) || !valid(i + 2))
+			{
+				continue;
+			}
+			const Vec3& a = vertices[indices[i]];
+			Vec3 n = cross(sub(vertices[indices[i + 1]], a), sub(vertices[indices[i + 2]], a));
+			const double area = std::sqrt(dot(n, n));
+			if (!(area > kDegenerateFace))
+			{
+				continue;
+			}
+			n = {n.x / area, n.y / area, n.z / area};
+			double offset = dot(n, a);
+			if (dot(n, centroid) > offset)
+			{
+				n = {-n.x, -n.y, -n.z};
+				offset = -offset;
+			}
+			const bool duplicate = std::any_of(planes.begin(), planes.end(), [&](const HalfSpace& plane)
+			{
+				return std::abs(plane.normal.x - n.x) < kSamePlane && std::abs(plane.normal.y - n.y) < kSamePlane
+					&& std::abs(plane.normal.z - n.z) < kSamePlane && std::abs(plane.offset - offset) < kSamePlane;
+			});
+			if (!duplicate)
+			{
+				planes.push_back({n, offset});
+			}
+		}
+		if (planes.empty())
+		{
+			return;
+		}
+
+		int first_x, last_x;
+		indexRange(min_x, max_x, grid.num_x, grid.voxel_size.x, first_x, last_x);
+		for (int x_index = first_x; x_index <= last_x; ++x_index)
+		{
+			// 截面的 Y 范围由各条棱与平面的交点给出
+			const double x = voxelCenter(x_index, grid.num_x, grid.voxel_size.x);
+			double y_lo = std::numeric_limits<double>::infinity();
+			double y_hi = -std::numeric_limits<double>::infinity();
+			for (int i = 0; i + 2 < num_indices; i += 3)
+			{
+				if (!valid(i) || !valid(i + 1) || !valid(i + 2))
+				{
+					continue;
+				}
+				const Vec3& a = vertices[indices[i]];
+				const Vec3& b = vertices[indices[i + 1]];
+				const Vec3& c = vertices[indices[i + 2]];
+				expandSlice(a, b, x, y_lo, y_hi);
+				expandSlice(b, c, x, y_lo, y_hi);
+				expandSlice(c, a, x, y_lo, y_hi);
+			}
+			if (y_lo > y_hi)
+			{
+				continue;
+			}
+			int first_y, last_y;
+			indexRange(y_lo, y_hi, grid.num_y, grid.voxel_size.y, first_y, last_y);
+			scanPlane(grid, x_index, first_y, last_y, [&](const ScanRow& row, double* z_min, double* z_max)
+			{
+				convexSpans(planes.data(), static_cast<int>(planes.size()), row, z_min, z_max);
+			}, voxels);
+		}
+	}
+}
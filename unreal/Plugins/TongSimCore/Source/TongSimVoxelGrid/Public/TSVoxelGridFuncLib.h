@@ -3,17 +3,25 @@
 #pragma once
 #include "CoreMinimal.h"
 #include "PhysicsEngine/ConvexElem.h"
+#include "voxel/voxel_encoding.h"
 
-struct FZAxisSegment
+struct FKAggregateGeom;
+
+// 一个待体素化的碰撞体：聚合几何体及其在体素盒空间下的变换
+struct FVoxelizeAggGeom
 	{
-	double Z[2];
-	int IntersectionPointNum;
+	const FKAggregateGeom* AggGeom = nullptr;
+	FTransform TransformInVoxelBoxSpace;
 	};
 
-struct FMinAndMaxYLineInPlaneX
+// 一次（批量）查询内各体素盒共用的组件数据，避免重复计算骨骼网格体的 AABB 和骨骼姿态
+struct FVoxelSourceSnapshot
 	{
-	int MinYLineIndex;
-	int MaxYLineIndex;
+	TMap<TObjectPtr<UBodySetup>, FBox> BodySetupAABBs;
+	// 骨骼网格体在世界空间下的物理资产 AABB
+	TMap<TObjectPtr<USkeletalMeshComponent>, FBox> SkeletalMeshAABBs;
+	// 骨骼网格体各骨骼的碰撞体及其世界变换
+	TMap<TObjectPtr<USkeletalMeshComponent>, TArray<TPair<const FKAggregateGeom*, FTransform>>> SkeletalBoneBodies;
 	};
 
 struct FVoxelBox
@@ -85,6 +93,14 @@ public:
 	};
 	};
 
+// 按是否会移动筛选碰撞源，UTSVoxelMap 分层体素化时使用；判定见 UTSVoxelSourceCache::IsStaticSource
+enum class EVoxelSourceFilter : uint8
+	{
+	All,
+	Static,
+	Dynamic,
+	};
+
 struct FVoxelGridQueryParam
 	{
 	FVoxelGridQueryParam() = delete;
@@ -94,11 +110,17 @@ struct FVoxelGridQueryParam
 
 	FVoxelBox GridBox;
 
+	// 为 true 时从世界的 UTSVoxelSourceCache 取与体素盒相交的组件，忽略 Actors，排除 IgnoredActors
+	bool bUseWorldSourceCache = false;
+	TSet<TObjectPtr<AActor>> IgnoredActors;
+
 	TArray<AActor*> Actors;
 	TSet<TObjectPtr<UPrimitiveComponent>> IgnoredPrimitiveComponents;
 
 	TSet<TObjectPtr<USkeletalMeshComponent>> IgnoredSkeletalMeshComponents;
 
+	EVoxelSourceFilter SourceFilter = EVoxelSourceFilter::All;
+
 	FORCEINLINE bool IsValid() const{
 		return GridBox.IsValid() && World != nullptr;
 	}
@@ -110,6 +132,23 @@ private:
 	UWorld* World = nullptr;
 	};
 
+// 编码后的通用压缩，取值与 voxel.proto 的 VoxelCompression 一致
+enum class EVoxelGridCompression : uint8
+	{
+	None = 0,
+	LZ4 = 1,
+	Zlib = 2,
+	};
+
+// EncodeVoxelGrids 实际使用的编码方式，客户端据此解码
+struct FVoxelGridEncoding
+	{
+	tsvoxel::Encoding Encoding = tsvoxel::Encoding::kDense;
+	EVoxelGridCompression Compression = EVoxelGridCompression::None;
+	// 压缩前（编码后）的字节数，解压时需要
+	int32 RawSize = 0;
+	};
+
 struct TONGSIMVOXELGRID_API TSVoxelGridFuncLib
 	{
 	TSVoxelGridFuncLib() = delete;
@@ -118,14 +157,30 @@ struct TONGSIMVOXELGRID_API TSVoxelGridFuncLib
 
 	static auto QueryVoxelGrids(const FVoxelGridQueryParam& QueryParams, TArray<uint8>& VoxelGrids, UWorld* InWorld=nullptr) -> void;
 
+	// 一次查询多个体素盒，VoxelGrids[i] 与 QueryParams[i] 对应，内容与逐个调用 QueryVoxelGrids 相同
+	// 各体素盒在游戏线程上筛选碰撞体时共用组件数据，之后各体素盒并行体素化
+	static auto BatchQueryVoxelGrids(TConstArrayView<FVoxelGridQueryParam> QueryParams, TArray<TArray<uint8>>& VoxelGrids) -> void;
+
+	// 体素网格的字节数：X*Y 列，每列 Z 方向按 8 对齐后按位存放
+	static int32 GetVoxelGridsNum(const FVoxelBox& GridBox);
+
+	// 把 QueryVoxelGrids 输出的稠密网格原地编码，再按需压缩；压缩失败或没有变小时不压缩
+	// Encoding 为 kAuto 时按占用率、段数和非空块数估计大小，选最小的编码
+	static void EncodeVoxelGrids(const FVoxelBox& GridBox, tsvoxel::Encoding Encoding, EVoxelGridCompression Compression,
+	                             TArray<uint8>& VoxelGrids, FVoxelGridEncoding& OutEncoding);
+
 private:
+	// 筛选与体素盒重叠的碰撞体，追加到 AggGeoms
+	static void CollectOverlappedAggGeoms(const FVoxelGridQueryParam& QueryParams, FVoxelSourceSnapshot& Snapshot,
+	                                      TArray<FVoxelizeAggGeom>& AggGeoms);
+
 	static void UpdateBodySetupAABBMap(const TArray<AActor*>& Actors, const FVoxelGridQueryParam& QueryParam,
 	                                   TArray<TObjectPtr<UPrimitiveComponent>>& WorldPrimitiveComponents,
 	                                   TArray<TObjectPtr<USkeletalMeshComponent>>& WorldSkeletalMeshComponents,
 	                                   TMap<TObjectPtr<UBodySetup>, FBox>& BodySetupAABBsMap,
 	                                   TMap<FName, FBox>& SkeletalMeshComponentAABBsMap);
 
-	static TArray<FVector> GetBoxEdges(const FBox& Box);
+	// 分离轴测试，A 为轴对齐盒，B 为局部 AABB 经 BTransform 变换后的有向盒
 	static bool AABBOverlap(const FBox& A, const FBox& B, const FTransform& BTransform);
 
 	FORCEINLINE static bool IsValidCollision(UPrimitiveComponent* Component){
@@ -148,32 +203,36 @@ private:
 		return IsValid(SkeletalMesh) && (SkeletalMesh->GetBodySetup());
 	}
 
-	// 计算FKAggregateGeom占用空间网格体素的情况，方法内部会调用FixGridVoxelWithCapsule,Sphere,Box,Convex
+	// 把一批碰撞体写入体素网格；数量足够多时按碰撞体分给多个任务并行计算，再按X平面把各任务的结果“或”进输出，结果与串行一致
+	static void VoxelizeAggGeoms(const FVoxelBox& GridBox, TConstArrayView<FVoxelizeAggGeom> AggGeoms,
+	                             TArray<uint8>& VoxelGridsArray, UWorld* InWorld=nullptr);
+
+	// 计算FKAggregateGeom占用空间网格体素的情况，方法内部会调用FixVoxelGridsWithCapsule,Sphere,Box,ConvexMesh
 	static void FixVoxelGridsWithAggGeom(const FVoxelBox& GridBox, const FKAggregateGeom& AggGeom,
 	                                     const FTransform& AggGeomTransformInVoxelBoxSpace,
 	                                     TArray<uint8>& VoxelGridsArray,
 	                                     UWorld* InWorld=nullptr);
 
-	// 计算胶囊碰撞体占用空间网格体素的情况，方法内部会调用FixGridVoxelWithSegment
+	// 计算胶囊碰撞体占用空间网格体素的情况，转到体素盒空间后调用 tsvoxel::rasterizeCapsule
 	static void FixVoxelGridsWithCapsule(const FVoxelBox& GridBox, const FVector& Center1, const FVector& Center2,
 	                                     float Radius, TArray<uint8>& VoxelGridsArray);
 
-	// 计算Box碰撞体占用空间网格体素的情况，方法内部会调用FixGridVoxelWithSegment
+	// 计算Box碰撞体占用空间网格体素的情况，转到体素盒空间后调用 tsvoxel::rasterizeBox
 	static void FixVoxelGridsWithBox(const FVoxelBox& GridBox, const FVector& BoxExtent,
 	                                 const FTransform& TransformBS2VS, TArray<uint8>& VoxelGridsArray, UWorld* InWorld=nullptr, bool bIsDrawDebug=false);
 
-	// 计算Sphere碰撞体占用空间网格体素的情况，方法内部会调用FixGridVoxelWithSegment
+	// 计算Sphere碰撞体占用空间网格体素的情况，转到体素盒空间后调用 tsvoxel::rasterizeSphere
 	static void FixVoxelGridsWithSphere(const FVoxelBox& GridBox, const FVector& Center, float Radius,
 	                                    TArray<uint8>& VoxelGridsArray);
 
-	// 计算凸碰撞体占用空间网格体素的情况，方法内部会调用FixGridVoxelWithSegment
+	// 计算凸碰撞体占用空间网格体素的情况，转到体素盒空间后调用 tsvoxel::rasterizeConvex
 	static void FixVoxelGridsWithConvexMesh(const FVoxelBox& GridBox, const FKConvexElem& Convex,
 	                                        const FTransform& ConvexTransformInVoxelBoxSpace,
 	                                        TArray<uint8>& VoxelGridsArray);
 
 	// 给定一条线段(XPlaneIndex平面上，LineYIndex直线上，最大Z为MaxZ, 最小Z维MinZ)，计算在VoxelBox的局部坐标系下，线段占用的体素网格
-	static bool FixVoxelGridsWithSegment(const FVoxelBox& GridBox, int PlaneXIndex, int LineYIndex, float ZMin,
-	                                     float ZMax, TArray<uint8>& VoxelGridsArray);
+	static bool FixVoxelGridsWithSegment(const FVoxelBox& GridBox, int PlaneXIndex, int LineYIndex, double ZMin,
+	                                     double ZMax, TArray<uint8>& VoxelGridsArray);
 
 	static void ClearAllVoxels(TArray<uint8>& GridVoxelArray){
 		if (!GridVoxelArray.IsEmpty())
@@ -373,35 +432,6 @@ private:
 	// 	MaxZIndex = FMath::Clamp(MaxZIndex, 0, GridZNum - 1);
 	// }
 
-	static void ResetZAxisSegmentArray(const FVoxelBox& GridBox, TArray<FZAxisSegment>& ZAxisSegmentArray){
-		ZAxisSegmentArray.Empty();
-		// if (ZAxisSegmentArray.IsEmpty())
-		// {
-		// 	return;
-		// }
-		uint32 GridNumX = GridBox.GetGridHalfNumX() * 2;
-		uint32 GridNumY = GridBox.GetGridHalfNumY() * 2;
-		ZAxisSegmentArray.SetNumZeroed(GridNumX * GridNumY);
-		// FMemory::Memset(ZAxisSegmentArray.GetData(), 0, sizeof(FZAxisSegment) * GridNumX * GridNumY);
-	}
-
-	static void ResetMinAndMaxYLineInPlaneXArray(const FVoxelBox& GridBox,
-	                                             TArray<FMinAndMaxYLineInPlaneX>& MinAndMaxYLineInPlaneXArray){
-		MinAndMaxYLineInPlaneXArray.Empty();
-		MinAndMaxYLineInPlaneXArray.SetNumUninitialized(GridBox.GetGridHalfNumX() * 2);
-		// if (MinAndMaxYLineInPlaneXArray.IsEmpty())
-		// {
-		// 	return;
-		// }
-		for (auto& Elem : MinAndMaxYLineInPlaneXArray)
-		{
-			Elem.MinYLineIndex = GridBox.GetGridSize().Y;
-			Elem.MaxYLineIndex = -GridBox.GetGridSize().Y;
-		}
-		// FMemory::Memset(MinAndMaxYLineInPlaneXArray.GetData(), 0,
-		//                 sizeof(FMinAndMaxYLineInPlaneX) * GridBox.GetGridHalfNumX() * 2);
-	};
-
 public:
 	static void DrawDebugGrids(const UWorld* World, const FVoxelBox& VoxelBox, float TimeLength, FColor Color, const TArray<uint8>& Voxels);
 
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "TSVoxelMap.generated.h"
+
+struct FVoxelGridQueryParam;
+class UTSVoxelSourceCache;
+class USkeletalMeshComponent;
+
+/**
+ * 常驻体素地图：以世界原点为基准、轴对齐的体素格点，按 8x8x8 的块稀疏存放，静态层与动态层分开。
+ * 区域（8x8x8 个块）第一次被查询时体素化两层；之后静态碰撞体增删只作废所在区域，
+ * 动态碰撞体（Movable 组件、骨骼网格体）只重算新旧 AABB 覆盖的块，每次查询的开销与移动的物体数成正比。
+ * 只能在游戏线程访问。
+ */
+UCLASS()
+class TONGSIMVOXELGRID_API UTSVoxelMap : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * 从地图读出 QueryParam.GridBox 的稠密网格，布局与 TSVoxelGridFuncLib::QueryVoxelGrids 相同。
+	 * 体素盒不能旋转，且会吸附到最近的格点（偏移小于一个体素）；地图的体素尺寸取自查询，尺寸变化时整张地图重建。
+	 * 只支持 bUseWorldSourceCache 的查询，IgnoredActors 所在的块按查询单独体素化。
+	 * 不满足条件时返回 false，调用方应退回无状态查询。
+	 */
+	bool QueryVoxelGrids(const FVoxelGridQueryParam& QueryParam, TArray<uint8>& VoxelGrids);
+
+	/** 丢弃全部块，下次查询时重新体素化 */
+	void Reset();
+
+	int32 NumBricks() const { return Bricks.Num(); }
+	int32 NumReadyRegions() const { return ReadyRegions.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	static constexpr int32 BrickShift = 3;
+	static constexpr int32 BrickSize = 1 << BrickShift;
+	static constexpr int32 BrickBytes = BrickSize * BrickSize;
+	// 区域边长为 8 个块（2^3），区域是首次体素化和静态失效的粒度
+	static constexpr int32 RegionShift = 3;
+
+	struct FBrick
+	{
+		// 字节 lx*8 + ly 是列 (lx, ly) 在本块 Z 范围内的 8 个体素，LSB 对应最低的 z
+		uint8 Static[BrickBytes] = {};
+		uint8 Dynamic[BrickBytes] = {};
+	};
+
+	// 块坐标闭区间
+	struct FBrickRange
+	{
+		FIntVector Min;
+		FIntVector Max;
+
+		bool operator==(const FBrickRange& Other) const { return Min == Other.Min && Max == Other.Max; }
+	};
+
+	void HandleSourceChanged(const FBox& OldBounds, const FBox& NewBounds, bool bStatic);
+	void AddDirtyRange(const FBox& WorldBounds);
+	void InvalidateRegions(const FBox& WorldBounds);
+	void Update(UTSVoxelSourceCache& SourceCache, const FBrickRange& QueryBricks);
+	void Rasterize(const TArray<FBrickRange>& StaticRanges, const TArray<FBrickRange>& DynamicRanges);
+	void BuildOverrides(const FVoxelGridQueryParam& QueryParam, const FBrickRange& QueryBricks,
+	                    TMap<FIntVector, TStaticArray<uint8, BrickBytes>>& OutOverrides);
+	void ReadGrids(const FIntVector& MinVoxel, const FIntVector& Num,
+	               const TMap<FIntVector, TStaticArray<uint8, BrickBytes>>& Overrides, TArray<uint8>& VoxelGrids) const;
+
+	bool ToBrickRange(const FBox& WorldBounds, FBrickRange& OutRange) const;
+	bool IsAnyRegionReady(const FBrickRange& Range) const;
+	FVoxelGridQueryParam MakeRangeParam(const FBrickRange& Range) const;
+
+	FVector VoxelSize = FVector::ZeroVector;
+	TMap<FIntVector, FBrick> Bricks;
+	TSet<FIntVector> ReadyRegions;
+	// 上次查询以来动态碰撞体新旧 AABB 覆盖的块
+	TArray<FBrickRange> DirtyRanges;
+	// 骨骼网格体上次体素化时的包围盒，姿态每帧都在变，每次查询都重算
+	TMap<TObjectKey<USkeletalMeshComponent>, FBox> SkeletalBounds;
+
+	FDelegateHandle SourceChangedHandle;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "TSVoxelSourceCache.generated.h"
+
+class UBodySetup;
+class UPrimitiveComponent;
+class USkeletalMeshComponent;
+
+// 非骨骼组件加入、移除或移动后的世界 AABB 变化；加入时 OldBounds、移除时 NewBounds 无效
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnVoxelSourceChanged, const FBox& /*OldBounds*/, const FBox& /*NewBounds*/, bool /*bStatic*/);
+
+/**
+ * 体素查询的碰撞体缓存：按世界 AABB 把带物理状态的组件放进均匀哈希网格，查询时只取与体素盒相交的格子。
+ * 组件创建/销毁物理状态时增删，移动时标脏、下次查询前重新分格；BodySetup 的局部 AABB 只计算一次。
+ * 骨骼网格体的姿态每帧都在变，不进网格，查询时用渲染包围盒逐个粗筛。只能在游戏线程访问。
+ */
+UCLASS()
+class TONGSIMVOXELGRID_API UTSVoxelSourceCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * 收集世界 AABB 与 WorldBox 相交的组件，IgnoredActors 的组件不返回；
+	 * 骨骼网格体同时出现在两个输出里，与逐 Actor 收集组件时一致
+	 */
+	void GatherCandidates(const FBox& WorldBox, const TSet<TObjectPtr<AActor>>& IgnoredActors,
+	                      TArray<TObjectPtr<UPrimitiveComponent>>& OutPrimitiveComponents,
+	                      TArray<TObjectPtr<USkeletalMeshComponent>>& OutSkeletalMeshComponents);
+
+	/** BodySetup 聚合几何体在自身坐标系下的 AABB */
+	FBox GetBodySetupBounds(UBodySetup* BodySetup);
+
+	/** 补扫世界并处理积累的移动，移动的组件在这里广播 OnSourceChanged */
+	void Flush();
+
+	/** 当前所有带物理状态的骨骼网格体 */
+	void GatherSkeletalMeshComponents(TArray<TObjectPtr<USkeletalMeshComponent>>& OutSkeletalMeshComponents) const;
+
+	/** 不会移动的碰撞源：非 Movable 且不是骨骼网格体 */
+	static bool IsStaticSource(const UPrimitiveComponent* Component);
+
+	FOnVoxelSourceChanged OnSourceChanged;
+
+	int32 Num() const { return Entries.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		FBox Bounds = FBox(ForceInit);
+		FIntVector CellMin = FIntVector::ZeroValue;
+		FIntVector CellMax = FIntVector::ZeroValue;
+		// 不在网格里的（骨骼网格体、跨格过多的大物体）每次查询都检查
+		bool bLoose = false;
+		bool bSkeletal = false;
+		bool bDirty = false;
+		uint32 QueryStamp = 0;
+	};
+
+	void HandleCreatePhysicsState(UActorComponent* Component);
+	void HandleDestroyPhysicsState(UActorComponent* Component);
+	void HandleTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	void ScanWorldOnce();
+	void AddComponent(UPrimitiveComponent* Component);
+	void RemoveComponent(UPrimitiveComponent* Component);
+	void RemoveEntry(int32 EntryIndex);
+	void FlushDirty();
+	bool ComputeBounds(UPrimitiveComponent* Component, FBox& OutBounds);
+	void LinkEntry(int32 EntryIndex);
+	void UnlinkEntry(int32 EntryIndex);
+	FIntVector ToCell(const FVector& Position) const;
+
+	double CellSize = 1000.;
+	bool bScanned = false;
+	uint32 QueryStamp = 0;
+
+	TSparseArray<FEntry> Entries;
+	TMap<TObjectKey<UPrimitiveComponent>, int32> ComponentToEntry;
+	TMap<FIntVector, TArray<int32>> Cells;
+	TArray<int32> LooseEntries;
+	TArray<int32> DirtyEntries;
+	TMap<TObjectKey<UBodySetup>, FBox> BodySetupBounds;
+
+	FDelegateHandle CreatePhysicsHandle;
+	FDelegateHandle DestroyPhysicsHandle;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 体素缓冲的编码，只依赖标准库，UE 模块和 Tools/VoxelBench 共用
+// 输入是 QueryVoxelGrids 输出的稠密布局：X*Y 列（x 在外层），每列 Z 方向按位存放（LSB 在前），补齐到整字节
+namespace tsvoxel
+{
+	// 取值与 voxel.proto 的 VoxelEncoding 一致
+	enum class Encoding : uint8_t
+	{
+		kDense = 0,
+		// 按 (x, y, z) 线性顺序（z 最快）交替记录空/占用的连续长度，从空开始，LEB128 变长整数；末尾的空段省略
+		kRleZ = 1,
+		// 占用体素的线性下标 (x*Y + y)*Z + z，uint32 小端，升序
+		kSparse = 2,
+		// 8x8x8 体素一块：先是块占用位图（块下标 (bx*BY + by)*BZ + bz，LSB 在前），再按块下标顺序存每个非空块的 64 字节
+		// 块内字节 lx*8 + ly 就是该列在这一块 Z 范围内的那个稠密字节
+		kBrick = 3,
+		// 服务端按统计信息选上面之一
+		kAuto = 4,
+	};
+
+	struct GridDims
+	{
+		int x = 0;
+		int y = 0;
+		int z = 0;
+
+		int zBytes() const { return (z + 7) / 8; }
+		size_t denseSize() const { return static_cast<size_t>(x) * y * zBytes(); }
+		uint64_t voxelCount() const { return static_cast<uint64_t>(x) * y * z; }
+	};
+
+	// 选编码用的统计，一次遍历得到
+	struct GridStats
+	{
+		uint64_t occupied = 0;
+		// 线性顺序下空/占用交替的段数
+		uint64_t runs = 0;
+		uint64_t non_empty_bricks = 0;
+	};
+
+	GridStats computeStats(const uint8_t* dense, const GridDims& dims);
+
+	// 各编码的大致字节数，RLE 按每段 2 字节估计
+	size_t estimateSize(Encoding encoding, const GridStats& stats, const GridDims& dims);
+
+	// 估计最小的编码；体素总数超出 uint32 时不选 kSparse
+	Encoding chooseEncoding(const GridStats& stats, const GridDims& dims);
+
+	// 把稠密缓冲编码到 out（覆盖原内容），返回实际使用的编码；kAuto 会先统计再选择
+	Encoding encode(Encoding encoding, const uint8_t* dense, const GridDims& dims, std::vector<uint8_t>& out);
+
+	// 解码回稠密布局，数据不合法时返回 false
+	bool decode(Encoding encoding, const uint8_t* data, size_t size, const GridDims& dims, std::vector<uint8_t>& dense);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+// 体素化的内层核函数，只依赖标准库，UE 模块和 Tools/VoxelBench 共用
+// 坐标都在体素盒空间下；扫描线的 Z 区间按一个 X 平面批量计算，内层循环不分配内存
+namespace tsvoxel
+{
+	struct Vec3
+	{
+		double x = 0;
+		double y = 0;
+		double z = 0;
+	};
+
+	// 有向盒：中心、三个单位轴、各轴半长
+	struct OrientedBox
+	{
+		Vec3 center;
+		Vec3 axes[3];
+		double half_extent[3] = {};
+	};
+
+	// 半空间 dot(normal, p) <= offset，normal 为单位向量；凸包是若干半空间的交
+	struct HalfSpace
+	{
+		Vec3 normal;
+		double offset = 0;
+	};
+
+	// 平面 x 上 count 条等距的 y 线：y_i = y0 + i*dy
+	struct ScanRow
+	{
+		double x = 0;
+		double y0 = 0;
+		double dy = 0;
+		int count = 0;
+	};
+
+	// 把一列的 Z 位 [begin, end) 置 1；column 指向该列第一个字节，列长 z_bytes 字节，LSB 在前
+	// 按 64 位字读改写，Z 不超过 64 的列一次写完
+	void fillZRange(uint8_t* column, int z_bytes, int begin, int end);
+
+	// 轴对齐盒与有向盒是否相交（含接触），分离轴定理的 15 条轴
+	bool aabbObbOverlap(const Vec3& aabb_min, const Vec3& aabb_max, const OrientedBox& box);
+
+	// 以下计算每条 y 线穿过形体的 Z 区间，写入 z_min[i]、z_max[i]；不相交时 z_min[i] > z_max[i]
+	void sphereSpans(const Vec3& center, double radius, const ScanRow& row, double* z_min, double* z_max);
+
+	// 胶囊体：线段 p0-p1 外扩 radius
+	void capsuleSpans(const Vec3& p0, const Vec3& p1, double radius, const ScanRow& row, double* z_min, double* z_max);
+
+	void boxSpans(const OrientedBox& box, const ScanRow& row, double* z_min, double* z_max);
+
+	// 凸包：num_planes 个半空间的交，num_planes 为 0 时区间为整条线
+	void convexSpans(const HalfSpace* planes, int num_planes, const ScanRow& row, double* z_min, double* z_max);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "voxel/voxel_raster.h"
+
+// 不依赖引擎的体素化：把基本形体写进稠密网格，TSVoxelGridFuncLib 和 Tools/VoxelBench 共用
+// 网格布局与 TSVoxelGridFuncLib::QueryVoxelGrids 的输出相同：体素盒中心为原点、轴对齐，x 在外层，
+// 每列 (x, y) 占 zBytes() 字节，Z 位 LSB 在前。过体素中心的 Z 向直线与形体的交落在该体素的 Z 范围内时置位
+// 形体坐标都在体素盒空间下；只做按位或，同一网格上写入顺序不影响结果
+namespace tsvoxel
+{
+	struct GridSpec
+	{
+		// 各轴体素数，均为正偶数（FVoxelBox 的 2*HalfNum）
+		int num_x = 0;
+		int num_y = 0;
+		int num_z = 0;
+		Vec3 voxel_size;
+
+		int zBytes() const { return (num_z + 7) / 8; }
+		size_t byteSize() const { return static_cast<size_t>(num_x) * num_y * zBytes(); }
+	};
+
+	// 列 (x_index, y_index) 上 Z 区间 [z_min, z_max] 覆盖的体素置位；区间为空、整段在网格上下方或列越界时返回 false
+	bool rasterizeSegment(const GridSpec& grid, int x_index, int y_index, double z_min, double z_max, uint8_t* voxels);
+
+	void rasterizeSphere(const GridSpec& grid, const Vec3& center, double radius, uint8_t* voxels);
+
+	// 胶囊体：线段 p0-p1 外扩 radius
+	void rasterizeCapsule(const GridSpec& grid, const Vec3& p0, const Vec3& p1, double radius, uint8_t* voxels);
+
+	// 与体素盒不相交时直接返回 false
+	bool rasterizeBox(const GridSpec& grid, const OrientedBox& box, uint8_t* voxels);
+
+	// 凸包：indices 每三个一组是一个三角面，面的绕向不要求一致；退化面忽略
+	void rasterizeConvex(const GridSpec& grid, const Vec3* vertices, int num_vertices, const int32_t* indices,
+	                     int num_indices, uint8_t* voxels);
+}
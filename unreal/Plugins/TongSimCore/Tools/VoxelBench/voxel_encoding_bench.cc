@@ -0,0 +1,315 @@
+// 体素编码压测：在几种典型场景上统计各编码的编码耗时、大小，以及 Zlib/LZ4 压缩后的大小
+// 场景直接在稠密缓冲上摆放轴对齐的盒子，布局与 QueryVoxelGrids 的输出一致；每种编码都会解码回来校验
+//   ./build/voxel_encoding_bench --x=512 --y=512 --z=64 --rounds=20 --seed=1
+#include "voxel/voxel_encoding.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef VOXEL_BENCH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef VOXEL_BENCH_LZ4
+#include <lz4.h>
+#endif
+
+namespace
+{
+	struct BenchOptions
+	{
+		int x = 512;
+		int y = 512;
+		int z = 64;
+		int rounds = 20;
+		uint32_t seed = 1;
+	};
+
+	BenchOptions g_options;
+
+	void printUsage()
+	{
+		std::printf("usage: voxel_encoding_bench [--x=512] [--y=512] [--z=64] [--rounds=20] [--seed=1]\n");
+	}
+
+	bool parseOptions(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const size_t eq = arg.find('=');
+			if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+			{
+				return false;
+			}
+			const std::string key = arg.substr(2, eq - 2);
+			const std::string value = arg.substr(eq + 1);
+			if (key == "x") options.x = std::atoi(value.c_str());
+			else if (key == "y") options.y = std::atoi(value.c_str());
+			else if (key == "z") options.z = std::atoi(value.c_str());
+			else if (key == "rounds") options.rounds = std::atoi(value.c_str());
+			else if (key == "seed") options.seed = static_cast<uint32_t>(std::atoll(value.c_str()));
+			else return false;
+		}
+		return options.x > 0 && options.y > 0 && options.z > 0 && options.rounds > 0;
+	}
+
+	class Scene
+	{
+	public:
+		explicit Scene(const tsvoxel::GridDims& dims) : dims_(dims), dense_(dims.denseSize(), 0)
+		{
+		}
+
+		// 闭区间，自动裁剪到网格内
+		void fillBox(int x0, int y0, int z0, int x1, int y1, int z1)
+		{
+			x0 = std::max(x0, 0), y0 = std::max(y0, 0), z0 = std::max(z0, 0);
+			x1 = std::min(x1, dims_.x - 1), y1 = std::min(y1, dims_.y - 1), z1 = std::min(z1, dims_.z - 1);
+			for (int x = x0; x <= x1; ++x)
+			{
+				for (int y = y0; y <= y1; ++y)
+				{
+					uint8_t* column = dense_.data() + (static_cast<size_t>(x) * dims_.y + y) * dims_.zBytes();
+					for (int z = z0; z <= z1; ++z)
+					{
+						column[z / 8] |= static_cast<uint8_t>(1u << (z % 8));
+					}
+				}
+			}
+		}
+
+		const std::vector<uint8_t>& dense() const { return dense_; }
+
+	private:
+		tsvoxel::GridDims dims_;
+		std::vector<uint8_t> dense_;
+	};
+
+	struct SceneSpec
+	{
+		const char* name;
+		std::function<void(Scene&, const tsvoxel::GridDims&, std::mt19937&)> build;
+	};
+
+	std::vector<SceneSpec> makeScenes()
+	{
+		return {
+			{"empty", [](Scene&, const tsvoxel::GridDims&, std::mt19937&) {}},
+			{"floor", [](Scene& scene, const tsvoxel::GridDims& d, std::mt19937&)
+			{
+				scene.fillBox(0, 0, 0, d.x - 1, d.y - 1, 1);
+			}},
+			// 室内：地面 + 每隔一段距离一堵墙（留门洞）+ 随机家具
+			{"indoor", [](Scene& scene, const tsvoxel::GridDims& d, std::mt19937& rng)
+			{
+				scene.fillBox(0, 0, 0, d.x - 1, d.y - 1, 1);
+				for (int wall = 64; wall < d.x; wall += 96)
+				{
+					scene.fillBox(wall, 0, 0, wall + 2, d.y - 1, d.z - 1);
+					scene.fillBox(wall, d.y / 2, 0, wall + 2, d.y / 2 + 12, d.z * 2 / 3);
+				}
+				std::uniform_int_distribution<int> px(0, d.x - 1), py(0, d.y - 1), size(3, 16), height(4, std::max(4, d.z / 2));
+				for (int i = 0; i < d.x * d.y / 2048; ++i)
+				{
+					const int x = px(rng), y = py(rng);
+					scene.fillBox(x, y, 2, x + size(rng), y + size(rng), height(rng));
+				}
+			}},
+			// 户外：地面 + 稀疏的细高障碍物（树干、路灯）
+			{"outdoor", [](Scene& scene, const tsvoxel::GridDims& d, std::mt19937& rng)
+			{
+				scene.fillBox(0, 0, 0, d.x - 1, d.y - 1, 0);
+				std::uniform_int_distribution<int> px(0, d.x - 1), py(0, d.y - 1), height(8, d.z - 1);
+				for (int i = 0; i < d.x * d.y / 1024; ++i)
+				{
+					const int x = px(rng), y = py(rng);
+					scene.fillBox(x, y, 1, x + 1, y + 1, height(rng));
+				}
+			}},
+			// 最坏情况：一半体素随机占用
+			{"noise", [](Scene& scene, const tsvoxel::GridDims& d, std::mt19937& rng)
+			{
+				std::bernoulli_distribution occupied(0.5);
+				for (int x = 0; x < d.x; ++x)
+					for (int y = 0; y < d.y; ++y)
+						for (int z = 0; z < d.z; ++z)
+							if (occupied(rng)) scene.fillBox(x, y, z, x, y, z);
+			}},
+		};
+	}
+
+	using Clock = std::chrono::steady_clock;
+
+	size_t zlibSize(const std::vector<uint8_t>& data)
+	{
+#ifdef VOXEL_BENCH_ZLIB
+		uLongf size = compressBound(static_cast<uLong>(data.size()));
+		std::vector<uint8_t> out(size);
+		compress2(out.data(), &size, data.data(), static_cast<uLong>(data.size()), Z_DEFAULT_COMPRESSION);
+		return size;
+#else
+		(void)data;
+		return 0;
+#endif
+	}
+
+	size_t lz4Size(const std::vector<uint8_t>& data)
+	{
+#ifdef VOXEL_BENCH_LZ4
+		std::vector<char> out(LZ4_compressBound(static_cast<int>(data.size())));
+		return static_cast<size_t>(LZ4_compress_default(reinterpret_cast<const char*>(data.data()), out.data(),
+			static_cast<int>(data.size()), static_cast<int>(out.size())));
+#else
+		(void)data;
+		return 0;
+#endif
+	}
+
+	// 原实现：逐字节访问，每字节一次除法、popcount 和块标记，用来校验 computeStats
+	tsvoxel::GridStats referenceStats(const uint8_t* dense, const tsvoxel::GridDims& dims)
+	{
+		tsvoxel::GridStats stats;
+		if (dims.denseSize() == 0)
+		{
+			return stats;
+		}
+		const int z_bytes = dims.zBytes();
+		const int last_bits = dims.z - (z_bytes - 1) * 8;
+		const int bricks_y = (dims.y + 7) / 8;
+		std::vector<uint8_t> brick_used(static_cast<size_t>((dims.x + 7) / 8) * bricks_y * z_bytes, 0);
+		stats.runs = 1;
+		bool previous = false;
+		for (int x = 0; x < dims.x; ++x)
+		{
+			for (int y = 0; y < dims.y; ++y)
+			{
+				const uint8_t* column = dense + (static_cast<size_t>(x) * dims.y + y) * z_bytes;
+				for (int b = 0; b < z_bytes; ++b)
+				{
+					const int bits = b + 1 == z_bytes ? last_bits : 8;
+					const uint8_t mask = bits >= 8 ? 0xFF : static_cast<uint8_t>((1u << bits) - 1);
+					const uint8_t value = column[b] & mask;
+					if (value)
+					{
+						brick_used[(static_cast<size_t>(x / 8) * bricks_y + y / 8) * z_bytes + b] = 1;
+					}
+					stats.occupied += static_cast<uint64_t>(std::popcount(value));
+					stats.runs += static_cast<uint64_t>((value & 1) != previous);
+					stats.runs += static_cast<uint64_t>(std::popcount(static_cast<uint8_t>((value ^ (value >> 1)) & (mask >> 1))));
+					previous = (value >> (bits - 1)) & 1;
+				}
+			}
+		}
+		if (!previous)
+		{
+			--stats.runs;
+		}
+		stats.non_empty_bricks = static_cast<uint64_t>(std::count(brick_used.begin(), brick_used.end(), 1));
+		return stats;
+	}
+
+	bool sameStats(const tsvoxel::GridStats& a, const tsvoxel::GridStats& b)
+	{
+		return a.occupied == b.occupied && a.runs == b.runs && a.non_empty_bricks == b.non_empty_bricks;
+	}
+
+	const char* encodingName(tsvoxel::Encoding encoding)
+	{
+		switch (encoding)
+		{
+		case tsvoxel::Encoding::kDense: return "dense";
+		case tsvoxel::Encoding::kRleZ: return "rle_z";
+		case tsvoxel::Encoding::kSparse: return "sparse";
+		case tsvoxel::Encoding::kBrick: return "brick";
+		default: return "auto";
+		}
+	}
+
+	bool runScene(const SceneSpec& spec, const tsvoxel::GridDims& dims, std::mt19937& rng)
+	{
+		Scene scene(dims);
+		spec.build(scene, dims, rng);
+		const std::vector<uint8_t>& dense = scene.dense();
+		const tsvoxel::GridStats stats = tsvoxel::computeStats(dense.data(), dims);
+		std::printf("[%s] occupied=%.2f%% runs=%llu bricks=%llu\n", spec.name,
+			100.0 * static_cast<double>(stats.occupied) / static_cast<double>(dims.voxelCount()),
+			static_cast<unsigned long long>(stats.runs), static_cast<unsigned long long>(stats.non_empty_bricks));
+
+		// AUTO 的额外开销就是这一次统计
+		tsvoxel::GridStats reference;
+		auto start = Clock::now();
+		for (int i = 0; i < g_options.rounds; ++i)
+		{
+			reference = referenceStats(dense.data(), dims);
+		}
+		const double reference_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / g_options.rounds;
+		start = Clock::now();
+		for (int i = 0; i < g_options.rounds; ++i)
+		{
+			tsvoxel::computeStats(dense.data(), dims);
+		}
+		const double stats_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / g_options.rounds;
+		bool ok = sameStats(stats, reference);
+		std::printf("  %-14s reference=%8.3fms word=%8.3fms %s\n", "stats", reference_ms, stats_ms, ok ? "ok" : "MISMATCH");
+
+		std::vector<uint8_t> encoded;
+		std::vector<uint8_t> decoded;
+		for (const tsvoxel::Encoding encoding : {tsvoxel::Encoding::kDense, tsvoxel::Encoding::kRleZ, tsvoxel::Encoding::kSparse,
+		                                         tsvoxel::Encoding::kBrick, tsvoxel::Encoding::kAuto})
+		{
+			tsvoxel::Encoding used = encoding;
+			const auto start = Clock::now();
+			for (int i = 0; i < g_options.rounds; ++i)
+			{
+				used = tsvoxel::encode(encoding, dense.data(), dims, encoded);
+			}
+			const double encode_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / g_options.rounds;
+
+			const auto decode_start = Clock::now();
+			const bool decoded_ok = tsvoxel::decode(used, encoded.data(), encoded.size(), dims, decoded);
+			const double decode_ms = std::chrono::duration<double, std::milli>(Clock::now() - decode_start).count();
+			const bool match = decoded_ok && decoded == dense;
+			ok = ok && match;
+
+			char label[32];
+			std::snprintf(label, sizeof(label), encoding == tsvoxel::Encoding::kAuto ? "auto->%s" : "%s", encodingName(used));
+			std::printf("  %-14s size=%10zu (%6.2f%%) encode=%8.3fms decode=%8.3fms zlib=%9zu lz4=%9zu %s\n",
+				label, encoded.size(), 100.0 * static_cast<double>(encoded.size()) / static_cast<double>(dense.size()),
+				encode_ms, decode_ms, zlibSize(encoded), lz4Size(encoded), match ? "ok" : "MISMATCH");
+		}
+		return ok;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (!parseOptions(argc, argv, g_options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	const tsvoxel::GridDims dims{g_options.x, g_options.y, g_options.z};
+	std::printf("grid %dx%dx%d dense=%zu bytes rounds=%d\n", dims.x, dims.y, dims.z, dims.denseSize(), g_options.rounds);
+#ifndef VOXEL_BENCH_ZLIB
+	std::printf("zlib not found, zlib column is 0\n");
+#endif
+#ifndef VOXEL_BENCH_LZ4
+	std::printf("liblz4 not found, lz4 column is 0\n");
+#endif
+	std::mt19937 rng(g_options.seed);
+	bool ok = true;
+	for (const SceneSpec& spec : makeScenes())
+	{
+		ok = runScene(spec, dims, rng) && ok;
+	}
+	return ok ? 0 : 2;
+}
@@ -0,0 +1,498 @@
+// 体素化核函数的校验与压测：随机形体上把 voxel_raster 的结果和参考实现比对，再统计耗时
+//   fill    Z 区间置位，参考实现是原 FixVoxelGridsWithSegment 的逐字节写法
+//   overlap 轴对齐盒与有向盒相交，参考实现是原 AABBOverlap 的 24 条棱线段求交
+//   spans   球/胶囊/盒/凸包的扫描线 Z 区间，参考实现沿列二分求形体的有向距离为 0 的点
+//   ./build/voxel_raster_bench --cases=20000 --rounds=20 --seed=1
+#include "voxel/voxel_raster.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct BenchOptions
+	{
+		int cases = 20000;
+		int rounds = 20;
+		uint32_t seed = 1;
+	};
+
+	BenchOptions g_options;
+
+	void printUsage()
+	{
+		std::printf("usage: voxel_raster_bench [--cases=20000] [--rounds=20] [--seed=1]\n");
+	}
+
+	bool parseOptions(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const size_t eq = arg.find('=');
+			if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+			{
+				return false;
+			}
+			const std::string key = arg.substr(2, eq - 2);
+			const std::string value = arg.substr(eq + 1);
+			if (key == "cases") options.cases = std::atoi(value.c_str());
+			else if (key == "rounds") options.rounds = std::atoi(value.c_str());
+			else if (key == "seed") options.seed = static_cast<uint32_t>(std::atoll(value.c_str()));
+			else return false;
+		}
+		return options.cases > 0 && options.rounds > 0;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	using tsvoxel::Vec3;
+
+	double elapsedNs(Clock::time_point start, double count)
+	{
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+	}
+
+	Vec3 add(const Vec3& a, const Vec3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+	Vec3 sub(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+	Vec3 mul(const Vec3& a, double s) { return {a.x * s, a.y * s, a.z * s}; }
+	double dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	double length(const Vec3& a) { return std::sqrt(dot(a, a)); }
+
+	Vec3 randomUnit(std::mt19937& rng)
+	{
+		std::normal_distribution<double> normal;
+		Vec3 v{normal(rng), normal(rng), normal(rng)};
+		return mul(v, 1 / std::max(length(v), 1e-12));
+	}
+
+	// 随机正交基；一部分轴对齐或只绕 Z 旋转，覆盖平行的退化情况
+	void randomAxes(std::mt19937& rng, Vec3 axes[3])
+	{
+		std::uniform_int_distribution<int> kind(0, 3);
+		std::uniform_real_distribution<double> angle(0, 6.283185307179586);
+		switch (kind(rng))
+		{
+		case 0:
+			axes[0] = {1, 0, 0}, axes[1] = {0, 1, 0}, axes[2] = {0, 0, 1};
+			return;
+		case 1:
+		{
+			const double a = angle(rng);
+			axes[0] = {std::cos(a), std::sin(a), 0}, axes[1] = {-std::sin(a), std::cos(a), 0}, axes[2] = {0, 0, 1};
+			return;
+		}
+		default:
+		{
+			const Vec3 x = randomUnit(rng);
+			Vec3 y = randomUnit(rng);
+			y = sub(y, mul(x, dot(x, y)));
+			y = mul(y, 1 / std::max(length(y), 1e-12));
+			axes[0] = x;
+			axes[1] = y;
+			axes[2] = {x.y * y.z - x.z * y.y, x.z * y.x - x.x * y.z, x.x * y.y - x.y * y.x};
+		}
+		}
+	}
+
+	// ---------- fill ----------
+
+	// 原实现：首尾字节按位补，中间逐字节写 0xFF；[z_min, z_max] 闭区间
+	void referenceFill(uint8_t* column, int z_min, int z_max)
+	{
+		const int start = z_min / 8 + 1;
+		const int end = z_max / 8;
+		const int start_bit = z_min % 8;
+		const int end_bit = z_max % 8;
+		for (int byte = start; byte < end; ++byte)
+		{
+			column[byte] = 0xFF;
+		}
+		if (start <= end)
+		{
+			column[start - 1] |= static_cast<uint8_t>(0xFF << start_bit);
+			column[end] |= static_cast<uint8_t>(0xFF >> (7 - end_bit));
+		}
+		else
+		{
+			column[start - 1] |= static_cast<uint8_t>((0xFF << start_bit) & (0xFF >> (7 - end_bit)));
+		}
+	}
+
+	bool runFill(std::mt19937& rng)
+	{
+		bool ok = true;
+		for (const int z : {8, 32, 64, 100, 256, 1024})
+		{
+			const int z_bytes = (z + 7) / 8;
+			std::uniform_int_distribution<int> pick(0, z - 1);
+			std::vector<std::pair<int, int>> ranges(g_options.cases);
+			for (auto& range : ranges)
+			{
+				range = std::minmax(pick(rng), pick(rng));
+			}
+
+			std::vector<uint8_t> expected(z_bytes), actual(z_bytes);
+			int mismatches = 0;
+			for (const auto& [lo, hi] : ranges)
+			{
+				std::fill(expected.begin(), expected.end(), 0x20);
+				std::fill(actual.begin(), actual.end(), 0x20);
+				referenceFill(expected.data(), lo, hi);
+				tsvoxel::fillZRange(actual.data(), z_bytes, lo, hi + 1);
+				mismatches += expected != actual;
+			}
+
+			// 各区间写进相邻的列，模拟一次体素化里的写入模式
+			// 两种实现逐轮交替计时、各取最快一轮，单核或有其他负载时先后顺序不会偏向某一边
+			std::vector<uint8_t> grid(static_cast<size_t>(z_bytes) * ranges.size());
+			double reference_ns = std::numeric_limits<double>::infinity();
+			double fill_ns = std::numeric_limits<double>::infinity();
+			for (int r = 0; r < g_options.rounds; ++r)
+			{
+				auto start = Clock::now();
+				for (size_t i = 0; i < ranges.size(); ++i)
+				{
+					referenceFill(grid.data() + i * z_bytes, ranges[i].first, ranges[i].second);
+				}
+				reference_ns = std::min(reference_ns, elapsedNs(start, static_cast<double>(ranges.size())));
+				start = Clock::now();
+				for (size_t i = 0; i < ranges.size(); ++i)
+				{
+					tsvoxel::fillZRange(grid.data() + i * z_bytes, z_bytes, ranges[i].first, ranges[i].second + 1);
+				}
+				fill_ns = std::min(fill_ns, elapsedNs(start, static_cast<double>(ranges.size())));
+			}
+
+			std::printf("  fill    z=%-5d reference=%7.2fns word=%7.2fns speedup=%5.2fx %s\n", z, reference_ns, fill_ns,
+				reference_ns / fill_ns, mismatches ? "MISMATCH" : "ok");
+			ok = ok && !mismatches;
+		}
+		return ok;
+	}
+
+	// ---------- overlap ----------
+
+	// 线段与轴对齐盒相交（含端点在盒内），同 FMath::LineBoxIntersection
+	bool segmentBoxIntersect(const Vec3& box_min, const Vec3& box_max, const Vec3& p0, const Vec3& p1)
+	{
+		const double start[3] = {p0.x, p0.y, p0.z};
+		const double dir[3] = {p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+		const double lo[3] = {box_min.x, box_min.y, box_min.z};
+		const double hi[3] = {box_max.x, box_max.y, box_max.z};
+		double t_min = 0, t_max = 1;
+		for (int k = 0; k < 3; ++k)
+		{
+			if (std::abs(dir[k]) < 1e-12)
+			{
+				if (start[k] < lo[k] || start[k] > hi[k])
+				{
+					return false;
+				}
+				continue;
+			}
+			double t0 = (lo[k] - start[k]) / dir[k];
+			double t1 = (hi[k] - start[k]) / dir[k];
+			if (t0 > t1) std::swap(t0, t1);
+			t_min = std::max(t_min, t0);
+			t_max = std::min(t_max, t1);
+			if (t_min > t_max)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void boxCorners(const tsvoxel::OrientedBox& box, Vec3 corners[8])
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			Vec3 p = box.center;
+			for (int k = 0; k < 3; ++k)
+			{
+				p = add(p, mul(box.axes[k], (i >> k & 1 ? 1 : -1) * box.half_extent[k]));
+			}
+			corners[i] = p;
+		}
+	}
+
+	// 原实现：有向盒的 12 条棱与轴对齐盒求交，再把轴对齐盒的棱变换到有向盒空间求交
+	bool referenceOverlap(const Vec3& aabb_min, const Vec3& aabb_max, const tsvoxel::OrientedBox& box)
+	{
+		static constexpr int kEdges[12][2] = {{0, 1}, {2, 3}, {4, 5}, {6, 7}, {0, 2}, {1, 3}, {4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+		Vec3 corners[8];
+		boxCorners(box, corners);
+		for (const auto& edge : kEdges)
+		{
+			if (segmentBoxIntersect(aabb_min, aabb_max, corners[edge[0]], corners[edge[1]]))
+			{
+				return true;
+			}
+		}
+
+		tsvoxel::OrientedBox aabb;
+		aabb.center = mul(add(aabb_min, aabb_max), 0.5);
+		aabb.axes[0] = {1, 0, 0}, aabb.axes[1] = {0, 1, 0}, aabb.axes[2] = {0, 0, 1};
+		aabb.half_extent[0] = (aabb_max.x - aabb_min.x) / 2;
+		aabb.half_extent[1] = (aabb_max.y - aabb_min.y) / 2;
+		aabb.half_extent[2] = (aabb_max.z - aabb_min.z) / 2;
+		boxCorners(aabb, corners);
+		const Vec3 local_max{box.half_extent[0], box.half_extent[1], box.half_extent[2]};
+		const Vec3 local_min = mul(local_max, -1);
+		for (Vec3& corner : corners)
+		{
+			const Vec3 d = sub(corner, box.center);
+			corner = {dot(d, box.axes[0]), dot(d, box.axes[1]), dot(d, box.axes[2])};
+		}
+		for (const auto& edge : kEdges)
+		{
+			if (segmentBoxIntersect(local_min, local_max, corners[edge[0]], corners[edge[1]]))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool runOverlap(std::mt19937& rng)
+	{
+		// 体素盒固定为 [-50, 50]^3，碰撞体随机分布在周围，约一半相交
+		const Vec3 aabb_min{-50, -50, -50}, aabb_max{50, 50, 50};
+		std::uniform_real_distribution<double> position(-120, 120), extent(1, 60);
+		std::vector<tsvoxel::OrientedBox> boxes(g_options.cases);
+		for (auto& box : boxes)
+		{
+			box.center = {position(rng), position(rng), position(rng)};
+			randomAxes(rng, box.axes);
+			for (double& half : box.half_extent) half = extent(rng);
+		}
+
+		int mismatches = 0, overlapped = 0;
+		for (const auto& box : boxes)
+		{
+			const bool expected = referenceOverlap(aabb_min, aabb_max, box);
+			overlapped += expected;
+			mismatches += expected != tsvoxel::aabbObbOverlap(aabb_min, aabb_max, box);
+		}
+
+		int sink = 0;
+		auto start = Clock::now();
+		for (int r = 0; r < g_options.rounds; ++r)
+			for (const auto& box : boxes)
+				sink += referenceOverlap(aabb_min, aabb_max, box);
+		const double reference_ns = elapsedNs(start, static_cast<double>(g_options.rounds) * boxes.size());
+		start = Clock::now();
+		for (int r = 0; r < g_options.rounds; ++r)
+			for (const auto& box : boxes)
+				sink += tsvoxel::aabbObbOverlap(aabb_min, aabb_max, box);
+		const double sat_ns = elapsedNs(start, static_cast<double>(g_options.rounds) * boxes.size());
+
+		std::printf("  overlap overlapped=%.1f%% reference=%7.2fns sat=%7.2fns speedup=%5.2fx mismatches=%d %s (%d)\n",
+			100.0 * overlapped / boxes.size(), reference_ns, sat_ns, reference_ns / sat_ns, mismatches,
+			mismatches ? "MISMATCH" : "ok", sink & 1);
+		return !mismatches;
+	}
+
+	// ---------- spans ----------
+
+	// 各形体的有向距离（内部为负），沿任意直线都是凸函数
+	struct Shape
+	{
+		const char* name;
+		std::function<double(const Vec3&)> distance;
+		std::function<void(const tsvoxel::ScanRow&, double*, double*)> spans;
+		double z_lo;
+		double z_hi;
+	};
+
+	double segmentDistance(const Vec3& p, const Vec3& a, const Vec3& b)
+	{
+		const Vec3 ab = sub(b, a);
+		const double len2 = dot(ab, ab);
+		const double t = len2 > 0 ? std::clamp(dot(sub(p, a), ab) / len2, 0.0, 1.0) : 0.0;
+		return length(sub(p, add(a, mul(ab, t))));
+	}
+
+	Shape randomShape(int kind, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<double> position(-40, 40), size(2, 40);
+		const Vec3 center{position(rng), position(rng), position(rng)};
+		if (kind == 0)
+		{
+			const double radius = size(rng);
+			return {"sphere",
+				[=](const Vec3& p) { return length(sub(p, center)) - radius; },
+				[=](const tsvoxel::ScanRow& row, double* lo, double* hi) { tsvoxel::sphereSpans(center, radius, row, lo, hi); },
+				center.z - radius, center.z + radius};
+		}
+		if (kind == 1)
+		{
+			const double radius = size(rng) / 2;
+			Vec3 axes[3];
+			randomAxes(rng, axes);
+			const Vec3 half_axis = mul(axes[2], size(rng));
+			const Vec3 p0 = sub(center, half_axis), p1 = add(center, half_axis);
+			return {"capsule",
+				[=](const Vec3& p) { return segmentDistance(p, p0, p1) - radius; },
+				[=](const tsvoxel::ScanRow& row, double* lo, double* hi) { tsvoxel::capsuleSpans(p0, p1, radius, row, lo, hi); },
+				std::min(p0.z, p1.z) - radius, std::max(p0.z, p1.z) + radius};
+		}
+		if (kind == 3)
+		{
+			// 外切于球的随机半空间，再加上外接盒的 6 个面保证有界；max(dot(n, p) - offset) 在内部为负
+			const double radius = size(rng) / 2;
+			std::vector<tsvoxel::HalfSpace> planes;
+			for (int k = 0; k < 12; ++k)
+			{
+				const Vec3 n = randomUnit(rng);
+				planes.push_back({n, dot(n, center) + radius});
+			}
+			for (int k = 0; k < 6; ++k)
+			{
+				const double sign = k < 3 ? 1 : -1;
+				const Vec3 n = k % 3 == 0 ? Vec3{sign, 0, 0} : k % 3 == 1 ? Vec3{0, sign, 0} : Vec3{0, 0, sign};
+				planes.push_back({n, dot(n, center) + radius * 1.5});
+			}
+			return {"convex",
+				[=](const Vec3& p)
+				{
+					double distance = -1e300;
+					for (const auto& plane : planes) distance = std::max(distance, dot(plane.normal, p) - plane.offset);
+					return distance;
+				},
+				[=](const tsvoxel::ScanRow& row, double* lo, double* hi)
+				{
+					tsvoxel::convexSpans(planes.data(), static_cast<int>(planes.size()), row, lo, hi);
+				},
+				center.z - radius * 1.5, center.z + radius * 1.5};
+		}
+		tsvoxel::OrientedBox box;
+		box.center = center;
+		randomAxes(rng, box.axes);
+		for (double& half : box.half_extent) half = size(rng) / 2;
+		const double reach = length(Vec3{box.half_extent[0], box.half_extent[1], box.half_extent[2]});
+		return {"box",
+			[=](const Vec3& p)
+			{
+				const Vec3 d = sub(p, box.center);
+				double distance = -1e300;
+				for (int k = 0; k < 3; ++k) distance = std::max(distance, std::abs(dot(d, box.axes[k])) - box.half_extent[k]);
+				return distance;
+			},
+			[=](const tsvoxel::ScanRow& row, double* lo, double* hi) { tsvoxel::boxSpans(box, row, lo, hi); },
+			center.z - reach, center.z + reach};
+	}
+
+	// 参考实现：三分找列上距离最小的点，再向两侧二分出边界；返回 false 表示不相交或只擦边
+	bool referenceSpan(const Shape& shape, double x, double y, double& lo, double& hi)
+	{
+		const auto f = [&](double z) { return shape.distance(Vec3{x, y, z}); };
+		double a = shape.z_lo - 1, b = shape.z_hi + 1;
+		for (int i = 0; i < 200; ++i)
+		{
+			const double m1 = a + (b - a) / 3, m2 = b - (b - a) / 3;
+			if (f(m1) < f(m2)) b = m2;
+			else a = m1;
+		}
+		const double inside = (a + b) / 2;
+		if (f(inside) > -1e-6)
+		{
+			return false;
+		}
+		double l = shape.z_lo - 1, r = inside;
+		for (int i = 0; i < 100; ++i)
+		{
+			const double m = (l + r) / 2;
+			if (f(m) > 0) l = m;
+			else r = m;
+		}
+		lo = r;
+		l = inside, r = shape.z_hi + 1;
+		for (int i = 0; i < 100; ++i)
+		{
+			const double m = (l + r) / 2;
+			if (f(m) > 0) r = m;
+			else l = m;
+		}
+		hi = l;
+		return true;
+	}
+
+	bool runSpans(std::mt19937& rng)
+	{
+		constexpr int kLines = 64;
+		constexpr double kGraze = 0.05;
+		const int shapes = std::max(1, g_options.cases / 100);
+		bool ok = true;
+		for (int kind = 0; kind < 4; ++kind)
+		{
+			const char* name = nullptr;
+			int mismatches = 0, columns = 0, hits = 0;
+			double zone_ns = 0;
+			std::vector<double> lo(kLines), hi(kLines);
+			for (int s = 0; s < shapes; ++s)
+			{
+				const Shape shape = randomShape(kind, rng);
+				name = shape.name;
+				for (int plane = 0; plane < 16; ++plane)
+				{
+					const tsvoxel::ScanRow row{-60 + plane * 7.5 + 0.25, -63, 2, kLines};
+					shape.spans(row, lo.data(), hi.data());
+					for (int i = 0; i < kLines; ++i, ++columns)
+					{
+						double expected_lo, expected_hi;
+						const bool expected = referenceSpan(shape, row.x, row.y0 + i * row.dy, expected_lo, expected_hi);
+						const bool actual = lo[i] <= hi[i];
+						hits += expected;
+						if (expected != actual)
+						{
+							// 只在擦边（区间很短）时允许判定不同
+							mismatches += actual ? hi[i] - lo[i] > kGraze : expected_hi - expected_lo > kGraze;
+							continue;
+						}
+						if (expected && (std::abs(lo[i] - expected_lo) > 1e-6 || std::abs(hi[i] - expected_hi) > 1e-6))
+						{
+							++mismatches;
+						}
+					}
+
+					const auto start = Clock::now();
+					for (int r = 0; r < g_options.rounds; ++r)
+					{
+						shape.spans(row, lo.data(), hi.data());
+					}
+					zone_ns += elapsedNs(start, static_cast<double>(g_options.rounds) * kLines);
+				}
+			}
+			std::printf("  spans   %-7s columns=%d hit=%.1f%% %7.2fns/column mismatches=%d %s\n", name, columns,
+				100.0 * hits / columns, zone_ns / (shapes * 16), mismatches, mismatches ? "MISMATCH" : "ok");
+			ok = ok && !mismatches;
+		}
+		return ok;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (!parseOptions(argc, argv, g_options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::printf("cases=%d rounds=%d seed=%u\n", g_options.cases, g_options.rounds, g_options.seed);
+	std::mt19937 rng(g_options.seed);
+	bool ok = runFill(rng);
+	ok = runOverlap(rng) && ok;
+	ok = runSpans(rng) && ok;
+	return ok ? 0 : 2;
+}
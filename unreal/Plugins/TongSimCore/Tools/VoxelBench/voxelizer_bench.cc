@@ -0,0 +1,425 @@
+// 无引擎体素化的校验与压测：随机生成一堆球/胶囊/盒/凸包，用 tsvoxel::rasterize* 写进 N^3 的网格
+//   校验  与参考实现逐字节比对：参考实现不做 X/Y 范围裁剪，逐列调用单列的 Z 区间核函数；
+//         另把每个盒子转成 12 个三角面的凸包，与 rasterizeBox 的结果比对。核函数本身由 voxel_raster_bench 校验
+//   压测  同一堆形体在各分辨率下体素化，取多轮中最快的一轮，报告网格体素数/秒和每个形体的耗时
+//   ./build/voxelizer_bench --sizes=64,128,256,512 --primitives=256 --rounds=5 --seed=1
+//   --min-mvoxels=N 时任一分辨率低于 N 百万体素/秒即返回 3，可用于固定机器上的性能回归检查
+#include "voxel/voxelizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct BenchOptions
+	{
+		std::vector<int> sizes = {64, 128, 256, 512};
+		int primitives = 256;
+		int rounds = 5;
+		uint32_t seed = 1;
+		double min_mvoxels = 0;
+	};
+
+	BenchOptions g_options;
+
+	void printUsage()
+	{
+		std::printf("usage: voxelizer_bench [--sizes=64,128,256,512] [--primitives=256] [--rounds=5] [--seed=1] "
+			"[--min-mvoxels=0]\n");
+	}
+
+	bool parseSizes(const std::string& value, std::vector<int>& sizes)
+	{
+		sizes.clear();
+		std::stringstream stream(value);
+		std::string item;
+		while (std::getline(stream, item, ','))
+		{
+			const int size = std::atoi(item.c_str());
+			// 网格各轴体素数必须是正偶数
+			if (size <= 0 || size % 2)
+			{
+				return false;
+			}
+			sizes.push_back(size);
+		}
+		return !sizes.empty();
+	}
+
+	bool parseOptions(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const size_t eq = arg.find('=');
+			if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+			{
+				return false;
+			}
+			const std::string key = arg.substr(2, eq - 2);
+			const std::string value = arg.substr(eq + 1);
+			if (key == "sizes")
+			{
+				if (!parseSizes(value, options.sizes)) return false;
+			}
+			else if (key == "primitives") options.primitives = std::atoi(value.c_str());
+			else if (key == "rounds") options.rounds = std::atoi(value.c_str());
+			else if (key == "seed") options.seed = static_cast<uint32_t>(std::atoll(value.c_str()));
+			else if (key == "min-mvoxels") options.min_mvoxels = std::atof(value.c_str());
+			else return false;
+		}
+		return options.primitives > 0 && options.rounds > 0;
+	}
+
+	using Clock = std::chrono::steady_clock;
+	using tsvoxel::Vec3;
+
+	Vec3 add(const Vec3& a, const Vec3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+	Vec3 sub(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+	Vec3 mul(const Vec3& a, double s) { return {a.x * s, a.y * s, a.z * s}; }
+	double dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	Vec3 cross(const Vec3& a, const Vec3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+	double length(const Vec3& a) { return std::sqrt(dot(a, a)); }
+
+	Vec3 randomUnit(std::mt19937& rng)
+	{
+		std::normal_distribution<double> normal;
+		Vec3 v{normal(rng), normal(rng), normal(rng)};
+		return mul(v, 1 / std::max(length(v), 1e-12));
+	}
+
+	// 随机正交基；一部分轴对齐或只绕 Z 旋转，和场景里常见的摆放一致
+	void randomAxes(std::mt19937& rng, Vec3 axes[3])
+	{
+		std::uniform_int_distribution<int> kind(0, 3);
+		std::uniform_real_distribution<double> angle(0, 6.283185307179586);
+		switch (kind(rng))
+		{
+		case 0:
+			axes[0] = {1, 0, 0}, axes[1] = {0, 1, 0}, axes[2] = {0, 0, 1};
+			return;
+		case 1:
+		{
+			const double a = angle(rng);
+			axes[0] = {std::cos(a), std::sin(a), 0}, axes[1] = {-std::sin(a), std::cos(a), 0}, axes[2] = {0, 0, 1};
+			return;
+		}
+		default:
+		{
+			const Vec3 x = randomUnit(rng);
+			Vec3 y = randomUnit(rng);
+			y = sub(y, mul(x, dot(x, y)));
+			y = mul(y, 1 / std::max(length(y), 1e-12));
+			axes[0] = x;
+			axes[1] = y;
+			axes[2] = cross(x, y);
+		}
+		}
+	}
+
+	// ---------- 形体 ----------
+
+	enum class Kind
+	{
+		Sphere,
+		Capsule,
+		Box,
+		Convex,
+	};
+
+	constexpr const char* kKindNames[] = {"sphere", "capsule", "box", "convex"};
+	constexpr int kNumKinds = 4;
+
+	struct Primitive
+	{
+		Kind kind = Kind::Sphere;
+		Vec3 p0;
+		Vec3 p1;
+		double radius = 0;
+		tsvoxel::OrientedBox box;
+		std::vector<Vec3> vertices;
+		std::vector<int32_t> indices;
+	};
+
+	// 正二十面体，凸包的模板
+	constexpr double kPhi = 1.618033988749895;
+	const Vec3 kIcosahedronVertices[12] = {
+		{-1, kPhi, 0}, {1, kPhi, 0}, {-1, -kPhi, 0}, {1, -kPhi, 0}, {0, -1, kPhi}, {0, 1, kPhi},
+		{0, -1, -kPhi}, {0, 1, -kPhi}, {kPhi, 0, -1}, {kPhi, 0, 1}, {-kPhi, 0, -1}, {-kPhi, 0, 1},
+	};
+	constexpr int32_t kIcosahedronIndices[60] = {
+		0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+		3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+	};
+
+	// 盒子的 8 个角点和 12 个三角面；角点 i 的第 k 位决定沿第 k 轴取正还是负
+	void boxHull(const tsvoxel::OrientedBox& box, std::vector<Vec3>& vertices, std::vector<int32_t>& indices)
+	{
+		vertices.clear();
+		for (int i = 0; i < 8; ++i)
+		{
+			Vec3 p = box.center;
+			for (int k = 0; k < 3; ++k)
+			{
+				p = add(p, mul(box.axes[k], (i >> k & 1 ? 1 : -1) * box.half_extent[k]));
+			}
+			vertices.push_back(p);
+		}
+		indices = {0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6, 0, 1, 5, 0, 5, 4, 2, 6, 7, 2, 7, 3, 0, 4, 6, 0, 6, 2, 1, 3, 7, 1, 7, 5};
+	}
+
+	// 体素盒为 [-50, 50]^3（FVoxelBox 的默认尺寸），形体分布在周围，一部分伸出盒外
+	std::vector<Primitive> generateSoup(std::mt19937& rng, int count)
+	{
+		std::uniform_real_distribution<double> position(-60, 60), size(1, 12), unit(0.5, 1.5);
+		std::uniform_int_distribution<int> kind(0, kNumKinds - 1);
+		std::vector<Primitive> soup(count);
+		for (Primitive& primitive : soup)
+		{
+			primitive.kind = static_cast<Kind>(kind(rng));
+			const Vec3 center{position(rng), position(rng), position(rng)};
+			Vec3 axes[3];
+			randomAxes(rng, axes);
+			switch (primitive.kind)
+			{
+			case Kind::Sphere:
+				primitive.p0 = center;
+				primitive.radius = size(rng);
+				break;
+			case Kind::Capsule:
+			{
+				const Vec3 half_axis = mul(axes[2], size(rng));
+				primitive.p0 = sub(center, half_axis);
+				primitive.p1 = add(center, half_axis);
+				primitive.radius = size(rng) / 2;
+				break;
+			}
+			case Kind::Box:
+				primitive.box.center = center;
+				std::copy(axes, axes + 3, primitive.box.axes);
+				for (double& half : primitive.box.half_extent) half = size(rng);
+				break;
+			case Kind::Convex:
+			{
+				const double scale[3] = {size(rng) / kPhi * unit(rng), size(rng) / kPhi * unit(rng), size(rng) / kPhi * unit(rng)};
+				for (const Vec3& v : kIcosahedronVertices)
+				{
+					primitive.vertices.push_back(add(center, add(add(mul(axes[0], v.x * scale[0]), mul(axes[1], v.y * scale[1])),
+						mul(axes[2], v.z * scale[2]))));
+				}
+				primitive.indices.assign(std::begin(kIcosahedronIndices), std::end(kIcosahedronIndices));
+				break;
+			}
+			}
+		}
+		return soup;
+	}
+
+	void rasterize(const tsvoxel::GridSpec& grid, const Primitive& primitive, uint8_t* voxels)
+	{
+		switch (primitive.kind)
+		{
+		case Kind::Sphere:
+			tsvoxel::rasterizeSphere(grid, primitive.p0, primitive.radius, voxels);
+			break;
+		case Kind::Capsule:
+			tsvoxel::rasterizeCapsule(grid, primitive.p0, primitive.p1, primitive.radius, voxels);
+			break;
+		case Kind::Box:
+			tsvoxel::rasterizeBox(grid, primitive.box, voxels);
+			break;
+		case Kind::Convex:
+			tsvoxel::rasterizeConvex(grid, primitive.vertices.data(), static_cast<int>(primitive.vertices.size()),
+				primitive.indices.data(), static_cast<int>(primitive.indices.size()), voxels);
+			break;
+		}
+	}
+
+	// ---------- 校验 ----------
+
+	double voxelCenter(int index, int num, double size)
+	{
+		return (index - num / 2 + 0.5) * size;
+	}
+
+	// 参考实现：每一列都单独计算 Z 区间，不做任何范围裁剪
+	void referenceRasterize(const tsvoxel::GridSpec& grid, const Primitive& primitive, uint8_t* voxels)
+	{
+		std::vector<tsvoxel::HalfSpace> planes;
+		if (primitive.kind == Kind::Convex)
+		{
+			Vec3 centroid;
+			for (const Vec3& v : primitive.vertices) centroid = add(centroid, v);
+			centroid = mul(centroid, 1.0 / primitive.vertices.size());
+			for (size_t i = 0; i < primitive.indices.size(); i += 3)
+			{
+				const Vec3& a = primitive.vertices[primitive.indices[i]];
+				Vec3 n = cross(sub(primitive.vertices[primitive.indices[i + 1]], a), sub(primitive.vertices[primitive.indices[i + 2]], a));
+				n = mul(n, 1 / length(n));
+				const double offset = dot(n, a);
+				planes.push_back(dot(n, centroid) > offset ? tsvoxel::HalfSpace{mul(n, -1), -offset} : tsvoxel::HalfSpace{n, offset});
+			}
+		}
+
+		for (int x = 0; x < grid.num_x; ++x)
+		{
+			for (int y = 0; y < grid.num_y; ++y)
+			{
+				const tsvoxel::ScanRow row{
+					voxelCenter(x, grid.num_x, grid.voxel_size.x), voxelCenter(y, grid.num_y, grid.voxel_size.y), grid.voxel_size.y, 1
+				};
+				double z_min, z_max;
+				switch (primitive.kind)
+				{
+				case Kind::Sphere:
+					tsvoxel::sphereSpans(primitive.p0, primitive.radius, row, &z_min, &z_max);
+					break;
+				case Kind::Capsule:
+					tsvoxel::capsuleSpans(primitive.p0, primitive.p1, primitive.radius, row, &z_min, &z_max);
+					break;
+				case Kind::Box:
+					tsvoxel::boxSpans(primitive.box, row, &z_min, &z_max);
+					break;
+				case Kind::Convex:
+					tsvoxel::convexSpans(planes.data(), static_cast<int>(planes.size()), row, &z_min, &z_max);
+					break;
+				}
+				tsvoxel::rasterizeSegment(grid, x, y, z_min, z_max, voxels);
+			}
+		}
+	}
+
+	int64_t countBits(const std::vector<uint8_t>& voxels)
+	{
+		int64_t bits = 0;
+		for (const uint8_t byte : voxels) bits += __builtin_popcount(byte);
+		return bits;
+	}
+
+	int64_t diffBits(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+	{
+		int64_t bits = 0;
+		for (size_t i = 0; i < a.size(); ++i) bits += __builtin_popcount(a[i] ^ b[i]);
+		return bits;
+	}
+
+	tsvoxel::GridSpec makeGrid(int num_x, int num_y, int num_z)
+	{
+		// 体素盒尺寸固定为 100，分辨率越高体素越小
+		return {num_x, num_y, num_z, {100.0 / num_x, 100.0 / num_y, 100.0 / num_z}};
+	}
+
+	bool runCheck(const std::vector<Primitive>& soup)
+	{
+		bool ok = true;
+		// 第二个网格 Y 方向超过一批的线数，Z 不是 8 的倍数
+		for (const tsvoxel::GridSpec& grid : {makeGrid(64, 64, 64), makeGrid(32, 600, 42)})
+		{
+			std::vector<uint8_t> expected(grid.byteSize()), actual(grid.byteSize());
+			for (const Primitive& primitive : soup)
+			{
+				referenceRasterize(grid, primitive, expected.data());
+				rasterize(grid, primitive, actual.data());
+			}
+			const int64_t mismatches = diffBits(expected, actual);
+			std::printf("  check   grid=%dx%dx%d filled=%lld mismatches=%lld %s\n", grid.num_x, grid.num_y, grid.num_z,
+				static_cast<long long>(countBits(expected)), static_cast<long long>(mismatches), mismatches ? "MISMATCH" : "ok");
+			ok = ok && !mismatches;
+		}
+
+		const tsvoxel::GridSpec grid = makeGrid(64, 64, 64);
+		std::vector<uint8_t> as_box(grid.byteSize()), as_convex(grid.byteSize());
+		int boxes = 0;
+		for (const Primitive& primitive : soup)
+		{
+			if (primitive.kind != Kind::Box)
+			{
+				continue;
+			}
+			Primitive hull;
+			hull.kind = Kind::Convex;
+			boxHull(primitive.box, hull.vertices, hull.indices);
+			rasterize(grid, primitive, as_box.data());
+			rasterize(grid, hull, as_convex.data());
+			++boxes;
+		}
+		const int64_t mismatches = diffBits(as_box, as_convex);
+		std::printf("  check   box-as-convex boxes=%d filled=%lld mismatches=%lld %s\n", boxes,
+			static_cast<long long>(countBits(as_box)), static_cast<long long>(mismatches), mismatches ? "MISMATCH" : "ok");
+		return ok && !mismatches;
+	}
+
+	// ---------- 压测 ----------
+
+	bool runBench(const std::vector<Primitive>& soup)
+	{
+		bool fast_enough = true;
+		for (const int size : g_options.sizes)
+		{
+			const tsvoxel::GridSpec grid = makeGrid(size, size, size);
+			std::vector<uint8_t> voxels(grid.byteSize());
+			double best_ms = 1e300;
+			double kind_ms[kNumKinds] = {};
+			int kind_count[kNumKinds] = {};
+			for (int r = 0; r < g_options.rounds; ++r)
+			{
+				std::fill(voxels.begin(), voxels.end(), 0);
+				double round_kind_ms[kNumKinds] = {};
+				const auto round_start = Clock::now();
+				for (const Primitive& primitive : soup)
+				{
+					const auto start = Clock::now();
+					rasterize(grid, primitive, voxels.data());
+					round_kind_ms[static_cast<int>(primitive.kind)] +=
+						std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				}
+				const double round_ms = std::chrono::duration<double, std::milli>(Clock::now() - round_start).count();
+				if (round_ms < best_ms)
+				{
+					best_ms = round_ms;
+					std::copy(round_kind_ms, round_kind_ms + kNumKinds, kind_ms);
+				}
+			}
+			for (const Primitive& primitive : soup) ++kind_count[static_cast<int>(primitive.kind)];
+
+			const double grid_voxels = static_cast<double>(size) * size * size;
+			const double mvoxels = grid_voxels / (best_ms * 1e3);
+			std::printf("  bench   %4d^3 best=%9.3fms %9.1f Mvoxel/s filled=%5.2f%%", size, best_ms, mvoxels,
+				100.0 * countBits(voxels) / grid_voxels);
+			for (int k = 0; k < kNumKinds; ++k)
+			{
+				std::printf(" %s=%.1fus", kKindNames[k], kind_count[k] ? 1e3 * kind_ms[k] / kind_count[k] : 0.0);
+			}
+			const bool below = g_options.min_mvoxels > 0 && mvoxels < g_options.min_mvoxels;
+			std::printf("%s\n", below ? " SLOW" : "");
+			fast_enough = fast_enough && !below;
+		}
+		return fast_enough;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (!parseOptions(argc, argv, g_options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::printf("primitives=%d rounds=%d seed=%u\n", g_options.primitives, g_options.rounds, g_options.seed);
+	std::mt19937 rng(g_options.seed);
+	const std::vector<Primitive> soup = generateSoup(rng, g_options.primitives);
+	if (!runCheck(soup))
+	{
+		return 2;
+	}
+	return runBench(soup) ? 0 : 3;
+}
@@ -339,7 +339,8 @@ void UCaptureGrpcSubsystem::UpdateStatusFromSubsystem(FGuid CameraGuid, FCapture
 
 tongos::ResponseStatus UCaptureGrpcSubsystem::CaptureSnapshotInternal(
 	const tongsim_lite::capture::CaptureSnapshotRequest& Req,
-	tongsim_lite::capture::CaptureFrame& OutFrame)
+	tongsim_lite::capture::CaptureFrame& OutFrame,
+	std::vector<tongos::RpcExternalBytes>* OutExternalBytes)
 {
 	if (!Instance)
 	{
@@ -381,11 +382,12 @@ tongos::ResponseStatus UCaptureGrpcSubsystem::CaptureSnapshotInternal(
 		MakeShared<FTSCaptureFrame>(MoveTemp(Frame)),
 		State,
 		Req.include_color(),
-		Req.include_depth());
+		Req.include_depth(),
+		OutExternalBytes);
 	return ResponseStatus::OK;
 }
 
-tongsim_lite::capture::CaptureFrame UCaptureGrpcSubsystem::ToProtoFrame(const FGuid& CameraGuid, const TSharedPtr<FTSCaptureFrame>& Frame, const FCaptureCameraState* State, bool bIncludeColor, bool bIncludeDepth)
+tongsim_lite::capture::CaptureFrame UCaptureGrpcSubsystem::ToProtoFrame(const FGuid& CameraGuid, const TSharedPtr<FTSCaptureFrame>& Frame, const FCaptureCameraState* State, bool bIncludeColor, bool bIncludeDepth, std::vector<tongos::RpcExternalBytes>* OutExternalBytes)
 {
 	tongsim_lite::capture::CaptureFrame Out;
 	if (CameraGuid.IsValid())
@@ -414,9 +416,26 @@ tongsim_lite::capture::CaptureFrame UCaptureGrpcSubsystem::ToProtoFrame(const FG
 		Out.set_depth_far(0.f);
 		Out.set_depth_mode(tongsim_lite::capture::CaptureDepthMode::CAPTURE_DEPTH_NONE);
 	}
+	// 外部内存由 grpc 持有 Frame 的引用，发送完成后释放
+	const auto AddExternalBytes = [&Frame, OutExternalBytes](int32 FieldNumber, const void* Data, size_t Size)
+	{
+		tongos::RpcExternalBytes Bytes;
+		Bytes.field_number = FieldNumber;
+		Bytes.data = Data;
+		Bytes.size = Size;
+		Bytes.owner = std::shared_ptr<const void>(Frame.Get(), [KeepAlive = Frame](const void*) {});
+		OutExternalBytes->push_back(MoveTemp(Bytes));
+	};
 	if (bIncludeColor && Frame->Rgba8.Num() > 0)
 	{
-		Out.set_rgba8(Frame->Rgba8.GetData(), Frame->Rgba8.Num());
+		if (OutExternalBytes)
+		{
+			AddExternalBytes(tongsim_lite::capture::CaptureFrame::kRgba8FieldNumber, Frame->Rgba8.GetData(), Frame->Rgba8.Num());
+		}
+		else
+		{
+			Out.set_rgba8(Frame->Rgba8.GetData(), Frame->Rgba8.Num());
+		}
 		Out.set_has_color(true);
 	}
 	else
@@ -426,7 +445,14 @@ tongsim_lite::capture::CaptureFrame UCaptureGrpcSubsystem::ToProtoFrame(const FG
 	if (bIncludeDepth && Frame->DepthR32.Num() > 0)
 	{
 		const uint8* DepthBytes = reinterpret_cast<const uint8*>(Frame->DepthR32.GetData());
-		Out.set_depth_r32(DepthBytes, Frame->DepthR32.Num() * sizeof(float));
+		if (OutExternalBytes)
+		{
+			AddExternalBytes(tongsim_lite::capture::CaptureFrame::kDepthR32FieldNumber, DepthBytes, Frame->DepthR32.Num() * sizeof(float));
+		}
+		else
+		{
+			Out.set_depth_r32(DepthBytes, Frame->DepthR32.Num() * sizeof(float));
+		}
 		Out.set_has_depth(true);
 	}
 	else
@@ -450,10 +476,11 @@ void UCaptureGrpcSubsystem::FCaptureSnapshotReactor::onRequest(tongsim_lite::cap
 	AsyncTask(ENamedThreads::GameThread, [Self, RequestCopy]() mutable
 	{
 		tongsim_lite::capture::CaptureFrame ResponseFrame;
-		ResponseStatus Status = UCaptureGrpcSubsystem::CaptureSnapshotInternal(RequestCopy, ResponseFrame);
+		std::vector<tongos::RpcExternalBytes> ExternalBytes;
+		ResponseStatus Status = UCaptureGrpcSubsystem::CaptureSnapshotInternal(RequestCopy, ResponseFrame, &ExternalBytes);
 		if (Status.ok())
 		{
-			Self->writeAndFinish(ResponseFrame);
+			Self->writeAndFinish(ResponseFrame, MoveTemp(ExternalBytes));
 		}
 		else
 		{
@@ -470,8 +470,7 @@ tongos::ResponseStatus UArenaGrpcSubsystem::DestroyActorInArena(
 	{
 		FGuid Aid;
 		if (ObjectIdToGuid(Req.actor_id(), Aid))
-			if (const TWeakObjectPtr<AActor>* Found = G->GetIdToActorMap().Find(Aid))
-				Actor = Found->Get();
+			Actor = G->FindActorByGuid(Aid);
 	}
 	if (!IsValid(Actor)) return ResponseStatus(grpc::StatusCode::NOT_FOUND, "Actor not found");
 
@@ -799,8 +798,7 @@ tongos::ResponseStatus UArenaGrpcSubsystem::SetActorPoseLocal(
 	{
 		FGuid Aid;
 		if (ObjectIdToGuid(Req.actor_id(), Aid))
-			if (const TWeakObjectPtr<AActor>* Found = G->GetIdToActorMap().Find(Aid))
-				Actor = Found->Get();
+			Actor = G->FindActorByGuid(Aid);
 	}
 	if (!IsValid(Actor))
 	{
@@ -828,8 +826,7 @@ tongos::ResponseStatus UArenaGrpcSubsystem::GetActorPoseLocal(
 	{
 		FGuid Aid;
 		if (ObjectIdToGuid(Req.actor_id(), Aid))
-			if (const TWeakObjectPtr<AActor>* Found = G->GetIdToActorMap().Find(Aid))
-				Actor = Found->Get();
+			Actor = G->FindActorByGuid(Aid);
 	}
 	if (!IsValid(Actor)) return ResponseStatus(grpc::StatusCode::NOT_FOUND, "Actor not found");
 
@@ -0,0 +1,218 @@
+// DemoRLStateColumns.cpp
+
+#include "DemoRL/DemoRLStateColumns.h"
+
+#include "TSActorRegistry.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Info.h"
+
+namespace
+{
+	// 名称按 Actor 实例各占一条，长时间大量生成/销毁时靠上限兜底
+	constexpr int32 MaxStringTableSize = 1 << 20;
+
+	void AppendGuidLE(const FGuid& G, TArray<uint8>& Out)
+	{
+		const uint32 Parts[4] = {
+			static_cast<uint32>(G.A), static_cast<uint32>(G.B),
+			static_cast<uint32>(G.C), static_cast<uint32>(G.D)
+		};
+		for (const uint32 V : Parts)
+		{
+			Out.Add(static_cast<uint8>(V & 0xFF));
+			Out.Add(static_cast<uint8>((V >> 8) & 0xFF));
+			Out.Add(static_cast<uint8>((V >> 16) & 0xFF));
+			Out.Add(static_cast<uint8>((V >> 24) & 0xFF));
+		}
+	}
+
+	void AppendVector(const FVector& V, TArray<float>& Out)
+	{
+		Out.Add(static_cast<float>(V.X));
+		Out.Add(static_cast<float>(V.Y));
+		Out.Add(static_cast<float>(V.Z));
+	}
+
+	/** 每次请求解析一次过滤条件，类的匹配结果按 UClass 缓存 */
+	class FColumnsFilter
+	{
+	public:
+		explicit FColumnsFilter(const tongsim_lite::demo_rl::QueryStateColumnsRequest& Request)
+		{
+			for (const std::string& Class : Request.class_filter())
+			{
+				ClassNames.Add(UTF8_TO_TCHAR(Class.c_str()));
+			}
+			for (const std::string& Tag : Request.tag_filter())
+			{
+				Tags.Add(FName(UTF8_TO_TCHAR(Tag.c_str())));
+			}
+		}
+
+		bool Matches(const AActor* Actor)
+		{
+			return MatchesClass(Actor->GetClass()) && MatchesTag(Actor);
+		}
+
+	private:
+		bool MatchesClass(const UClass* Class)
+		{
+			if (ClassNames.IsEmpty())
+			{
+				return true;
+			}
+			if (const bool* Cached = ClassMatches.Find(Class))
+			{
+				return *Cached;
+			}
+			bool bMatch = false;
+			for (const UClass* It = Class; It && !bMatch; It = It->GetSuperClass())
+			{
+				bMatch = ClassNames.Contains(It->GetName()) || ClassNames.Contains(It->GetPathName());
+			}
+			ClassMatches.Add(Class, bMatch);
+			return bMatch;
+		}
+
+		bool MatchesTag(const AActor* Actor) const
+		{
+			if (Tags.IsEmpty())
+			{
+				return true;
+			}
+			for (const FName& Tag : Actor->Tags)
+			{
+				if (Tags.Contains(Tag))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		TSet<FString> ClassNames;
+		TSet<FName> Tags;
+		TMap<const UClass*, bool> ClassMatches;
+	};
+}
+
+FDemoRLStringTable::FDemoRLStringTable()
+{
+	Reset();
+}
+
+uint32 FDemoRLStringTable::InternName(FName Name)
+{
+	if (Name.IsNone())
+	{
+		return 0;
+	}
+	if (const uint32* Found = NameToIndex.Find(Name))
+	{
+		return *Found;
+	}
+	const uint32 Index = Add(std::string(TCHAR_TO_UTF8(*Name.ToString())));
+	NameToIndex.Add(Name, Index);
+	return Index;
+}
+
+uint32 FDemoRLStringTable::InternClass(const UClass* Class)
+{
+	if (!Class)
+	{
+		return 0;
+	}
+	if (const uint32* Found = ClassToIndex.Find(Class))
+	{
+		return *Found;
+	}
+	const uint32 Index = Add(std::string(TCHAR_TO_UTF8(*Class->GetPathName())));
+	ClassToIndex.Add(Class, Index);
+	return Index;
+}
+
+void FDemoRLStringTable::FillIncrement(uint64 ClientEpoch, uint32 KnownCount, tongsim_lite::demo_rl::DemoRLStateColumns& Out) const
+{
+	const uint32 Offset = ClientEpoch == Epoch ? FMath::Min(KnownCount, static_cast<uint32>(Strings.Num())) : 0;
+	Out.set_string_table_epoch(Epoch);
+	Out.set_string_table_offset(Offset);
+	Out.mutable_strings()->Reserve(Strings.Num() - Offset);
+	for (int32 i = Offset; i < Strings.Num(); ++i)
+	{
+		Out.add_strings(Strings[i]);
+	}
+}
+
+void FDemoRLStringTable::TrimIfNeeded()
+{
+	if (Strings.Num() >= MaxStringTableSize)
+	{
+		Reset();
+	}
+}
+
+void FDemoRLStringTable::Reset()
+{
+	const FGuid Random = FGuid::NewGuid();
+	// 0 留给客户端表示没有缓存
+	Epoch = ((static_cast<uint64>(Random.A) << 32) | static_cast<uint32>(Random.B)) | 1;
+	Strings.Reset();
+	NameToIndex.Reset();
+	ClassToIndex.Reset();
+	Strings.Emplace();
+}
+
+uint32 FDemoRLStringTable::Add(std::string&& Value)
+{
+	return static_cast<uint32>(Strings.Add(MoveTemp(Value)));
+}
+
+void FDemoRLStateColumns::Build(const FTSActorRegistry& Registry, const tongsim_lite::demo_rl::QueryStateColumnsRequest& Request, FDemoRLStringTable& StringTable)
+{
+	const int32 Capacity = Registry.Num();
+	Ids.Reserve(Capacity * 16);
+	Locations.Reserve(Capacity * 3);
+	Rotations.Reserve(Capacity * 3);
+	Bounds.Reserve(Capacity * 6);
+	Speeds.Reserve(Capacity);
+	NameIds.Reserve(Capacity);
+	ClassIds.Reserve(Capacity);
+	TagIds.Reserve(Capacity);
+
+	FColumnsFilter Filter(Request);
+	Registry.ForEach([&](const FTSActorRecord& Record)
+	{
+		AActor* Actor = Record.bDestroyed ? nullptr : Record.Actor.Get();
+		if (!Actor || !Filter.Matches(Actor))
+		{
+			return;
+		}
+
+		++Count;
+		AppendGuidLE(Record.Guid, Ids);
+		NameIds.Add(StringTable.InternName(Actor->GetFName()));
+		ClassIds.Add(StringTable.InternClass(Actor->GetClass()));
+		TagIds.Add(StringTable.InternName(Actor->Tags.Num() > 0 ? Actor->Tags[0] : NAME_None));
+
+		// 与 QueryState 一致，AInfo 没有空间信息
+		if (Actor->IsA(AInfo::StaticClass()))
+		{
+			Locations.AddZeroed(3);
+			Rotations.AddZeroed(3);
+			Bounds.AddZeroed(6);
+			Speeds.Add(0.f);
+			return;
+		}
+
+		const FTransform& Transform = Actor->GetActorTransform();
+		AppendVector(Transform.GetLocation(), Locations);
+		const FRotator Rotator = Transform.Rotator();
+		Rotations.Add(static_cast<float>(Rotator.Roll));
+		Rotations.Add(static_cast<float>(Rotator.Pitch));
+		Rotations.Add(static_cast<float>(Rotator.Yaw));
+		const FBox Box = Actor->GetComponentsBoundingBox(/*bNonColliding=*/true);
+		AppendVector(Box.Min, Bounds);
+		AppendVector(Box.Max, Bounds);
+		Speeds.Add(static_cast<float>(Actor->GetVelocity().Size()));
+	});
+}
@@ -0,0 +1,242 @@
+// DemoRLStateTracker.cpp
+
+#include "DemoRL/DemoRLStateTracker.h"
+
+#include "TSGrpcSubsystem.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Info.h"
+
+namespace
+{
+	// 变化阈值：小于阈值的抖动不推送，缓存只在判定为变化时更新，缓慢漂移累计超过阈值后仍会推送
+	constexpr double LocationToleranceUU = 0.1;
+	constexpr double RotationToleranceRad = UE_DOUBLE_PI / 180.0 * 0.05;
+	constexpr double ScaleTolerance = 1e-3;
+	constexpr double BoundsToleranceUU = 0.1;
+	constexpr float SpeedToleranceUU = 1.f;
+	// 静止 Actor 的包围盒轮询间隔（tick）
+	constexpr int32 BoundsRefreshTicks = 64;
+
+	std::string GuidToBytesLE(const FGuid& G)
+	{
+		const uint32 Parts[4] = {
+			static_cast<uint32>(G.A), static_cast<uint32>(G.B),
+			static_cast<uint32>(G.C), static_cast<uint32>(G.D)
+		};
+		std::string Out(16, '\0');
+		for (int i = 0; i < 4; ++i)
+		{
+			Out[i * 4 + 0] = static_cast<char>(Parts[i] & 0xFF);
+			Out[i * 4 + 1] = static_cast<char>((Parts[i] >> 8) & 0xFF);
+			Out[i * 4 + 2] = static_cast<char>((Parts[i] >> 16) & 0xFF);
+			Out[i * 4 + 3] = static_cast<char>((Parts[i] >> 24) & 0xFF);
+		}
+		return Out;
+	}
+
+	void SetVector(const FVector& V, tongsim_lite::common::Vector3f& Out)
+	{
+		Out.set_x(static_cast<float>(V.X));
+		Out.set_y(static_cast<float>(V.Y));
+		Out.set_z(static_cast<float>(V.Z));
+	}
+
+	FName FirstTag(const AActor* Actor)
+	{
+		return Actor->Tags.Num() > 0 ? Actor->Tags[0] : NAME_None;
+	}
+}
+
+void FDemoRLStateTracker::Update(const UTSGrpcSubsystem& GrpcSubsystem)
+{
+	++Frame;
+
+	GrpcSubsystem.GetActorRegistry().ForEach([this](const FTSActorRecord& Record)
+	{
+		const FGuid& Guid = Record.Guid;
+		AActor* Actor = Record.bDestroyed ? nullptr : Record.Actor.Get();
+		FEntry* Entry = Entries.Find(Guid);
+		if (!Actor)
+		{
+			if (Entry && Entry->DestroyedFrame == 0)
+			{
+				Entry->DestroyedFrame = Frame;
+			}
+			return;
+		}
+
+		if (!Entry || Entry->DestroyedFrame != 0)
+		{
+			Entry = &Entries.Add(Guid);
+			InitEntry(*Entry, Guid, Actor);
+		}
+		else
+		{
+			RefreshEntry(*Entry, Actor);
+		}
+		Entry->SeenFrame = Frame;
+	});
+
+	// 已经从注册表里清掉的 GUID 也视为销毁
+	for (auto& Pair : Entries)
+	{
+		FEntry& Entry = Pair.Value;
+		if (Entry.DestroyedFrame == 0 && Entry.SeenFrame != Frame)
+		{
+			Entry.DestroyedFrame = Frame;
+		}
+	}
+}
+
+void FDemoRLStateTracker::PurgeTombstones(uint64 MinSentFrame)
+{
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (It->Value.DestroyedFrame != 0 && It->Value.DestroyedFrame <= MinSentFrame)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FDemoRLStateTracker::Reset()
+{
+	Entries.Empty();
+}
+
+bool FDemoRLStateTracker::BuildDelta(uint64 LastSentFrame, bool bKeyframe, tongsim_lite::demo_rl::DemoRLStateDelta& Out) const
+{
+	Out.set_frame(Frame);
+	Out.set_keyframe(bKeyframe);
+
+	for (const auto& Pair : Entries)
+	{
+		const FEntry& Entry = Pair.Value;
+		if (bKeyframe)
+		{
+			if (Entry.DestroyedFrame == 0)
+			{
+				FillActorState(Entry, *Out.add_updated());
+			}
+			continue;
+		}
+
+		if (Entry.DestroyedFrame != 0)
+		{
+			// 客户端没见过的 Actor（上次发送之后生成又销毁）不用通知
+			if (Entry.DestroyedFrame > LastSentFrame && Entry.SpawnFrame <= LastSentFrame)
+			{
+				Out.add_destroyed()->set_guid(Entry.GuidBytes);
+			}
+		}
+		else if (Entry.SpawnFrame > LastSentFrame)
+		{
+			FillActorState(Entry, *Out.add_spawned());
+		}
+		else if (Entry.ChangedFrame > LastSentFrame)
+		{
+			FillActorState(Entry, *Out.add_updated());
+		}
+	}
+
+	return bKeyframe || Out.spawned_size() > 0 || Out.updated_size() > 0 || Out.destroyed_size() > 0;
+}
+
+void FDemoRLStateTracker::FillActorState(const FEntry& Entry, tongsim_lite::demo_rl::ActorState& OutState)
+{
+	tongsim_lite::object::ObjectInfo* Info = OutState.mutable_object_info();
+	Info->mutable_id()->set_guid(Entry.GuidBytes);
+	Info->set_name(Entry.Name);
+	Info->set_class_path(Entry.ClassPath);
+
+	if (Entry.bInfoOnly)
+	{
+		return;
+	}
+
+	SetVector(Entry.Location, *OutState.mutable_location());
+	SetVector(Entry.Rotation.GetForwardVector(), *OutState.mutable_unit_forward_vector());
+	SetVector(Entry.Rotation.GetRightVector(), *OutState.mutable_unit_right_vector());
+	SetVector(Entry.Bounds.Min, *OutState.mutable_bounding_box()->mutable_min_vertex());
+	SetVector(Entry.Bounds.Max, *OutState.mutable_bounding_box()->mutable_max_vertex());
+	OutState.set_tag(Entry.TagUtf8);
+	OutState.set_current_speed(Entry.Speed);
+}
+
+void FDemoRLStateTracker::InitEntry(FEntry& Entry, const FGuid& Guid, AActor* Actor)
+{
+	Entry.Actor = Actor;
+	Entry.GuidBytes = GuidToBytesLE(Guid);
+	Entry.Name = TCHAR_TO_UTF8(*Actor->GetName());
+	const UClass* Cls = Actor->GetClass();
+	Entry.ClassPath = TCHAR_TO_UTF8(*(Cls ? Cls->GetPathName() : FString(TEXT("None"))));
+	Entry.bInfoOnly = Actor->IsA(AInfo::StaticClass());
+
+	const FTransform& Transform = Actor->GetActorTransform();
+	Entry.Location = Transform.GetLocation();
+	Entry.Rotation = Transform.GetRotation();
+	Entry.Scale = Transform.GetScale3D();
+	Entry.Bounds = Actor->GetComponentsBoundingBox(/*bNonColliding=*/true);
+	Entry.Tag = FirstTag(Actor);
+	Entry.TagUtf8 = Entry.Tag.IsNone() ? std::string() : std::string(TCHAR_TO_UTF8(*Entry.Tag.ToString()));
+	Entry.Speed = Actor->GetVelocity().Size();
+
+	Entry.SpawnFrame = Frame;
+	Entry.ChangedFrame = Frame;
+	Entry.DestroyedFrame = 0;
+	// 错开各 Actor 的轮询帧，避免同一帧集中计算包围盒
+	Entry.TicksUntilBoundsRefresh = 1 + static_cast<int32>(GetTypeHash(Guid) % BoundsRefreshTicks);
+}
+
+void FDemoRLStateTracker::RefreshEntry(FEntry& Entry, AActor* Actor)
+{
+	if (Entry.bInfoOnly)
+	{
+		return;
+	}
+
+	bool bChanged = false;
+
+	const FTransform& Transform = Actor->GetActorTransform();
+	const bool bMoved = !Transform.GetLocation().Equals(Entry.Location, LocationToleranceUU)
+		|| Transform.GetRotation().AngularDistance(Entry.Rotation) > RotationToleranceRad
+		|| !Transform.GetScale3D().Equals(Entry.Scale, ScaleTolerance);
+	if (bMoved)
+	{
+		Entry.Location = Transform.GetLocation();
+		Entry.Rotation = Transform.GetRotation();
+		Entry.Scale = Transform.GetScale3D();
+		bChanged = true;
+	}
+
+	if (bMoved || --Entry.TicksUntilBoundsRefresh <= 0)
+	{
+		Entry.TicksUntilBoundsRefresh = BoundsRefreshTicks;
+		const FBox Bounds = Actor->GetComponentsBoundingBox(/*bNonColliding=*/true);
+		if (!Bounds.Min.Equals(Entry.Bounds.Min, BoundsToleranceUU) || !Bounds.Max.Equals(Entry.Bounds.Max, BoundsToleranceUU))
+		{
+			Entry.Bounds = Bounds;
+			bChanged = true;
+		}
+	}
+
+	const float Speed = Actor->GetVelocity().Size();
+	if (FMath::Abs(Speed - Entry.Speed) > SpeedToleranceUU)
+	{
+		Entry.Speed = Speed;
+		bChanged = true;
+	}
+
+	const FName Tag = FirstTag(Actor);
+	if (Tag != Entry.Tag)
+	{
+		Entry.Tag = Tag;
+		Entry.TagUtf8 = Tag.IsNone() ? std::string() : std::string(TCHAR_TO_UTF8(*Tag.ToString()));
+		bChanged = true;
+	}
+
+	if (bChanged)
+	{
+		Entry.ChangedFrame = Frame;
+	}
+}
@@ -4,7 +4,12 @@
 
 #include "TSGrpcSubsystem.h"
 #include "TSVoxelGridFuncLib.h"
+#include "TSVoxelMap.h"
 #include "Kismet/GameplayStatics.h"
+#include "Async/ParallelFor.h"
+#include "Misc/App.h"
+#include "Hash/CityHash.h"
+#include "Physics/PhysicsInterfaceCore.h"
 #include "Engine/LevelStreaming.h"
 #include "Engine/Engine.h"
 #include "Engine/World.h"
@@ -215,12 +220,7 @@ namespace DemoRLServiceHelpers
 		FGuid G;
 		if (!ObjectIdToGuid(Id, G)) return nullptr;
 
-		const TMap<FGuid, TWeakObjectPtr<AActor>>& Map = GrpcSubsystem->GetIdToActorMap();
-		if (const TWeakObjectPtr<AActor>* Found = Map.Find(G))
-		{
-			return Found->Get();
-		}
-		return nullptr;
+		return GrpcSubsystem->FindActorByGuid(G);
 	}
 
 	/* ---------- Tag Conveniences ---------- */
@@ -239,6 +239,18 @@ void UDemoRLSubsystem::Deinitialize()
 {
 	Instance = nullptr;
 	FWorldDelegates::OnPostWorldInitialization.RemoveAll(this);
+	for (const std::shared_ptr<FSubscribeStateReactor>& Subscriber : StateSubscribers)
+	{
+		Subscriber->bFinished = true;
+		Subscriber->finish(ResponseStatus(grpc::StatusCode::UNAVAILABLE, "DemoRLSubsystem deinitialized."));
+	}
+	StateSubscribers.Empty();
+	StateTracker.Reset();
+	for (const std::shared_ptr<FBatchQueryNavigationPathReactor>& Batch : NavPathBatches)
+	{
+		Batch->Abort(ResponseStatus(grpc::StatusCode::UNAVAILABLE, "DemoRLSubsystem deinitialized."));
+	}
+	NavPathBatches.Empty();
 	Super::Deinitialize();
 }
 
@@ -272,6 +284,53 @@ void UDemoRLSubsystem::Tick(float DeltaTime)
 		for (const FGuid& K : Keys)
 			if (auto* SP = PickUpReactorMap.Find(K)) if (*SP) (*SP)->Tick(DeltaTime);
 	}
+
+	for (int32 i = NavPathBatches.Num() - 1; i >= 0; --i)
+	{
+		// Tick 里可能结束流，先持有一份
+		const std::shared_ptr<FBatchQueryNavigationPathReactor> Batch = NavPathBatches[i];
+		if (!Batch || !Batch->Tick())
+		{
+			NavPathBatches.RemoveAtSwap(i);
+		}
+	}
+
+	TickStateSubscribers();
+}
+
+void UDemoRLSubsystem::TickStateSubscribers()
+{
+	if (StateSubscribers.Num() == 0)
+	{
+		// 没有订阅者时不扫描 Actor
+		if (StateTracker.Num() > 0)
+		{
+			StateTracker.Reset();
+		}
+		return;
+	}
+
+	UTSGrpcSubsystem* GrpcSubsystem = UTSGrpcSubsystem::GetInstance();
+	if (!GrpcSubsystem)
+	{
+		return;
+	}
+
+	// 所有订阅者共用一次扫描
+	StateTracker.Update(*GrpcSubsystem);
+
+	uint64 MinSentFrame = MAX_uint64;
+	for (int32 i = StateSubscribers.Num() - 1; i >= 0; --i)
+	{
+		const std::shared_ptr<FSubscribeStateReactor> Subscriber = StateSubscribers[i];
+		if (!Subscriber || !Subscriber->Tick(StateTracker))
+		{
+			StateSubscribers.RemoveAtSwap(i);
+			continue;
+		}
+		MinSentFrame = FMath::Min(MinSentFrame, Subscriber->LastSentFrame);
+	}
+	StateTracker.PurgeTombstones(StateSubscribers.Num() > 0 ? MinSentFrame : StateTracker.GetFrame());
 }
 
 void UDemoRLSubsystem::HandlePostWorldInit(UWorld* World, const UWorld::InitializationValues IVS)
@@ -283,6 +342,8 @@ void UDemoRLSubsystem::HandlePostWorldInit(UWorld* World, const UWorld::Initiali
 	}
 
 	GrpcSubsystem->RegisterUnaryHandler("/tongsim_lite.demo_rl.DemoRLService/QueryState", &ThisClass::QueryState);
+	GrpcSubsystem->RegisterReactor<ThisClass::FSubscribeStateReactor>("/tongsim_lite.demo_rl.DemoRLService/SubscribeState");
+	GrpcSubsystem->RegisterReactor<ThisClass::FQueryStateColumnsReactor>("/tongsim_lite.demo_rl.DemoRLService/QueryStateColumns");
 	GrpcSubsystem->RegisterReactor<ThisClass::FResetLevelReactor>("/tongsim_lite.demo_rl.DemoRLService/ResetLevel");
 	GrpcSubsystem->RegisterReactor<ThisClass::FSimpleMoveTowardsReactor>("/tongsim_lite.demo_rl.DemoRLService/SimpleMoveTowards");
 
@@ -291,10 +352,12 @@ void UDemoRLSubsystem::HandlePostWorldInit(UWorld* World, const UWorld::Initiali
 	GrpcSubsystem->RegisterUnaryHandler("/tongsim_lite.demo_rl.DemoRLService/SetActorTransform", &ThisClass::SetActorTransform);
 	GrpcSubsystem->RegisterUnaryHandler("/tongsim_lite.demo_rl.DemoRLService/SpawnActor", &ThisClass::SpawnActor);
 
-	GrpcSubsystem->RegisterUnaryHandler("/tongsim_lite.voxel.VoxelService/QueryVoxel", &ThisClass::QueryVoxel);
+	GrpcSubsystem->RegisterReactor<ThisClass::FQueryVoxelReactor>("/tongsim_lite.voxel.VoxelService/QueryVoxel");
+	GrpcSubsystem->RegisterReactor<ThisClass::FBatchQueryVoxelReactor>("/tongsim_lite.voxel.VoxelService/BatchQueryVoxel");
 
 	GrpcSubsystem->RegisterUnaryHandler("/tongsim_lite.demo_rl.DemoRLService/ExecConsoleCommand", &ThisClass::ExecConsoleCommand);
 	GrpcSubsystem->RegisterUnaryHandler("/tongsim_lite.demo_rl.DemoRLService/QueryNavigationPath", &ThisClass::QueryNavigationPath);
+	GrpcSubsystem->RegisterReactor<ThisClass::FBatchQueryNavigationPathReactor>("/tongsim_lite.demo_rl.DemoRLService/BatchQueryNavigationPath");
 	GrpcSubsystem->RegisterReactor<ThisClass::FNavigateToLocationReactor>("/tongsim_lite.demo_rl.DemoRLService/NavigateToLocation");
 	GrpcSubsystem->RegisterReactor<ThisClass::FPickUpObjectReactor>("/tongsim_lite.demo_rl.DemoRLService/PickUpObject");
 	GrpcSubsystem->RegisterReactor<ThisClass::FDropObjectReactor>("/tongsim_lite.demo_rl.DemoRLService/DropObject");
@@ -308,6 +371,8 @@ void UDemoRLSubsystem::HandlePostWorldInit(UWorld* World, const UWorld::Initiali
 	GrpcSubsystem->RegisterUnaryHandler(
 	"/tongsim_lite.demo_rl.DemoRLService/BatchMultiLineTraceByObject",
 	&ThisClass::BatchMultiLineTraceByObject);
+
+	GrpcSubsystem->RegisterUnaryHandler("/tongsim_lite.demo_rl.DemoRLService/TraceRayPattern", &ThisClass::TraceRayPattern);
 }
 
 /* ---------- Unary Handlers ---------- */
@@ -322,28 +387,25 @@ tongos::ResponseStatus UDemoRLSubsystem::QueryState(
 		return tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "No valid TongSim gRPC Subsystem.");
 	}
 
-	const TMap<FGuid, TWeakObjectPtr<AActor>>& IdToActorMap = GrpcSubsystem->GetIdToActorMap();
-	const TSet<FGuid>& DestroyedIds = GrpcSubsystem->GetDestroyedIds();
+	const FTSActorRegistry& Registry = GrpcSubsystem->GetActorRegistry();
+	Response.mutable_actor_states()->Reserve(Registry.Num());
 
-	for (const auto& Pair : IdToActorMap)
+	Registry.ForEach([&Response](const FTSActorRecord& Record)
 	{
-		const FGuid Guid = Pair.Key;
-		if (Guid.IsValid())
+		AActor* Actor = Record.bDestroyed ? nullptr : Record.Actor.Get();
+		if (Actor)
 		{
-			if (AActor* Actor = Pair.Value.Get())
-			{
-				auto* Out = Response.add_actor_states();
-				DemoRLServiceHelpers::FillActorState(Guid, Actor, *Out);
-			}
-			else if (DestroyedIds.Contains(Guid))
-			{
-				auto* Out = Response.add_actor_states();
-				// 仅填 ObjectInfo，名称/类路径会落到 "None"
-				DemoRLServiceHelpers::FillObjectInfo(Guid, /*Actor=*/nullptr, *Out->mutable_object_info());
-				Out->set_destroyed(true); // 新增字段
-			}
+			auto* Out = Response.add_actor_states();
+			DemoRLServiceHelpers::FillActorState(Record.Guid, Actor, *Out);
 		}
-	}
+		else if (Record.bDestroyed)
+		{
+			auto* Out = Response.add_actor_states();
+			// 仅填 ObjectInfo，名称/类路径会落到 "None"
+			DemoRLServiceHelpers::FillObjectInfo(Record.Guid, /*Actor=*/nullptr, *Out->mutable_object_info());
+			Out->set_destroyed(true); // 新增字段
+		}
+	});
 	return tongos::ResponseStatus::OK;
 }
 
@@ -461,8 +523,61 @@ tongos::ResponseStatus UDemoRLSubsystem::SpawnActor(
 	return tongos::ResponseStatus::OK;
 }
 
+namespace DemoRLServiceHelpers
+{
+	/** 把 QueryVoxelRequest 转成体素查询参数 */
+	tongos::ResponseStatus MakeVoxelQueryParam(const tongsim_lite::voxel::QueryVoxelRequest& Request, FVoxelGridQueryParam& QueryParam)
+	{
+		FTransform QueryTransform = FromProtoTransform(Request.transform());
+
+		if (Request.voxel_num_x() % 2 != 0 || Request.voxel_num_y() % 2 != 0 || Request.voxel_num_z() % 2 != 0)
+		{
+			return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Voxel num must be even.");
+		}
+
+		const uint16 VoxelHalfNumX = Request.voxel_num_x() / 2;
+		const uint16 VoxelHalfNumY = Request.voxel_num_y() / 2;
+		const uint16 VoxelHalfNumZ = Request.voxel_num_z() / 2;
+
+		const FVector Extent = FromProtoVector3f(Request.extent());
+
+		// 碰撞体由世界的体素源缓存增量维护，不再每次遍历全部 Actor
+		QueryParam.bUseWorldSourceCache = true;
+
+		for (const tongsim_lite::object::ObjectId& ActorId_Proto : Request.actorstoignore())
+		{
+			if (AActor* ActorToIgnore = FindActorByObjectId(ActorId_Proto))
+			{
+				QueryParam.IgnoredActors.Add(ActorToIgnore);
+			}
+		}
+
+		QueryParam.GridBox = FVoxelBox{
+			QueryTransform, VoxelHalfNumX, VoxelHalfNumY, VoxelHalfNumZ, Extent * 2.f
+		};
+		return tongos::ResponseStatus::OK;
+	}
+
+	/** 读取请求的编码与压缩方式，proto 枚举取值与 tsvoxel::Encoding / EVoxelGridCompression 一致 */
+	tongos::ResponseStatus GetVoxelEncoding(const tongsim_lite::voxel::QueryVoxelRequest& Request,
+	                                        tsvoxel::Encoding& OutEncoding, EVoxelGridCompression& OutCompression)
+	{
+		if (!tongsim_lite::voxel::VoxelEncoding_IsValid(Request.encoding()))
+		{
+			return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Unknown voxel encoding.");
+		}
+		if (!tongsim_lite::voxel::VoxelCompression_IsValid(Request.compression()))
+		{
+			return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Unknown voxel compression.");
+		}
+		OutEncoding = static_cast<tsvoxel::Encoding>(Request.encoding());
+		OutCompression = static_cast<EVoxelGridCompression>(Request.compression());
+		return tongos::ResponseStatus::OK;
+	}
+}
+
 tongos::ResponseStatus UDemoRLSubsystem::QueryVoxel(
-	tongsim_lite::voxel::QueryVoxelRequest& Request, tongsim_lite::voxel::Voxel& Response)
+	const tongsim_lite::voxel::QueryVoxelRequest& Request, TArray<uint8>& OutVoxelGrids, FVoxelGridEncoding& OutEncoding)
 {
 	UWorld* World = Instance ? Instance->GetWorld() : DemoRLServiceHelpers::GetGameWorld();
 	if (!World)
@@ -470,41 +585,196 @@ tongos::ResponseStatus UDemoRLSubsystem::QueryVoxel(
 		return tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "No valid UWorld.");
 	}
 
-	FTransform QueryTransform = DemoRLServiceHelpers::FromProtoTransform(Request.transform());
-
-	if (Request.voxel_num_x() % 2 != 0 || Request.voxel_num_y() % 2 != 0 || Request.voxel_num_z() % 2 != 0)
+	FVoxelGridQueryParam QueryParam{World};
+	tongos::ResponseStatus Status = DemoRLServiceHelpers::MakeVoxelQueryParam(Request, QueryParam);
+	if (!Status.ok())
 	{
-		return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Voxel num must be even.");
+		return Status;
 	}
+	tsvoxel::Encoding Encoding;
+	EVoxelGridCompression Compression;
+	Status = DemoRLServiceHelpers::GetVoxelEncoding(Request, Encoding, Compression);
+	if (!Status.ok())
+	{
+		return Status;
+	}
+	// 常驻地图不接的查询（旋转的盒子等）退回无状态体素化
+	UTSVoxelMap* VoxelMap = Request.use_voxel_map() ? World->GetSubsystem<UTSVoxelMap>() : nullptr;
+	if (!VoxelMap || !VoxelMap->QueryVoxelGrids(QueryParam, OutVoxelGrids))
+	{
+		TSVoxelGridFuncLib::QueryVoxelGrids(QueryParam, OutVoxelGrids, World);
+	}
+	TSVoxelGridFuncLib::EncodeVoxelGrids(QueryParam.GridBox, Encoding, Compression, OutVoxelGrids, OutEncoding);
 
-	const uint16 VoxelHalfNumX = Request.voxel_num_x() / 2;
-	const uint16 VoxelHalfNumY = Request.voxel_num_y() / 2;
-	const uint16 VoxelHalfNumZ = Request.voxel_num_z() / 2;
-
-	const FVector Extent = DemoRLServiceHelpers::FromProtoVector3f(Request.extent());
+	return tongos::ResponseStatus::OK;
+}
 
-	FVoxelGridQueryParam QueryParam{World};
-	UGameplayStatics::GetAllActorsOfClass(World, AActor::StaticClass(), QueryParam.Actors);
+tongos::ResponseStatus UDemoRLSubsystem::BatchQueryVoxel(
+	const tongsim_lite::voxel::BatchQueryVoxelRequest& Request, TArray<TArray<uint8>>& OutVoxelGrids,
+	TArray<FVoxelGridEncoding>& OutEncodings)
+{
+	UWorld* World = Instance ? Instance->GetWorld() : DemoRLServiceHelpers::GetGameWorld();
+	if (!World)
+	{
+		return tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "No valid UWorld.");
+	}
 
-	for (const tongsim_lite::object::ObjectId& ActorId_Proto : Request.actorstoignore())
+	TArray<FVoxelGridQueryParam> QueryParams;
+	TArray<TPair<tsvoxel::Encoding, EVoxelGridCompression>> Encodings;
+	QueryParams.Reserve(Request.queries_size());
+	Encodings.SetNum(Request.queries_size());
+	for (int32 i = 0; i < Request.queries_size(); ++i)
 	{
-		if (AActor* ActorToIgnore = DemoRLServiceHelpers::FindActorByObjectId(ActorId_Proto))
+		tongos::ResponseStatus Status = DemoRLServiceHelpers::MakeVoxelQueryParam(Request.queries(i), QueryParams.Emplace_GetRef(World));
+		if (Status.ok())
+		{
+			Status = DemoRLServiceHelpers::GetVoxelEncoding(Request.queries(i), Encodings[i].Key, Encodings[i].Value);
+		}
+		if (!Status.ok())
 		{
-			QueryParam.Actors.Remove(ActorToIgnore);
+			return tongos::ResponseStatus(Status.error_code(), "queries[" + std::to_string(i) + "]: " + Status.error_message());
+		}
+	}
+	// 先由常驻地图接走能接的查询，剩下的一次批量体素化
+	UTSVoxelMap* VoxelMap = World->GetSubsystem<UTSVoxelMap>();
+	OutVoxelGrids.SetNum(QueryParams.Num());
+	TArray<FVoxelGridQueryParam> StatelessParams;
+	TArray<int32> StatelessIndices;
+	for (int32 i = 0; i < QueryParams.Num(); ++i)
+	{
+		if (!VoxelMap || !Request.queries(i).use_voxel_map() || !VoxelMap->QueryVoxelGrids(QueryParams[i], OutVoxelGrids[i]))
+		{
+			StatelessParams.Add(QueryParams[i]);
+			StatelessIndices.Add(i);
+		}
+	}
+	if (StatelessIndices.Num() == QueryParams.Num())
+	{
+		TSVoxelGridFuncLib::BatchQueryVoxelGrids(QueryParams, OutVoxelGrids);
+	}
+	else if (!StatelessIndices.IsEmpty())
+	{
+		TArray<TArray<uint8>> StatelessGrids;
+		TSVoxelGridFuncLib::BatchQueryVoxelGrids(StatelessParams, StatelessGrids);
+		for (int32 j = 0; j < StatelessIndices.Num(); ++j)
+		{
+			OutVoxelGrids[StatelessIndices[j]] = MoveTemp(StatelessGrids[j]);
 		}
 	}
 
-	QueryParam.GridBox = FVoxelBox{
-		QueryTransform, VoxelHalfNumX, VoxelHalfNumY, VoxelHalfNumZ, Extent * 2.f
-	};
-	TArray<uint8> VoxelGrids;
-	TSVoxelGridFuncLib::QueryVoxelGrids(QueryParam, VoxelGrids, World);
-
-	Response.set_voxel_buffer(static_cast<uint8*>(VoxelGrids.GetData()), VoxelGrids.Num());
+	// 编码与压缩只读写各自的缓冲，各体素盒并行
+	OutEncodings.SetNum(QueryParams.Num());
+	ParallelFor(QueryParams.Num(), [&](int32 i)
+	{
+		TSVoxelGridFuncLib::EncodeVoxelGrids(QueryParams[i].GridBox, Encodings[i].Key, Encodings[i].Value,
+		                                     OutVoxelGrids[i], OutEncodings[i]);
+	});
 
 	return tongos::ResponseStatus::OK;
 }
 
+void UDemoRLSubsystem::FQueryVoxelReactor::onRequest(tongsim_lite::voxel::QueryVoxelRequest& Request)
+{
+	// 体素缓冲的所有权交给 grpc，发送完成后在 grpc 线程上释放
+	std::shared_ptr<TArray<uint8>> VoxelGrids = std::make_shared<TArray<uint8>>();
+	FVoxelGridEncoding Encoding;
+	const tongos::ResponseStatus Status = QueryVoxel(Request, *VoxelGrids, Encoding);
+	if (!Status.ok())
+	{
+		finish(Status);
+		return;
+	}
+
+	tongsim_lite::voxel::Voxel Response;
+	Response.set_encoding(static_cast<tongsim_lite::voxel::VoxelEncoding>(Encoding.Encoding));
+	Response.set_compression(static_cast<tongsim_lite::voxel::VoxelCompression>(Encoding.Compression));
+	Response.set_raw_size(Encoding.RawSize);
+
+	tongos::RpcExternalBytes VoxelBuffer;
+	VoxelBuffer.field_number = tongsim_lite::voxel::Voxel::kVoxelBufferFieldNumber;
+	VoxelBuffer.data = VoxelGrids->GetData();
+	VoxelBuffer.size = VoxelGrids->Num();
+	VoxelBuffer.owner = VoxelGrids;
+	writeAndFinish(Response, {std::move(VoxelBuffer)});
+}
+
+void UDemoRLSubsystem::FBatchQueryVoxelReactor::onRequest(tongsim_lite::voxel::BatchQueryVoxelRequest& Request)
+{
+	std::shared_ptr<TArray<TArray<uint8>>> VoxelGrids = std::make_shared<TArray<TArray<uint8>>>();
+	TArray<FVoxelGridEncoding> Encodings;
+	const tongos::ResponseStatus Status = BatchQueryVoxel(Request, *VoxelGrids, Encodings);
+	if (!Status.ok())
+	{
+		finish(Status);
+		return;
+	}
+
+	tongsim_lite::voxel::BatchVoxel Response;
+	for (const FVoxelGridEncoding& Encoding : Encodings)
+	{
+		Response.add_encodings(static_cast<tongsim_lite::voxel::VoxelEncoding>(Encoding.Encoding));
+		Response.add_compressions(static_cast<tongsim_lite::voxel::VoxelCompression>(Encoding.Compression));
+		Response.add_raw_sizes(Encoding.RawSize);
+	}
+
+	// 每个体素盒一个 voxel_buffers 元素，共用同一个 owner；稀疏编码下空体素盒的缓冲为空，也要占一个元素
+	std::vector<tongos::RpcExternalBytes> VoxelBuffers;
+	VoxelBuffers.reserve(VoxelGrids->Num());
+	for (const TArray<uint8>& Grids : *VoxelGrids)
+	{
+		tongos::RpcExternalBytes VoxelBuffer;
+		VoxelBuffer.field_number = tongsim_lite::voxel::BatchVoxel::kVoxelBuffersFieldNumber;
+		VoxelBuffer.data = Grids.GetData();
+		VoxelBuffer.size = Grids.Num();
+		VoxelBuffer.owner = VoxelGrids;
+		VoxelBuffer.repeated = true;
+		VoxelBuffers.push_back(std::move(VoxelBuffer));
+	}
+	writeAndFinish(Response, std::move(VoxelBuffers));
+}
+
+void UDemoRLSubsystem::FQueryStateColumnsReactor::onRequest(tongsim_lite::demo_rl::QueryStateColumnsRequest& Request)
+{
+	UTSGrpcSubsystem* GrpcSubsystem = UTSGrpcSubsystem::GetInstance();
+	if (!GrpcSubsystem || !Instance)
+	{
+		finish(tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "No valid TongSim gRPC Subsystem."));
+		return;
+	}
+
+	FDemoRLStringTable& StringTable = Instance->StateStringTable;
+	StringTable.TrimIfNeeded();
+
+	std::shared_ptr<FDemoRLStateColumns> Columns = std::make_shared<FDemoRLStateColumns>();
+	Columns->Build(GrpcSubsystem->GetActorRegistry(), Request, StringTable);
+
+	tongsim_lite::demo_rl::DemoRLStateColumns Response;
+	Response.set_count(static_cast<uint32>(Columns->Count));
+	StringTable.FillIncrement(Request.string_table_epoch(), Request.known_string_count(), Response);
+
+	// 列数据与 Columns 同生命周期，发送完成后一起释放
+	auto Field = [&Columns](int FieldNumber, const auto& Array)
+	{
+		tongos::RpcExternalBytes Bytes;
+		Bytes.field_number = FieldNumber;
+		Bytes.data = Array.GetData();
+		Bytes.size = static_cast<size_t>(Array.Num()) * Array.GetTypeSize();
+		Bytes.owner = Columns;
+		return Bytes;
+	};
+	using tongsim_lite::demo_rl::DemoRLStateColumns;
+	writeAndFinish(Response, {
+		Field(DemoRLStateColumns::kIdsFieldNumber, Columns->Ids),
+		Field(DemoRLStateColumns::kLocationsFieldNumber, Columns->Locations),
+		Field(DemoRLStateColumns::kRotationsFieldNumber, Columns->Rotations),
+		Field(DemoRLStateColumns::kBoundsFieldNumber, Columns->Bounds),
+		Field(DemoRLStateColumns::kSpeedsFieldNumber, Columns->Speeds),
+		Field(DemoRLStateColumns::kNameIdsFieldNumber, Columns->NameIds),
+		Field(DemoRLStateColumns::kClassIdsFieldNumber, Columns->ClassIds),
+		Field(DemoRLStateColumns::kTagIdsFieldNumber, Columns->TagIds),
+	});
+}
+
 tongos::ResponseStatus UDemoRLSubsystem::ExecConsoleCommand(
 	tongsim_lite::demo_rl::ExecConsoleCommandRequest& Request,
 	tongsim_lite::demo_rl::ExecConsoleCommandResponse& Response)
@@ -617,6 +887,270 @@ tongos::ResponseStatus UDemoRLSubsystem::QueryNavigationPath(
 	return tongos::ResponseStatus::OK;
 }
 
+/* ---------- BatchQueryNavigationPath Reactor ---------- */
+
+namespace DemoRLNavPath
+{
+	// [HARD LIMIT] 一次最多处理的寻路查询数
+	constexpr int32 kMaxQueriesPerCall = 100000;
+	constexpr int32 kDefaultMaxInFlight = 256;
+	// 客户端来不及接收时暂停推送，结果合并进下一条
+	constexpr size_t kMaxPendingMessages = 2;
+
+	double PathLength(const TArray<FNavPathPoint>& Points)
+	{
+		double Length = 0.0;
+		for (int32 i = 1; i < Points.Num(); ++i)
+		{
+			Length += FVector::Distance(Points[i - 1].Location, Points[i].Location);
+		}
+		return Length;
+	}
+
+	// Douglas-Peucker：保留首尾点，逐段保留离当前线段最远且超过容差的点
+	void SimplifyPath(const TArray<FNavPathPoint>& Points, double Tolerance, TArray<bool>& OutKeep)
+	{
+		const int32 Num = Points.Num();
+		OutKeep.Init(Tolerance <= 0.0 || Num <= 2, Num);
+		if (Tolerance <= 0.0 || Num <= 2)
+		{
+			return;
+		}
+		OutKeep[0] = true;
+		OutKeep[Num - 1] = true;
+
+		TArray<TPair<int32, int32>, TInlineAllocator<32>> Spans;
+		Spans.Emplace(0, Num - 1);
+		while (Spans.Num() > 0)
+		{
+			const TPair<int32, int32> Span = Spans.Pop();
+			const FVector& A = Points[Span.Key].Location;
+			const FVector& B = Points[Span.Value].Location;
+			double MaxDistance = Tolerance;
+			int32 MaxIndex = INDEX_NONE;
+			for (int32 i = Span.Key + 1; i < Span.Value; ++i)
+			{
+				const double Distance = FMath::PointDistToSegment(Points[i].Location, A, B);
+				if (Distance > MaxDistance)
+				{
+					MaxDistance = Distance;
+					MaxIndex = i;
+				}
+			}
+			if (MaxIndex != INDEX_NONE)
+			{
+				OutKeep[MaxIndex] = true;
+				Spans.Emplace(Span.Key, MaxIndex);
+				Spans.Emplace(MaxIndex, Span.Value);
+			}
+		}
+	}
+}
+
+void UDemoRLSubsystem::FBatchQueryNavigationPathReactor::onRequest(tongsim_lite::demo_rl::BatchQueryNavigationPathRequest& request)
+{
+	UWorld* World = Instance ? Instance->GetWorld() : nullptr;
+	if (!World)
+	{
+		this->finish(ResponseStatus(grpc::StatusCode::UNAVAILABLE, "No valid UWorld."));
+		return;
+	}
+	UNavigationSystemV1* Sys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	if (!Sys)
+	{
+		this->finish(ResponseStatus(grpc::StatusCode::UNAVAILABLE, "No NavigationSystem."));
+		return;
+	}
+	ANavigationData* Data = Sys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate);
+	if (!Data)
+	{
+		this->finish(ResponseStatus(grpc::StatusCode::UNAVAILABLE, "No NavData."));
+		return;
+	}
+	if (request.queries_size() > DemoRLNavPath::kMaxQueriesPerCall)
+	{
+		this->finish(ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Too many navigation queries in one call."));
+		return;
+	}
+
+	NavSys = Sys;
+	NavData = Data;
+	QueryFilter = UNavigationQueryFilter::GetQueryFilter(*Data, nullptr, nullptr);
+
+	Starts.Reserve(request.queries_size());
+	Ends.Reserve(request.queries_size());
+	for (const tongsim_lite::demo_rl::NavigationPathQuery& Query : request.queries())
+	{
+		Starts.Add(DemoRLServiceHelpers::FromProtoVector3f(Query.start()));
+		Ends.Add(DemoRLServiceHelpers::FromProtoVector3f(Query.end()));
+	}
+	bAllowPartial = request.allow_partial();
+	bRequireNavigableEnd = request.require_navigable_end_location();
+	CostLimit = request.cost_limit();
+	bOmitPathPoints = request.omit_path_points();
+	SimplifyTolerance = request.simplify_tolerance();
+	MaxInFlight = request.max_in_flight() > 0
+		? static_cast<int32>(FMath::Min<uint32>(request.max_in_flight(), DemoRLNavPath::kMaxQueriesPerCall))
+		: DemoRLNavPath::kDefaultMaxInFlight;
+
+	// 查询在 Tick 里分批发出，结果在之后的 tick 推送
+	Instance->NavPathBatches.Add(this->sharedSelf<FBatchQueryNavigationPathReactor>());
+	DispatchQueries();
+}
+
+void UDemoRLSubsystem::FBatchQueryNavigationPathReactor::onCancel()
+{
+	Abort(ResponseStatus(grpc::StatusCode::CANCELLED, "BatchQueryNavigationPath cancelled by client."));
+}
+
+void UDemoRLSubsystem::FBatchQueryNavigationPathReactor::Abort(const ResponseStatus& Status)
+{
+	if (bFinished)
+	{
+		return;
+	}
+	bFinished = true;
+	if (UNavigationSystemV1* Sys = NavSys.Get())
+	{
+		for (const TPair<uint32, int32>& Query : InFlight)
+		{
+			Sys->AbortAsyncFindPathRequest(Query.Key);
+		}
+	}
+	InFlight.Empty();
+	this->finish(Status);
+}
+
+void UDemoRLSubsystem::FBatchQueryNavigationPathReactor::DispatchQueries()
+{
+	UNavigationSystemV1* Sys = NavSys.Get();
+	ANavigationData* Data = NavData.Get();
+	if (!Sys || !Data)
+	{
+		Abort(ResponseStatus(grpc::StatusCode::UNAVAILABLE, "Navigation data was removed."));
+		return;
+	}
+
+	const std::weak_ptr<FBatchQueryNavigationPathReactor> WeakSelf = this->sharedSelf<FBatchQueryNavigationPathReactor>();
+	while (NextQuery < Starts.Num() && InFlight.Num() < MaxInFlight)
+	{
+		const int32 QueryIndex = NextQuery++;
+		FVector End = Ends[QueryIndex];
+		if (bRequireNavigableEnd)
+		{
+			FNavLocation ProjectedEnd;
+			if (!Sys->ProjectPointToNavigation(End, ProjectedEnd, FVector(100.f, 100.f, 300.f)))
+			{
+				AddFailure(QueryIndex, "End location is not navigable.");
+				continue;
+			}
+			End = ProjectedEnd.Location;
+		}
+
+		FPathFindingQuery Query(nullptr, *Data, Starts[QueryIndex], End, QueryFilter);
+		Query.SetAllowPartialPaths(bAllowPartial);
+		if (CostLimit > 0.f) { Query.CostLimit = CostLimit; }
+
+		// 结果在游戏线程上回调；流可能已经结束，只持有弱引用
+		const uint32 QueryId = Sys->FindPathAsync(FNavAgentProperties::DefaultProperties, Query,
+			FNavPathQueryDelegate::CreateLambda([WeakSelf, QueryIndex](uint32 Id, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+			{
+				if (const std::shared_ptr<FBatchQueryNavigationPathReactor> Self = WeakSelf.lock())
+				{
+					if (Self->InFlight.Remove(Id) > 0)
+					{
+						Self->OnPathFound(QueryIndex, Result == ENavigationQueryResult::Success, Path);
+					}
+				}
+			}));
+		if (QueryId == INVALID_NAVQUERYID)
+		{
+			AddFailure(QueryIndex, "Failed to start path query.");
+			continue;
+		}
+		InFlight.Add(QueryId, QueryIndex);
+	}
+}
+
+void UDemoRLSubsystem::FBatchQueryNavigationPathReactor::OnPathFound(int32 QueryIndex, bool bSuccess, FNavPathSharedPtr Path)
+{
+	if (bFinished)
+	{
+		return;
+	}
+	if (!bSuccess || !Path.IsValid())
+	{
+		AddFailure(QueryIndex, "Path not found.");
+		return;
+	}
+
+	const TArray<FNavPathPoint>& Points = Path->GetPathPoints();
+	tongsim_lite::demo_rl::NavigationPathResult* Out = Pending.add_results();
+	Out->set_query_index(QueryIndex);
+	Out->set_success(true);
+	Out->set_is_partial(Path->IsPartial());
+	Out->set_path_cost(static_cast<float>(Path->GetCost()));
+	Out->set_path_length(static_cast<float>(DemoRLNavPath::PathLength(Points)));
+	if (!bOmitPathPoints)
+	{
+		TArray<bool> bKeep;
+		DemoRLNavPath::SimplifyPath(Points, SimplifyTolerance, bKeep);
+		for (int32 i = 0; i < Points.Num(); ++i)
+		{
+			if (bKeep[i])
+			{
+				*Out->add_path_points() = DemoRLServiceHelpers::ToProtoVector3f(Points[i].Location);
+			}
+		}
+	}
+	++NumCompleted;
+}
+
+void UDemoRLSubsystem::FBatchQueryNavigationPathReactor::AddFailure(int32 QueryIndex, const char* Message)
+{
+	tongsim_lite::demo_rl::NavigationPathResult* Out = Pending.add_results();
+	Out->set_query_index(QueryIndex);
+	Out->set_success(false);
+	Out->set_message(Message);
+	++NumCompleted;
+}
+
+bool UDemoRLSubsystem::FBatchQueryNavigationPathReactor::Tick()
+{
+	if (bFinished)
+	{
+		return false;
+	}
+	DispatchQueries();
+	if (bFinished)
+	{
+		return false;
+	}
+
+	if (Pending.results_size() > 0 && this->pendingWrites() <= DemoRLNavPath::kMaxPendingMessages)
+	{
+		Pending.set_completed(NumCompleted);
+		try
+		{
+			this->write(Pending);
+		}
+		catch (RpcException& Ex)
+		{
+			Abort(Ex.status());
+			return false;
+		}
+		Pending.Clear();
+	}
+
+	if (NumCompleted == Starts.Num() && Pending.results_size() == 0)
+	{
+		bFinished = true;
+		this->finish(ResponseStatus::OK);
+		return false;
+	}
+	return true;
+}
+
 /* ---------- ResetLevel Reactor ---------- */
 
 void UDemoRLSubsystem::FResetLevelReactor::onRequest(tongsim_lite::common::Empty&)
@@ -1362,6 +1896,82 @@ void UDemoRLSubsystem::FPickUpObjectReactor::Tick(float DeltaTime)
 	}
 }
 
+/* ---------- SubscribeState Reactor ---------- */
+
+namespace
+{
+	// 客户端来不及接收时暂停推送；增量总是相对上次发送的帧，跳过的变化会合并进下一条
+	constexpr size_t MaxPendingStateMessages = 2;
+}
+
+void UDemoRLSubsystem::FSubscribeStateReactor::onRequest(tongsim_lite::demo_rl::SubscribeStateRequest& request)
+{
+	if (!Instance)
+	{
+		this->finish(ResponseStatus(grpc::StatusCode::UNAVAILABLE, "DemoRLSubsystem is not available."));
+		return;
+	}
+
+	TickInterval = FMath::Max<uint32>(request.tick_interval(), 1);
+	KeyframeInterval = request.keyframe_interval();
+	bSendEmpty = request.send_empty();
+	// 首条消息在下一个 tick 立即发送
+	TicksSinceSend = TickInterval - 1;
+
+	Instance->StateSubscribers.Add(this->sharedSelf<FSubscribeStateReactor>());
+}
+
+void UDemoRLSubsystem::FSubscribeStateReactor::onCancel()
+{
+	bFinished = true;
+	if (Instance)
+	{
+		Instance->StateSubscribers.Remove(this->sharedSelf<FSubscribeStateReactor>());
+	}
+	this->finish(ResponseStatus(grpc::StatusCode::CANCELLED, "SubscribeState cancelled by client."));
+}
+
+bool UDemoRLSubsystem::FSubscribeStateReactor::Tick(const FDemoRLStateTracker& Tracker)
+{
+	if (bFinished)
+	{
+		return false;
+	}
+	if (++TicksSinceSend < TickInterval)
+	{
+		return true;
+	}
+	if (this->pendingWrites() > MaxPendingStateMessages)
+	{
+		return true;
+	}
+	TicksSinceSend = 0;
+
+	const bool bKeyframe = LastSentFrame == 0 || (KeyframeInterval > 0 && Sequence % KeyframeInterval == 0);
+	tongsim_lite::demo_rl::DemoRLStateDelta Delta;
+	if (!Tracker.BuildDelta(LastSentFrame, bKeyframe, Delta) && !bSendEmpty)
+	{
+		// 没有变化时不发消息，直接推进已同步的帧号
+		LastSentFrame = Tracker.GetFrame();
+		return true;
+	}
+	Delta.set_sequence(Sequence);
+
+	try
+	{
+		this->write(Delta);
+	}
+	catch (RpcException& Ex)
+	{
+		bFinished = true;
+		this->finish(Ex.status());
+		return false;
+	}
+	++Sequence;
+	LastSentFrame = Tracker.GetFrame();
+	return true;
+}
+
 void UDemoRLSubsystem::FDropObjectReactor::onRequest(tongsim_lite::demo_rl::DropObjectRequest& /*request*/)
 {
 	tongsim_lite::demo_rl::DropObjectResponse Resp;
@@ -1414,82 +2024,415 @@ static bool GuidOfActor(const AActor* Actor, FGuid& OutGuid)
 	if (!Actor) return false;
 	if (UTSGrpcSubsystem* GrpcSubsystem = UTSGrpcSubsystem::GetInstance())
 	{
-		const TMap<FGuid, TWeakObjectPtr<AActor>>& Map = GrpcSubsystem->GetIdToActorMap();
-		for (const auto& KVP : Map)
-		{
-			if (KVP.Value.Get() == Actor)
-			{
-				OutGuid = KVP.Key;
-				return true;
-			}
-		}
+		OutGuid = GrpcSubsystem->FindGuidByActor(Actor);
+		return OutGuid.IsValid();
 	}
 	return false;
 }
 
-tongos::ResponseStatus UDemoRLSubsystem::BatchSingleLineTraceByObject(tongsim_lite::demo_rl::BatchSingleLineTraceByObjectRequest& Request, tongsim_lite::demo_rl::BatchSingleLineTraceByObjectResponse& Response)
+namespace DemoRLLineTrace
 {
-	UWorld* World = Instance->GetWorld();
-	if (!IsValid(World))
-		return tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "World invalid");
+	static bool bParallelLineTraces = true;
+	static FAutoConsoleVariableRef CVarParallelLineTraces(TEXT("tongsim.Trace.ParallelLineTraces"),
+		bParallelLineTraces,
+		TEXT("Run batch line trace jobs on task threads under a physics scene read lock. Results keep the request order."));
 
-	// [HARD LIMIT] 一次最多处理 kMaxLineTraceJobsPerCall 条线
-	// TODO:
+	static int32 MinJobsPerTask = 64;
+	static FAutoConsoleVariableRef CVarMinJobsPerTask(TEXT("tongsim.Trace.ParallelMinJobsPerTask"),
+		MinJobsPerTask,
+		TEXT("Minimum number of line trace jobs per task; smaller batches run on the game thread."));
+
+	// [HARD LIMIT] 一次最多处理的射线数
 	constexpr int32 kMaxLineTraceJobsPerCall = 20000;
-	const int32 NumJobs = FMath::Min<int32>(Request.jobs_size(), kMaxLineTraceJobsPerCall);
+	// [HARD LIMIT] TraceRayPattern 一次最多生成的射线数
+	constexpr int32 kMaxRayPatternRays = 2048 * 128;
 
-	// 全局忽略
-	for (int32 JobIndex = 0; JobIndex < NumJobs; ++JobIndex)
-	{
-		const auto& Job = Request.jobs(JobIndex);
+	// [HARD LIMIT] 跨调用缓存的忽略列表数，超过后整体清空
+	constexpr int32 kMaxCachedQueryGroups = 1024;
 
-		// 构造 Query Params
+	// 一组射线共用的查询参数；Key 是 object_types、trace_complex 和忽略 id 的编码
+	struct FQueryGroup
+	{
+		std::string Key;
 		FCollisionObjectQueryParams ObjParams;
-		BuildObjectQueryParams(Job.object_types(), ObjParams);
+		FCollisionQueryParams QueryParams;
+	};
 
-		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(BatchSingleLineTraceByObject), Job.trace_complex());
-		QueryParams.bReturnPhysicalMaterial = false;
+	// 游戏线程上解析好的一条射线，任务线程只读
+	struct FJob
+	{
+		FVector Start;
+		FVector End;
+		int32 Group = 0;
+	};
+
+	// 跨调用缓存：解析好的忽略列表，Actor 失效时重新解析
+	struct FCachedQueryGroup
+	{
+		std::string Key;
+		FCollisionObjectQueryParams ObjParams;
+		TArray<TWeakObjectPtr<AActor>> IgnoredActors;
+	};
+	static TMap<uint64, FCachedQueryGroup> QueryGroupCache;
 
-		for (const auto& Oid : Job.actors_to_ignore())
+	// LineTraceByObjectJob 和 LineTraceQueryGroup 字段名相同
+	template <typename FQuerySource>
+	void MakeQueryKey(const FQuerySource& Source, std::string& OutKey)
+	{
+		uint32 ObjectTypeMask = 0;
+		for (const int Type : Source.object_types())
 		{
-			if (AActor* A = DemoRLServiceHelpers::FindActorByObjectId(Oid))
-				QueryParams.AddIgnoredActor(A);
+			ObjectTypeMask |= 1u << (Type & 31);
 		}
+		OutKey.clear();
+		OutKey.append(reinterpret_cast<const char*>(&ObjectTypeMask), sizeof(ObjectTypeMask));
+		OutKey.push_back(Source.trace_complex() ? 1 : 0);
+		for (const tongsim_lite::object::ObjectId& Oid : Source.actors_to_ignore())
+		{
+			// 带上长度，避免不定长的 id 拼接后产生歧义
+			OutKey.push_back(static_cast<char>(FMath::Min<size_t>(Oid.guid().size(), 255)));
+			OutKey.append(Oid.guid());
+		}
+	}
 
-		// 执行 LineTraceSingleByObjectType
-		FHitResult Hit;
-		const FVector Start(Job.start().x(), Job.start().y(), Job.start().z());
-		const FVector End(Job.end().x(), Job.end().y(), Job.end().z());
-		const bool bHit = World->LineTraceSingleByObjectType(Hit, Start, End, ObjParams, QueryParams);
-
-		auto* Out = Response.add_results();
-		Out->set_job_index(JobIndex);
-		Out->set_blocking_hit(bHit);
+	// 同一请求里相同的参数只建一组；不同请求之间复用 QueryGroupCache 中解析好的忽略列表
+	template <typename FQuerySource>
+	int32 ResolveQueryGroup(const FQuerySource& Source, const FCollisionQueryParams& BaseParams, std::string& Key,
+	                        TMap<uint64, int32>& CallGroups, TArray<FQueryGroup>& OutGroups)
+	{
+		MakeQueryKey(Source, Key);
+		const uint64 Hash = CityHash64(Key.data(), static_cast<uint32>(Key.size()));
+		if (const int32* Existing = CallGroups.Find(Hash))
+		{
+			if (OutGroups[*Existing].Key == Key)
+			{
+				return *Existing;
+			}
+		}
 
-		if (bHit)
+		FCachedQueryGroup* Cached = QueryGroupCache.Find(Hash);
+		bool bCacheValid = Cached && Cached->Key == Key;
+		for (int32 i = 0; bCacheValid && i < Cached->IgnoredActors.Num(); ++i)
 		{
-			Out->set_distance((Hit.ImpactPoint - Start).Size());
-			*Out->mutable_impact_point() = DemoRLServiceHelpers::ToProtoVector3f(Hit.ImpactPoint);
+			bCacheValid = Cached->IgnoredActors[i].IsValid();
+		}
 
-			if (AActor* HitActor = Hit.GetActor())
+		FCachedQueryGroup Resolved;
+		if (!bCacheValid)
+		{
+			Resolved.Key = Key;
+			BuildObjectQueryParams(Source.object_types(), Resolved.ObjParams);
+			bool bAllResolved = true;
+			for (const tongsim_lite::object::ObjectId& Oid : Source.actors_to_ignore())
+			{
+				AActor* A = DemoRLServiceHelpers::FindActorByObjectId(Oid);
+				bAllResolved &= A != nullptr;
+				if (A)
+					Resolved.IgnoredActors.Add(A);
+			}
+			// 有解析不到的 id 时不缓存：对应 Actor 可能稍后才注册
+			Cached = nullptr;
+			if (bAllResolved)
 			{
-				tongsim_lite::demo_rl::ActorState* S = Out->mutable_actor_state();
-				FGuid G;
-				if (GuidOfActor(HitActor, G))
+				if (QueryGroupCache.Num() >= kMaxCachedQueryGroups)
 				{
-					DemoRLServiceHelpers::FillActorState(G, HitActor, *S);
+					QueryGroupCache.Reset();
 				}
-				else
+				Cached = &QueryGroupCache.Add(Hash, Resolved);
+			}
+		}
+		const FCachedQueryGroup& Entry = Cached ? *Cached : Resolved;
+
+		const int32 Index = OutGroups.Num();
+		FQueryGroup& Out = OutGroups.AddDefaulted_GetRef();
+		Out.Key = Key;
+		Out.ObjParams = Entry.ObjParams;
+		Out.QueryParams = BaseParams;
+		Out.QueryParams.bTraceComplex = Source.trace_complex();
+		for (const TWeakObjectPtr<AActor>& A : Entry.IgnoredActors)
+			Out.QueryParams.AddIgnoredActor(A.Get());
+		CallGroups.Add(Hash, Index);
+		return Index;
+	}
+
+	// 解析请求中的射线；忽略列表要查 Actor 注册表，只能在游戏线程做
+	tongos::ResponseStatus BuildJobs(
+		const google::protobuf::RepeatedPtrField<tongsim_lite::demo_rl::LineTraceQueryGroup>& QueryGroups,
+		const google::protobuf::RepeatedPtrField<tongsim_lite::demo_rl::LineTraceByObjectJob>& Jobs,
+		const FCollisionQueryParams& BaseParams, TArray<FQueryGroup>& OutGroups, TArray<FJob>& OutJobs)
+	{
+		const int32 NumJobs = FMath::Min<int32>(Jobs.size(), kMaxLineTraceJobsPerCall);
+		OutGroups.Reset();
+		OutJobs.Reset(NumJobs);
+		TMap<uint64, int32> CallGroups;
+		std::string Key;
+
+		TArray<int32> RequestGroups;
+		RequestGroups.Reserve(QueryGroups.size());
+		for (const tongsim_lite::demo_rl::LineTraceQueryGroup& Group : QueryGroups)
+		{
+			RequestGroups.Add(ResolveQueryGroup(Group, BaseParams, Key, CallGroups, OutGroups));
+		}
+
+		for (int32 JobIndex = 0; JobIndex < NumJobs; ++JobIndex)
+		{
+			const tongsim_lite::demo_rl::LineTraceByObjectJob& Job = Jobs.Get(JobIndex);
+			FJob& Out = OutJobs.AddDefaulted_GetRef();
+			Out.Start = DemoRLServiceHelpers::FromProtoVector3f(Job.start());
+			Out.End = DemoRLServiceHelpers::FromProtoVector3f(Job.end());
+			if (Job.has_query_group())
+			{
+				if (Job.query_group() >= static_cast<uint32>(RequestGroups.Num()))
 				{
-					// 无 Guid（比如不是注册过的 Actor），也返回最基本信息
-					DemoRLServiceHelpers::FillActorState(FGuid(), HitActor, *S);
+					return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Line trace job references an unknown query group.");
 				}
+				Out.Group = RequestGroups[Job.query_group()];
+			}
+			else
+			{
+				Out.Group = ResolveQueryGroup(Job, BaseParams, Key, CallGroups, OutGroups);
+			}
+		}
+		return tongos::ResponseStatus::OK;
+	}
+
+	// 在物理场景读锁内对每条射线执行 Body(JobIndex)，整批射线看到同一个场景状态
+	// 射线足够多时分给多个任务；Body 只能做场景查询并写自己序号的结果槽
+	template <typename FBody>
+	void ExecuteJobs(UWorld* World, int32 NumJobs, const TCHAR* DebugName, FBody Body)
+	{
+		const int32 MinBatchSize = FMath::Max(MinJobsPerTask, 1);
+		const bool bParallel = bParallelLineTraces && NumJobs >= 2 * MinBatchSize && FApp::ShouldUseThreadingForPerformance();
+		auto Run = [&]()
+		{
+			ParallelFor(DebugName, NumJobs, MinBatchSize, Body,
+			            bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+		};
+		if (!FPhysicsCommand::ExecuteRead(World->GetPhysicsScene(), Run))
+		{
+			Run();
+		}
+	}
+
+	// result_detail 对应要返回的字段
+	struct FResultLayout
+	{
+		bool bImpactPoint = false;
+		bool bImpactNormal = false;
+		bool bActorId = false;
+		bool bActorState = false;
+	};
+
+	bool MakeResultLayout(tongsim_lite::demo_rl::LineTraceResultDetail Detail, bool bPacked, FResultLayout& OutLayout)
+	{
+		OutLayout = FResultLayout();
+		switch (Detail)
+		{
+		case tongsim_lite::demo_rl::LINE_TRACE_RESULT_FULL:
+			OutLayout.bImpactPoint = true;
+			OutLayout.bImpactNormal = true;
+			// 列里放不下 ActorState，只给 id
+			OutLayout.bActorId = bPacked;
+			OutLayout.bActorState = !bPacked;
+			return true;
+		case tongsim_lite::demo_rl::LINE_TRACE_RESULT_DISTANCE:
+			return true;
+		case tongsim_lite::demo_rl::LINE_TRACE_RESULT_DISTANCE_NORMAL:
+			OutLayout.bImpactNormal = true;
+			return true;
+		case tongsim_lite::demo_rl::LINE_TRACE_RESULT_ID_LOCATION:
+			OutLayout.bImpactPoint = true;
+			OutLayout.bActorId = true;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// 命中 Actor 的 GUID；没有 Actor 或未注册时为全 0
+	void HitActorGuidBytes(const AActor* HitActor, uint8 OutBytes[16])
+	{
+		FGuid G;
+		GuidOfActor(HitActor, G);
+		DemoRLServiceHelpers::FGuidToBytesLE(G, OutBytes);
+	}
+
+	// 单条命中写进 SingleLineTraceByObjectResult / MultiLineTraceHit，两者字段名相同
+	template <typename FHitMessage>
+	void FillHitMessage(const FResultLayout& Layout, const FVector& ImpactPoint, const FVector& ImpactNormal,
+	                    const AActor* HitActor, FHitMessage& Out)
+	{
+		if (Layout.bImpactPoint)
+		{
+			*Out.mutable_impact_point() = DemoRLServiceHelpers::ToProtoVector3f(ImpactPoint);
+		}
+		if (Layout.bImpactNormal)
+		{
+			*Out.mutable_impact_normal() = DemoRLServiceHelpers::ToProtoVector3f(ImpactNormal);
+		}
+		if (!HitActor)
+		{
+			return;
+		}
+		if (Layout.bActorId)
+		{
+			uint8 GuidBytes[16];
+			HitActorGuidBytes(HitActor, GuidBytes);
+			Out.mutable_actor_id()->set_guid(reinterpret_cast<const char*>(GuidBytes), 16);
+		}
+		if (Layout.bActorState)
+		{
+			// 无 Guid（比如不是注册过的 Actor），也返回最基本信息
+			FGuid G;
+			GuidOfActor(HitActor, G);
+			DemoRLServiceHelpers::FillActorState(G, HitActor, *Out.mutable_actor_state());
+		}
+	}
+
+	// 直接写进响应的 bytes 字段，整批结果是几段连续内存，不再逐条建消息
+	class FColumnWriter
+	{
+	public:
+		FColumnWriter(const FResultLayout& Layout, int32 Count, int32 NumJobsForHitCounts,
+		              tongsim_lite::demo_rl::LineTraceResultColumns& Columns)
+		{
+			Columns.set_count(static_cast<uint32>(Count));
+			Distances = Resize(*Columns.mutable_distances(), Count * sizeof(float));
+			ImpactPoints = Layout.bImpactPoint ? Resize(*Columns.mutable_impact_points(), Count * 3 * sizeof(float)) : nullptr;
+			ImpactNormals = Layout.bImpactNormal ? Resize(*Columns.mutable_impact_normals(), Count * 3 * sizeof(float)) : nullptr;
+			ActorIds = Layout.bActorId ? Resize(*Columns.mutable_actor_ids(), Count * 16) : nullptr;
+			HitCounts = NumJobsForHitCounts > 0 ? Resize(*Columns.mutable_hit_counts(), NumJobsForHitCounts * sizeof(uint32)) : nullptr;
+		}
+
+		// 未命中的记录只写距离，其余列保持 0
+		void Write(int32 Index, float Distance, const FVector& ImpactPoint, const FVector& ImpactNormal, const AActor* HitActor)
+		{
+			FMemory::Memcpy(Distances + Index * sizeof(float), &Distance, sizeof(float));
+			if (Distance < 0.f)
+			{
+				return;
+			}
+			if (ImpactPoints)
+			{
+				WriteVector(ImpactPoints + Index * 3 * sizeof(float), ImpactPoint);
+			}
+			if (ImpactNormals)
+			{
+				WriteVector(ImpactNormals + Index * 3 * sizeof(float), ImpactNormal);
+			}
+			if (ActorIds && HitActor)
+			{
+				WriteActorId(Index, HitActor);
 			}
 		}
+
+		// 要查 Actor 注册表，只能在游戏线程调用
+		void WriteActorId(int32 Index, const AActor* HitActor)
+		{
+			HitActorGuidBytes(HitActor, ActorIds + Index * 16);
+		}
+
+		void SetHitCount(int32 JobIndex, uint32 NumHits)
+		{
+			FMemory::Memcpy(HitCounts + JobIndex * sizeof(uint32), &NumHits, sizeof(uint32));
+		}
+
+	private:
+		static uint8* Resize(std::string& Bytes, size_t Size)
+		{
+			Bytes.assign(Size, '\0');
+			return reinterpret_cast<uint8*>(Bytes.data());
+		}
+
+		static void WriteVector(uint8* Out, const FVector& V)
+		{
+			const float F[3] = {static_cast<float>(V.X), static_cast<float>(V.Y), static_cast<float>(V.Z)};
+			FMemory::Memcpy(Out, F, sizeof(F));
+		}
+
+		uint8* Distances = nullptr;
+		uint8* ImpactPoints = nullptr;
+		uint8* ImpactNormals = nullptr;
+		uint8* ActorIds = nullptr;
+		uint8* HitCounts = nullptr;
+	};
+
+	// 标准正态噪声；只由种子和射线序号决定，与任务划分无关
+	float GaussianNoise(uint32 Seed, uint32 Index)
+	{
+		const uint32 H1 = MurmurFinalize32(Seed ^ (Index * 0x9E3779B9u));
+		const uint32 H2 = MurmurFinalize32(H1 ^ 0x85EBCA6Bu);
+		const float U1 = ((H1 >> 8) + 0.5f) / 16777216.f;
+		const float U2 = (H2 >> 8) / 16777216.f;
+		return FMath::Sqrt(-2.f * FMath::Loge(U1)) * FMath::Cos(2.f * PI * U2);
+	}
+}
+
+tongos::ResponseStatus UDemoRLSubsystem::BatchSingleLineTraceByObject(tongsim_lite::demo_rl::BatchSingleLineTraceByObjectRequest& Request, tongsim_lite::demo_rl::BatchSingleLineTraceByObjectResponse& Response)
+{
+	UWorld* World = Instance->GetWorld();
+	if (!IsValid(World))
+		return tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "World invalid");
+
+	DemoRLLineTrace::FResultLayout Layout;
+	if (!DemoRLLineTrace::MakeResultLayout(Request.result_detail(), Request.packed(), Layout))
+		return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Unknown line trace result detail.");
+
+	FCollisionQueryParams BaseParams(SCENE_QUERY_STAT(BatchSingleLineTraceByObject), false);
+	BaseParams.bReturnPhysicalMaterial = false;
+	TArray<DemoRLLineTrace::FQueryGroup> Groups;
+	TArray<DemoRLLineTrace::FJob> Jobs;
+	const tongos::ResponseStatus BuildStatus = DemoRLLineTrace::BuildJobs(Request.query_groups(), Request.jobs(), BaseParams, Groups, Jobs);
+	if (!BuildStatus.ok())
+		return BuildStatus;
+
+	// 执行 LineTraceSingleByObjectType，结果按 job 序号写入
+	TArray<FHitResult> Hits;
+	TArray<bool> bHits;
+	Hits.SetNum(Jobs.Num());
+	bHits.SetNumZeroed(Jobs.Num());
+	DemoRLLineTrace::ExecuteJobs(World, Jobs.Num(), TEXT("BatchSingleLineTraceByObject"), [&](int32 JobIndex)
+	{
+		const DemoRLLineTrace::FJob& Job = Jobs[JobIndex];
+		const DemoRLLineTrace::FQueryGroup& Group = Groups[Job.Group];
+		bHits[JobIndex] = World->LineTraceSingleByObjectType(Hits[JobIndex], Job.Start, Job.End, Group.ObjParams, Group.QueryParams);
+	});
+
+	// Actor 注册表和 Actor 状态只能在游戏线程访问，按请求顺序写响应
+	if (Request.packed())
+	{
+		DemoRLLineTrace::FColumnWriter Columns(Layout, Jobs.Num(), 0, *Response.mutable_columns());
+		for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+		{
+			const FHitResult& Hit = Hits[JobIndex];
+			const float Distance = bHits[JobIndex] ? (Hit.ImpactPoint - Jobs[JobIndex].Start).Size() : -1.f;
+			Columns.Write(JobIndex, Distance, Hit.ImpactPoint, Hit.ImpactNormal, Hit.GetActor());
+		}
+		return tongos::ResponseStatus::OK;
+	}
+
+	Response.mutable_results()->Reserve(Jobs.Num());
+	for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+	{
+		const FHitResult& Hit = Hits[JobIndex];
+		const bool bHit = bHits[JobIndex];
+
+		auto* Out = Response.add_results();
+		Out->set_job_index(JobIndex);
+		Out->set_blocking_hit(bHit);
+
+		if (bHit)
+		{
+			Out->set_distance((Hit.ImpactPoint - Jobs[JobIndex].Start).Size());
+			DemoRLLineTrace::FillHitMessage(Layout, Hit.ImpactPoint, Hit.ImpactNormal, Hit.GetActor(), *Out);
+		}
 		else
 		{
 			Out->set_distance(0.f);
-			*Out->mutable_impact_point() = DemoRLServiceHelpers::ToProtoVector3f(FVector::ZeroVector);
+			if (Layout.bImpactPoint)
+			{
+				*Out->mutable_impact_point() = DemoRLServiceHelpers::ToProtoVector3f(FVector::ZeroVector);
+			}
 		}
 	}
 
@@ -1497,117 +2440,265 @@ tongos::ResponseStatus UDemoRLSubsystem::BatchSingleLineTraceByObject(tongsim_li
 }
 
 tongos::ResponseStatus UDemoRLSubsystem::BatchMultiLineTraceByObject(
-    tongsim_lite::demo_rl::BatchMultiLineTraceByObjectRequest& Request,
-    tongsim_lite::demo_rl::BatchMultiLineTraceByObjectResponse& Response)
+	tongsim_lite::demo_rl::BatchMultiLineTraceByObjectRequest& Request,
+	tongsim_lite::demo_rl::BatchMultiLineTraceByObjectResponse& Response)
 {
-    UWorld* World = Instance->GetWorld();
-    if (!IsValid(World))
-        return tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "World invalid");
-
-    constexpr int32 kMaxLineTraceJobsPerCall = 20000; // 与 single 保持一致
-    const int32 NumJobs = FMath::Min<int32>(Request.jobs_size(), kMaxLineTraceJobsPerCall);
-    const bool bEnableDebugDraw = Request.enable_debug_draw();
-
-    for (int32 JobIndex = 0; JobIndex < NumJobs; ++JobIndex)
-    {
-        const auto& Job = Request.jobs(JobIndex);
-
-        // 1) 构造 Object/Query 参数（与 single 相同）
-        FCollisionObjectQueryParams ObjParams;
-        BuildObjectQueryParams(Job.object_types(), ObjParams); // 你已有的工具函数
-        FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(BatchMultiLineTraceByObject), Job.trace_complex());
-        QueryParams.bReturnPhysicalMaterial = false;
-
-        for (const auto& Oid : Job.actors_to_ignore())
-        {
-            if (AActor* A = DemoRLServiceHelpers::FindActorByObjectId(Oid))
-                QueryParams.AddIgnoredActor(A);
-        }
-
-        // 2) 执行 Multi Trace
-        const FVector Start(Job.start().x(), Job.start().y(), Job.start().z());
-        const FVector End(Job.end().x(), Job.end().y(), Job.end().z());
-        TArray<FHitResult> Hits;
-        const bool bAnyHit = World->LineTraceMultiByObjectType(Hits, Start, End, ObjParams, QueryParams);
-
-        // 3) 仅保留 blocking，按距离升序
-        bool bHasBlockingHits = false;
-        if (bAnyHit)
-        {
-            // 过滤 blocking
-            Hits = Hits.FilterByPredicate([](const FHitResult& H){ return H.bBlockingHit; });
-            bHasBlockingHits = Hits.Num() > 0;
-
-            // 按从起点的距离排序（有些平台 H.Distance 未必可靠，这里用 ImpactPoint 与 Start 计算）
-            Hits.Sort([&Start](const FHitResult& A, const FHitResult& B)
-            {
-                const double DA = FVector::Dist(A.ImpactPoint, Start);
-                const double DB = FVector::Dist(B.ImpactPoint, Start);
-                return DA < DB;
-            });
-        }
-        else
-        {
-            Hits.Reset();
-        }
+	UWorld* World = Instance->GetWorld();
+	if (!IsValid(World))
+		return tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "World invalid");
+
+	const bool bEnableDebugDraw = Request.enable_debug_draw();
+
+	DemoRLLineTrace::FResultLayout Layout;
+	if (!DemoRLLineTrace::MakeResultLayout(Request.result_detail(), Request.packed(), Layout))
+		return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Unknown line trace result detail.");
+
+	// 1) 构造 Object/Query 参数（与 single 相同）
+	FCollisionQueryParams BaseParams(SCENE_QUERY_STAT(BatchMultiLineTraceByObject), false);
+	BaseParams.bReturnPhysicalMaterial = false;
+	TArray<DemoRLLineTrace::FQueryGroup> Groups;
+	TArray<DemoRLLineTrace::FJob> Jobs;
+	const tongos::ResponseStatus BuildStatus = DemoRLLineTrace::BuildJobs(Request.query_groups(), Request.jobs(), BaseParams, Groups, Jobs);
+	if (!BuildStatus.ok())
+		return BuildStatus;
+
+	// 2) 执行 Multi Trace，3) 仅保留 blocking，按距离升序；都在任务线程上完成
+	TArray<TArray<FHitResult>> JobHits;
+	JobHits.SetNum(Jobs.Num());
+	DemoRLLineTrace::ExecuteJobs(World, Jobs.Num(), TEXT("BatchMultiLineTraceByObject"), [&](int32 JobIndex)
+	{
+		const DemoRLLineTrace::FJob& Job = Jobs[JobIndex];
+		TArray<FHitResult>& Hits = JobHits[JobIndex];
+		const DemoRLLineTrace::FQueryGroup& Group = Groups[Job.Group];
+		if (!World->LineTraceMultiByObjectType(Hits, Job.Start, Job.End, Group.ObjParams, Group.QueryParams))
+		{
+			Hits.Reset();
+			return;
+		}
+
+		Hits.RemoveAll([](const FHitResult& H){ return !H.bBlockingHit; });
+
+		// 按从起点的距离排序（有些平台 H.Distance 未必可靠，这里用 ImpactPoint 与 Start 计算）
+		const FVector Start = Job.Start;
+		Hits.Sort([&Start](const FHitResult& A, const FHitResult& B)
+		{
+			const double DA = FVector::Dist(A.ImpactPoint, Start);
+			const double DB = FVector::Dist(B.ImpactPoint, Start);
+			return DA < DB;
+		});
+	});
+
+	// 4) 回到游戏线程按请求顺序写响应；packed 时所有命中拼接成一组列
+	TOptional<DemoRLLineTrace::FColumnWriter> Columns;
+	int32 Record = 0;
+	if (Request.packed())
+	{
+		int32 NumHits = 0;
+		for (const TArray<FHitResult>& Hits : JobHits)
+		{
+			NumHits += Hits.Num();
+		}
+		Columns.Emplace(Layout, NumHits, Jobs.Num(), *Response.mutable_columns());
+	}
+	else
+	{
+		Response.mutable_results()->Reserve(Jobs.Num());
+	}
+	for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+	{
+		const FVector& Start = Jobs[JobIndex].Start;
+		const TArray<FHitResult>& Hits = JobHits[JobIndex];
+		const bool bHasBlockingHits = Hits.Num() > 0;
 
 #if ENABLE_DRAW_DEBUG
-        if (bEnableDebugDraw)
-        {
-            const float DebugLifeTime = 0.1f;
-            const FColor LineColor = bHasBlockingHits ? FColor::Red : FColor::Green;
-            DrawDebugLine(World, Start, End, LineColor, false, DebugLifeTime, 0, 1.5f);
-            DrawDebugPoint(World, Start, 8.0f, FColor::Cyan, false, DebugLifeTime);
-            DrawDebugPoint(World, End, 8.0f, FColor::Cyan, false, DebugLifeTime);
-
-            if (bHasBlockingHits)
-            {
-                for (const FHitResult& Hit : Hits)
-                {
-                    const FVector ImpactPoint = !Hit.ImpactPoint.IsNearlyZero() ? Hit.ImpactPoint : Hit.Location;
-                    const FVector ImpactNormal = !Hit.ImpactNormal.IsNearlyZero() ? Hit.ImpactNormal : Hit.Normal;
-
-                    DrawDebugPoint(World, ImpactPoint, 10.0f, FColor::Yellow, false, DebugLifeTime);
-                    DrawDebugLine(World, Start, Hit.Location, FColor::Orange, false, DebugLifeTime, 0, 0.9f);
-
-                    if (!ImpactNormal.IsNearlyZero())
-                    {
-                        DrawDebugLine(World, ImpactPoint, ImpactPoint + ImpactNormal * 50.0f, FColor::Cyan, false, DebugLifeTime, 0, 1.0f);
-                    }
-                }
-            }
-        }
+		if (bEnableDebugDraw)
+		{
+			const FVector& End = Jobs[JobIndex].End;
+			const float DebugLifeTime = 0.1f;
+			const FColor LineColor = bHasBlockingHits ? FColor::Red : FColor::Green;
+			DrawDebugLine(World, Start, End, LineColor, false, DebugLifeTime, 0, 1.5f);
+			DrawDebugPoint(World, Start, 8.0f, FColor::Cyan, false, DebugLifeTime);
+			DrawDebugPoint(World, End, 8.0f, FColor::Cyan, false, DebugLifeTime);
+
+			for (const FHitResult& Hit : Hits)
+			{
+				const FVector ImpactPoint = !Hit.ImpactPoint.IsNearlyZero() ? Hit.ImpactPoint : Hit.Location;
+				const FVector ImpactNormal = !Hit.ImpactNormal.IsNearlyZero() ? Hit.ImpactNormal : Hit.Normal;
+
+				DrawDebugPoint(World, ImpactPoint, 10.0f, FColor::Yellow, false, DebugLifeTime);
+				DrawDebugLine(World, Start, Hit.Location, FColor::Orange, false, DebugLifeTime, 0, 0.9f);
+
+				if (!ImpactNormal.IsNearlyZero())
+				{
+					DrawDebugLine(World, ImpactPoint, ImpactPoint + ImpactNormal * 50.0f, FColor::Cyan, false, DebugLifeTime, 0, 1.0f);
+				}
+			}
+		}
 #endif
 
-        // 4) 写回响应
-        auto* Out = Response.add_results();
-        Out->set_job_index(JobIndex);
-
-        for (const FHitResult& H : Hits)
-        {
-            auto* HH = Out->add_hits();
-            const FVector ImpactPoint = !H.ImpactPoint.IsNearlyZero() ? H.ImpactPoint : H.Location;
-            const FVector ImpactNormal = !H.ImpactNormal.IsNearlyZero() ? H.ImpactNormal : H.Normal;
-            HH->set_distance((ImpactPoint - Start).Size());
-            *HH->mutable_impact_point() = DemoRLServiceHelpers::ToProtoVector3f(ImpactPoint);
-            *HH->mutable_impact_normal() = DemoRLServiceHelpers::ToProtoVector3f(ImpactNormal);
-
-            if (AActor* HitActor = H.GetActor())
-            {
-                tongsim_lite::demo_rl::ActorState* S = HH->mutable_actor_state();
-                FGuid G;
-                if (GuidOfActor(HitActor, G)) // 你已有的工具函数
-                {
-                    DemoRLServiceHelpers::FillActorState(G, HitActor, *S);
-                }
-                else
-                {
-                    // 没有注册 GUID 也返回基本信息
-                    DemoRLServiceHelpers::FillActorState(FGuid(), HitActor, *S);
-                }
-            }
-        }
-    }
-
-    return tongos::ResponseStatus::OK;
+		if (Columns)
+		{
+			Columns->SetHitCount(JobIndex, Hits.Num());
+			for (const FHitResult& H : Hits)
+			{
+				const FVector ImpactPoint = !H.ImpactPoint.IsNearlyZero() ? H.ImpactPoint : H.Location;
+				const FVector ImpactNormal = !H.ImpactNormal.IsNearlyZero() ? H.ImpactNormal : H.Normal;
+				Columns->Write(Record++, (ImpactPoint - Start).Size(), ImpactPoint, ImpactNormal, H.GetActor());
+			}
+			continue;
+		}
+
+		auto* Out = Response.add_results();
+		Out->set_job_index(JobIndex);
+
+		for (const FHitResult& H : Hits)
+		{
+			auto* HH = Out->add_hits();
+			const FVector ImpactPoint = !H.ImpactPoint.IsNearlyZero() ? H.ImpactPoint : H.Location;
+			const FVector ImpactNormal = !H.ImpactNormal.IsNearlyZero() ? H.ImpactNormal : H.Normal;
+			HH->set_distance((ImpactPoint - Start).Size());
+			DemoRLLineTrace::FillHitMessage(Layout, ImpactPoint, ImpactNormal, H.GetActor(), *HH);
+		}
+	}
+
+	return tongos::ResponseStatus::OK;
+}
+
+tongos::ResponseStatus UDemoRLSubsystem::TraceRayPattern(
+	tongsim_lite::demo_rl::TraceRayPatternRequest& Request,
+	tongsim_lite::demo_rl::TraceRayPatternResponse& Response)
+{
+	UWorld* World = Instance->GetWorld();
+	if (!IsValid(World))
+		return tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "World invalid");
+
+	const uint32 Rows = Request.vertical_resolution();
+	const uint32 Cols = Request.horizontal_resolution();
+	if (Rows == 0 || Cols == 0 || static_cast<uint64>(Rows) * Cols > DemoRLLineTrace::kMaxRayPatternRays)
+		return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Ray pattern resolution must be positive and within the ray limit.");
+
+	const float HorizontalFov = Request.horizontal_fov();
+	const float VerticalFov = Request.vertical_fov();
+	const float MaxRange = Request.max_range();
+	if (!(HorizontalFov > 0.f && HorizontalFov <= 360.f) || !(VerticalFov > 0.f && VerticalFov <= 180.f) || !(MaxRange > 0.f))
+		return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Invalid ray pattern field of view or range.");
+
+	if (Request.query().object_types_size() == 0)
+		return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Ray pattern query needs at least one object type.");
+
+	DemoRLLineTrace::FResultLayout Layout;
+	if (!DemoRLLineTrace::MakeResultLayout(Request.result_detail(), true, Layout))
+		return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Unknown line trace result detail.");
+
+	// 传感器位姿，不带缩放
+	FTransform SensorPose;
+	AActor* OriginActor = nullptr;
+	switch (Request.origin_case())
+	{
+	case tongsim_lite::demo_rl::TraceRayPatternRequest::kActorId:
+	{
+		OriginActor = DemoRLServiceHelpers::FindActorByObjectId(Request.actor_id());
+		if (!OriginActor)
+			return tongos::ResponseStatus(grpc::StatusCode::NOT_FOUND, "Actor not found.");
+		SensorPose = FTransform(OriginActor->GetActorQuat(), OriginActor->GetActorLocation());
+		if (Request.has_sensor_offset())
+		{
+			FTransform Offset = DemoRLServiceHelpers::FromProtoTransform(Request.sensor_offset());
+			Offset.SetScale3D(FVector::OneVector);
+			SensorPose = Offset * SensorPose;
+		}
+		break;
+	}
+	case tongsim_lite::demo_rl::TraceRayPatternRequest::kPose:
+		SensorPose = DemoRLServiceHelpers::FromProtoTransform(Request.pose());
+		SensorPose.SetScale3D(FVector::OneVector);
+		break;
+	default:
+		return tongos::ResponseStatus(grpc::StatusCode::INVALID_ARGUMENT, "Ray pattern needs an origin actor or pose.");
+	}
+
+	// 查询参数与批量射线共用解析和缓存；原点 Actor 不参与检测
+	FCollisionQueryParams BaseParams(SCENE_QUERY_STAT(TraceRayPattern), false);
+	BaseParams.bReturnPhysicalMaterial = false;
+	if (OriginActor)
+	{
+		BaseParams.AddIgnoredActor(OriginActor);
+	}
+	TArray<DemoRLLineTrace::FQueryGroup> Groups;
+	TMap<uint64, int32> CallGroups;
+	std::string Key;
+	const int32 GroupIndex = DemoRLLineTrace::ResolveQueryGroup(Request.query(), BaseParams, Key, CallGroups, Groups);
+	const DemoRLLineTrace::FQueryGroup& Group = Groups[GroupIndex];
+
+	// 方向按行、列可分离：每行一个仰角，每列一个水平角，都取格子中心
+	TArray<float> RowCos, RowSin, ColCos, ColSin;
+	RowCos.SetNumUninitialized(Rows);
+	RowSin.SetNumUninitialized(Rows);
+	ColCos.SetNumUninitialized(Cols);
+	ColSin.SetNumUninitialized(Cols);
+	for (uint32 Row = 0; Row < Rows; ++Row)
+	{
+		const float Pitch = FMath::DegreesToRadians(VerticalFov * (0.5f - (Row + 0.5f) / Rows));
+		FMath::SinCos(&RowSin[Row], &RowCos[Row], Pitch);
+	}
+	for (uint32 Col = 0; Col < Cols; ++Col)
+	{
+		const float Yaw = FMath::DegreesToRadians(HorizontalFov * ((Col + 0.5f) / Cols - 0.5f));
+		FMath::SinCos(&ColSin[Col], &ColCos[Col], Yaw);
+	}
+
+	const int32 NumRays = static_cast<int32>(Rows * Cols);
+	const FVector Start = SensorPose.GetLocation();
+	const FQuat SensorRotation = SensorPose.GetRotation();
+	const float NoiseStddev = FMath::Max(Request.range_noise_stddev(), 0.f);
+	const uint32 NoiseSeed = Request.has_noise_seed() ? Request.noise_seed() : static_cast<uint32>(GFrameCounter);
+
+	Response.set_rows(Rows);
+	Response.set_cols(Cols);
+	*Response.mutable_sensor_pose() = DemoRLServiceHelpers::ToProtoTransform(SensorPose);
+
+	// 任务线程直接写距离、命中点和法线列；Actor id 要查注册表，先记下命中的 Actor
+	DemoRLLineTrace::FColumnWriter Columns(Layout, NumRays, 0, *Response.mutable_columns());
+	TArray<const AActor*> HitActors;
+	if (Layout.bActorId)
+	{
+		HitActors.SetNumZeroed(NumRays);
+	}
+	DemoRLLineTrace::ExecuteJobs(World, NumRays, TEXT("TraceRayPattern"), [&](int32 RayIndex)
+	{
+		const uint32 Row = RayIndex / Cols;
+		const uint32 Col = RayIndex % Cols;
+		const FVector Direction = SensorRotation.RotateVector(
+			FVector(RowCos[Row] * ColCos[Col], RowCos[Row] * ColSin[Col], RowSin[Row]));
+
+		FHitResult Hit;
+		if (!World->LineTraceSingleByObjectType(Hit, Start, Start + Direction * MaxRange, Group.ObjParams, Group.QueryParams))
+		{
+			Columns.Write(RayIndex, -1.f, FVector::ZeroVector, FVector::ZeroVector, nullptr);
+			return;
+		}
+
+		float Distance = (Hit.ImpactPoint - Start).Size();
+		FVector ImpactPoint = Hit.ImpactPoint;
+		if (NoiseStddev > 0.f)
+		{
+			Distance = FMath::Clamp(Distance + NoiseStddev * DemoRLLineTrace::GaussianNoise(NoiseSeed, RayIndex), 0.f, MaxRange);
+			ImpactPoint = Start + Direction * Distance;
+		}
+		Columns.Write(RayIndex, Distance, ImpactPoint, Hit.ImpactNormal, nullptr);
+		if (HitActors.Num() > 0)
+		{
+			HitActors[RayIndex] = Hit.GetActor();
+		}
+	});
+
+	for (int32 RayIndex = 0; RayIndex < HitActors.Num(); ++RayIndex)
+	{
+		if (HitActors[RayIndex])
+		{
+			Columns.WriteActorId(RayIndex, HitActors[RayIndex]);
+		}
+	}
+
+	return tongos::ResponseStatus::OK;
 }
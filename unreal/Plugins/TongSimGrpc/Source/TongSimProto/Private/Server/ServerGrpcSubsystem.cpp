@@ -0,0 +1,81 @@
+#include "Server/ServerGrpcSubsystem.h"
+
+#include "grpcpp/support/status.h"
+#include "TongosGrpc/Public/TSGrpcSubsystem.h"
+#include "rpc_metrics.h"
+#include "rpc_object_pool.h"
+
+namespace
+{
+	void ToProtoLatency(const tongos::RpcLatencyHistogram& Histogram, tongsim_lite::server::LatencySummary& Out)
+	{
+		Out.set_count(Histogram.count());
+		Out.set_mean_us(Histogram.mean());
+		Out.set_p50_us(Histogram.percentile(0.5));
+		Out.set_p90_us(Histogram.percentile(0.9));
+		Out.set_p99_us(Histogram.percentile(0.99));
+		Out.set_max_us(Histogram.max());
+	}
+}
+
+void UServerGrpcSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Collection.InitializeDependency<UTSGrpcSubsystem>();
+	UTSGrpcSubsystem* GrpcSubsystem = UTSGrpcSubsystem::GetInstance();
+	if (!IsValid(GrpcSubsystem))
+	{
+		return;
+	}
+
+	// 只读原子计数，不访问UObject，可以直接在cq线程上处理
+	GrpcSubsystem->RegisterUnaryHandler("/tongsim_lite.server.ServerService/GetServerMetrics", &ThisClass::GetServerMetrics, tongos::RpcLane::CQ_THREAD);
+}
+
+tongos::ResponseStatus UServerGrpcSubsystem::GetServerMetrics(
+	tongsim_lite::server::GetServerMetricsRequest& Request,
+	tongsim_lite::server::ServerMetrics& Response)
+{
+	const UTSGrpcSubsystem* GrpcSubsystem = UTSGrpcSubsystem::GetInstance();
+	if (!GrpcSubsystem)
+	{
+		return tongos::ResponseStatus(grpc::StatusCode::UNAVAILABLE, "No valid TongSim gRPC Subsystem.");
+	}
+
+	Response.set_event_queue_depth(GrpcSubsystem->GetEventQueueDepth());
+	Response.set_calls_in_flight(GrpcSubsystem->GetCallsInFlight());
+	Response.set_write_queue_length(GrpcSubsystem->GetWriteQueueLength());
+	Response.set_cq_worker_num(GrpcSubsystem->GetCompletionQueueWorkerNum());
+	Response.set_lane_pool_thread_num(GrpcSubsystem->GetLanePoolThreadNum());
+
+	const tongos::RpcObjectPool::Stats PoolStats = tongos::RpcObjectPool::stats();
+	tongsim_lite::server::ObjectPoolStats* ObjectPool = Response.mutable_object_pool();
+	ObjectPool->set_pooled_allocs(PoolStats.pooled_allocs);
+	ObjectPool->set_heap_allocs(PoolStats.heap_allocs);
+	ObjectPool->set_frees(PoolStats.frees);
+	ObjectPool->set_cached_blocks(PoolStats.cached_blocks);
+	ObjectPool->set_cached_bytes(PoolStats.cached_bytes);
+
+	GrpcSubsystem->ForEachRouteMetrics([&Request, &Response](tongos::RpcRouteMetrics& Metrics)
+	{
+		const uint64 Calls = Metrics.calls.load(std::memory_order_relaxed);
+		if (Calls > 0 || Request.include_idle_routes())
+		{
+			tongsim_lite::server::RouteMetrics* Route = Response.add_routes();
+			Route->set_method(Metrics.method);
+			Route->set_calls(Calls);
+			Route->set_failed_calls(Metrics.failed_calls.load(std::memory_order_relaxed));
+			ToProtoLatency(Metrics.phase(tongos::RpcPhase::QUEUE_WAIT), *Route->mutable_queue_wait());
+			ToProtoLatency(Metrics.phase(tongos::RpcPhase::HANDLER), *Route->mutable_handler());
+			ToProtoLatency(Metrics.phase(tongos::RpcPhase::SERIALIZE), *Route->mutable_serialize());
+			ToProtoLatency(Metrics.phase(tongos::RpcPhase::WRITE_DRAIN), *Route->mutable_write_drain());
+		}
+		if (Request.reset())
+		{
+			Metrics.reset();
+		}
+	});
+
+	return tongos::ResponseStatus::OK;
+}
@@ -6,6 +6,7 @@
 #include "rpc_reactor.h"
 
 #include <memory>
+#include <vector>
 
 #include <tongsim_lite_protobuf/capture.pb.h>
 
@@ -95,9 +96,10 @@ private:
 	static void GuidToObjectId(const FGuid& Guid, tongsim_lite::object::ObjectId& OutId);
 	static tongsim_lite::capture::CaptureCameraParams ToProtoParams(const struct FTSCaptureCameraParams& Params);
 	static void FromProtoParams(const tongsim_lite::capture::CaptureCameraParams& Proto, struct FTSCaptureCameraParams& Out);
-	static tongsim_lite::capture::CaptureFrame ToProtoFrame(const FGuid& CameraGuid, const TSharedPtr<struct FTSCaptureFrame>& Frame, const FCaptureCameraState* State, bool bIncludeColor, bool bIncludeDepth);
+	// OutExternalBytes 非空时 rgba8/depth_r32 不拷贝进 proto，而是以外部内存的形式追加到 OutExternalBytes
+	static tongsim_lite::capture::CaptureFrame ToProtoFrame(const FGuid& CameraGuid, const TSharedPtr<struct FTSCaptureFrame>& Frame, const FCaptureCameraState* State, bool bIncludeColor, bool bIncludeDepth, std::vector<tongos::RpcExternalBytes>* OutExternalBytes = nullptr);
 	static tongsim_lite::capture::CaptureCameraStatus ToProtoStatus(const struct FTSCaptureStatus& Status);
 
 	void UpdateStatusFromSubsystem(FGuid CameraGuid, FCaptureCameraState& State);
-	static tongos::ResponseStatus CaptureSnapshotInternal(const tongsim_lite::capture::CaptureSnapshotRequest& Req, tongsim_lite::capture::CaptureFrame& OutFrame);
+	static tongos::ResponseStatus CaptureSnapshotInternal(const tongsim_lite::capture::CaptureSnapshotRequest& Req, tongsim_lite::capture::CaptureFrame& OutFrame, std::vector<tongos::RpcExternalBytes>* OutExternalBytes = nullptr);
 };
@@ -0,0 +1,61 @@
+// DemoRLStateColumns.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+#include <string>
+
+#include <tongsim_lite_protobuf/demo_rl.pb.h>
+
+class AActor;
+class FTSActorRegistry;
+
+/**
+ * QueryStateColumns 的字符串表：名称、类路径、tag 只转换一次 UTF-8，之后按下标引用。
+ * 只增不减，客户端按 (Epoch, 已知条数) 增量同步；条数超过上限时整体重建并换新的 Epoch。
+ */
+class FDemoRLStringTable
+{
+public:
+	FDemoRLStringTable();
+
+	uint32 InternName(FName Name);
+	uint32 InternClass(const UClass* Class);
+
+	uint64 GetEpoch() const { return Epoch; }
+	int32 Num() const { return Strings.Num(); }
+
+	/** 把客户端还没有的字符串写进响应 */
+	void FillIncrement(uint64 ClientEpoch, uint32 KnownCount, tongsim_lite::demo_rl::DemoRLStateColumns& Out) const;
+
+	/** 超过上限时重建，在一次导出开始前调用，避免同一响应里的下标跨两个版本 */
+	void TrimIfNeeded();
+
+private:
+	void Reset();
+	uint32 Add(std::string&& Value);
+
+	uint64 Epoch = 0;
+	TArray<std::string> Strings;
+	TMap<FName, uint32> NameToIndex;
+	TMap<FObjectKey, uint32> ClassToIndex;
+};
+
+/** 一次导出的列数据；作为外部内存直接拼进响应，发送完成后释放 */
+struct FDemoRLStateColumns
+{
+	int32 Count = 0;
+	TArray<uint8> Ids;
+	TArray<float> Locations;
+	TArray<float> Rotations;
+	TArray<float> Bounds;
+	TArray<float> Speeds;
+	TArray<uint32> NameIds;
+	TArray<uint32> ClassIds;
+	TArray<uint32> TagIds;
+
+	/** 按请求里的类/tag 过滤，顺序遍历注册表中存活的 Actor */
+	void Build(const FTSActorRegistry& Registry, const tongsim_lite::demo_rl::QueryStateColumnsRequest& Request, FDemoRLStringTable& StringTable);
+};
@@ -0,0 +1,76 @@
+// DemoRLStateTracker.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <string>
+
+#include <tongsim_lite_protobuf/demo_rl.pb.h>
+
+class AActor;
+class UTSGrpcSubsystem;
+
+/**
+ * SubscribeState 的共享状态缓存。
+ * 有订阅者时每个 tick 扫描一次已注册 Actor，记下每个 Actor 最后一次生成/变化/销毁的帧号；
+ * 订阅者只需比较帧号挑出自己上次发送之后变化的 Actor，组包时直接读缓存，不再访问 Actor。
+ */
+class FDemoRLStateTracker
+{
+public:
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+
+		// ObjectInfo 在第一次见到时转换一次
+		std::string GuidBytes;
+		std::string Name;
+		std::string ClassPath;
+		// AInfo 只输出 ObjectInfo，与 QueryState 一致
+		bool bInfoOnly = false;
+
+		FVector Location = FVector::ZeroVector;
+		FQuat Rotation = FQuat::Identity;
+		FVector Scale = FVector::OneVector;
+		FBox Bounds = FBox(ForceInit);
+		FName Tag;
+		std::string TagUtf8;
+		float Speed = 0.f;
+
+		uint64 SpawnFrame = 0;
+		uint64 ChangedFrame = 0;
+		// 0 表示存活
+		uint64 DestroyedFrame = 0;
+		uint64 SeenFrame = 0;
+		// 包围盒在 Actor 移动时重新计算，另外每隔若干帧轮询一次，兜住不改变位姿的形变
+		int32 TicksUntilBoundsRefresh = 0;
+	};
+
+	/** 扫描一次已注册 Actor，帧号加一 */
+	void Update(const UTSGrpcSubsystem& GrpcSubsystem);
+
+	/** 所有订阅者都已发送到 MinSentFrame 之后，丢弃不再需要的销毁记录 */
+	void PurgeTombstones(uint64 MinSentFrame);
+
+	/** 没有订阅者时释放缓存；帧号保持递增 */
+	void Reset();
+
+	uint64 GetFrame() const { return Frame; }
+	int32 Num() const { return Entries.Num(); }
+
+	/**
+	 * 生成 LastSentFrame 之后的增量。
+	 * bKeyframe 为 true 时 updated 里是全部存活 Actor；返回消息中是否有内容
+	 */
+	bool BuildDelta(uint64 LastSentFrame, bool bKeyframe, tongsim_lite::demo_rl::DemoRLStateDelta& Out) const;
+
+	static void FillActorState(const FEntry& Entry, tongsim_lite::demo_rl::ActorState& OutState);
+
+private:
+	void InitEntry(FEntry& Entry, const FGuid& Guid, AActor* Actor);
+	void RefreshEntry(FEntry& Entry, AActor* Actor);
+
+	uint64 Frame = 0;
+	TMap<FGuid, FEntry> Entries;
+};
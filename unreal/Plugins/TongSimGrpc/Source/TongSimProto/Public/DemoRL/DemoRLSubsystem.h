@@ -4,7 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "AI/Navigation/NavigationTypes.h"
 #include "rpc_reactor.h"
+#include "DemoRL/DemoRLStateColumns.h"
+#include "DemoRL/DemoRLStateTracker.h"
 
 // Protobuf
 #include <tongsim_lite_protobuf/common.pb.h>
@@ -19,8 +22,11 @@ namespace tongos
 	class ResponseStatus;
 }
 
+struct FVoxelGridEncoding;
 class AAIController;
 class ACharacter;
+class ANavigationData;
+class UNavigationSystemV1;
 class UTSItemInteractComponent;
 
 UCLASS()
@@ -41,6 +47,9 @@ public:
 	// World hook
 	void HandlePostWorldInit(UWorld* World, const UWorld::InitializationValues IVS);
 
+	/** 更新共享状态缓存并给 SubscribeState 订阅者推送增量 */
+	void TickStateSubscribers();
+
 	/* ---------- Unary Handlers ---------- */
 
 	/** QueryState: 返回全局 Actor 状态列表 */
@@ -68,10 +77,17 @@ public:
 		tongsim_lite::demo_rl::SpawnActorRequest& Request,
 		tongsim_lite::demo_rl::SpawnActorResponse& Response);
 
-	/** TODO: */
+	/** QueryVoxel: 体素化查询，结果按请求的 encoding/compression 编码后写入 OutVoxelGrids */
 	static tongos::ResponseStatus QueryVoxel(
-		tongsim_lite::voxel::QueryVoxelRequest& Request,
-		tongsim_lite::voxel::Voxel& Response);
+		const tongsim_lite::voxel::QueryVoxelRequest& Request,
+		TArray<uint8>& OutVoxelGrids,
+		FVoxelGridEncoding& OutEncoding);
+
+	/** BatchQueryVoxel: 一次查询多个体素盒，OutVoxelGrids/OutEncodings 与 queries 一一对应 */
+	static tongos::ResponseStatus BatchQueryVoxel(
+		const tongsim_lite::voxel::BatchQueryVoxelRequest& Request,
+		TArray<TArray<uint8>>& OutVoxelGrids,
+		TArray<FVoxelGridEncoding>& OutEncodings);
 
 	/** ExecConsoleCommand: 执行 UE 控制台命令 */
 	static tongos::ResponseStatus ExecConsoleCommand(
@@ -94,8 +110,39 @@ public:
 	static tongos::ResponseStatus BatchMultiLineTraceByObject(
 		tongsim_lite::demo_rl::BatchMultiLineTraceByObjectRequest& Request,
 		tongsim_lite::demo_rl::BatchMultiLineTraceByObjectResponse& Response);
+
+	static tongos::ResponseStatus TraceRayPattern(
+		tongsim_lite::demo_rl::TraceRayPatternRequest& Request,
+		tongsim_lite::demo_rl::TraceRayPatternResponse& Response);
 	/* ---------- Reactor(s) ---------- */
 
+	/** QueryVoxel 的 Reactor：voxel_buffer 以外部内存发送，不拷贝进 proto */
+	class FQueryVoxelReactor final
+		: public tongos::RpcReactorUnary<tongsim_lite::voxel::QueryVoxelRequest, tongsim_lite::voxel::Voxel>
+	{
+	public:
+		void onRequest(tongsim_lite::voxel::QueryVoxelRequest& Request) override;
+	};
+
+	/** BatchQueryVoxel 的 Reactor：每个体素盒的缓冲都以外部内存发送 */
+	class FBatchQueryVoxelReactor final
+		: public tongos::RpcReactorUnary<tongsim_lite::voxel::BatchQueryVoxelRequest, tongsim_lite::voxel::BatchVoxel>
+	{
+	public:
+		void onRequest(tongsim_lite::voxel::BatchQueryVoxelRequest& Request) override;
+	};
+
+	/** QueryStateColumns 的 Reactor：各列以外部内存发送 */
+	class FQueryStateColumnsReactor final
+		: public tongos::RpcReactorUnary<tongsim_lite::demo_rl::QueryStateColumnsRequest, tongsim_lite::demo_rl::DemoRLStateColumns>
+	{
+	public:
+		void onRequest(tongsim_lite::demo_rl::QueryStateColumnsRequest& Request) override;
+	};
+
+	/** QueryStateColumns 的字符串表，跨请求复用 */
+	FDemoRLStringTable StateStringTable;
+
 	/** ResetLevel 的 Reactor：Unary + 异步完成 */
 	class FResetLevelReactor final
 		: public tongos::RpcReactorUnary<tongsim_lite::common::Empty, tongsim_lite::common::Empty>
@@ -227,6 +274,79 @@ public:
 
 	TMap<FGuid, std::shared_ptr<FPickUpObjectReactor>> PickUpReactorMap;
 
+	/** SubscribeState 的 Reactor：按 tick 推送变化的 Actor 状态，首条及周期性关键帧推送全量 */
+	class FSubscribeStateReactor final
+		: public tongos::RpcReactorServerStreaming<tongsim_lite::demo_rl::SubscribeStateRequest, tongsim_lite::demo_rl::DemoRLStateDelta>
+	{
+	public:
+		void onRequest(tongsim_lite::demo_rl::SubscribeStateRequest& request) override;
+		void onCancel() override;
+
+		/** 返回 false 表示订阅已结束 */
+		bool Tick(const FDemoRLStateTracker& Tracker);
+
+		friend class UDemoRLSubsystem;
+
+	private:
+		uint32 TickInterval = 1;
+		uint32 KeyframeInterval = 0;
+		bool bSendEmpty = false;
+
+		uint32 TicksSinceSend = 0;
+		uint64 Sequence = 0;
+		// 上一条消息对应的 Tracker 帧号，0 表示还没发送过
+		uint64 LastSentFrame = 0;
+		bool bFinished = false;
+	};
+
+	TArray<std::shared_ptr<FSubscribeStateReactor>> StateSubscribers;
+	FDemoRLStateTracker StateTracker;
+
+	/** BatchQueryNavigationPath 的 Reactor：FindPathAsync 批量寻路，每个 tick 推送已完成的结果 */
+	class FBatchQueryNavigationPathReactor final
+		: public tongos::RpcReactorServerStreaming<tongsim_lite::demo_rl::BatchQueryNavigationPathRequest, tongsim_lite::demo_rl::BatchQueryNavigationPathResponse>
+	{
+	public:
+		void onRequest(tongsim_lite::demo_rl::BatchQueryNavigationPathRequest& request) override;
+		void onCancel() override;
+
+		/** 返回 false 表示已结束 */
+		bool Tick();
+
+		/** 放弃还在寻路线程上的查询并结束流 */
+		void Abort(const tongos::ResponseStatus& Status);
+
+		friend class UDemoRLSubsystem;
+
+	private:
+		void DispatchQueries();
+		void OnPathFound(int32 QueryIndex, bool bSuccess, FNavPathSharedPtr Path);
+		void AddFailure(int32 QueryIndex, const char* Message);
+
+		TWeakObjectPtr<UNavigationSystemV1> NavSys;
+		TWeakObjectPtr<ANavigationData> NavData;
+		FSharedConstNavQueryFilter QueryFilter;
+
+		TArray<FVector> Starts;
+		TArray<FVector> Ends;
+		bool bAllowPartial = false;
+		bool bRequireNavigableEnd = false;
+		float CostLimit = 0.f;
+		bool bOmitPathPoints = false;
+		float SimplifyTolerance = 0.f;
+		int32 MaxInFlight = 0;
+
+		int32 NextQuery = 0;
+		int32 NumCompleted = 0;
+		// FindPathAsync 返回的查询 id -> 请求下标
+		TMap<uint32, int32> InFlight;
+		// 还没发出去的结果，每个 tick 合并成一条消息
+		tongsim_lite::demo_rl::BatchQueryNavigationPathResponse Pending;
+		bool bFinished = false;
+	};
+
+	TArray<std::shared_ptr<FBatchQueryNavigationPathReactor>> NavPathBatches;
+
 	/** DropObject 的 Reactor：先打通 gRPC，UE 逻辑留空 */
 	class FDropObjectReactor final
 		: public tongos::RpcReactorUnary<tongsim_lite::demo_rl::DropObjectRequest, tongsim_lite::demo_rl::DropObjectResponse>
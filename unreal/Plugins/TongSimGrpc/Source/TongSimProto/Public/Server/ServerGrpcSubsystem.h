@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "rpc_reactor.h"
+
+#include <tongsim_lite_protobuf/server.pb.h>
+
+#include "ServerGrpcSubsystem.generated.h"
+
+namespace tongos
+{
+	class ResponseStatus;
+}
+
+/**
+ * 内置的服务端自检接口（tongsim_lite.server.ServerService）
+ * 在cq线程上处理，游戏线程卡住时依然能返回
+ */
+UCLASS()
+class UServerGrpcSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** GetServerMetrics: 各路由分阶段延迟与队列计量 */
+	static tongos::ResponseStatus GetServerMetrics(
+		tongsim_lite::server::GetServerMetricsRequest& Request,
+		tongsim_lite::server::ServerMetrics& Response);
+};
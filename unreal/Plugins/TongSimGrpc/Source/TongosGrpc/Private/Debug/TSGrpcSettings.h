@@ -23,4 +23,84 @@ public:
 	UPROPERTY(Config, EditAnywhere, Category="TongSim|Debug")
 	bool bSerializeGrpcMessage = false;
 
+	/** 监听地址，命令行 -GrpcHost= 覆盖 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	FString ServerHost = TEXT("0.0.0.0");
+
+	/** 监听端口，命令行 -GrpcPort= 覆盖 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	int32 ServerPort = 5726;
+
+	/** 非空时改为监听 unix domain socket（忽略 Host/Port），命令行 -GrpcUnixSocket= 覆盖 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	FString UnixSocketPath;
+
+	/** CQ worker 线程数，<=0 表示按 CPU 核数自动选择，命令行 -GrpcWorkers= 覆盖 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	int32 CompletionQueueWorkerNum = 0;
+
+	/** 每个 CQ 上预投递的 RequestCall 数 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server", meta=(ClampMin=1))
+	int32 PendingCallsPerWorker = 4;
+
+	/** WORKER_POOL 线路的线程数 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server", meta=(ClampMin=1))
+	int32 LanePoolThreadNum = 2;
+
+	/** 单条消息最大字节数（MB），-1 表示不限制，0 表示 gRPC 默认值，命令行 -GrpcMaxMessageMB= 覆盖 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	int32 MaxSendMessageSizeMB = 512;
+
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	int32 MaxReceiveMessageSizeMB = 512;
+
+	/** keepalive ping 间隔（毫秒），0 表示不开启 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	int32 KeepAliveTimeMs = 30000;
+
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	int32 KeepAliveTimeoutMs = 10000;
+
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	bool bKeepAlivePermitWithoutCalls = true;
+
+	/** 单个连接的最大并发流数，0 表示 gRPC 默认值 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	int32 MaxConcurrentStreams = 0;
+
+	/** gRPC 资源配额：内存上限（MB）与线程上限，0 表示不限制 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	int32 ResourceQuotaMemoryMB = 0;
+
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	int32 ResourceQuotaMaxThreads = 0;
+
+	/** 复用每次调用的 RpcStream / reactor / arena 块内存，关闭后每次调用直接 new/delete */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Server")
+	bool bPoolRpcObjects = true;
+
+	/** tongos 日志级别：0 DEBUG, 1 INFO, 2 WARN, 4 FATAL */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Log", meta=(ClampMin=0, ClampMax=4))
+	int32 LogLevel = 1;
+
+	/** 日志文件路径，相对路径基于 Saved/Logs；为空时不写文件 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Log")
+	FString LogFilePath = TEXT("TongosGrpc.log");
+
+	/** 单个日志文件上限（MB），超过后滚动，0 表示不滚动 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Log")
+	int32 MaxLogFileSizeMB = 64;
+
+	/** 滚动后保留的旧文件数 */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Log")
+	int32 MaxLogFiles = 5;
+
+	/** 批量写盘的时间间隔（毫秒） */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Log", meta=(ClampMin=1))
+	int32 LogFlushIntervalMs = 200;
+
+	/** 同时输出到 UE_LOG(LogTongosGrpc) */
+	UPROPERTY(Config, EditAnywhere, Category="TongSim|Log")
+	bool bRouteLogToUE = false;
+
 };
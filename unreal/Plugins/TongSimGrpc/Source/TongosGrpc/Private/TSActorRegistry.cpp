@@ -0,0 +1,120 @@
+#include "TSActorRegistry.h"
+
+#include "GameFramework/Actor.h"
+
+namespace
+{
+	tongos::SlotHandle HandleOf(const FGuid& Guid)
+	{
+		return {static_cast<uint32>(Guid.C), static_cast<uint32>(Guid.D)};
+	}
+}
+
+FGuid FTSActorRegistry::Register(AActor* Actor)
+{
+	check(Actor);
+	if (const FTSActorRecord* Existing = FindLiveRecord(Actor))
+	{
+		return Existing->Guid;
+	}
+
+	FTSActorRecord NewRecord;
+	NewRecord.Actor = Actor;
+	NewRecord.ObjectIndex = Actor->GetUniqueID();
+	const tongos::SlotHandle Handle = Records.insert(MoveTemp(NewRecord));
+
+	// A 段最低位置 1，保证 GUID 有效
+	const FGuid Random = FGuid::NewGuid();
+	FTSActorRecord& Record = *Records.find(Handle);
+	Record.Guid = FGuid(Random.A | 1u, Random.B, Handle.index, Handle.generation);
+
+	if (static_cast<uint32>(ObjectIndexToSlot.Num()) <= Record.ObjectIndex)
+	{
+		ObjectIndexToSlot.SetNumZeroed(FMath::Max<int32>(Record.ObjectIndex + 1, ObjectIndexToSlot.Num() * 2));
+	}
+	ObjectIndexToSlot[Record.ObjectIndex] = Handle.index + 1;
+	return Record.Guid;
+}
+
+FGuid FTSActorRegistry::MarkDestroyed(AActor* Actor)
+{
+	FTSActorRecord* Record = FindLiveRecord(Actor);
+	if (!Record)
+	{
+		return FGuid();
+	}
+	Record->bDestroyed = true;
+	// 下标可能很快被新对象复用，墓碑只能再按 GUID 找到
+	ObjectIndexToSlot[Record->ObjectIndex] = 0;
+	return Record->Guid;
+}
+
+AActor* FTSActorRegistry::FindActor(const FGuid& Guid) const
+{
+	const FTSActorRecord* Record = FindRecord(Guid);
+	return Record && !Record->bDestroyed ? Record->Actor.Get() : nullptr;
+}
+
+const FTSActorRecord* FTSActorRegistry::FindRecord(const FGuid& Guid) const
+{
+	const FTSActorRecord* Record = Records.find(HandleOf(Guid));
+	return Record && Record->Guid == Guid ? Record : nullptr;
+}
+
+FGuid FTSActorRegistry::FindGuid(const AActor* Actor) const
+{
+	const FTSActorRecord* Record = FindLiveRecord(Actor);
+	return Record ? Record->Guid : FGuid();
+}
+
+int32 FTSActorRegistry::Purge()
+{
+	TArray<tongos::SlotHandle> Dead;
+	for (size_t i = 0; i < Records.size(); ++i)
+	{
+		const FTSActorRecord& Record = Records[i];
+		if (Record.bDestroyed || !Record.Actor.IsValid())
+		{
+			Dead.Add(Records.handleAt(i));
+		}
+	}
+
+	for (const tongos::SlotHandle& Handle : Dead)
+	{
+		const FTSActorRecord& Record = *Records.find(Handle);
+		// 被 GC 但没收到销毁回调的 Actor，下标映射可能还指向这里
+		if (static_cast<uint32>(ObjectIndexToSlot.Num()) > Record.ObjectIndex && ObjectIndexToSlot[Record.ObjectIndex] == Handle.index + 1)
+		{
+			ObjectIndexToSlot[Record.ObjectIndex] = 0;
+		}
+		Records.erase(Handle);
+	}
+	return Dead.Num();
+}
+
+void FTSActorRegistry::Reset()
+{
+	Records.clear();
+	ObjectIndexToSlot.Reset();
+}
+
+FTSActorRecord* FTSActorRegistry::FindLiveRecord(const AActor* Actor)
+{
+	return const_cast<FTSActorRecord*>(static_cast<const FTSActorRegistry*>(this)->FindLiveRecord(Actor));
+}
+
+const FTSActorRecord* FTSActorRegistry::FindLiveRecord(const AActor* Actor) const
+{
+	if (!Actor)
+	{
+		return nullptr;
+	}
+	const uint32 ObjectIndex = Actor->GetUniqueID();
+	if (static_cast<uint32>(ObjectIndexToSlot.Num()) <= ObjectIndex || ObjectIndexToSlot[ObjectIndex] == 0)
+	{
+		return nullptr;
+	}
+	const FTSActorRecord* Record = Records.find(Records.handleOf(ObjectIndexToSlot[ObjectIndex] - 1));
+	// 下标被复用时弱指针的序列号对不上
+	return Record && !Record->bDestroyed && Record->Actor.Get() == Actor ? Record : nullptr;
+}
@@ -1,9 +1,16 @@
 ﻿#include "TSGrpcSubsystem.h"
 
-#include "EngineUtils.h"
+#include "Engine/Level.h"
+#include "Core/TSCommandLineParams.h"
+#include "Debug/TSGrpcSettings.h"
+#include "Performance/TSPerformanceStatSubSystem.h"
 #include "rpc_event.h"
+#include "rpc_lane_pool.h"
+#include "rpc_object_pool.h"
 #include "rpc_server.h"
-#include "util/channel.h"
+#include "rpc_write_queue.h"
+#include "util/logger.h"
+#include "util/mpsc_channel.h"
 
 DECLARE_STATS_GROUP(TEXT("TongSim gRPC"), STATGROUP_gRPC, STATCAT_Advanced);
 
@@ -11,6 +18,67 @@ DECLARE_CYCLE_STAT(TEXT("TongSim gRPC Tick Handling"), STAT_UTSGrpcSubsystem_Upd
 
 UTSGrpcSubsystem* UTSGrpcSubsystem::Instance = nullptr;
 
+namespace
+{
+	constexpr size_t EventChannelCapacity = 65536;
+	constexpr size_t EventDrainBatchSize = 1024;
+
+	int MegabytesToBytes(int32 MB)
+	{
+		// -1 不限制，0 使用 gRPC 默认值
+		return MB > 0 ? static_cast<int>(FMath::Min<int64>(static_cast<int64>(MB) * 1024 * 1024, MAX_int32)) : MB;
+	}
+
+	tongos::RpcServerOptions MakeServerOptions(const UTSGrpcSettings& Settings, const FTSCommandLineParams& CommandLineParams)
+	{
+		tongos::RpcServerOptions Options;
+
+		// 命令行优先于配置；指定了 unix socket 时不再监听 TCP
+		const FString& UnixSocket = CommandLineParams.GrpcUnixSocket.IsEmpty() ? Settings.UnixSocketPath : CommandLineParams.GrpcUnixSocket;
+		if (!UnixSocket.IsEmpty())
+		{
+			Options.address = TCHAR_TO_UTF8(*(TEXT("unix:") + UnixSocket));
+		}
+		else
+		{
+			const FString& Host = CommandLineParams.GrpcHost.IsEmpty() ? Settings.ServerHost : CommandLineParams.GrpcHost;
+			const int32 Port = CommandLineParams.GrpcPort > 0 ? CommandLineParams.GrpcPort : Settings.ServerPort;
+			Options.address = TCHAR_TO_UTF8(*FString::Printf(TEXT("%s:%d"), *Host, Port));
+		}
+
+		const int32 MaxMessageMB = CommandLineParams.GrpcMaxMessageMB;
+		Options.max_send_message_size = MegabytesToBytes(MaxMessageMB != 0 ? MaxMessageMB : Settings.MaxSendMessageSizeMB);
+		Options.max_receive_message_size = MegabytesToBytes(MaxMessageMB != 0 ? MaxMessageMB : Settings.MaxReceiveMessageSizeMB);
+		Options.keepalive_time_ms = Settings.KeepAliveTimeMs;
+		Options.keepalive_timeout_ms = Settings.KeepAliveTimeoutMs;
+		Options.keepalive_permit_without_calls = Settings.bKeepAlivePermitWithoutCalls;
+		Options.max_concurrent_streams = Settings.MaxConcurrentStreams;
+		Options.resource_quota_memory_bytes = static_cast<int64>(Settings.ResourceQuotaMemoryMB) * 1024 * 1024;
+		Options.resource_quota_max_threads = Settings.ResourceQuotaMaxThreads;
+		return Options;
+	}
+
+	tongos::LoggerOptions MakeLoggerOptions(const UTSGrpcSettings& Settings)
+	{
+		tongos::LoggerOptions Options;
+		if (!Settings.LogFilePath.IsEmpty())
+		{
+			const FString LogFile = FPaths::IsRelative(Settings.LogFilePath) ? FPaths::Combine(FPaths::ProjectLogDir(), Settings.LogFilePath) : Settings.LogFilePath;
+			Options.file_path = TCHAR_TO_UTF8(*FPaths::ConvertRelativePathToFull(LogFile));
+		}
+		else
+		{
+			Options.file_path.clear();
+		}
+		Options.level = Settings.LogLevel;
+		Options.flush_interval_ms = FMath::Max(Settings.LogFlushIntervalMs, 1);
+		Options.max_file_bytes = static_cast<uint64>(FMath::Max(Settings.MaxLogFileSizeMB, 0)) * 1024 * 1024;
+		Options.max_files = Settings.MaxLogFiles;
+		Options.route_to_ue_log = Settings.bRouteLogToUE;
+		return Options;
+	}
+}
+
 void UTSGrpcSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
@@ -21,12 +89,14 @@ void UTSGrpcSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	// hooks
 	FWorldDelegates::OnPostWorldInitialization.AddUObject(this, &ThisClass::HandlePostWorldInit);
 	FWorldDelegates::OnWorldCleanup.AddUObject(this, &ThisClass::HandleWorldCleanup);
+	FWorldDelegates::LevelAddedToWorld.AddUObject(this, &ThisClass::HandleLevelAddedToWorld);
 }
 
 void UTSGrpcSubsystem::Deinitialize()
 {
 	FWorldDelegates::OnPostWorldInitialization.RemoveAll(this);
 	FWorldDelegates::OnWorldCleanup.RemoveAll(this);
+	FWorldDelegates::LevelAddedToWorld.RemoveAll(this);
 
 	Instance = nullptr;
 
@@ -37,66 +107,144 @@ void UTSGrpcSubsystem::Deinitialize()
 void UTSGrpcSubsystem::Tick(float DeltaTime)
 {
 	UpdateRpcRouter();
+	UpdatePerformanceStats(DeltaTime);
+}
+
+int64 UTSGrpcSubsystem::GetEventQueueDepth() const
+{
+	return EventChannel ? static_cast<int64>(EventChannel->size_approx()) : 0;
+}
+
+int64 UTSGrpcSubsystem::GetCallsInFlight() const
+{
+	return RpcServer ? static_cast<int64>(RpcServer->callsInFly()) : 0;
+}
+
+int64 UTSGrpcSubsystem::GetWriteQueueLength() const
+{
+	return tongos::RpcWriteQueue::totalLength();
+}
+
+int32 UTSGrpcSubsystem::GetCompletionQueueWorkerNum() const
+{
+	return RpcServer ? static_cast<int32>(RpcServer->workerNum()) : 0;
+}
+
+int32 UTSGrpcSubsystem::GetLanePoolThreadNum() const
+{
+	return LanePool ? static_cast<int32>(LanePool->size()) : 0;
+}
+
+void UTSGrpcSubsystem::UpdatePerformanceStats(float DeltaTime)
+{
+	UTSPerformanceStatSubSystem* PerformanceStat = UTSPerformanceStatSubSystem::GetInstance();
+	if (!PerformanceStat)
+	{
+		return;
+	}
+
+	uint64 TotalCalls = 0;
+	ForEachRouteMetrics([&TotalCalls](const tongos::RpcRouteMetrics& Metrics)
+	{
+		TotalCalls += Metrics.calls.load(std::memory_order_relaxed);
+	});
+	// 统计被重置过时计数会变小，这一帧的速率按0处理
+	const uint64 NewCalls = TotalCalls >= LastTotalCalls ? TotalCalls - LastTotalCalls : 0;
+	LastTotalCalls = TotalCalls;
+
+	PerformanceStat->SetExternalStat(ETongSimPerformanceStat::RpcEventQueueDepth, GetEventQueueDepth());
+	PerformanceStat->SetExternalStat(ETongSimPerformanceStat::RpcCallsInFlight, GetCallsInFlight());
+	PerformanceStat->SetExternalStat(ETongSimPerformanceStat::RpcWriteQueueLength, GetWriteQueueLength());
+	PerformanceStat->SetExternalStat(ETongSimPerformanceStat::RpcCallRate, DeltaTime > 0.f ? NewCalls / DeltaTime : 0.0);
 }
 
 void UTSGrpcSubsystem::StartGrpcServer()
 {
-	// server的回调，消息会被投递到管道里
+	// server的回调（在cq线程上执行），按路由的线路分发：
+	// 游戏线程的消息投递到管道里，在Tick中处理；其余在线程池或cq线程上直接处理
 	auto CallBack = [this](tongos::RpcEvent RpcEvent)
 	{
-		EventChannel->send(std::move(RpcEvent));
+		size_t Slot = 0;
+		switch (RpcRouter->queryLane(RpcEvent, Slot))
+		{
+		case tongos::RpcLane::CQ_THREAD:
+			RpcRouter->handle(std::move(RpcEvent));
+			break;
+		case tongos::RpcLane::WORKER_POOL:
+			LanePool->dispatch(Slot, std::move(RpcEvent));
+			break;
+		default:
+			EventChannel->send(std::move(RpcEvent));
+			break;
+		}
 	};
 
-	EventChannel = MakeShareable(new tongos::Channel<tongos::RpcEvent>);
+	// 有界无锁管道：满时worker线程自旋等待游戏线程消费
+	EventChannel = MakeShareable(new tongos::MpscChannel<tongos::RpcEvent>(EventChannelCapacity));
+	PendingEvents.reserve(EventDrainBatchSize);
+	const UTSGrpcSettings* Settings = GetDefault<UTSGrpcSettings>();
+	const FTSCommandLineParams& CommandLineParams = FTSCommandLineParams::Get();
+	tongos::configureLogger(MakeLoggerOptions(*Settings));
+	tongos::RpcObjectPool::setEnabled(Settings->bPoolRpcObjects);
+
 	RpcRouter = MakeShareable(new tongos::RpcRouter());
-	const FString IP = "0.0.0.0:5726"; // TODO by @wukunlun
-	RpcServer = MakeShareable(new tongos::RpcServer(TCHAR_TO_UTF8(*IP), *RpcRouter));
-	RpcServer->addWorker(CallBack);
+	LanePool = MakeShareable(new tongos::RpcLanePool(FMath::Max(Settings->LanePoolThreadNum, 1), [Router = RpcRouter](tongos::RpcEvent RpcEvent)
+	{
+		Router->handle(std::move(RpcEvent));
+	}));
+
+	const tongos::RpcServerOptions Options = MakeServerOptions(*Settings, CommandLineParams);
+	RpcServer = MakeShareable(new tongos::RpcServer(Options, *RpcRouter));
+	// 每个worker一个cq + 一个线程，调用按cq分片；回调会在多个worker线程上并发投递
+	int32 NumWorkers = CommandLineParams.GrpcWorkerNum > 0 ? CommandLineParams.GrpcWorkerNum : Settings->CompletionQueueWorkerNum;
+	if (NumWorkers <= 0)
+	{
+		NumWorkers = FMath::Clamp(FPlatformMisc::NumberOfCores() / 2, 1, 8);
+	}
+	RpcServer->addWorkers(NumWorkers, CallBack, FMath::Max(Settings->PendingCallsPerWorker, 1));
 	RpcServer->start();
 }
 
 void UTSGrpcSubsystem::StopGrpcServer()
 {
-	RpcServer.Reset();
+	// 先关闭管道：关闭期间游戏线程不再消费，避免worker线程在满队列上自旋导致无法join
 	EventChannel->close();
+	if (LanePool)
+	{
+		LanePool->stop();
+	}
+	if (RpcServer)
+	{
+		RpcServer->shutdown();
+	}
+	RpcServer.Reset();
+	LanePool.Reset();
 	EventChannel.Reset();
+	PendingEvents.clear();
 }
 
 void UTSGrpcSubsystem::UpdateRpcRouter()
 {
 	SCOPE_CYCLE_COUNTER(STAT_UTSGrpcSubsystem_UpdateRpcRouter);
-	while (true)
+	// 批量处理管道里的消息，处理过程中新到的消息在同一帧内继续处理
+	while (EventChannel->try_receive_bulk(PendingEvents, EventDrainBatchSize) > 0)
 	{
-		// 处理管道里的消息
-		auto OptionalValue = EventChannel->try_receive();
-		if (!OptionalValue)
+		for (tongos::RpcEvent& Event : PendingEvents)
 		{
-			break;
+			RpcRouter->handle(std::move(Event));
 		}
-		RpcRouter->handle(std::move(OptionalValue).value());
+		PendingEvents.clear();
 	}
 }
 
 AActor* UTSGrpcSubsystem::FindActorByGuid(const FGuid& Id) const
 {
-	if (const TWeakObjectPtr<AActor>* P = IdToActor.Find(Id))
-	{
-		return P->Get();
-	}
-	return nullptr;
+	return ActorRegistry.FindActor(Id);
 }
 
-FGuid UTSGrpcSubsystem::FindGuidByActor(AActor* Actor) const
+FGuid UTSGrpcSubsystem::FindGuidByActor(const AActor* Actor) const
 {
-	if (!Actor)
-	{
-		return FGuid();
-	}
-	if (const FGuid* Found = ActorToId.Find(Actor))
-	{
-		return *Found;
-	}
-	return FGuid();
+	return ActorRegistry.FindGuid(Actor);
 }
 
 bool UTSGrpcSubsystem::ShouldAddressActor(const AActor* Actor) const
@@ -126,20 +274,14 @@ FGuid UTSGrpcSubsystem::RegisterActor(AActor* Actor)
 	}
 
 	// 已有则复用
-	if (const FGuid* Existing = ActorToId.Find(Actor))
+	const FGuid Existing = ActorRegistry.FindGuid(Actor);
+	if (Existing.IsValid())
 	{
-		return *Existing;
+		return Existing;
 	}
 
-	FGuid NewId = FGuid::NewGuid();
-	// TODO: 是否需要检查重试？
-	// while (IdToActor.Contains(NewId))
-	// {
-	// 	NewId = FGuid::NewGuid();
-	// }
-
-	IdToActor.Add(NewId, Actor);
-	ActorToId.Add(Actor, NewId);
+	// GUID 自带槽位和代数，不会与存活或墓碑记录冲突
+	const FGuid NewId = ActorRegistry.Register(Actor);
 
 	// EndPlay
 	Actor->OnEndPlay.AddUniqueDynamic(this, &ThisClass::HandleActorEndPlay);
@@ -158,67 +300,49 @@ void UTSGrpcSubsystem::UnregisterActor(AActor* Actor)
 		return;
 	}
 
-	if (const FGuid* Found = ActorToId.Find(Actor))
-	{
-		const FGuid Id = *Found;
-
-		// 解绑事件
-		Actor->OnEndPlay.RemoveAll(this);
-		Actor->OnDestroyed.RemoveAll(this);
-
-		// 仅从 Actor->Id 侧移除；Id->Actor 保留（弱指针将失效）
-		ActorToId.Remove(Actor);
-		// 标记为 Destroyed
-		DestroyedIds.Add(Id);
+	// 解绑事件
+	Actor->OnEndPlay.RemoveAll(this);
+	Actor->OnDestroyed.RemoveAll(this);
 
+	// 保留墓碑，按旧 GUID 查询时仍可报告已销毁
+	const FGuid Id = ActorRegistry.MarkDestroyed(Actor);
+	if (Id.IsValid())
+	{
 		UE_LOG(LogTongSimGRPC, Verbose, TEXT("Marked Destroyed Actor %s <- %s"), *GetNameSafe(Actor), *Id.ToString(EGuidFormats::DigitsWithHyphensInBraces));
 	}
 }
 
-void UTSGrpcSubsystem::PurgeInvalidActor()
+void UTSGrpcSubsystem::RegisterLevelActors(ULevel* Level)
 {
-	// 清理失效弱引用
-	TArray<FGuid> DeadIds;
-	for (const auto& Pair : IdToActor)
+	if (!Level)
 	{
-		if (!Pair.Value.IsValid() && !DestroyedIds.Contains(Pair.Key))
-		{
-			DeadIds.Add(Pair.Key);
-		}
-	}
-	for (const FGuid& Id : DeadIds)
-	{
-		IdToActor.Remove(Id);
-	}
-
-	TArray<TWeakObjectPtr<AActor>> DeadObjs;
-	for (const auto& Pair : ActorToId)
-	{
-		if (!Pair.Key.IsValid())
-		{
-			DeadObjs.Add(Pair.Key);
-		}
-	}
-	for (const auto& K : DeadObjs)
-	{
-		ActorToId.Remove(K);
+		return;
 	}
-
-	if (DeadIds.Num() || DeadObjs.Num())
+	RegisteredLevels.Add(Level);
+	for (AActor* Actor : Level->Actors)
 	{
-		UE_LOG(LogTongSimGRPC, Verbose, TEXT("Purged invalid entries: %d ids, %d objs"), DeadIds.Num(), DeadObjs.Num());
+		RegisterActor(Actor);
 	}
 }
 
 void UTSGrpcSubsystem::RefreshActorMappings()
 {
-	DestroyedIds.Empty();
-	PurgeInvalidActor();
+	const int32 Purged = ActorRegistry.Purge();
+	if (Purged > 0)
+	{
+		UE_LOG(LogTongSimGRPC, Verbose, TEXT("Purged %d destroyed actors"), Purged);
+	}
 
-	// 扫描现存 Actor
-	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	// 生成/销毁/关卡加载都有回调维护，这里只兜底补扫没见过的关卡
+	if (UWorld* World = GetWorld())
 	{
-		RegisterActor(*It);
+		for (ULevel* Level : World->GetLevels())
+		{
+			if (Level && !RegisteredLevels.Contains(Level))
+			{
+				RegisterLevelActors(Level);
+			}
+		}
 	}
 }
 
@@ -231,25 +355,40 @@ void UTSGrpcSubsystem::HandlePostWorldInit(UWorld* World, const UWorld::Initiali
 	}
 
 	// 做一次清理
-	DestroyedIds.Empty();
-	PurgeInvalidActor();
+	ActorRegistry.Purge();
 
-	// 扫描现存 Actor
-	for (TActorIterator<AActor> It(World); It; ++It)
+	// 扫描已加载关卡里的 Actor，之后的流式关卡由 LevelAddedToWorld 处理
+	for (ULevel* Level : World->GetLevels())
 	{
-		RegisterActor(*It);
+		RegisterLevelActors(Level);
 	}
 
 	ActorSpawnedDelegateHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ThisClass::HandleActorSpawned));
 
-	UE_LOG(LogTongSimGRPC, Log, TEXT("[HandlePostWorldInit] PostWorldInit scan complete. Current registered: %d"), IdToActor.Num());
+	UE_LOG(LogTongSimGRPC, Log, TEXT("[HandlePostWorldInit] PostWorldInit scan complete. Current registered: %d"), ActorRegistry.Num());
 }
 
 void UTSGrpcSubsystem::HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
 {
 	// 做一次清理
-	DestroyedIds.Empty();
-	PurgeInvalidActor();
+	ActorRegistry.Purge();
+	for (auto It = RegisteredLevels.CreateIterator(); It; ++It)
+	{
+		const ULevel* Level = It->ResolveObjectPtr();
+		if (!Level || Level->GetWorld() == World)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UTSGrpcSubsystem::HandleLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (!World || World->IsPreviewWorld())
+	{
+		return;
+	}
+	RegisterLevelActors(Level);
 }
 
 void UTSGrpcSubsystem::HandleActorSpawned(AActor* Actor)
@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 #include "TongosGrpc.h"
+#include "util/logger.h"
 
 DEFINE_LOG_CATEGORY(LogTongosGrpc);
 
@@ -12,7 +13,8 @@ void FTongosGrpcModule::StartupModule()
 
 void FTongosGrpcModule::ShutdownModule()
 {
-
+	// 写完缓冲中的日志
+	tongos::closeLogFile();
 }
 
 #undef LOCTEXT_NAMESPACE
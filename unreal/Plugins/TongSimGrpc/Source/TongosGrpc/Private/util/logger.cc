@@ -1,68 +1,362 @@
 #include "util/logger.h"
-#include "util/channel.h"
+#ifndef TONGOS_STANDALONE
+#include "TongosGrpc.h"
+#endif
+#include "util/mpsc_channel.h"
 #include "util/thread.h"
-#include "util/time.h"
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 namespace tongos
 {
-	int g_log_level = 0;
-	std::ofstream g_log_file("../tongtest-grpc.log", std::ios_base::app);
-	Channel<std::string> g_log_channel;
+	std::atomic<int> g_log_level{INFO};
 
-	void setLogLevel(int log_level)
+	namespace
 	{
-		g_log_level = log_level;
-
-		// 重新打开一个日志文件
-		g_log_file.close();
-		std::ostringstream log_file_name_oss;
-		log_file_name_oss << "../tongtest-grpc-";
-		PUT_TIME(log_file_name_oss, "%Y%m%d-%H%M%S");
-		log_file_name_oss << ".log";
-		g_log_file = std::ofstream(log_file_name_oss.str(), std::ios_base::app);
+		struct LogRecord
+		{
+			int level;
+			uint32_t length;
+			char data[kMaxLogLineSize];
+		};
+
+		const char kLevelChar[] = {'D', 'I', 'W', 'E', 'F'};
+
+		// 后台写盘线程：从环形缓冲批量取日志，攒到输出缓冲里按大小/时间写盘
+		class LogSink
+		{
+		public:
+			explicit LogSink(const LoggerOptions& options) : options(options), ring(options.ring_capacity)
+			{
+				out.reserve(options.flush_bytes + kMaxLogLineSize);
+			}
+
+			bool push(int level, const char* data, size_t length)
+			{
+				// 缓冲在Logger里已经格式化好，这里只拷贝到槽位，失败直接丢弃
+				if (!ring.try_send(makeRecord(level, data, length)))
+				{
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+				return true;
+			}
+
+			void configure(const LoggerOptions& new_options)
+			{
+				std::lock_guard lock{options_mu};
+				pending_options = std::make_unique<LoggerOptions>(new_options);
+			}
+
+			void start()
+			{
+				std::lock_guard lock{thread_mu};
+				if (thread.joinable())
+				{
+					return;
+				}
+				stopping.store(false, std::memory_order_relaxed);
+				thread = std::thread(&LogSink::run, this);
+			}
+
+			void stop()
+			{
+				std::lock_guard lock{thread_mu};
+				if (!thread.joinable())
+				{
+					return;
+				}
+				stopping.store(true, std::memory_order_release);
+				thread.join();
+			}
+
+			uint64_t droppedLines() const { return dropped.load(std::memory_order_relaxed); }
+
+		private:
+			static LogRecord makeRecord(int level, const char* data, size_t length)
+			{
+				LogRecord record;
+				record.level = level;
+				record.length = static_cast<uint32_t>(length < kMaxLogLineSize ? length : kMaxLogLineSize);
+				memcpy(record.data, data, record.length);
+				return record;
+			}
+
+			void run()
+			{
+				using Clock = std::chrono::steady_clock;
+				auto last_flush = Clock::now();
+				uint64_t reported_dropped = 0;
+				for (;;)
+				{
+					applyPendingOptions();
+					const bool stop_requested = stopping.load(std::memory_order_acquire);
+					bool urgent = false;
+					const size_t received = ring.drain([this, &urgent](LogRecord&& record)
+					{
+						append(record);
+						urgent |= record.level >= WARN;
+					}, 1024);
+
+					const uint64_t total_dropped = dropped.load(std::memory_order_relaxed);
+					if (total_dropped != reported_dropped)
+					{
+						char notice[96];
+						const int n = snprintf(notice, sizeof(notice), "[logger] %llu lines dropped, ring buffer full\n",
+						                       static_cast<unsigned long long>(total_dropped - reported_dropped));
+						out.insert(out.end(), notice, notice + n);
+						reported_dropped = total_dropped;
+					}
+
+					const auto now = Clock::now();
+					if (urgent || out.size() >= options.flush_bytes || stop_requested ||
+						now - last_flush >= std::chrono::milliseconds(options.flush_interval_ms))
+					{
+						flush();
+						last_flush = now;
+					}
+
+					if (stop_requested && received == 0)
+					{
+						break;
+					}
+					if (received == 0)
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(2));
+					}
+				}
+				closeFile();
+			}
+
+			void applyPendingOptions()
+			{
+				std::unique_ptr<LoggerOptions> new_options;
+				{
+					std::lock_guard lock{options_mu};
+					new_options.swap(pending_options);
+				}
+				if (!new_options)
+				{
+					return;
+				}
+				flush();
+				const bool reopen = new_options->file_path != options.file_path;
+				options = *new_options;
+				if (reopen)
+				{
+					closeFile();
+				}
+			}
+
+			void append(const LogRecord& record)
+			{
+				out.insert(out.end(), record.data, record.data + record.length);
+				if (options.route_to_ue_log)
+				{
+					routeToUELog(record);
+				}
+			}
+
+			static void routeToUELog(const LogRecord& record)
+			{
+#ifndef TONGOS_STANDALONE
+				// 去掉行尾换行，UE_LOG自己会换行
+				const int32 length = record.length > 0 && record.data[record.length - 1] == '\n' ? record.length - 1 : record.length;
+				const FUTF8ToTCHAR line(record.data, length);
+				const FString message(line.Length(), line.Get());
+				switch (record.level)
+				{
+				case DEBUG:
+					UE_LOG(LogTongosGrpc, Verbose, TEXT("%s"), *message);
+					break;
+				case INFO:
+					UE_LOG(LogTongosGrpc, Log, TEXT("%s"), *message);
+					break;
+				case WARN:
+					UE_LOG(LogTongosGrpc, Warning, TEXT("%s"), *message);
+					break;
+				default:
+					UE_LOG(LogTongosGrpc, Error, TEXT("%s"), *message);
+					break;
+				}
+#endif
+			}
+
+			void flush()
+			{
+				if (out.empty())
+				{
+					return;
+				}
+				if (!options.file_path.empty() && openFile())
+				{
+					fwrite(out.data(), 1, out.size(), file);
+					fflush(file);
+					file_bytes += out.size();
+					if (options.max_file_bytes > 0 && file_bytes >= options.max_file_bytes)
+					{
+						rotate();
+					}
+				}
+				out.clear();
+			}
+
+			bool openFile()
+			{
+				if (file)
+				{
+					return true;
+				}
+				file = fopen(options.file_path.c_str(), "ab");
+				if (!file)
+				{
+					return false;
+				}
+				fseek(file, 0, SEEK_END);
+				const long size = ftell(file);
+				file_bytes = size > 0 ? static_cast<uint64_t>(size) : 0;
+				return true;
+			}
+
+			void closeFile()
+			{
+				if (file)
+				{
+					fclose(file);
+					file = nullptr;
+				}
+				file_bytes = 0;
+			}
+
+			// xxx.log -> xxx.log.1 -> xxx.log.2 ...，超出max_files的删除
+			void rotate()
+			{
+				closeFile();
+				const std::string& path = options.file_path;
+				if (options.max_files <= 0)
+				{
+					std::remove(path.c_str());
+					return;
+				}
+				std::remove((path + "." + std::to_string(options.max_files)).c_str());
+				for (int i = options.max_files - 1; i >= 1; --i)
+				{
+					std::rename((path + "." + std::to_string(i)).c_str(), (path + "." + std::to_string(i + 1)).c_str());
+				}
+				std::rename(path.c_str(), (path + ".1").c_str());
+			}
+
+			// 只在写盘线程上访问
+			LoggerOptions options;
+			std::vector<char> out;
+			FILE* file = nullptr;
+			uint64_t file_bytes = 0;
+
+			MpscChannel<LogRecord> ring;
+			std::atomic<uint64_t> dropped{0};
+
+			std::mutex options_mu;
+			std::unique_ptr<LoggerOptions> pending_options;
+
+			std::mutex thread_mu;
+			std::thread thread;
+			std::atomic<bool> stopping{false};
+		};
+
+		std::once_flag g_sink_once;
+		// 有意不释放：进程退出时仍可能有线程在写日志
+		LogSink* g_sink = nullptr;
+
+		LogSink& sink(const LoggerOptions* options = nullptr)
+		{
+			std::call_once(g_sink_once, [options]
+			{
+				g_sink = new LogSink(options ? *options : LoggerOptions{});
+				g_sink->start();
+			});
+			return *g_sink;
+		}
+
+		// 同一秒内复用格式化好的日期时间，避免每行调用localtime
+		size_t formatTime(char* buf, size_t len)
+		{
+			struct TimeCache
+			{
+				int64_t seconds = -1;
+				char text[32];
+				size_t length = 0;
+			};
+			thread_local TimeCache cache;
+
+			const auto now = std::chrono::system_clock::now();
+			const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+			const int64_t seconds = us / 1000000;
+			if (seconds != cache.seconds)
+			{
+				const std::time_t t = static_cast<std::time_t>(seconds);
+				std::tm ltime;
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32)
+				localtime_s(&ltime, &t);
+#else
+				localtime_r(&t, &ltime);
+#endif
+				cache.length = strftime(cache.text, sizeof(cache.text), "%Y-%m-%d %H:%M:%S", &ltime);
+				cache.seconds = seconds;
+			}
+			const int n = snprintf(buf, len, "%.*s.%06lld", static_cast<int>(cache.length), cache.text,
+			                       static_cast<long long>(us % 1000000));
+			return n > 0 ? static_cast<size_t>(n) : 0;
+		}
+	} // namespace
+
+	void configureLogger(const LoggerOptions& options)
+	{
+		g_log_level.store(options.level, std::memory_order_relaxed);
+		LogSink& log_sink = sink(&options);
+		log_sink.configure(options);
+		log_sink.start();
 	}
 
-	void closeLogFile()
+	void setLogLevel(int log_level)
 	{
-		// g_log_file.close();
+		g_log_level.store(log_level, std::memory_order_relaxed);
 	}
 
-	void asyncWriteLog()
+	void closeLogFile()
 	{
-		while (true)
+		if (g_sink)
 		{
-			g_log_file << g_log_channel.receive().value();
-			g_log_file.flush();
+			g_sink->stop();
 		}
 	}
 
-	std::thread launchLogThread()
+	uint64_t droppedLogLines()
 	{
-		std::thread log_thread(asyncWriteLog);
-		log_thread.detach();
-		return log_thread;
+		return g_sink ? g_sink->droppedLines() : 0;
 	}
 
-	Logger::Logger(const char* filepath, int line, int level) : level_(level)
+	Logger::Logger(const char* filepath, int line, int level)
+		: level_(level), sbuf_(buf_, sizeof(buf_)), os_(&sbuf_)
 	{
-		static std::thread log_thread = launchLogThread();
-		// log_thread.detach();
-		int64_t us = PUT_TIME(oss, "%Y-%m-%d %H:%M:%S.");
-		oss << std::setfill('0')
-			<< std::setw(6) << us << ' ' << getThreadId() << " ["
-			<< basename(filepath) << ":" << line << "] ";
+		char prefix[128];
+		const size_t time_length = formatTime(prefix, sizeof(prefix));
+		const char level_char = level >= 0 && level < static_cast<int>(sizeof(kLevelChar)) ? kLevelChar[level] : '?';
+		const int n = snprintf(prefix + time_length, sizeof(prefix) - time_length, " %c %llu [%s:%d] ", level_char,
+		                       static_cast<unsigned long long>(getThreadId()), basename(filepath), line);
+		// snprintf返回的是未截断时的长度
+		const size_t prefix_length = n > 0 ? std::min(time_length + n, sizeof(prefix) - 1) : time_length;
+		sbuf_.sputn(prefix, static_cast<std::streamsize>(prefix_length));
 	}
 
 	Logger::~Logger()
 	{
-		if (level_ < g_log_level)
-		{
-			return;
-		}
-		oss << std::endl;
-		// std::cout << oss.str();
-		g_log_channel.send(oss.str());
+		sbuf_.appendNewline();
+		sink().push(level_, buf_, sbuf_.size());
 	}
 } // namespace tongos
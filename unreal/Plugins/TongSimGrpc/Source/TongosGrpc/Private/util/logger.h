@@ -1,12 +1,16 @@
 #pragma once
-#include "Containers/StringConv.h"
-#include <chrono>
-#include <ctime>
-// #include <glog/logging.h>
-#include <iomanip>
-#include <iostream>
-#include <sstream>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// 编译期最低日志级别：低于它的tonglog连同参数求值一起被编译器裁掉
+#ifndef TONGOS_MIN_LOG_LEVEL
+#define TONGOS_MIN_LOG_LEVEL 0
+#endif
 
 namespace tongos
 {
@@ -16,16 +20,40 @@ namespace tongos
 	// constexpr int ERROR = 3;
 	constexpr int FATAL = 4;
 
+	// 单行日志最大字节数，超出部分截断
+	constexpr size_t kMaxLogLineSize = 512;
+
+	struct LoggerOptions
+	{
+		// 日志文件路径，空表示不写文件
+		std::string file_path = "../tongtest-grpc.log";
+		int level = INFO;
+		// 环形缓冲的行数，只在第一次创建时生效；缓冲满时丢弃新日志并计数，不阻塞rpc线程
+		size_t ring_capacity = 4096;
+		// 攒够flush_bytes或距上次写盘超过flush_interval_ms时批量写盘，WARN及以上立即写盘
+		size_t flush_bytes = 64 * 1024;
+		int flush_interval_ms = 200;
+		// 文件超过max_file_bytes后滚动为 .1 .2 ...，最多保留max_files个旧文件；0表示不滚动
+		uint64_t max_file_bytes = 64ull * 1024 * 1024;
+		int max_files = 5;
+		// 同时转发到UE_LOG(LogTongosGrpc)
+		bool route_to_ue_log = false;
+	};
+
+	// 可以重复调用，后台线程会在下一批写盘前切换到新配置
+	void TONGOSGRPC_API configureLogger(const LoggerOptions& options);
 	void TONGOSGRPC_API setLogLevel(int log_level);
+	// 写完缓冲中的日志并停止后台线程
 	void TONGOSGRPC_API closeLogFile();
-	// class GLOG_EXPORT LogStreamBuf : public std::streambuf {
-	// public:
-	//   LogStreamBuf(char *buf, int len) { setp(buf, buf + len - 2); }
+	// 因缓冲满被丢弃的行数
+	uint64_t TONGOSGRPC_API droppedLogLines();
 
-	//   // This effectively ignores overflow.
-	//   int_type overflow(int_type ch) { return ch; }
-	// };
+	extern TONGOSGRPC_API std::atomic<int> g_log_level;
 
+	inline bool logEnabled(int level)
+	{
+		return level >= g_log_level.load(std::memory_order_relaxed);
+	}
 
 	static const char* basename(const char* filepath)
 	{
@@ -37,41 +65,55 @@ namespace tongos
 		return base ? (base + 1) : filepath;
 	}
 
+	// 写入定长缓冲的streambuf，写满后忽略剩余内容
+	class LogStreamBuf : public std::streambuf
+	{
+	public:
+		// 预留1字节给行尾换行
+		LogStreamBuf(char* buf, size_t len) { setp(buf, buf + len - 1); }
+
+		size_t size() const { return static_cast<size_t>(pptr() - pbase()); }
+
+		void appendNewline()
+		{
+			*pptr() = '\n';
+			pbump(1);
+		}
+
+	protected:
+		int_type overflow(int_type ch) override { return ch; }
+	};
+
+	// 一行日志：在栈上的定长缓冲里格式化，析构时整行拷进环形缓冲，过程中不分配内存
 	class TONGOSGRPC_API Logger
 	{
 	public:
 		Logger(const char* filepath, int line, int level);
 		~Logger();
 
-		template <typename T>
-		friend std::ostream& operator<<(Logger&& logger, T&& t)
-		{
-			logger.oss << t;
-			return logger.oss;
-		}
+		Logger(const Logger&) = delete;
+		Logger& operator=(const Logger&) = delete;
+
+		std::ostream& stream() { return os_; }
 
 	private:
-		std::ostringstream oss;
 		int level_;
+		char buf_[kMaxLogLineSize];
+		LogStreamBuf sbuf_;
+		std::ostream os_;
 	};
 
-	class BlankLogger
+	// 让 "cond ? (void)0 : LogVoidify{} & stream << ..." 两个分支类型一致
+	struct LogVoidify
 	{
-	public:
-		BlankLogger()
-		{
-		}
-
-		template <typename T>
-		friend const BlankLogger& operator<<(const BlankLogger& logger, T&& t)
+		void operator&(std::ostream&)
 		{
-			return logger;
 		}
 	};
 
-	// #define tonglog(INFO)                                                              \
-	//   BlankLogger {}
+	// 先判断级别再构造Logger，被过滤的日志不会格式化也不会对参数求值
 #define tonglog(level)                                                              \
-  Logger { __FILE__, __LINE__, level}
-	// #define tonglog(level) LOG(level)
+  !((level) >= TONGOS_MIN_LOG_LEVEL && ::tongos::logEnabled(level))                 \
+      ? (void)0                                                                     \
+      : ::tongos::LogVoidify{} & ::tongos::Logger{__FILE__, __LINE__, level}.stream()
 } // namespace tongos
@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace tongos {
+
+// 有界无锁多生产者/单消费者环形管道（Vyukov bounded queue，消费端去掉CAS）
+// 生产者：gRPC worker线程；消费者：游戏线程（只能有一个线程调用receive系列接口）
+// 容量会向上取整到2的幂，槽位预分配，send/receive都不分配内存也不加锁
+template <typename T> class MpscChannel {
+public:
+  explicit MpscChannel(size_t capacity = 65536)
+      : mask(roundUpPow2(capacity) - 1), cells(new Cell[mask + 1]),
+        enqueue_pos(0), dequeue_pos(0), done(false) {
+    for (size_t i = 0; i <= mask; ++i) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~MpscChannel() {
+    while (try_receive()) {
+    }
+    delete[] cells;
+  }
+
+  MpscChannel(const MpscChannel &) = delete;
+  MpscChannel &operator=(const MpscChannel &) = delete;
+
+  // 队列满时自旋让出直到有空位（对worker线程形成反压），channel关闭后返回false
+  template <typename U> bool send(U &&u) {
+    uint32_t spins = 0;
+    while (!try_send(std::forward<U>(u))) {
+      if (done.load(std::memory_order_acquire)) {
+        return false;
+      }
+      if (++spins > 64) {
+        std::this_thread::yield();
+      }
+    }
+    return true;
+  }
+
+  // 队列满时立即返回false，u不会被移走
+  template <typename U> bool try_send(U &&u) {
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    Cell *cell;
+    for (;;) {
+      cell = &cells[pos & mask];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    new (cell->storage) T(std::forward<U>(u));
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  void close() { done.store(true, std::memory_order_release); }
+
+  bool closed() const { return done.load(std::memory_order_acquire); }
+
+  std::optional<T> try_receive() {
+    std::optional<T> value;
+    drain([&value](T &&t) { value.emplace(std::move(t)); }, 1);
+    return value;
+  }
+
+  // 批量取出最多max_count个元素并依次交给f，返回取出的数量
+  template <typename F> size_t drain(F &&f, size_t max_count = SIZE_MAX) {
+    size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+    size_t count = 0;
+    while (count < max_count) {
+      Cell *cell = &cells[pos & mask];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      if (seq != pos + 1) {
+        break;
+      }
+      T *t = std::launder(reinterpret_cast<T *>(cell->storage));
+      f(std::move(*t));
+      t->~T();
+      cell->sequence.store(pos + mask + 1, std::memory_order_release);
+      ++pos;
+      ++count;
+    }
+    dequeue_pos.store(pos, std::memory_order_relaxed);
+    return count;
+  }
+
+  // 批量取出到out尾部（out可以复用，避免每帧分配）
+  size_t try_receive_bulk(std::vector<T> &out, size_t max_count = SIZE_MAX) {
+    return drain([&out](T &&t) { out.emplace_back(std::move(t)); }, max_count);
+  }
+
+  // 近似长度，仅用于统计
+  size_t size_approx() const {
+    const size_t enq = enqueue_pos.load(std::memory_order_relaxed);
+    const size_t deq = dequeue_pos.load(std::memory_order_relaxed);
+    return enq > deq ? enq - deq : 0;
+  }
+
+  size_t capacity() const { return mask + 1; }
+
+private:
+  static constexpr size_t kCacheLine = 64;
+
+  struct alignas(kCacheLine) Cell {
+    std::atomic<size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  static size_t roundUpPow2(size_t v) {
+    size_t n = 2;
+    while (n < v) {
+      n <<= 1;
+    }
+    return n;
+  }
+
+  const size_t mask;
+  Cell *const cells;
+  alignas(kCacheLine) std::atomic<size_t> enqueue_pos;
+  alignas(kCacheLine) std::atomic<size_t> dequeue_pos;
+  alignas(kCacheLine) std::atomic<bool> done;
+};
+} // namespace tongos
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "util/slot_map.h"
+
+class AActor;
+
+/** 注册表中的一条记录；Actor 销毁后保留为墓碑直到 Purge，期间按 GUID 仍能查到并报告 destroyed */
+struct FTSActorRecord
+{
+	FGuid Guid;
+	TWeakObjectPtr<AActor> Actor;
+	uint32 ObjectIndex = 0;
+	bool bDestroyed = false;
+};
+
+/**
+ * gRPC ObjectId <-> Actor 的分代稠密槽位注册表，只能在游戏线程访问。
+ * GUID 的 C/D 段就是槽位下标和代数，A/B 段随机：按 GUID 查找直接定位槽位后比对完整 GUID，不做哈希；
+ * Actor -> GUID 按 UObject 全局下标索引。记录连续存放，导出状态时顺序遍历即可。
+ */
+class TONGOSGRPC_API FTSActorRegistry
+{
+public:
+	/** 已注册的 Actor 返回原 GUID */
+	FGuid Register(AActor* Actor);
+
+	/** 标记为已销毁并保留墓碑，未注册时返回无效 GUID */
+	FGuid MarkDestroyed(AActor* Actor);
+
+	/** 查不到或已销毁时返回空 */
+	AActor* FindActor(const FGuid& Guid) const;
+
+	/** 包括墓碑 */
+	const FTSActorRecord* FindRecord(const FGuid& Guid) const;
+
+	/** 未注册或已销毁时返回无效 GUID */
+	FGuid FindGuid(const AActor* Actor) const;
+
+	/** 释放墓碑和已被 GC 的记录，返回释放的条数；槽位复用后旧 GUID 不会再被解析到新 Actor */
+	int32 Purge();
+
+	void Reset();
+
+	int32 Num() const { return static_cast<int32>(Records.size()); }
+
+	/** 按连续存放的顺序遍历，回调签名为 void(const FTSActorRecord&) */
+	template <typename Fn>
+	void ForEach(Fn&& Func) const
+	{
+		for (const FTSActorRecord& Record : Records)
+		{
+			Func(Record);
+		}
+	}
+
+private:
+	FTSActorRecord* FindLiveRecord(const AActor* Actor);
+	const FTSActorRecord* FindLiveRecord(const AActor* Actor) const;
+
+	tongos::SlotMap<FTSActorRecord> Records;
+	/** UObject 全局下标 -> 槽位下标 + 1，0 表示未注册 */
+	TArray<uint32> ObjectIndexToSlot;
+};
@@ -1,18 +1,21 @@
 ﻿#pragma once
 
 #include <string>
+#include <vector>
 #include "CoreMinimal.h"
 #include "rpc_router.h"
+#include "TSActorRegistry.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "TSGrpcSubsystem.generated.h"
 
 namespace tongos
 {
 	template <typename T>
-	class Channel;
+	class MpscChannel;
 
 	class RpcServer;
 	class RpcEvent;
+	class RpcLanePool;
 }
 
 UCLASS()
@@ -37,27 +40,58 @@ private:
 	 * gRPC Server
 	 */
 public:
+	// Lane默认在游戏线程执行；WORKER_POOL/CQ_THREAD只能用于不访问UObject的线程安全handler
 	template <typename Handler>
-	void RegisterUnaryHandler(const std::string& method, Handler handler)
+	void RegisterUnaryHandler(const std::string& method, Handler handler, tongos::RpcLane Lane = tongos::RpcLane::GAME_THREAD)
 	{
-		RpcRouter->registerUnaryHandler(method, handler);
+		RpcRouter->registerUnaryHandler(method, handler, Lane);
 	}
 
 	template <typename Reactor>
-	void RegisterReactor(const std::string& method)
+	void RegisterReactor(const std::string& method, tongos::RpcLane Lane = tongos::RpcLane::GAME_THREAD)
 	{
-		RpcRouter->registerReactor<Reactor>(method);
+		RpcRouter->registerReactor<Reactor>(method, Lane);
 	}
 
+	/** 释放已销毁 Actor 的记录，并补注册尚未见过的关卡里的 Actor；正常情况下生成/销毁/关卡加载回调已经增量维护 */
 	void RefreshActorMappings();
 
+	/**
+	 * gRPC 运行指标：以下接口都是线程安全的，可以在任意线路上调用
+	 */
+	// 等待游戏线程处理的事件数
+	int64 GetEventQueueDepth() const;
+	// 已接收尚未结束的调用数（包括预投递在cq上的）
+	int64 GetCallsInFlight() const;
+	// 排在写队列里尚未发出的响应数
+	int64 GetWriteQueueLength() const;
+	int32 GetCompletionQueueWorkerNum() const;
+	int32 GetLanePoolThreadNum() const;
+
+	// 遍历每个路由的延迟统计，回调签名为 void(tongos::RpcRouteMetrics&)
+	template <typename Fn>
+	void ForEachRouteMetrics(Fn&& fn) const
+	{
+		if (RpcRouter)
+		{
+			RpcRouter->forEachRouteMetrics(std::forward<Fn>(fn));
+		}
+	}
+
 private:
+	// 每帧把计量值推送到 UTSPerformanceStatSubSystem
+	void UpdatePerformanceStats(float DeltaTime);
+	uint64 LastTotalCalls = 0;
+
 	void StartGrpcServer();
 	void StopGrpcServer();
 	void UpdateRpcRouter();
 	TSharedPtr<tongos::RpcRouter> RpcRouter;
 	TSharedPtr<tongos::RpcServer> RpcServer;
-	TSharedPtr<tongos::Channel<tongos::RpcEvent>> EventChannel;
+	TSharedPtr<tongos::RpcLanePool> LanePool;
+	TSharedPtr<tongos::MpscChannel<tongos::RpcEvent>> EventChannel;
+	// 每帧批量取出的事件，复用以避免分配
+	std::vector<tongos::RpcEvent> PendingEvents;
 	/**
 	 * ~gRPC Server
 	 */
@@ -70,27 +104,25 @@ public:
 	AActor* FindActorByGuid(const FGuid& Id) const;
 
 	/** 查 Actor -> GUID（可能返回无效 GUID） */
-	FGuid FindGuidByActor(AActor* Actor) const;
-
-	const TMap<FGuid, TWeakObjectPtr<AActor>>& GetIdToActorMap() const {return IdToActor;}
-	const TMap<TWeakObjectPtr<AActor>, FGuid>& GetActorToIdMap() const {return ActorToId;}
+	FGuid FindGuidByActor(const AActor* Actor) const;
 
-	const TSet<FGuid>& GetDestroyedIds() const { return DestroyedIds; }
+	/** 全部已注册 Actor（含墓碑），导出状态时直接顺序遍历 */
+	const FTSActorRegistry& GetActorRegistry() const { return ActorRegistry; }
 private:
 	bool ShouldAddressActor(const AActor* Actor) const;
 	FGuid RegisterActor(AActor* Actor);
 	void UnregisterActor(AActor* Actor);
-	void PurgeInvalidActor();
+	void RegisterLevelActors(ULevel* Level);
 
-	/** GUID <-> Actor（弱引用） */
-	TMap<FGuid, TWeakObjectPtr<AActor>> IdToActor;
-	TMap<TWeakObjectPtr<AActor>, FGuid> ActorToId;
-	// 被销毁的 GUID 集合
-	TSet<FGuid> DestroyedIds;
+	/** GUID <-> Actor，销毁的 Actor 保留墓碑直到 World 清理 */
+	FTSActorRegistry ActorRegistry;
+	/** 已经扫描过的关卡，RefreshActorMappings 只补扫新关卡 */
+	TSet<TObjectKey<ULevel>> RegisteredLevels;
 
 
 	void HandlePostWorldInit(UWorld* World, const UWorld::InitializationValues IVS);
 	void HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+	void HandleLevelAddedToWorld(ULevel* Level, UWorld* World);
 	void HandleActorSpawned(AActor* Actor);
 	UFUNCTION()
 	void HandleActorEndPlay(AActor* Actor, EEndPlayReason::Type Reason);
@@ -1,7 +1,25 @@
 #include "rpc_common.h"
+#include "rpc_reactor_base.h"
+
+#include <atomic>
 
 namespace tongos
 {
 	const ResponseStatus& ResponseStatus::OK = ResponseStatus();
 	const ResponseStatus& ResponseStatus::CANCELLED = ResponseStatus(grpc::StatusCode::CANCELLED, "");
+
+	namespace
+	{
+		std::atomic<bool> g_arena_enabled{true};
+	}
+
+	void setRpcArenaEnabled(bool enabled)
+	{
+		g_arena_enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool rpcArenaEnabled()
+	{
+		return g_arena_enabled.load(std::memory_order_relaxed);
+	}
 }
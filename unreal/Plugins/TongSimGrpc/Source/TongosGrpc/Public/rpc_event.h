@@ -1,4 +1,5 @@
 #pragma once
+#include "rpc_metrics.h"
 
 namespace tongos
 {
@@ -22,7 +23,8 @@ namespace tongos
 	{
 	public:
 		RpcEvent(RpcStream* rpc_stream, RpcReactorBase* rpc_reactor, RpcEventType event_type)
-			: rpc_stream_(rpc_stream), backuped_rpc_reactor_(rpc_reactor), event_type_(event_type)
+			: rpc_stream_(rpc_stream), backuped_rpc_reactor_(rpc_reactor), event_type_(event_type),
+			  enqueue_time_(RpcClock::now())
 		{
 		}
 
@@ -35,9 +37,13 @@ namespace tongos
 			return backuped_rpc_reactor_;
 		}
 
+		// 事件在cq线程上产生的时间，用于统计排队耗时
+		RpcClock::time_point enqueue_time() const { return enqueue_time_; }
+
 	private:
 		RpcStream* rpc_stream_;
 		RpcReactorBase* backuped_rpc_reactor_;
 		RpcEventType event_type_;
+		RpcClock::time_point enqueue_time_;
 	};
 } // namespace tongos
@@ -0,0 +1,118 @@
+#include "rpc_external_bytes.h"
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <algorithm>
+#include <string>
+
+namespace tongos
+{
+	namespace
+	{
+		using google::protobuf::internal::WireFormatLite;
+
+		void releaseOwner(void* user_data)
+		{
+			delete static_cast<std::shared_ptr<const void>*>(user_data);
+		}
+
+		// 返回header中第一个字段号大于field_number的字段的偏移
+		// proto按字段号升序序列化已知字段，所以在这里插入与整体序列化的顺序一致
+		bool findInsertOffset(const uint8_t* data, size_t size, size_t begin, int field_number, size_t* offset)
+		{
+			google::protobuf::io::CodedInputStream input(data + begin, static_cast<int>(size - begin));
+			for (;;)
+			{
+				const size_t position = begin + static_cast<size_t>(input.CurrentPosition());
+				const uint32_t tag = input.ReadTag();
+				if (tag == 0)
+				{
+					*offset = size;
+					return true;
+				}
+				const int number = WireFormatLite::GetTagFieldNumber(tag);
+				if (number == field_number)
+				{
+					return false;
+				}
+				if (number > field_number)
+				{
+					*offset = position;
+					return true;
+				}
+				if (!WireFormatLite::SkipField(&input, tag))
+				{
+					return false;
+				}
+			}
+		}
+
+		grpc::Slice makePrefix(int field_number, size_t size)
+		{
+			using google::protobuf::io::CodedOutputStream;
+			uint8_t prefix[16];
+			uint8_t* end = CodedOutputStream::WriteVarint32ToArray(
+				WireFormatLite::MakeTag(field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED), prefix);
+			end = CodedOutputStream::WriteVarint64ToArray(size, end);
+			return grpc::Slice(prefix, static_cast<size_t>(end - prefix));
+		}
+	}
+
+	grpc::Status serializeWithExternalBytes(const google::protobuf::MessageLite& header,
+	                                        std::vector<RpcExternalBytes> fields,
+	                                        grpc::ByteBuffer* buffer)
+	{
+		const size_t header_size = header.ByteSizeLong();
+		grpc::Slice header_slice(header_size);
+		header.SerializeWithCachedSizesToArray(const_cast<uint8_t*>(header_slice.begin()));
+
+		std::stable_sort(fields.begin(), fields.end(), [](const RpcExternalBytes& a, const RpcExternalBytes& b)
+		{
+			return a.field_number < b.field_number;
+		});
+
+		std::vector<grpc::Slice> slices;
+		slices.reserve(fields.size() * 3 + 1);
+		size_t cursor = 0;
+		for (RpcExternalBytes& field : fields)
+		{
+			if (field.size == 0 && !field.repeated)
+			{
+				continue;
+			}
+			size_t offset = 0;
+			if (!findInsertOffset(header_slice.begin(), header_size, cursor, field.field_number, &offset))
+			{
+				return grpc::Status(grpc::StatusCode::INTERNAL,
+				                    "external bytes field " + std::to_string(field.field_number) +
+				                    " must be empty in header message");
+			}
+			if (offset > cursor)
+			{
+				slices.emplace_back(header_slice.sub(cursor, offset));
+				cursor = offset;
+			}
+			slices.emplace_back(makePrefix(field.field_number, field.size));
+			if (field.size == 0)
+			{
+				continue;
+			}
+			if (field.size < kExternalBytesMinSize || !field.owner)
+			{
+				slices.emplace_back(field.data, field.size);
+			}
+			else
+			{
+				slices.emplace_back(const_cast<void*>(field.data), field.size, &releaseOwner,
+				                    new std::shared_ptr<const void>(std::move(field.owner)));
+			}
+		}
+		if (cursor < header_size)
+		{
+			slices.emplace_back(header_slice.sub(cursor, header_size));
+		}
+
+		grpc::ByteBuffer result(slices.data(), slices.size());
+		buffer->Swap(&result);
+		return grpc::Status::OK;
+	}
+}
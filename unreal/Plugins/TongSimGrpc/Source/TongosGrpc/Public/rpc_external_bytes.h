@@ -0,0 +1,30 @@
+#pragma once
+#include <grpcpp/grpcpp.h>
+#include <google/protobuf/message_lite.h>
+#include <memory>
+#include <vector>
+
+namespace tongos
+{
+	// 以外部内存直接拼进响应的bytes字段，只支持顶层字段
+	// owner持有data所在的内存，grpc发送完成后在grpc线程上释放
+	struct RpcExternalBytes
+	{
+		int field_number = 0;
+		const void* data = nullptr;
+		size_t size = 0;
+		std::shared_ptr<const void> owner;
+		// repeated bytes的元素即使为空也要写出，否则后面元素的下标会错位
+		bool repeated = false;
+	};
+
+	// 小于该字节数（或没有owner）的字段直接拷贝，外部slice的管理开销反而更大
+	constexpr size_t kExternalBytesMinSize = 4096;
+
+	// header是外部字段留空的响应消息，外部字段按字段号插入header的序列化结果中
+	// 生成的ByteBuffer与先把数据拷进消息再整体序列化逐字节相同（proto3下size为0的非repeated字段不输出）
+	// header里对应字段非空时返回INTERNAL
+	TONGOSGRPC_API grpc::Status serializeWithExternalBytes(const google::protobuf::MessageLite& header,
+	                                                      std::vector<RpcExternalBytes> fields,
+	                                                      grpc::ByteBuffer* buffer);
+}
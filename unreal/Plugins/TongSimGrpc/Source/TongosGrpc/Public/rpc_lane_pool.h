@@ -0,0 +1,82 @@
+#pragma once
+#include "rpc_event.h"
+#include "util/channel.h"
+#include "util/logger.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace tongos
+{
+	// RpcLane::WORKER_POOL线路的执行线程池
+	// 每个线程有自己的队列，同一个slot的事件总是投递到同一个线程，保证单个调用内的事件按序、不并发
+	class RpcLanePool
+	{
+	public:
+		using Handler = std::function<void(RpcEvent)>;
+
+		RpcLanePool(size_t num, Handler handler) : handler(std::move(handler)), stopped(false)
+		{
+			if (num == 0)
+			{
+				num = 1;
+			}
+			for (size_t i = 0; i < num; ++i)
+			{
+				channels.emplace_back(std::make_unique<Channel<RpcEvent>>());
+			}
+			for (size_t i = 0; i < num; ++i)
+			{
+				threads.emplace_back(&RpcLanePool::work, this, i);
+			}
+		}
+
+		~RpcLanePool() { stop(); }
+
+		void dispatch(size_t slot, RpcEvent rpc_event)
+		{
+			channels[slot % channels.size()]->send(std::move(rpc_event));
+		}
+
+		// 停止后未处理的事件直接丢弃：此时server即将关闭，不能再往流上写
+		void stop()
+		{
+			if (stopped.exchange(true))
+			{
+				return;
+			}
+			for (auto& channel : channels)
+			{
+				channel->close();
+			}
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+			tonglog(INFO) << "lane pool stopped";
+		}
+
+		size_t size() const { return channels.size(); }
+
+	private:
+		void work(size_t index)
+		{
+			Channel<RpcEvent>& channel = *channels[index];
+			while (auto rpc_event = channel.receive())
+			{
+				if (stopped)
+				{
+					break;
+				}
+				handler(std::move(rpc_event).value());
+			}
+		}
+
+		Handler handler;
+		std::vector<std::unique_ptr<Channel<RpcEvent>>> channels;
+		std::vector<std::thread> threads;
+		std::atomic<bool> stopped;
+	};
+} // namespace tongos
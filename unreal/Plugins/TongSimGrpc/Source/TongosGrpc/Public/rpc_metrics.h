@@ -0,0 +1,178 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace tongos
+{
+	using RpcClock = std::chrono::steady_clock;
+
+	// 一次调用经过的各个阶段
+	enum class RpcPhase : uint8_t
+	{
+		// cq线程产生事件 -> 所在线路开始处理（GAME_THREAD线路上主要是等下一帧Tick）
+		QUEUE_WAIT = 0,
+		// reactor回调执行
+		HANDLER,
+		// 响应消息序列化
+		SERIALIZE,
+		// 响应进入写队列 -> grpc写完成
+		WRITE_DRAIN,
+		COUNT,
+	};
+
+	inline const char* rpcPhaseName(RpcPhase phase)
+	{
+		switch (phase)
+		{
+		case RpcPhase::QUEUE_WAIT:
+			return "queue_wait";
+		case RpcPhase::HANDLER:
+			return "handler";
+		case RpcPhase::SERIALIZE:
+			return "serialize";
+		case RpcPhase::WRITE_DRAIN:
+			return "write_drain";
+		default:
+			return "unknown";
+		}
+	}
+
+	// HDR风格的对数-线性直方图，单位微秒
+	// 每个2的幂区间分成16个子桶，相对误差不超过1/16；record无锁，可以在任意线程调用
+	class RpcLatencyHistogram
+	{
+	public:
+		static constexpr int kSubBucketBits = 4;
+		static constexpr int kSubBuckets = 1 << kSubBucketBits;
+		// 最大记录2^40微秒（约12天），更大的值落在最后一个桶
+		static constexpr int kMaxMagnitude = 40;
+		static constexpr size_t kBucketNum = (kMaxMagnitude - kSubBucketBits + 1) * kSubBuckets;
+
+		void record(uint64_t value_us)
+		{
+			buckets[bucketIndex(value_us)].fetch_add(1, std::memory_order_relaxed);
+			total.fetch_add(1, std::memory_order_relaxed);
+			sum.fetch_add(value_us, std::memory_order_relaxed);
+			uint64_t prev_max = max_value.load(std::memory_order_relaxed);
+			while (value_us > prev_max &&
+				!max_value.compare_exchange_weak(prev_max, value_us, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		void recordSince(RpcClock::time_point start)
+		{
+			const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(RpcClock::now() - start);
+			record(elapsed.count() > 0 ? static_cast<uint64_t>(elapsed.count()) : 0);
+		}
+
+		uint64_t count() const { return total.load(std::memory_order_relaxed); }
+		uint64_t max() const { return max_value.load(std::memory_order_relaxed); }
+
+		double mean() const
+		{
+			const uint64_t n = count();
+			return n == 0 ? 0.0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / n;
+		}
+
+		// 返回q分位（0~1）所在桶的上界
+		uint64_t percentile(double q) const
+		{
+			const uint64_t n = count();
+			if (n == 0)
+			{
+				return 0;
+			}
+			const uint64_t rank = static_cast<uint64_t>(q * (n - 1)) + 1;
+			uint64_t seen = 0;
+			for (size_t i = 0; i < kBucketNum; ++i)
+			{
+				seen += buckets[i].load(std::memory_order_relaxed);
+				if (seen >= rank)
+				{
+					const uint64_t upper = bucketUpperBound(i);
+					const uint64_t max_seen = max();
+					return upper < max_seen ? upper : max_seen;
+				}
+			}
+			return max();
+		}
+
+		void reset()
+		{
+			for (auto& bucket : buckets)
+			{
+				bucket.store(0, std::memory_order_relaxed);
+			}
+			total.store(0, std::memory_order_relaxed);
+			sum.store(0, std::memory_order_relaxed);
+			max_value.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		static size_t bucketIndex(uint64_t value)
+		{
+			if (value < kSubBuckets)
+			{
+				return static_cast<size_t>(value);
+			}
+			int magnitude = static_cast<int>(std::bit_width(value)) - 1;
+			if (magnitude >= kMaxMagnitude)
+			{
+				return kBucketNum - 1;
+			}
+			const int shift = magnitude - kSubBucketBits;
+			const size_t sub = static_cast<size_t>(value >> shift) - kSubBuckets;
+			return static_cast<size_t>(magnitude - kSubBucketBits + 1) * kSubBuckets + sub;
+		}
+
+		static uint64_t bucketUpperBound(size_t index)
+		{
+			const size_t group = index / kSubBuckets;
+			const size_t sub = index % kSubBuckets;
+			if (group == 0)
+			{
+				return sub;
+			}
+			const int shift = static_cast<int>(group) - 1;
+			const uint64_t lower = static_cast<uint64_t>(kSubBuckets + sub) << shift;
+			return lower + (uint64_t(1) << shift) - 1;
+		}
+
+		std::array<std::atomic<uint64_t>, kBucketNum> buckets{};
+		std::atomic<uint64_t> total{0};
+		std::atomic<uint64_t> sum{0};
+		std::atomic<uint64_t> max_value{0};
+	};
+
+	// 单个路由的统计，由RpcRouter在注册时创建，地址在server生命周期内保持不变
+	struct RpcRouteMetrics
+	{
+		explicit RpcRouteMetrics(std::string method) : method(std::move(method))
+		{
+		}
+
+		RpcLatencyHistogram& phase(RpcPhase rpc_phase) { return phases[static_cast<size_t>(rpc_phase)]; }
+
+		void record(RpcPhase rpc_phase, RpcClock::time_point start) { phase(rpc_phase).recordSince(start); }
+
+		void reset()
+		{
+			for (auto& histogram : phases)
+			{
+				histogram.reset();
+			}
+			calls.store(0, std::memory_order_relaxed);
+			failed_calls.store(0, std::memory_order_relaxed);
+		}
+
+		const std::string method;
+		std::array<RpcLatencyHistogram, static_cast<size_t>(RpcPhase::COUNT)> phases;
+		std::atomic<uint64_t> calls{0};
+		std::atomic<uint64_t> failed_calls{0};
+	};
+} // namespace tongos
@@ -0,0 +1,178 @@
+#include "rpc_object_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace tongos
+{
+	namespace
+	{
+		std::atomic<bool> g_pool_enabled{true};
+
+		struct FreeBlock
+		{
+			FreeBlock* next;
+		};
+
+		// 计数只由所属线程写，stats()从其他线程读，所以用原子但不用原子加
+		struct ThreadStats
+		{
+			std::atomic<uint64_t> pooled_allocs{0};
+			std::atomic<uint64_t> heap_allocs{0};
+			std::atomic<uint64_t> frees{0};
+			std::atomic<uint64_t> cached_blocks{0};
+			std::atomic<uint64_t> cached_bytes{0};
+		};
+
+		void bump(std::atomic<uint64_t>& counter, int64_t delta = 1)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+		}
+
+		struct ThreadCache;
+
+		std::mutex g_registry_mu;
+		std::vector<ThreadCache*> g_thread_caches;
+		// 已退出线程的累计计数
+		RpcObjectPool::Stats g_retired_stats;
+
+		// 线程退出时析构后置为true，之后这个线程上的分配释放直接走系统分配器
+		thread_local bool t_cache_destroyed = false;
+
+		struct ThreadCache
+		{
+			ThreadCache()
+			{
+				std::lock_guard lock{g_registry_mu};
+				g_thread_caches.push_back(this);
+			}
+
+			~ThreadCache()
+			{
+				for (size_t index = 0; index < RpcObjectPool::kSizeClassNum; ++index)
+				{
+					while (FreeBlock* block = heads[index])
+					{
+						heads[index] = block->next;
+						::operator delete(block);
+					}
+				}
+				t_cache_destroyed = true;
+
+				std::lock_guard lock{g_registry_mu};
+				g_retired_stats.pooled_allocs += stats.pooled_allocs.load(std::memory_order_relaxed);
+				g_retired_stats.heap_allocs += stats.heap_allocs.load(std::memory_order_relaxed);
+				g_retired_stats.frees += stats.frees.load(std::memory_order_relaxed);
+				g_thread_caches.erase(std::find(g_thread_caches.begin(), g_thread_caches.end(), this));
+			}
+
+			FreeBlock* heads[RpcObjectPool::kSizeClassNum] = {};
+			uint32_t counts[RpcObjectPool::kSizeClassNum] = {};
+			ThreadStats stats;
+		};
+
+		ThreadCache* threadCache()
+		{
+			if (t_cache_destroyed)
+			{
+				return nullptr;
+			}
+			thread_local ThreadCache cache;
+			return &cache;
+		}
+
+		size_t sizeClassOf(size_t size)
+		{
+			return size == 0 ? 0 : (size - 1) / RpcObjectPool::kSizeClassBytes;
+		}
+	} // namespace
+
+	void* RpcObjectPool::allocate(size_t size)
+	{
+		ThreadCache* cache = threadCache();
+		if (size > kMaxPooledSize)
+		{
+			if (cache)
+			{
+				bump(cache->stats.heap_allocs);
+			}
+			return ::operator new(size);
+		}
+
+		const size_t index = sizeClassOf(size);
+		if (cache)
+		{
+			FreeBlock* block = cache->heads[index];
+			if (block && g_pool_enabled.load(std::memory_order_relaxed))
+			{
+				cache->heads[index] = block->next;
+				--cache->counts[index];
+				bump(cache->stats.pooled_allocs);
+				bump(cache->stats.cached_blocks, -1);
+				bump(cache->stats.cached_bytes, -static_cast<int64_t>((index + 1) * kSizeClassBytes));
+				return block;
+			}
+			bump(cache->stats.heap_allocs);
+		}
+		// 总是按档位大小分配，池开关切换前后分配的块都能放回任意线程的缓存
+		return ::operator new((index + 1) * kSizeClassBytes);
+	}
+
+	void RpcObjectPool::deallocate(void* ptr, size_t size)
+	{
+		if (!ptr)
+		{
+			return;
+		}
+		ThreadCache* cache = threadCache();
+		if (cache)
+		{
+			bump(cache->stats.frees);
+		}
+		if (size > kMaxPooledSize || !cache || !g_pool_enabled.load(std::memory_order_relaxed))
+		{
+			::operator delete(ptr);
+			return;
+		}
+
+		const size_t index = sizeClassOf(size);
+		if (cache->counts[index] >= kMaxCachedPerClass)
+		{
+			::operator delete(ptr);
+			return;
+		}
+		// 块可能是别的线程分配的，挂到当前线程的缓存即可
+		FreeBlock* block = static_cast<FreeBlock*>(ptr);
+		block->next = cache->heads[index];
+		cache->heads[index] = block;
+		++cache->counts[index];
+		bump(cache->stats.cached_blocks);
+		bump(cache->stats.cached_bytes, static_cast<int64_t>((index + 1) * kSizeClassBytes));
+	}
+
+	void RpcObjectPool::setEnabled(bool enabled)
+	{
+		g_pool_enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool RpcObjectPool::enabled()
+	{
+		return g_pool_enabled.load(std::memory_order_relaxed);
+	}
+
+	RpcObjectPool::Stats RpcObjectPool::stats()
+	{
+		std::lock_guard lock{g_registry_mu};
+		Stats result = g_retired_stats;
+		for (const ThreadCache* cache : g_thread_caches)
+		{
+			result.pooled_allocs += cache->stats.pooled_allocs.load(std::memory_order_relaxed);
+			result.heap_allocs += cache->stats.heap_allocs.load(std::memory_order_relaxed);
+			result.frees += cache->stats.frees.load(std::memory_order_relaxed);
+			result.cached_blocks += cache->stats.cached_blocks.load(std::memory_order_relaxed);
+			result.cached_bytes += cache->stats.cached_bytes.load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+} // namespace tongos
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace tongos
+{
+	// 每次调用都要分配的小对象（RpcStream、RpcStreamRW、reactor、arena块）的内存池
+	// 按64字节分档，每个线程缓存自己的空闲块，分配/释放不加锁；超过kMaxPooledSize或缓存已满时走系统分配器
+	// 池里只复用内存：对象总是先完整析构再还回池，下次重新构造，上一次调用的状态不会带到下一次
+	class TONGOSGRPC_API RpcObjectPool
+	{
+	public:
+		static constexpr size_t kSizeClassBytes = 64;
+		static constexpr size_t kMaxPooledSize = 4096;
+		static constexpr size_t kSizeClassNum = kMaxPooledSize / kSizeClassBytes;
+		// 每个线程每档最多缓存的空闲块数
+		static constexpr size_t kMaxCachedPerClass = 256;
+
+		struct Stats
+		{
+			// 直接从线程缓存拿到的块
+			uint64_t pooled_allocs = 0;
+			// 缓存为空、超过kMaxPooledSize或池被关闭，走了系统分配器
+			uint64_t heap_allocs = 0;
+			uint64_t frees = 0;
+			// 当前缓存在各线程里的空闲块
+			uint64_t cached_blocks = 0;
+			uint64_t cached_bytes = 0;
+		};
+
+		static void* allocate(size_t size);
+		static void deallocate(void* ptr, size_t size);
+
+		// 关闭后分配和释放都直接走系统分配器，用于对比测试
+		static void setEnabled(bool enabled);
+		static bool enabled();
+
+		static Stats stats();
+	};
+
+	// 继承后该类及其派生类的new/delete走RpcObjectPool
+	// 多态类型必须有虚析构，delete时才能拿到实际类型的大小
+	struct RpcPooled
+	{
+		static void* operator new(size_t size) { return RpcObjectPool::allocate(size); }
+		static void operator delete(void* ptr, size_t size) { RpcObjectPool::deallocate(ptr, size); }
+	};
+
+	// 给std::allocate_shared和shared_ptr控制块用的分配器
+	template <typename T>
+	struct RpcPoolAllocator
+	{
+		using value_type = T;
+
+		RpcPoolAllocator() = default;
+
+		template <typename U>
+		RpcPoolAllocator(const RpcPoolAllocator<U>&)
+		{
+		}
+
+		T* allocate(size_t n)
+		{
+			static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned type cannot be pooled");
+			return static_cast<T*>(RpcObjectPool::allocate(n * sizeof(T)));
+		}
+
+		void deallocate(T* ptr, size_t n) { RpcObjectPool::deallocate(ptr, n * sizeof(T)); }
+
+		template <typename U>
+		bool operator==(const RpcPoolAllocator<U>&) const { return true; }
+
+		template <typename U>
+		bool operator!=(const RpcPoolAllocator<U>&) const { return false; }
+	};
+} // namespace tongos
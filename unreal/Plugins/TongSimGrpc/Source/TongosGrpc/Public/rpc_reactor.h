@@ -16,6 +16,12 @@ namespace tongos
 		{
 			this->rpc_stream_rw->writeAndFinish(response);
 		}
+
+		// 大块bytes字段以外部内存发送，response中这些字段留空
+		void writeAndFinish(const Response& response, std::vector<RpcExternalBytes> fields)
+		{
+			this->rpc_stream_rw->writeAndFinishWithExternalBytes(response, std::move(fields));
+		}
 	};
 
 	template <typename Request, typename Response>
@@ -27,7 +33,8 @@ namespace tongos
 	private:
 		void onRequest(Request& request) override final
 		{
-			Response response;
+			// handler填充的响应分配在本次调用的arena上，call结束时整体释放
+			Response& response = *this->template createMessage<Response>();
 			ResponseStatus status = onRequestSync(request, response);
 			if (status.ok())
 			{
@@ -73,6 +80,15 @@ namespace tongos
 	public:
 		static constexpr RpcType rpc_type = RpcType::SERVER_STREAMING;
 		void write(const Response& response) override { this->rpc_stream_rw->write(response); }
+
+		// 大块bytes字段以外部内存发送，response中这些字段留空
+		void write(const Response& response, std::vector<RpcExternalBytes> fields)
+		{
+			this->rpc_stream_rw->writeWithExternalBytes(response, std::move(fields));
+		}
+
+		// 已提交但还没写到网络上的消息数，可以用来在客户端接收慢时合并或跳过推送
+		size_t pendingWrites() { return this->rpc_stream_rw->pendingWrites(); }
 	};
 
 	template <typename Request, typename Response>
@@ -106,6 +122,7 @@ namespace tongos
 			rpc_stream_rw->deserialize(optional_request.value());
 
 
+#ifndef TONGOS_STANDALONE
 			// Grpc Message Debug by WuKunKun:
 			UTSGrpcMessageDebugSubsystem* DebugSubsystem = UTSGrpcMessageDebugSubsystem::GetInstance();
 			if (optional_request && DebugSubsystem)
@@ -114,6 +131,7 @@ namespace tongos
 				// rpc_event.rpc_stream()->method()
 				DebugSubsystem->DebugRequest(&optional_request.value());
 			}
+#endif
 
 			onRequest(optional_request);
 			nextRequest();
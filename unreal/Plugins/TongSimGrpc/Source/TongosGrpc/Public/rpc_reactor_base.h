@@ -1,7 +1,13 @@
 #pragma once
 #include "rpc_stream_rw.h"
 #include "CoreMinimal.h"
+// TONGOS_STANDALONE：脱离UE单独编译框架（见 Tools/TongosBench），不带消息调试
+#ifndef TONGOS_STANDALONE
 #include "Debug/TSGrpcMessageDebugSubsystem.h"
+#endif
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/message_lite.h>
 
 namespace tongos
 {
@@ -19,13 +25,17 @@ namespace tongos
 		};
 	} // namespace detail
 
+	// 关闭后createMessage改为逐条堆分配，用于对比测试（见 Tools/TongosBench 的 --arena）
+	TONGOSGRPC_API void setRpcArenaEnabled(bool enabled);
+	TONGOSGRPC_API bool rpcArenaEnabled();
 
-	class RpcReactorBase : virtual public detail::RpcReactorFinisher
+	// reactor及其派生类的内存从RpcObjectPool复用
+	class RpcReactorBase : virtual public detail::RpcReactorFinisher, public RpcPooled
 	{
 	public:
 		RpcReactorBase()
 		{
-			rpc_stream_rw = MakeShareable(new RpcStreamRW);
+			rpc_stream_rw = std::allocate_shared<RpcStreamRW>(RpcPoolAllocator<RpcStreamRW>());
 		}
 
 		using unique_ptr = std::unique_ptr<RpcReactorBase>;
@@ -53,6 +63,37 @@ namespace tongos
 
 		std::shared_ptr<RpcReactorBase> sharedSelf() { return shared_self_; }
 
+		RpcLane lane() const { return lane_; }
+
+		// 本次调用的protobuf arena，第一次使用时创建，reactor析构时一次性释放
+		// 流式调用中arena只增不减，逐条构造的大消息不要放在这里
+		google::protobuf::Arena* arena()
+		{
+			if (!arena_)
+			{
+				google::protobuf::ArenaOptions options;
+				options.start_block_size = kArenaStartBlockSize;
+				options.max_block_size = kArenaMaxBlockSize;
+				// 小块从池里复用，大块会自动落到系统分配器
+				options.block_alloc = &RpcObjectPool::allocate;
+				options.block_dealloc = &RpcObjectPool::deallocate;
+				arena_.emplace(options);
+			}
+			return &arena_.value();
+		}
+
+		// 在本次调用的arena上创建消息，生命周期与reactor相同
+		template <typename Message>
+		Message* createMessage()
+		{
+			if (!rpcArenaEnabled())
+			{
+				heap_messages_.emplace_back(new Message());
+				return static_cast<Message*>(heap_messages_.back().get());
+			}
+			return google::protobuf::Arena::CreateMessage<Message>(arena());
+		}
+
 	protected:
 		// client断开连接时或者server端调用tryCancel后触发
 		// 这个回调能及时感知到错误，所以可以用来及时取消server正在进行的计算
@@ -74,7 +115,10 @@ namespace tongos
 		friend class RpcReactorServerStreaming;
 		template <typename Request, typename Response>
 		friend class RpcReactorBidiStreaming;
-		void init() { shared_self_ = std::shared_ptr<RpcReactorBase>(this); }
+		void init()
+		{
+			shared_self_ = std::shared_ptr<RpcReactorBase>(this, std::default_delete<RpcReactorBase>(), RpcPoolAllocator<RpcReactorBase>());
+		}
 
 		virtual void onFinish()
 		{
@@ -116,14 +160,24 @@ namespace tongos
 
 		void bindRpcStream(RpcEvent& rpc_event)
 		{
-			this->rpc_stream_rw->bind(rpc_event.rpc_stream());
+			this->rpc_stream_rw->bind(rpc_event.rpc_stream(), metrics_);
 		}
 
-		TSharedPtr<RpcStreamRW> rpc_stream_rw;
+		static constexpr size_t kArenaStartBlockSize = 1024;
+		static constexpr size_t kArenaMaxBlockSize = 1024 * 1024;
+
+		std::shared_ptr<RpcStreamRW> rpc_stream_rw;
 		std::shared_ptr<RpcReactorBase> shared_self_;
+		// 由RpcRouter在创建时设置，FINISH事件没有rpc_stream，靠它找回原来的线路
+		RpcLane lane_ = RpcLane::GAME_THREAD;
+		size_t lane_slot_ = 0;
+		RpcRouteMetrics* metrics_ = nullptr;
+		std::optional<google::protobuf::Arena> arena_;
+		// arena关闭时createMessage创建的消息
+		std::vector<std::unique_ptr<google::protobuf::MessageLite>> heap_messages_;
 
 	public:
-		TSharedPtr<RpcStreamRW> GetRpcStream()
+		std::shared_ptr<RpcStreamRW> GetRpcStream()
 		{
 			return rpc_stream_rw;
 		}
@@ -169,18 +223,21 @@ namespace tongos
 
 			void handleRequest(RpcEvent& rpc_event) override
 			{
-				Request request;
-				this->rpc_stream_rw->deserialize(request);
+				// 请求及其子消息都分配在本次调用的arena上
+				Request* request = this->template createMessage<Request>();
+				this->rpc_stream_rw->deserialize(*request);
 
+#ifndef TONGOS_STANDALONE
 				// Grpc Message Debug by WuKunKun:
 				if (UTSGrpcMessageDebugSubsystem* DebugSubsystem = UTSGrpcMessageDebugSubsystem::GetInstance())
 				{
 					// TODO: Add method to serialize?
 					// rpc_event.rpc_stream()->method()
-					DebugSubsystem->DebugRequest(&request);
+					DebugSubsystem->DebugRequest(request);
 				}
+#endif
 
-				invokeHandler(&RpcReactorUnaryBase::onRequest, *this, request);
+				invokeHandler(&RpcReactorUnaryBase::onRequest, *this, *request);
 			}
 		};
 
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "rpc_event.h"
+#include "rpc_metrics.h"
 #include "rpc_reactor.h"
 #include "rpc_responder.h"
 #include "rpc_type.h"
 #include <functional>
+#include <memory>
 #include <optional>
 #include <shared_mutex>
 
@@ -26,75 +28,89 @@ namespace tongos
 		{
 			RpcType rpc_type;
 			RpcReactorGenerator rpc_reactor_generator;
+			RpcLane lane = RpcLane::GAME_THREAD;
+			RpcRouteMetrics* metrics = nullptr;
 		};
 
+		// 非GAME_THREAD线路上的reactor不能访问UObject，必须自己保证线程安全
 		template <typename Reactor>
 		void registerReactorCreator(const std::string& method,
-		                            std::function<Reactor *()> reactor_creator)
+		                            std::function<Reactor *()> reactor_creator,
+		                            RpcLane lane = RpcLane::GAME_THREAD)
 		{
 			std::scoped_lock lock(mu);
 			route_map[method] = RpcRoute{
 				Reactor::rpc_type,
 				reactor_creator,
+				lane,
+				ensureMetrics(method),
 			};
 		}
 
-		void registerReactorCreator(const std::string& method, RpcType rpc_type, std::function<RpcReactorBase *()> reactor_creator)
+		void registerReactorCreator(const std::string& method, RpcType rpc_type, std::function<RpcReactorBase *()> reactor_creator,
+		                            RpcLane lane = RpcLane::GAME_THREAD)
 		{
 			std::scoped_lock lock(mu);
 			route_map[method] = RpcRoute{
 				rpc_type,
 				reactor_creator,
+				lane,
+				ensureMetrics(method),
 			};
 		}
 
 		template <typename Reactor>
 		void registerReactorCreator(const std::string& method,
-		                            Reactor*(reactor_creator)())
+		                            Reactor*(reactor_creator)(),
+		                            RpcLane lane = RpcLane::GAME_THREAD)
 		{
-			registerReactorCreator(method, std::function(reactor_creator));
+			registerReactorCreator(method, std::function(reactor_creator), lane);
 		}
 
 		template <typename T>
 		static T* allocate() { return new T{}; }
 
 		template <typename Reactor>
-		void registerReactor(const std::string& method)
+		void registerReactor(const std::string& method, RpcLane lane = RpcLane::GAME_THREAD)
 		{
-			registerReactorCreator(method, allocate<Reactor>);
+			registerReactorCreator(method, allocate<Reactor>, lane);
 		}
 
 		template <typename Request, typename Response>
 		void
 		registerUnary(const std::string& method,
-		              std::function<ResponseStatus(Request&, Response&)> handler)
+		              std::function<ResponseStatus(Request&, Response&)> handler,
+		              RpcLane lane = RpcLane::GAME_THREAD)
 		{
 			using Reactor = RpcReactorUnarySyncHandler<Request, Response>;
 			registerReactorCreator<Reactor>(
-				method, [handler]() { return Reactor::create(handler); });
+				method, [handler]() { return Reactor::create(handler); }, lane);
 		}
 
 		template <typename Handler>
-		void registerUnaryHandler(const std::string& method, Handler handler)
+		void registerUnaryHandler(const std::string& method, Handler handler,
+		                          RpcLane lane = RpcLane::GAME_THREAD)
 		{
-			registerUnary(method, std::function(handler));
+			registerUnary(method, std::function(handler), lane);
 		}
 
 		template <typename Request, typename Response>
 		void registerServerStreaming(const std::string& method,
 		                             std::function<void(Request& request,
 		                                                RpcServerStreamingResponder<Response> responder)>
-		                             handler)
+		                             handler,
+		                             RpcLane lane = RpcLane::GAME_THREAD)
 		{
 			using Reactor = RpcReactorServerStreamingHandler<Request, Response>;
 			registerReactorCreator<Reactor>(
-				method, [handler]() { return Reactor::create(handler); });
+				method, [handler]() { return Reactor::create(handler); }, lane);
 		}
 
 		template <typename Handler>
-		void registerServerStreamingHandler(const std::string& method, Handler handler)
+		void registerServerStreamingHandler(const std::string& method, Handler handler,
+		                                    RpcLane lane = RpcLane::GAME_THREAD)
 		{
-			registerServerStreaming(method, std::function(handler));
+			registerServerStreaming(method, std::function(handler), lane);
 		}
 
 		template <class Object, class Request, class Response>
@@ -127,6 +143,44 @@ namespace tongos
 			}
 		}
 
+		// 在cq线程上调用，决定事件投递到哪条线路；slot用于WORKER_POOL线路按调用固定线程
+		// 同一个调用的所有事件（包括没有rpc_stream的FINISH）都会得到相同的线路和slot
+		RpcLane queryLane(RpcEvent& rpc_event, size_t& slot)
+		{
+			RpcReactorBase* rpc_reactor = rpc_event.backuped_rpc_reactor();
+			RpcStream* rpc_stream = rpc_event.rpc_stream();
+			if (rpc_reactor == nullptr && rpc_stream != nullptr)
+			{
+				rpc_reactor = rpc_stream->getRpcReactor();
+			}
+			if (rpc_reactor != nullptr)
+			{
+				slot = rpc_reactor->lane_slot_;
+				return rpc_reactor->lane_;
+			}
+			if (rpc_stream == nullptr)
+			{
+				// 没有reactor的FINISH（未注册的方法），handle里会直接忽略
+				slot = 0;
+				return RpcLane::CQ_THREAD;
+			}
+			slot = laneSlotOf(rpc_stream);
+			auto optional_route = queryRoute(rpc_stream->method());
+			// 未注册的方法直接在cq线程上返回UNIMPLEMENTED
+			return optional_route ? optional_route.value()->lane : RpcLane::CQ_THREAD;
+		}
+
+		// 遍历所有路由的统计，fn在共享锁内调用
+		template <typename Fn>
+		void forEachRouteMetrics(Fn&& fn)
+		{
+			std::shared_lock lock{mu};
+			for (auto& [method, metrics] : metrics_map)
+			{
+				fn(*metrics);
+			}
+		}
+
 		void handle(RpcEvent rpc_event)
 		{
 			RpcReactorBase* rpc_reacotr = rpc_event.backuped_rpc_reactor();
@@ -155,6 +209,13 @@ namespace tongos
 				}
 				// 创建reactor
 				rpc_reacotr = optional_route.value()->rpc_reactor_generator();
+				rpc_reacotr->lane_ = optional_route.value()->lane;
+				rpc_reacotr->lane_slot_ = laneSlotOf(rpc_stream);
+				rpc_reacotr->metrics_ = optional_route.value()->metrics;
+				if (rpc_reacotr->metrics_)
+				{
+					rpc_reacotr->metrics_->calls.fetch_add(1, std::memory_order_relaxed);
+				}
 				rpc_stream->bindRpcReactor(rpc_reacotr);
 				rpc_reacotr->bindRpcStream(rpc_event);
 				rpc_reacotr->init();
@@ -162,10 +223,21 @@ namespace tongos
 				UE_LOG(LogTongSimGRPC, Log, TEXT("[handle] Created new RpcReactor for method: %s"), UTF8_TO_TCHAR(rpc_stream->method().c_str()));
 			}
 
-			// 处理消息
+			// 处理消息，CALL/REQUEST记录排队和执行耗时
+			RpcRouteMetrics* metrics = rpc_event.event_type() <= RpcEventType::REQUEST ? rpc_reacotr->metrics_ : nullptr;
+			const RpcClock::time_point handle_start = metrics ? RpcClock::now() : RpcClock::time_point();
+			if (metrics)
+			{
+				metrics->phase(RpcPhase::QUEUE_WAIT).record(static_cast<uint64_t>(
+					std::chrono::duration_cast<std::chrono::microseconds>(handle_start - rpc_event.enqueue_time()).count()));
+			}
 			try
 			{
 				rpc_reacotr->handle(rpc_event);
+				if (metrics)
+				{
+					metrics->record(RpcPhase::HANDLER, handle_start);
+				}
 			}
 			catch (const RpcException& ex)
 			{
@@ -190,9 +262,27 @@ namespace tongos
 		}
 
 	private:
+		// 调用方持有mu的写锁
+		RpcRouteMetrics* ensureMetrics(const std::string& method)
+		{
+			auto& metrics = metrics_map[method];
+			if (!metrics)
+			{
+				metrics = std::make_unique<RpcRouteMetrics>(method);
+			}
+			return metrics.get();
+		}
+
+		static size_t laneSlotOf(RpcStream* rpc_stream)
+		{
+			return std::hash<const void*>{}(rpc_stream) >> 4;
+		}
+
 		// todo 这里的Key类型应该是什么
 		using RouteMap = std::map<std::string, RpcRoute, std::less<>>;
 		std::shared_mutex mu;
 		RouteMap route_map;
+		// 重复注册同一个方法时复用统计，指针在router生命周期内有效
+		std::map<std::string, std::unique_ptr<RpcRouteMetrics>, std::less<>> metrics_map;
 	};
 } // namespace tongos
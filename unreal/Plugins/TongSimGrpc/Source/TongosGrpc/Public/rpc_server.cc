@@ -1,5 +1,7 @@
 #include "rpc_server.h"
 
+#include <grpcpp/resource_quota.h>
+
 namespace tongos
 {
 	RpcServer::RpcServer(std::string address, RpcRouter& router,
@@ -11,11 +13,84 @@ namespace tongos
 		server_builder.RegisterAsyncGenericService(&rpc_server_info.generic_service);
 	}
 
+	RpcServer::RpcServer(const RpcServerOptions& options, RpcRouter& router)
+		: address(options.address), rpc_server_info(router),
+		  shutdown_timeout_ms(options.shutdown_timeout_ms), index(0)
+	{
+		server_builder.AddListeningPort(address, grpc::InsecureServerCredentials());
+		server_builder.RegisterAsyncGenericService(&rpc_server_info.generic_service);
+		applyOptions(options);
+	}
+
+	void RpcServer::applyOptions(const RpcServerOptions& options)
+	{
+		if (options.max_send_message_size != 0)
+		{
+			server_builder.SetMaxSendMessageSize(options.max_send_message_size);
+		}
+		if (options.max_receive_message_size != 0)
+		{
+			server_builder.SetMaxReceiveMessageSize(options.max_receive_message_size);
+		}
+		if (options.keepalive_time_ms > 0)
+		{
+			server_builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIME_MS, options.keepalive_time_ms);
+			// 允许客户端以同样的频率发送ping，否则会被当成ping flood断开
+			server_builder.AddChannelArgument(GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS, options.keepalive_time_ms);
+		}
+		if (options.keepalive_timeout_ms > 0)
+		{
+			server_builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, options.keepalive_timeout_ms);
+		}
+		if (options.keepalive_permit_without_calls)
+		{
+			server_builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+			server_builder.AddChannelArgument(GRPC_ARG_HTTP2_MAX_PING_STRIKES, 0);
+		}
+		if (options.max_concurrent_streams > 0)
+		{
+			server_builder.AddChannelArgument(GRPC_ARG_MAX_CONCURRENT_STREAMS, options.max_concurrent_streams);
+		}
+		if (options.resource_quota_memory_bytes > 0 || options.resource_quota_max_threads > 0)
+		{
+			grpc::ResourceQuota quota("tongos");
+			if (options.resource_quota_memory_bytes > 0)
+			{
+				quota.Resize(static_cast<size_t>(options.resource_quota_memory_bytes));
+			}
+			if (options.resource_quota_max_threads > 0)
+			{
+				quota.SetMaxThreads(options.resource_quota_max_threads);
+			}
+			server_builder.SetResourceQuota(quota);
+		}
+	}
+
 	// 添加worker
-	void RpcServer::addWorker(RpcWorker::Callback callback)
+	void RpcServer::addWorker(RpcWorker::Callback callback, size_t pending_calls)
+	{
+		rpc_workers.emplace_front(index++, callback,
+		                          server_builder.AddCompletionQueue(),
+		                          rpc_server_info, pending_calls);
+	}
+
+	void RpcServer::addWorkers(size_t num, RpcWorker::Callback callback,
+	                           size_t pending_calls)
 	{
-		rpc_workers.emplace_front(
-			index++, callback, server_builder.AddCompletionQueue(), rpc_server_info);
+		for (size_t i = 0; i < num; ++i)
+		{
+			addWorker(callback, pending_calls);
+		}
+	}
+
+	uint64_t RpcServer::callsInFly()
+	{
+		uint64_t calls = 0;
+		for (auto&& worker : rpc_workers)
+		{
+			calls += worker.callsInFly();
+		}
+		return calls;
 	}
 
 	// 启动server
@@ -33,18 +108,31 @@ namespace tongos
 		{
 			worker.start();
 		}
-		UE_LOG(LogTongSimGRPC, Log, TEXT("[RpcServer::start] Starting gRPC server on address: %s"), UTF8_TO_TCHAR(address.c_str()));
+		UE_LOG(LogTongSimGRPC, Log, TEXT("[RpcServer::start] Starting gRPC server on address: %s, workers: %d"), UTF8_TO_TCHAR(address.c_str()), index);
 		return true;
 	}
 
 	void RpcServer::wait() { server->Wait(); }
 
-	RpcServer::~RpcServer()
+	void RpcServer::shutdown()
 	{
-		if (server)
+		if (!server)
+		{
+			return;
+		}
+		const auto deadline = std::chrono::system_clock::now() + shutdown_timeout_ms;
+		// server关闭后挂起的RequestCall会以ok=false返回，各cq上的calls_in_fly随之归零
+		server->Shutdown(deadline);
+		for (auto&& worker : rpc_workers)
 		{
-			server->Shutdown(std::chrono::system_clock::now() + shutdown_timeout_ms);
-			UE_LOG(LogTongSimGRPC, Log, TEXT("[RpcServer::~RpcServer] Server shutdown completed at address: %s"), UTF8_TO_TCHAR(address.c_str()));
+			worker.shutdown(deadline);
 		}
+		server.reset();
+		UE_LOG(LogTongSimGRPC, Log, TEXT("[RpcServer::shutdown] Server shutdown completed at address: %s"), UTF8_TO_TCHAR(address.c_str()));
+	}
+
+	RpcServer::~RpcServer()
+	{
+		shutdown();
 	}
 } // namespace tongos
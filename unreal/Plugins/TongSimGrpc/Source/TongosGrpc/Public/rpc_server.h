@@ -8,6 +8,26 @@
 
 namespace tongos
 {
+	// server启动参数，数值<=0表示使用grpc默认值
+	struct RpcServerOptions
+	{
+		// host:port，或者unix:/path/to/socket
+		std::string address = "0.0.0.0:5726";
+		std::chrono::milliseconds shutdown_timeout_ms = std::chrono::milliseconds(1000);
+		// 单条消息的最大字节数，-1表示不限制
+		int max_send_message_size = 0;
+		int max_receive_message_size = 0;
+		// keepalive
+		int keepalive_time_ms = 0;
+		int keepalive_timeout_ms = 0;
+		bool keepalive_permit_without_calls = false;
+		// 单个连接上的最大并发流数
+		int max_concurrent_streams = 0;
+		// 资源配额
+		int64_t resource_quota_memory_bytes = 0;
+		int resource_quota_max_threads = 0;
+	};
+
 	// UE跨模块编译会导致grpc链接出现问题（违反ODR)，从而卡在grpc::InsecureServerCredentials()上
 	// class TONGOSGRPC_API RpcServer {
 	class TONGOSGRPC_API RpcServer
@@ -16,15 +36,26 @@ namespace tongos
 		RpcServer(std::string address, RpcRouter& router,
 		          std::chrono::milliseconds shutdown_timeout_ms =
 			          std::chrono::milliseconds(1000));
+		RpcServer(const RpcServerOptions& options, RpcRouter& router);
 		~RpcServer();
 
-		// 添加worker
-		void addWorker(RpcWorker::Callback callback);
+		// 添加worker，每个worker独占一个cq和一个线程
+		void addWorker(RpcWorker::Callback callback, size_t pending_calls = 1);
+		// 添加num个worker，调用按cq分片；callback会在多个worker线程上并发调用
+		void addWorkers(size_t num, RpcWorker::Callback callback,
+		                size_t pending_calls = 1);
+		size_t workerNum() const { return static_cast<size_t>(index); }
+		// 所有worker上挂起和处理中的调用数
+		uint64_t callsInFly();
 		// 启动server
 		bool start();
 		void wait();
+		// 平滑关闭：先关闭server，再逐个等待cq上的调用结束并回收线程
+		void shutdown();
 
 	private:
+		void applyOptions(const RpcServerOptions& options);
+
 		grpc::ServerBuilder server_builder;
 		std::string address;
 		RpcServerInfo rpc_server_info;
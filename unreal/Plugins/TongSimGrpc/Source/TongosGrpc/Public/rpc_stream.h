@@ -3,6 +3,7 @@
 #include "rpc_common.h"
 #include "rpc_event.h"
 #include "rpc_exception.h"
+#include "rpc_object_pool.h"
 #include "rpc_type.h"
 #include "rpc_write_queue.h"
 // #include "util/logger.h"
@@ -28,7 +29,8 @@ namespace tongos
 
 	class RpcReactorBase;
 
-	class RpcStream
+	// 每个调用一个，cq线程上创建和销毁，内存从RpcObjectPool的线程缓存里复用
+	class RpcStream : public RpcPooled
 	{
 	public:
 		using Ptr = std::shared_ptr<RpcStream>;
@@ -70,6 +72,8 @@ namespace tongos
 
 		RpcReactorBase* getRpcReactor() { return this->rpc_reactor_; }
 
+		void bindMetrics(RpcRouteMetrics* metrics) { this->metrics_ = metrics; }
+
 		static std::optional<RpcEvent> handle(void* tag, bool ok,
 		                                      std::function<void()>& increment_hook,
 		                                      std::function<void()>& decrement_hook)
@@ -116,6 +120,7 @@ namespace tongos
 
 			if (!writing)
 			{
+				inflight_write_time = RpcClock::now();
 				generic_stream.Write(write_buffer, encodeTag(OpTag::WRITE));
 				writing = true;
 			}
@@ -127,6 +132,13 @@ namespace tongos
 
 		void tryCancel() { generic_server_ctx.TryCancel(); }
 
+		// 还没写完的消息数（包括正在写的那条）
+		size_t pendingWrites()
+		{
+			std::scoped_lock guard(write_mu);
+			return write_queue.size() + (writing ? 1 : 0);
+		}
+
 		// 上层需要保证finish只被调用一次
 		void finish(const ResponseStatus& status)
 		{
@@ -159,6 +171,13 @@ namespace tongos
 
 		void doFinish(const ResponseStatus& status)
 		{
+			if (!status.ok())
+			{
+				if (RpcRouteMetrics* metrics = metrics_)
+				{
+					metrics->failed_calls.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
 			rpc_state_ = RpcState::FINISHED;
 			generic_stream.Finish(status.to_grpc_status(), encodeTag(OpTag::FINISH));
 		}
@@ -227,10 +246,15 @@ namespace tongos
 		void nextWrite()
 		{
 			std::scoped_lock guard(write_mu);
+			if (RpcRouteMetrics* metrics = metrics_)
+			{
+				metrics->record(RpcPhase::WRITE_DRAIN, inflight_write_time);
+			}
 			if (!write_queue.empty())
 			{
 				if (rpc_state_ == RpcState::NORMAL)
 				{
+					inflight_write_time = write_queue.frontEnqueueTime();
 					generic_stream.Write(write_queue.front(), encodeTag(OpTag::WRITE));
 					write_queue.pop();
 					return;
@@ -357,5 +381,8 @@ namespace tongos
 		std::atomic<RpcState> rpc_state_;
 		std::optional<ResponseStatus> status_;
 		std::atomic<RpcReactorBase*> rpc_reactor_;
+		std::atomic<RpcRouteMetrics*> metrics_ = nullptr;
+		// 正在写的消息进入写队列的时间
+		RpcClock::time_point inflight_write_time;
 	};
 } // namespace tongos
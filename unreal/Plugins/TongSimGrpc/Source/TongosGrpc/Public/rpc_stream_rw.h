@@ -1,5 +1,6 @@
 #pragma once
 
+#include "rpc_external_bytes.h"
 #include "rpc_stream.h"
 #include <sstream>
 #include <grpcpp/support/proto_buffer_reader.h>
@@ -19,7 +20,12 @@ namespace tongos
 		{
 		}
 
-		void bind(RpcStream* rpc_stream) { this->rpc_stream_ = rpc_stream; }
+		void bind(RpcStream* rpc_stream, RpcRouteMetrics* metrics = nullptr)
+		{
+			this->rpc_stream_ = rpc_stream;
+			this->metrics_ = metrics;
+			rpc_stream->bindMetrics(metrics);
+		}
 
 		// readToBuffer不会抛出异常
 		void readToBuffer()
@@ -64,8 +70,13 @@ namespace tongos
 
 			bool own_buffer;
 			grpc::ByteBuffer write_buffer;
+			const RpcClock::time_point serialize_start = RpcClock::now();
 			auto status = grpc::GenericSerialize<grpc::ProtoBufferWriter, PB_TYPE>(
 				std::forward<PB_TYPE>(pb_value), &write_buffer, &own_buffer);
+			if (metrics_)
+			{
+				metrics_->record(RpcPhase::SERIALIZE, serialize_start);
+			}
 			if (!status.ok())
 			{
 				std::ostringstream oss;
@@ -78,6 +89,44 @@ namespace tongos
 			return rpc_stream_->write(std::move(write_buffer));
 		}
 
+		// 与write相同，但fields中的大块bytes以外部slice发送，不拷贝进消息也不再序列化一次
+		// header中对应字段必须留空
+		void writeWithExternalBytes(const google::protobuf::MessageLite& header, std::vector<RpcExternalBytes> fields)
+		{
+			std::scoped_lock lock_guard(mu);
+			ensureUnFinished();
+
+			grpc::ByteBuffer write_buffer;
+			const RpcClock::time_point serialize_start = RpcClock::now();
+			auto status = serializeWithExternalBytes(header, std::move(fields), &write_buffer);
+			if (metrics_)
+			{
+				metrics_->record(RpcPhase::SERIALIZE, serialize_start);
+			}
+			if (!status.ok())
+			{
+				std::ostringstream oss;
+				oss << (void*)this << " " << rpc_stream_->method()
+					<< " message serialize failed, code:" << status.error_code()
+					<< ", msg:" << status.error_message();
+				throw RpcException{grpc::StatusCode::INTERNAL, oss.str()};
+			}
+
+			return rpc_stream_->write(std::move(write_buffer));
+		}
+
+		// pendingWrites不会抛异常，流结束后返回0
+		size_t pendingWrites()
+		{
+			std::scoped_lock lock_guard(mu);
+			if (finished)
+			{
+				return 0;
+			}
+
+			return rpc_stream_->pendingWrites();
+		}
+
 		// tryCancel不会抛异常
 		void tryCancel()
 		{
@@ -119,6 +168,21 @@ namespace tongos
 			finish(status);
 		}
 
+		// writeAndFinishWithExternalBytes不会抛异常
+		void writeAndFinishWithExternalBytes(const google::protobuf::MessageLite& header, std::vector<RpcExternalBytes> fields)
+		{
+			ResponseStatus status;
+			try
+			{
+				writeWithExternalBytes(header, std::move(fields));
+			}
+			catch (RpcException& ex)
+			{
+				status = ex.status();
+			}
+			finish(status);
+		}
+
 	private:
 		void ensureUnFinished()
 		{
@@ -132,6 +196,7 @@ namespace tongos
 
 		std::mutex mu;
 		RpcStream* rpc_stream_;
+		RpcRouteMetrics* metrics_ = nullptr;
 		bool finished;
 	};
 } // namespace tongos
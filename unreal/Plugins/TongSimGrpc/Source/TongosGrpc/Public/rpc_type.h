@@ -12,6 +12,17 @@ namespace tongos
 		BIDI_STREAMING,
 	};
 
+	// 路由的执行线路：决定reactor的回调在哪个线程上执行
+	enum class RpcLane
+	{
+		// 游戏线程，在UTSGrpcSubsystem::Tick里处理（默认，可以访问UObject）
+		GAME_THREAD,
+		// 独立的worker线程池，同一个调用的事件总在同一个线程上按序处理
+		WORKER_POOL,
+		// 直接在cq线程上处理，只适合不阻塞、线程安全的轻量handler
+		CQ_THREAD,
+	};
+
 	class RpcTypeQueryer
 	{
 	public:
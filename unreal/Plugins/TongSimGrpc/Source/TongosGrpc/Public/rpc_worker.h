@@ -3,6 +3,7 @@
 #include "rpc_server_info.h"
 #include "rpc_stream.h"
 #include "util/logger.h"
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <grpcpp/grpcpp.h>
@@ -19,37 +20,65 @@ namespace tongos
 
 		RpcWorker(int index, Callback callback,
 		          std::unique_ptr<grpc::ServerCompletionQueue> cq,
-		          RpcServerInfo& rpc_server_info)
+		          RpcServerInfo& rpc_server_info, size_t pending_calls = 1)
 			: index(index), callback(callback), cq(std::move(cq)),
-			  rpc_server_info(rpc_server_info), calls_in_fly(1)
+			  rpc_server_info(rpc_server_info),
+			  pending_calls(pending_calls == 0 ? 1 : pending_calls),
+			  calls_in_fly(this->pending_calls), shutdowned(false)
 		{
 		}
 
-		~RpcWorker()
+		~RpcWorker() { shutdown(std::chrono::system_clock::now()); }
+
+		// 等待本队列上处理中的请求finish（最多到deadline），然后关闭cq并回收线程
+		// 需要在grpc::Server::Shutdown之后调用，否则预投递的RequestCall不会返回
+		void shutdown(std::chrono::system_clock::time_point deadline)
 		{
-			// 等待所有处理中的请求都finish了再关闭cq
-			// UE中server的关闭和回调处理在一个线程，所以不需要等待
-			// {
-			//   std::unique_lock lock_guard(shutdown_mu);
-			//   while(calls_in_fly != 0){
-			//     shutdown_cv.wait(lock_guard);
-			//   }
-			// }
-			tonglog(INFO) << index << " all calls done";
+			if (shutdowned)
+			{
+				return;
+			}
+			shutdowned = true;
+			if (worker.joinable())
+			{
+				std::unique_lock lock_guard(shutdown_mu);
+				if (!shutdown_cv.wait_until(lock_guard, deadline,
+				                            [this]() { return calls_in_fly == 0; }))
+				{
+					tonglog(WARN) << index << " shutdown deadline reached, calls in fly: "
+						<< calls_in_fly;
+				}
+				else
+				{
+					tonglog(INFO) << index << " all calls done";
+				}
+			}
 			cq->Shutdown();
 			tonglog(INFO) << index << " cq shutdowned";
-			worker.join();
+			if (worker.joinable())
+			{
+				worker.join();
+			}
 			tonglog(INFO) << index << " server worker joined";
 		}
 
+		uint64_t callsInFly()
+		{
+			std::scoped_lock lock_guard(shutdown_mu);
+			return calls_in_fly;
+		}
+
 		void start() { worker = std::thread(&RpcWorker::work, this); }
 
 	private:
 		void work()
 		{
-			// 开始接收请求
-			new RpcStream(&rpc_server_info.generic_service, cq.get(),
-			              rpc_server_info.rpc_router);
+			// 开始接收请求：每个cq预投递多个RequestCall，避免突发连接在单个accept上排队
+			for (size_t i = 0; i < pending_calls; ++i)
+			{
+				new RpcStream(&rpc_server_info.generic_service, cq.get(),
+				              rpc_server_info.rpc_router);
+			}
 			tonglog(INFO) << index << " server loop start";
 
 			std::function<void()> increment_calls = [this]() { incrementCalls(); };
@@ -59,7 +88,7 @@ namespace tongos
 			bool ok;
 			while (cq->Next(&tag, &ok))
 			{
-				tonglog(INFO) << "new tag: " << tag << ", result: " << ok;
+				tonglog(DEBUG) << index << " new tag: " << tag << ", result: " << ok;
 				std::optional<RpcEvent> rpc_event =
 					RpcStream::handle(tag, ok, increment_calls, decrement_calls);
 				if (!rpc_event)
@@ -73,6 +102,7 @@ namespace tongos
 
 		void incrementCalls()
 		{
+			std::scoped_lock lock_guard(shutdown_mu);
 			calls_in_fly += 1;
 			tonglog(DEBUG) << index << " increment calls in fly:" << calls_in_fly;
 		}
@@ -94,9 +124,12 @@ namespace tongos
 		RpcServerInfo& rpc_server_info;
 
 		std::thread worker;
-		// 平滑关闭
+		// 每个cq上同时挂起的RequestCall数量
+		size_t pending_calls;
+		// 平滑关闭：calls_in_fly = 挂起的RequestCall + 已接收未finish的调用
 		std::mutex shutdown_mu;
 		std::condition_variable shutdown_cv;
 		uint64_t calls_in_fly;
+		bool shutdowned;
 	};
 } // namespace tongos
@@ -2,23 +2,47 @@
 
 namespace tongos
 {
+	std::atomic<int64_t> RpcWriteQueue::total_length{0};
+
+	RpcWriteQueue::~RpcWriteQueue()
+	{
+		total_length.fetch_sub(static_cast<int64_t>(queue.size()), std::memory_order_relaxed);
+	}
+
 	bool RpcWriteQueue::empty()
 	{
 		return queue.empty();
 	}
 
+	size_t RpcWriteQueue::size()
+	{
+		return queue.size();
+	}
+
 	void RpcWriteQueue::emplace(grpc::ByteBuffer grpc_byte_buffer)
 	{
-		queue.emplace(std::move(grpc_byte_buffer));
+		queue.push(Entry{std::move(grpc_byte_buffer), RpcClock::now()});
+		total_length.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	grpc::ByteBuffer& RpcWriteQueue::front()
 	{
-		return queue.front();
+		return queue.front().buffer;
+	}
+
+	RpcClock::time_point RpcWriteQueue::frontEnqueueTime()
+	{
+		return queue.front().enqueue_time;
 	}
 
 	void RpcWriteQueue::pop()
 	{
 		queue.pop();
+		total_length.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	int64_t RpcWriteQueue::totalLength()
+	{
+		return total_length.load(std::memory_order_relaxed);
 	}
 }
@@ -1,4 +1,6 @@
 #pragma once
+#include "rpc_metrics.h"
+#include <atomic>
 #include <queue>
 #include <grpcpp/grpcpp.h>
 
@@ -7,12 +9,27 @@ namespace tongos
 	class TONGOSGRPC_API RpcWriteQueue
 	{
 	public:
+		~RpcWriteQueue();
+
 		bool empty();
+		size_t size();
 		void emplace(grpc::ByteBuffer grpc_byte_buffer);
 		grpc::ByteBuffer& front();
+		// 队首消息进入写队列的时间
+		RpcClock::time_point frontEnqueueTime();
 		void pop();
 
+		// 所有流上排队等待写出的消息总数
+		static int64_t totalLength();
+
 	private:
-		std::queue<grpc::ByteBuffer> queue;
+		struct Entry
+		{
+			grpc::ByteBuffer buffer;
+			RpcClock::time_point enqueue_time;
+		};
+
+		std::queue<Entry> queue;
+		static std::atomic<int64_t> total_length;
 	};
 }
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace tongos {
+
+// 槽位句柄：index定位槽位，generation在槽位被释放时加一，旧句柄随之失效
+struct SlotHandle {
+  static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+  uint32_t index = kInvalidIndex;
+  uint32_t generation = 0;
+
+  bool valid() const { return index != kInvalidIndex; }
+  bool operator==(const SlotHandle &other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const SlotHandle &other) const { return !(*this == other); }
+};
+
+// 分代稠密槽位表：插入、删除、按句柄查找都是O(1)，元素连续存放在values里便于遍历
+// 删除时把末尾元素挪到空位，因此遍历顺序不稳定，插入/删除后元素地址可能失效，需要长期持有的用句柄
+template <typename T> class SlotMap {
+public:
+  SlotHandle insert(T value) {
+    uint32_t index;
+    if (free_head != SlotHandle::kInvalidIndex) {
+      index = free_head;
+      free_head = slots[index].dense_or_next_free;
+    } else {
+      index = static_cast<uint32_t>(slots.size());
+      slots.emplace_back();
+    }
+    Slot &slot = slots[index];
+    slot.dense_or_next_free = static_cast<uint32_t>(values.size());
+    slot.occupied = true;
+    values.push_back(std::move(value));
+    dense_to_slot.push_back(index);
+    return {index, slot.generation};
+  }
+
+  bool erase(SlotHandle handle) {
+    if (!contains(handle)) {
+      return false;
+    }
+    Slot &slot = slots[handle.index];
+    const uint32_t dense = slot.dense_or_next_free;
+    const uint32_t last = static_cast<uint32_t>(values.size() - 1);
+    if (dense != last) {
+      values[dense] = std::move(values[last]);
+      dense_to_slot[dense] = dense_to_slot[last];
+      slots[dense_to_slot[dense]].dense_or_next_free = dense;
+    }
+    values.pop_back();
+    dense_to_slot.pop_back();
+    release(handle.index);
+    return true;
+  }
+
+  bool contains(SlotHandle handle) const {
+    return handle.index < slots.size() && slots[handle.index].occupied &&
+           slots[handle.index].generation == handle.generation;
+  }
+
+  T *find(SlotHandle handle) {
+    return contains(handle) ? &values[slots[handle.index].dense_or_next_free]
+                            : nullptr;
+  }
+
+  const T *find(SlotHandle handle) const {
+    return contains(handle) ? &values[slots[handle.index].dense_or_next_free]
+                            : nullptr;
+  }
+
+  // 槽位当前的句柄，槽位空闲时返回无效句柄
+  SlotHandle handleOf(uint32_t index) const {
+    if (index >= slots.size() || !slots[index].occupied) {
+      return {};
+    }
+    return {index, slots[index].generation};
+  }
+
+  // 第i个连续元素对应的句柄
+  SlotHandle handleAt(size_t dense) const {
+    const uint32_t index = dense_to_slot[dense];
+    return {index, slots[index].generation};
+  }
+
+  // 清空后槽位保留并递增代数，清空前发出的句柄都会失效
+  void clear() {
+    for (uint32_t index : dense_to_slot) {
+      release(index);
+    }
+    values.clear();
+    dense_to_slot.clear();
+  }
+
+  void reserve(size_t n) {
+    values.reserve(n);
+    dense_to_slot.reserve(n);
+    slots.reserve(n);
+  }
+
+  size_t size() const { return values.size(); }
+  bool empty() const { return values.empty(); }
+  // 包括空闲槽位
+  size_t capacity() const { return slots.size(); }
+
+  T &operator[](size_t dense) { return values[dense]; }
+  const T &operator[](size_t dense) const { return values[dense]; }
+
+  auto begin() { return values.begin(); }
+  auto end() { return values.end(); }
+  auto begin() const { return values.begin(); }
+  auto end() const { return values.end(); }
+
+private:
+  struct Slot {
+    // 占用时是values里的下标，空闲时是下一个空闲槽位
+    uint32_t dense_or_next_free = SlotHandle::kInvalidIndex;
+    uint32_t generation = 0;
+    bool occupied = false;
+  };
+
+  void release(uint32_t index) {
+    Slot &slot = slots[index];
+    slot.occupied = false;
+    ++slot.generation;
+    slot.dense_or_next_free = free_head;
+    free_head = index;
+  }
+
+  std::vector<T> values;
+  std::vector<uint32_t> dense_to_slot;
+  std::vector<Slot> slots;
+  uint32_t free_head = SlotHandle::kInvalidIndex;
+};
+
+} // namespace tongos
@@ -146,6 +146,12 @@ public class TongosGrpc : ModuleRules
 		//TODO: So, we don't want to change any third-party code, this why we add this definition
 		PublicDefinitions.Add("__NVCC__");
 
+		// Shipping 包里直接裁掉 tonglog(DEBUG)
+		if (Target.Configuration == UnrealTargetConfiguration.Shipping)
+		{
+			PublicDefinitions.Add("TONGOS_MIN_LOG_LEVEL=1");
+		}
+
 		Platform = Target.Platform;
 		Configuration = Target.Configuration;
 
@@ -180,7 +186,7 @@ public class TongosGrpc : ModuleRules
 		AddEngineThirdPartyPrivateStaticDependencies(Target, "OpenSSL");
 		AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
 
-		PrivateDependencyModuleNames.AddRange(new string[] { "CoreUObject", "Engine", "DeveloperSettings" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "CoreUObject", "Engine", "DeveloperSettings", "TongSimGameplay" });
 
 
 		if (Platform == UnrealTargetPlatform.Win64)
@@ -0,0 +1,35 @@
+#pragma once
+// TONGOS_STANDALONE 编译时代替UE的CoreMinimal.h，只提供框架用到的日志宏
+#include <cstdint>
+#include <cstdio>
+
+using int32 = int32_t;
+using int64 = int64_t;
+using uint64 = uint64_t;
+
+#define TEXT(x) x
+#define UTF8_TO_TCHAR(x) (x)
+
+namespace ELogVerbosity
+{
+	enum Type
+	{
+		Fatal,
+		Error,
+		Warning,
+		Display,
+		Log,
+		Verbose,
+		VeryVerbose
+	};
+}
+
+// 压测时只输出Warning及以上，避免逐调用的Log刷屏
+#define UE_LOG(Category, Verbosity, Format, ...)                                      \
+  do                                                                                  \
+  {                                                                                   \
+    if (ELogVerbosity::Verbosity <= ELogVerbosity::Warning)                           \
+    {                                                                                 \
+      std::fprintf(stderr, "[" #Category "][" #Verbosity "] " Format "\n", ##__VA_ARGS__); \
+    }                                                                                 \
+  } while (0)
@@ -0,0 +1,254 @@
+// 事件管道压测：对比原来的 std::list + mutex Channel 与 UTSGrpcSubsystem 使用的 MpscChannel
+// 多个生产者线程模拟 gRPC worker，单个消费者线程模拟游戏线程，消费端的取法分别与旧的 UpdateRpcRouter 和现在的一致
+// 每条事件带生产者编号和序号，消费端检查每个生产者的事件是否按发送顺序到达
+//   ./build/channel_bench --events=2000000 --producers=1,4,16 --rounds=3
+#include "util/channel.h"
+#include "util/mpsc_channel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct BenchOptions
+	{
+		int events = 2000000;
+		std::vector<int> producers{1, 4, 16};
+		int rounds = 3;
+		int capacity = 65536;
+	};
+
+	BenchOptions g_options;
+
+	void printUsage()
+	{
+		std::printf("usage: channel_bench [--events=2000000] [--producers=1,4,16] [--rounds=3] [--capacity=65536]\n");
+	}
+
+	bool parseIntList(const std::string& value, std::vector<int>& out)
+	{
+		out.clear();
+		size_t begin = 0;
+		while (begin <= value.size())
+		{
+			size_t end = value.find(',', begin);
+			if (end == std::string::npos)
+			{
+				end = value.size();
+			}
+			const int number = std::atoi(value.substr(begin, end - begin).c_str());
+			if (number <= 0)
+			{
+				return false;
+			}
+			out.push_back(number);
+			begin = end + 1;
+		}
+		return !out.empty();
+	}
+
+	bool parseOptions(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const size_t eq = arg.find('=');
+			if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+			{
+				return false;
+			}
+			const std::string key = arg.substr(2, eq - 2);
+			const std::string value = arg.substr(eq + 1);
+			if (key == "events") options.events = std::atoi(value.c_str());
+			else if (key == "producers")
+			{
+				if (!parseIntList(value, options.producers)) return false;
+			}
+			else if (key == "rounds") options.rounds = std::atoi(value.c_str());
+			else if (key == "capacity") options.capacity = std::atoi(value.c_str());
+			else return false;
+		}
+		return options.events > 0 && options.rounds > 0 && options.capacity > 0;
+	}
+
+	// 大小和移动开销与 RpcEvent 相近：一个 shared_ptr 加类型字段
+	struct BenchEvent
+	{
+		uint32_t producer = 0;
+		uint64_t sequence = 0;
+		std::shared_ptr<void> payload;
+	};
+
+	/**
+	 * 两种管道统一成 send / drain 接口
+	 */
+	class ListChannel
+	{
+	public:
+		explicit ListChannel(size_t)
+		{
+		}
+
+		void send(BenchEvent&& event) { channel.send(std::move(event)); }
+
+		// 与旧的 UpdateRpcRouter 一致：逐条 try_receive 直到取空
+		template <typename F>
+		size_t drain(F&& f)
+		{
+			size_t count = 0;
+			while (std::optional<BenchEvent> event = channel.try_receive())
+			{
+				f(std::move(*event));
+				++count;
+			}
+			return count;
+		}
+
+	private:
+		tongos::Channel<BenchEvent> channel;
+	};
+
+	class RingChannel
+	{
+	public:
+		explicit RingChannel(size_t capacity) : channel(capacity)
+		{
+			pending.reserve(1024);
+		}
+
+		void send(BenchEvent&& event) { channel.send(std::move(event)); }
+
+		// 与现在的 UpdateRpcRouter 一致：每次批量取最多1024条到复用的缓冲区
+		template <typename F>
+		size_t drain(F&& f)
+		{
+			size_t count = 0;
+			while (channel.try_receive_bulk(pending, 1024) > 0)
+			{
+				for (BenchEvent& event : pending)
+				{
+					f(std::move(event));
+				}
+				count += pending.size();
+				pending.clear();
+			}
+			return count;
+		}
+
+	private:
+		tongos::MpscChannel<BenchEvent> channel;
+		std::vector<BenchEvent> pending;
+	};
+
+	struct RunResult
+	{
+		double seconds = 0.0;
+		uint64_t order_errors = 0;
+	};
+
+	template <typename ChannelT>
+	RunResult runOnce(int producers)
+	{
+		ChannelT channel(static_cast<size_t>(g_options.capacity));
+		const uint64_t per_producer = static_cast<uint64_t>(g_options.events) / producers;
+		const uint64_t total = per_producer * producers;
+
+		std::atomic<bool> go{false};
+		std::vector<std::thread> threads;
+		for (int p = 0; p < producers; ++p)
+		{
+			threads.emplace_back([&channel, &go, p, per_producer]()
+			{
+				while (!go.load(std::memory_order_acquire))
+				{
+					std::this_thread::yield();
+				}
+				for (uint64_t i = 0; i < per_producer; ++i)
+				{
+					channel.send(BenchEvent{static_cast<uint32_t>(p), i, nullptr});
+				}
+			});
+		}
+
+		// 消费端：检查每个生产者的序号是否连续
+		std::vector<uint64_t> next_sequence(producers, 0);
+		RunResult result;
+		uint64_t received = 0;
+		const auto start = std::chrono::steady_clock::now();
+		go.store(true, std::memory_order_release);
+		while (received < total)
+		{
+			const size_t count = channel.drain([&](BenchEvent&& event)
+			{
+				uint64_t& expected = next_sequence[event.producer];
+				if (event.sequence != expected)
+				{
+					++result.order_errors;
+				}
+				expected = event.sequence + 1;
+			});
+			received += count;
+			if (count == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		return result;
+	}
+
+	// 多轮取最快的一次，顺序错误累加
+	template <typename ChannelT>
+	RunResult run(const char* name, int producers)
+	{
+		RunResult best;
+		best.seconds = std::numeric_limits<double>::max();
+		for (int round = 0; round < g_options.rounds; ++round)
+		{
+			const RunResult result = runOnce<ChannelT>(producers);
+			best.seconds = std::min(best.seconds, result.seconds);
+			best.order_errors += result.order_errors;
+		}
+		const uint64_t total = static_cast<uint64_t>(g_options.events) / producers * producers;
+		std::printf("  %-12s producers=%-3d events=%-9llu best=%8.1fms events/s=%12.0f ns/event=%7.1f fifo_errors=%llu\n",
+		            name, producers, static_cast<unsigned long long>(total), best.seconds * 1e3, total / best.seconds,
+		            best.seconds * 1e9 / total, static_cast<unsigned long long>(best.order_errors));
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (!parseOptions(argc, argv, g_options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	uint64_t order_errors = 0;
+	for (const int producers : g_options.producers)
+	{
+		std::printf("[producers=%d]\n", producers);
+		const RunResult list = run<ListChannel>("list_mutex", producers);
+		const RunResult ring = run<RingChannel>("mpsc_ring", producers);
+		std::printf("  speedup=%.1fx\n", ring.seconds > 0 ? list.seconds / ring.seconds : 0.0);
+		order_errors += list.order_errors + ring.order_errors;
+	}
+	// 有乱序时返回非0，方便脚本里当作正确性检查
+	return order_errors == 0 ? 0 : 2;
+}
@@ -0,0 +1,369 @@
+// 外部 bytes 字段压测：对比 serializeWithExternalBytes（header + 外部slice）与 gRPC 默认的 GenericSerialize
+// 先检查两条路径展开后的 ByteBuffer 逐字节相同，再用一帧 width*height*(4+4) 的 CaptureFrame 对比耗时和负载拷贝次数
+//   ./build/external_bytes_bench --width=1920 --height=1080 --rounds=20
+#include "rpc_external_bytes.h"
+#include "tongsim_lite_protobuf/capture.pb.h"
+#include "tongsim_lite_protobuf/demo_rl.pb.h"
+#include "tongsim_lite_protobuf/voxel.pb.h"
+
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/impl/codegen/proto_buffer_writer.h>
+#include <grpcpp/impl/codegen/proto_utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+	using Payload = std::shared_ptr<std::vector<uint8_t>>;
+
+	struct BenchOptions
+	{
+		int width = 1920;
+		int height = 1080;
+		int rounds = 20;
+	};
+
+	BenchOptions g_options;
+
+	void printUsage()
+	{
+		std::printf("usage: external_bytes_bench [--width=1920] [--height=1080] [--rounds=20]\n");
+	}
+
+	bool parseOptions(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const size_t eq = arg.find('=');
+			if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+			{
+				return false;
+			}
+			const std::string key = arg.substr(2, eq - 2);
+			const std::string value = arg.substr(eq + 1);
+			if (key == "width") options.width = std::atoi(value.c_str());
+			else if (key == "height") options.height = std::atoi(value.c_str());
+			else if (key == "rounds") options.rounds = std::atoi(value.c_str());
+			else return false;
+		}
+		return options.width > 0 && options.height > 0 && options.rounds > 0;
+	}
+
+	Payload makePayload(size_t size, uint32_t seed)
+	{
+		Payload payload = std::make_shared<std::vector<uint8_t>>(size);
+		uint32_t state = seed * 2654435761u + 1;
+		for (uint8_t& byte : *payload)
+		{
+			state = state * 1664525u + 1013904223u;
+			byte = static_cast<uint8_t>(state >> 24);
+		}
+		return payload;
+	}
+
+	tongos::RpcExternalBytes external(int field_number, const Payload& payload, bool repeated = false)
+	{
+		tongos::RpcExternalBytes bytes;
+		bytes.field_number = field_number;
+		bytes.data = payload->data();
+		bytes.size = payload->size();
+		bytes.owner = payload;
+		bytes.repeated = repeated;
+		return bytes;
+	}
+
+	// 与 RpcReactor / RpcStreamRW 的普通 write 走同一个序列化入口
+	bool genericSerialize(const google::protobuf::MessageLite& message, grpc::ByteBuffer* buffer)
+	{
+		bool own_buffer = false;
+		return grpc::GenericSerialize<grpc::ProtoBufferWriter, google::protobuf::MessageLite>(message, buffer, &own_buffer).ok();
+	}
+
+	std::string flatten(const grpc::ByteBuffer& buffer, size_t* slice_count)
+	{
+		std::vector<grpc::Slice> slices;
+		std::string out;
+		if (!buffer.Dump(&slices).ok())
+		{
+			return out;
+		}
+		*slice_count = slices.size();
+		out.reserve(buffer.Length());
+		for (const grpc::Slice& slice : slices)
+		{
+			out.append(reinterpret_cast<const char*>(slice.begin()), slice.size());
+		}
+		return out;
+	}
+
+	// 输出中不指向任何源负载的字节数，即序列化时实际拷贝的字节
+	size_t copiedBytes(const grpc::ByteBuffer& buffer, const std::vector<Payload>& sources)
+	{
+		std::vector<grpc::Slice> slices;
+		buffer.Dump(&slices);
+		size_t copied = 0;
+		for (const grpc::Slice& slice : slices)
+		{
+			const bool aliased = std::any_of(sources.begin(), sources.end(), [&slice](const Payload& source)
+			{
+				return slice.begin() >= source->data() && slice.end() <= source->data() + source->size();
+			});
+			copied += aliased ? 0 : slice.size();
+		}
+		return copied;
+	}
+
+	/**
+	 * 逐字节一致性检查：full 是所有字段都拷进消息的版本，header 是外部字段留空的版本
+	 */
+	bool checkIdentical(const char* name, const google::protobuf::MessageLite& full,
+	                    const google::protobuf::MessageLite& header, std::vector<tongos::RpcExternalBytes> fields)
+	{
+		grpc::ByteBuffer generic;
+		grpc::ByteBuffer spliced;
+		const bool generic_ok = genericSerialize(full, &generic);
+		const grpc::Status status = tongos::serializeWithExternalBytes(header, std::move(fields), &spliced);
+		size_t generic_slices = 0;
+		size_t spliced_slices = 0;
+		const std::string expected = flatten(generic, &generic_slices);
+		const std::string actual = flatten(spliced, &spliced_slices);
+		const bool ok = generic_ok && status.ok() && expected == actual;
+		std::printf("  %-24s bytes=%-10zu slices=%zu/%-3zu %s\n", name, actual.size(), generic_slices, spliced_slices,
+		            ok ? "identical" : "MISMATCH");
+		return ok;
+	}
+
+	bool runIdentityChecks()
+	{
+		std::printf("[identity] serializeWithExternalBytes vs GenericSerialize\n");
+		bool ok = true;
+
+		// QueryVoxel：大缓冲走外部slice、小缓冲走拷贝、空缓冲不输出
+		for (const size_t size : {size_t{1} << 20, size_t{1000}, size_t{0}})
+		{
+			const Payload buffer = makePayload(size, static_cast<uint32_t>(size));
+			tongsim_lite::voxel::Voxel header;
+			header.set_encoding(tongsim_lite::voxel::VoxelEncoding::VOXEL_ENCODING_BRICK);
+			header.set_raw_size(static_cast<int64_t>(size) * 3);
+			tongsim_lite::voxel::Voxel full = header;
+			full.set_voxel_buffer(buffer->data(), buffer->size());
+			const std::string name = "voxel/" + std::to_string(size);
+			ok &= checkIdentical(name.c_str(), full, header, {external(tongsim_lite::voxel::Voxel::kVoxelBufferFieldNumber, buffer)});
+		}
+
+		// BatchQueryVoxel：repeated 中间夹一个空元素，下标不能错位
+		{
+			tongsim_lite::voxel::BatchVoxel header;
+			tongsim_lite::voxel::BatchVoxel full;
+			std::vector<tongos::RpcExternalBytes> fields;
+			for (const size_t size : {size_t{65536}, size_t{0}, size_t{100}, size_t{300000}})
+			{
+				const Payload buffer = makePayload(size, static_cast<uint32_t>(size) + 7);
+				header.add_encodings(tongsim_lite::voxel::VoxelEncoding::VOXEL_ENCODING_DENSE);
+				header.add_raw_sizes(static_cast<int64_t>(size));
+				full.add_voxel_buffers(buffer->data(), buffer->size());
+				fields.push_back(external(tongsim_lite::voxel::BatchVoxel::kVoxelBuffersFieldNumber, buffer, true));
+			}
+			full.mutable_encodings()->CopyFrom(header.encodings());
+			full.mutable_raw_sizes()->CopyFrom(header.raw_sizes());
+			ok &= checkIdentical("batch_voxel/4", full, header, std::move(fields));
+		}
+
+		// CaptureSnapshot：外部字段前后都有 header 字段
+		{
+			const size_t pixels = 64 * 48;
+			const Payload rgba8 = makePayload(pixels * 4, 1);
+			const Payload depth = makePayload(pixels * 4, 2);
+			tongsim_lite::capture::CaptureFrame header;
+			header.mutable_camera_id()->set_guid("0123456789abcdef");
+			header.set_frame_id(42);
+			header.set_width(64);
+			header.set_height(48);
+			header.mutable_world_pose()->mutable_location()->set_x(1.5f);
+			header.set_depth_near(0.1f);
+			header.set_depth_far(1000.f);
+			header.set_has_color(true);
+			header.set_has_depth(true);
+			tongsim_lite::capture::CaptureFrame full = header;
+			full.set_rgba8(rgba8->data(), rgba8->size());
+			full.set_depth_r32(depth->data(), depth->size());
+			using tongsim_lite::capture::CaptureFrame;
+			ok &= checkIdentical("capture_frame/64x48", full, header, {
+				external(CaptureFrame::kDepthR32FieldNumber, depth),
+				external(CaptureFrame::kRgba8FieldNumber, rgba8),
+			});
+		}
+
+		// QueryStateColumns：8 个相邻的外部字段，后面还有字符串表字段
+		{
+			const int count = 2000;
+			using tongsim_lite::demo_rl::DemoRLStateColumns;
+			tongsim_lite::demo_rl::DemoRLStateColumns header;
+			header.set_count(count);
+			header.set_string_table_epoch(3);
+			tongsim_lite::demo_rl::DemoRLStateColumns full = header;
+			const std::pair<int, size_t> columns[] = {
+				{DemoRLStateColumns::kIdsFieldNumber, 16}, {DemoRLStateColumns::kLocationsFieldNumber, 12},
+				{DemoRLStateColumns::kRotationsFieldNumber, 12}, {DemoRLStateColumns::kBoundsFieldNumber, 24},
+				{DemoRLStateColumns::kSpeedsFieldNumber, 4}, {DemoRLStateColumns::kNameIdsFieldNumber, 4},
+				{DemoRLStateColumns::kClassIdsFieldNumber, 4}, {DemoRLStateColumns::kTagIdsFieldNumber, 4},
+			};
+			std::vector<tongos::RpcExternalBytes> fields;
+			for (const auto& [field_number, stride] : columns)
+			{
+				const Payload column = makePayload(stride * count, static_cast<uint32_t>(field_number));
+				full.GetReflection()->SetString(&full, full.GetDescriptor()->FindFieldByNumber(field_number),
+				                                std::string(column->begin(), column->end()));
+				fields.push_back(external(field_number, column));
+			}
+			ok &= checkIdentical("state_columns/2000", full, header, std::move(fields));
+		}
+
+		// header 里外部字段非空时必须拒绝
+		{
+			const Payload buffer = makePayload(8192, 3);
+			tongsim_lite::voxel::Voxel header;
+			header.set_voxel_buffer("x");
+			grpc::ByteBuffer spliced;
+			const grpc::Status status = tongos::serializeWithExternalBytes(
+				header, {external(tongsim_lite::voxel::Voxel::kVoxelBufferFieldNumber, buffer)}, &spliced);
+			const bool rejected = status.error_code() == grpc::StatusCode::INTERNAL;
+			std::printf("  %-24s %s\n", "non_empty_header", rejected ? "rejected" : "MISMATCH");
+			ok &= rejected;
+		}
+		return ok;
+	}
+
+	struct FrameResult
+	{
+		double best_us = 0.0;
+		double mean_us = 0.0;
+		// 负载在进程内被拷贝的次数：拷进消息 + 序列化时拷出
+		double payload_copies = 0.0;
+		size_t wire_bytes = 0;
+	};
+
+	void fillFrameHeader(tongsim_lite::capture::CaptureFrame& frame)
+	{
+		frame.mutable_camera_id()->set_guid("0123456789abcdef");
+		frame.set_frame_id(1);
+		frame.set_width(g_options.width);
+		frame.set_height(g_options.height);
+		frame.mutable_intrinsics()->set_fx(960.f);
+		frame.set_depth_near(0.1f);
+		frame.set_depth_far(1000.f);
+		frame.set_has_color(true);
+		frame.set_has_depth(true);
+	}
+
+	// 每轮都从帧数据构造消息并序列化，与 CaptureSnapshot 每次响应的工作一致
+	template <typename F>
+	FrameResult timeFrame(F&& serialize, const std::vector<Payload>& sources)
+	{
+		FrameResult result;
+		result.best_us = std::numeric_limits<double>::max();
+		double total_us = 0.0;
+		size_t payload_bytes = 0;
+		for (const Payload& source : sources)
+		{
+			payload_bytes += source->size();
+		}
+		for (int round = 0; round < g_options.rounds; ++round)
+		{
+			size_t copied_into_message = 0;
+			grpc::ByteBuffer buffer;
+			const auto start = Clock::now();
+			serialize(buffer, copied_into_message);
+			const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+			result.best_us = std::min(result.best_us, us);
+			total_us += us;
+			if (round == 0)
+			{
+				// 头部字段也算在拷贝字节里，所以外部路径会略大于 0
+				result.payload_copies = static_cast<double>(copied_into_message + copiedBytes(buffer, sources)) / payload_bytes;
+				result.wire_bytes = buffer.Length();
+			}
+		}
+		result.mean_us = total_us / g_options.rounds;
+		return result;
+	}
+
+	bool runFrameScenario()
+	{
+		const size_t pixels = static_cast<size_t>(g_options.width) * g_options.height;
+		const Payload rgba8 = makePayload(pixels * 4, 11);
+		const Payload depth = makePayload(pixels * 4, 12);
+		const std::vector<Payload> sources{rgba8, depth};
+		std::printf("[frame] %dx%dx(4+4) payload=%.1fMB rounds=%d\n", g_options.width, g_options.height,
+		            static_cast<double>(pixels * 8) / (1024.0 * 1024.0), g_options.rounds);
+
+		// 原来的路径：帧数据拷进 proto 的 string，GenericSerialize 再拷进 grpc slice
+		const FrameResult generic = timeFrame([&](grpc::ByteBuffer& buffer, size_t& copied)
+		{
+			tongsim_lite::capture::CaptureFrame frame;
+			fillFrameHeader(frame);
+			frame.set_rgba8(rgba8->data(), rgba8->size());
+			frame.set_depth_r32(depth->data(), depth->size());
+			copied = rgba8->size() + depth->size();
+			genericSerialize(frame, &buffer);
+		}, sources);
+
+		// 现在的路径：header 序列化后插入引用帧内存的 slice
+		const FrameResult spliced = timeFrame([&](grpc::ByteBuffer& buffer, size_t&)
+		{
+			tongsim_lite::capture::CaptureFrame frame;
+			fillFrameHeader(frame);
+			using tongsim_lite::capture::CaptureFrame;
+			tongos::serializeWithExternalBytes(frame, {
+				external(CaptureFrame::kRgba8FieldNumber, rgba8),
+				external(CaptureFrame::kDepthR32FieldNumber, depth),
+			}, &buffer);
+		}, sources);
+
+		const auto print = [](const char* name, const FrameResult& result)
+		{
+			std::printf("  %-16s best=%10.1fus mean=%10.1fus payload_copies=%.3f wire_bytes=%zu\n",
+			            name, result.best_us, result.mean_us, result.payload_copies, result.wire_bytes);
+		};
+		print("generic", generic);
+		print("external_bytes", spliced);
+		std::printf("  speedup=%.1fx\n", spliced.best_us > 0 ? generic.best_us / spliced.best_us : 0.0);
+
+		// 整帧也逐字节比一次
+		tongsim_lite::capture::CaptureFrame header;
+		fillFrameHeader(header);
+		tongsim_lite::capture::CaptureFrame full = header;
+		full.set_rgba8(rgba8->data(), rgba8->size());
+		full.set_depth_r32(depth->data(), depth->size());
+		using tongsim_lite::capture::CaptureFrame;
+		const std::string name = "capture_frame/" + std::to_string(g_options.width) + "x" + std::to_string(g_options.height);
+		return checkIdentical(name.c_str(), full, header, {
+			external(CaptureFrame::kRgba8FieldNumber, rgba8),
+			external(CaptureFrame::kDepthR32FieldNumber, depth),
+		});
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (!parseOptions(argc, argv, g_options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	bool ok = runIdentityChecks();
+	ok &= runFrameScenario();
+	// 有不一致时返回非0，方便脚本里当作正确性检查
+	return ok ? 0 : 2;
+}
@@ -0,0 +1,504 @@
+// Actor 注册表压测：对比原来的 GUID<->Actor 双哈希表 + 销毁集合 与 FTSActorRegistry 使用的分代稠密槽位表
+// 不依赖 UE：用一个带下标复用和序列号的对象数组模拟 UObject 全局数组和弱指针，两边的逻辑分别与旧实现和 TSActorRegistry.cpp 一致
+//   ./build/registry_bench --actors=50000 --rounds=200 --churn=0.1 --lookups=100000
+#include "util/slot_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+	struct BenchOptions
+	{
+		int actors = 50000;
+		int rounds = 200;
+		double churn = 0.1;
+		int lookups = 100000;
+		uint32_t seed = 1;
+	};
+
+	BenchOptions g_options;
+
+	void printUsage()
+	{
+		std::printf("usage: registry_bench [--actors=50000] [--rounds=200] [--churn=0.1] [--lookups=100000] [--seed=1]\n");
+	}
+
+	bool parseOptions(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const size_t eq = arg.find('=');
+			if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+			{
+				return false;
+			}
+			const std::string key = arg.substr(2, eq - 2);
+			const std::string value = arg.substr(eq + 1);
+			if (key == "actors") options.actors = std::atoi(value.c_str());
+			else if (key == "rounds") options.rounds = std::atoi(value.c_str());
+			else if (key == "churn") options.churn = std::atof(value.c_str());
+			else if (key == "lookups") options.lookups = std::atoi(value.c_str());
+			else if (key == "seed") options.seed = static_cast<uint32_t>(std::atoll(value.c_str()));
+			else return false;
+		}
+		return options.actors > 0 && options.rounds > 0 && options.churn > 0.0 && options.churn <= 1.0 && options.lookups >= 0;
+	}
+
+	/**
+	 * 模拟 UObject：全局数组的下标会被复用，弱指针靠序列号判断对象是否还是原来那个
+	 */
+	struct FakeActor
+	{
+		uint32_t index = 0;
+		uint32_t serial = 0;
+		float location[3] = {};
+	};
+
+	struct WeakActor
+	{
+		uint32_t index = 0;
+		uint32_t serial = 0;
+
+		bool operator==(const WeakActor& other) const { return index == other.index && serial == other.serial; }
+	};
+
+	struct WeakActorHash
+	{
+		size_t operator()(const WeakActor& weak) const { return (static_cast<size_t>(weak.serial) << 32) ^ weak.index; }
+	};
+
+	class ObjectArray
+	{
+	public:
+		FakeActor* spawn()
+		{
+			uint32_t index;
+			if (!free_indices.empty())
+			{
+				// UE 也是后进先出复用下标
+				index = free_indices.back();
+				free_indices.pop_back();
+			}
+			else
+			{
+				index = static_cast<uint32_t>(objects.size());
+				objects.emplace_back();
+			}
+			FakeActor& actor = objects[index];
+			actor.index = index;
+			actor.serial = ++next_serial;
+			alive.resize(objects.size(), 0);
+			alive[index] = 1;
+			return &actor;
+		}
+
+		void destroy(FakeActor* actor)
+		{
+			alive[actor->index] = 0;
+			free_indices.push_back(actor->index);
+		}
+
+		FakeActor* get(const WeakActor& weak)
+		{
+			if (weak.index >= objects.size() || !alive[weak.index] || objects[weak.index].serial != weak.serial)
+			{
+				return nullptr;
+			}
+			return &objects[weak.index];
+		}
+
+		void reserve(size_t n)
+		{
+			objects.reserve(n);
+			alive.reserve(n);
+		}
+
+	private:
+		// 预留后地址不变，模拟 UObject 指针
+		std::vector<FakeActor> objects;
+		std::vector<uint8_t> alive;
+		std::vector<uint32_t> free_indices;
+		uint32_t next_serial = 0;
+	};
+
+	WeakActor weakOf(const FakeActor* actor)
+	{
+		return {actor->index, actor->serial};
+	}
+
+	struct Guid
+	{
+		uint32_t a = 0, b = 0, c = 0, d = 0;
+
+		bool valid() const { return (a | b | c | d) != 0; }
+		bool operator==(const Guid& other) const { return a == other.a && b == other.b && c == other.c && d == other.d; }
+	};
+
+	struct GuidHash
+	{
+		size_t operator()(const Guid& guid) const
+		{
+			// 与 UE 的 GetTypeHash(FGuid) 一样按四段混合
+			size_t h = guid.a;
+			h = h * 0x9E3779B97F4A7C15ull ^ guid.b;
+			h = h * 0x9E3779B97F4A7C15ull ^ guid.c;
+			h = h * 0x9E3779B97F4A7C15ull ^ guid.d;
+			return h;
+		}
+	};
+
+	/**
+	 * 旧实现：IdToActor / ActorToId 两张哈希表，销毁的 GUID 另存一个集合，清理时全表扫描
+	 */
+	class MapRegistry
+	{
+	public:
+		explicit MapRegistry(ObjectArray& objects, std::mt19937& rng) : objects(objects), rng(rng) {}
+
+		Guid registerActor(FakeActor* actor)
+		{
+			const WeakActor weak = weakOf(actor);
+			if (auto it = actor_to_id.find(weak); it != actor_to_id.end())
+			{
+				return it->second;
+			}
+			const Guid id{static_cast<uint32_t>(rng()) | 1u, static_cast<uint32_t>(rng()), static_cast<uint32_t>(rng()), static_cast<uint32_t>(rng())};
+			id_to_actor.emplace(id, weak);
+			actor_to_id.emplace(weak, id);
+			return id;
+		}
+
+		void markDestroyed(FakeActor* actor)
+		{
+			if (auto it = actor_to_id.find(weakOf(actor)); it != actor_to_id.end())
+			{
+				destroyed.insert(it->second);
+				actor_to_id.erase(it);
+			}
+		}
+
+		FakeActor* findActor(const Guid& id)
+		{
+			auto it = id_to_actor.find(id);
+			return it != id_to_actor.end() ? objects.get(it->second) : nullptr;
+		}
+
+		Guid findGuid(const FakeActor* actor) const
+		{
+			auto it = actor_to_id.find(weakOf(actor));
+			return it != actor_to_id.end() ? it->second : Guid();
+		}
+
+		// RefreshActorMappings 的做法：先清空销毁集合，再删掉弱指针失效的条目
+		size_t purge()
+		{
+			destroyed.clear();
+			std::vector<Guid> dead_ids;
+			for (const auto& [id, weak] : id_to_actor)
+			{
+				if (!objects.get(weak))
+				{
+					dead_ids.push_back(id);
+				}
+			}
+			for (const Guid& id : dead_ids)
+			{
+				id_to_actor.erase(id);
+			}
+			std::vector<WeakActor> dead_objs;
+			for (const auto& [weak, id] : actor_to_id)
+			{
+				if (!objects.get(weak))
+				{
+					dead_objs.push_back(weak);
+				}
+			}
+			for (const WeakActor& weak : dead_objs)
+			{
+				actor_to_id.erase(weak);
+			}
+			return dead_ids.size();
+		}
+
+		template <typename Fn>
+		void forEach(Fn&& func)
+		{
+			for (const auto& [id, weak] : id_to_actor)
+			{
+				func(id, objects.get(weak), destroyed.count(id) != 0);
+			}
+		}
+
+		size_t size() const { return id_to_actor.size(); }
+
+	private:
+		ObjectArray& objects;
+		std::mt19937& rng;
+		std::unordered_map<Guid, WeakActor, GuidHash> id_to_actor;
+		std::unordered_map<WeakActor, Guid, WeakActorHash> actor_to_id;
+		std::unordered_set<Guid, GuidHash> destroyed;
+	};
+
+	/**
+	 * 新实现：与 FTSActorRegistry 相同，GUID 的 C/D 段是槽位句柄，Actor 侧按对象下标索引
+	 */
+	class SlotRegistry
+	{
+	public:
+		explicit SlotRegistry(ObjectArray& objects, std::mt19937& rng) : objects(objects), rng(rng) {}
+
+		Guid registerActor(FakeActor* actor)
+		{
+			if (const Record* existing = findLive(actor))
+			{
+				return existing->guid;
+			}
+			Record record;
+			record.actor = weakOf(actor);
+			const tongos::SlotHandle handle = records.insert(record);
+			Record& inserted = *records.find(handle);
+			inserted.guid = Guid{static_cast<uint32_t>(rng()) | 1u, static_cast<uint32_t>(rng()), handle.index, handle.generation};
+			if (index_to_slot.size() <= actor->index)
+			{
+				index_to_slot.resize(std::max<size_t>(actor->index + 1, index_to_slot.size() * 2), 0);
+			}
+			index_to_slot[actor->index] = handle.index + 1;
+			return inserted.guid;
+		}
+
+		void markDestroyed(FakeActor* actor)
+		{
+			if (Record* record = findLive(actor))
+			{
+				record->destroyed = true;
+				index_to_slot[actor->index] = 0;
+			}
+		}
+
+		FakeActor* findActor(const Guid& id)
+		{
+			const Record* record = records.find({id.c, id.d});
+			return record && record->guid == id && !record->destroyed ? objects.get(record->actor) : nullptr;
+		}
+
+		Guid findGuid(const FakeActor* actor)
+		{
+			const Record* record = findLive(actor);
+			return record ? record->guid : Guid();
+		}
+
+		size_t purge()
+		{
+			std::vector<tongos::SlotHandle> dead;
+			for (size_t i = 0; i < records.size(); ++i)
+			{
+				if (records[i].destroyed || !objects.get(records[i].actor))
+				{
+					dead.push_back(records.handleAt(i));
+				}
+			}
+			for (const tongos::SlotHandle& handle : dead)
+			{
+				const Record& record = *records.find(handle);
+				if (record.actor.index < index_to_slot.size() && index_to_slot[record.actor.index] == handle.index + 1)
+				{
+					index_to_slot[record.actor.index] = 0;
+				}
+				records.erase(handle);
+			}
+			return dead.size();
+		}
+
+		template <typename Fn>
+		void forEach(Fn&& func)
+		{
+			for (const Record& record : records)
+			{
+				func(record.guid, record.destroyed ? nullptr : objects.get(record.actor), record.destroyed);
+			}
+		}
+
+		size_t size() const { return records.size(); }
+
+	private:
+		struct Record
+		{
+			Guid guid;
+			WeakActor actor;
+			bool destroyed = false;
+		};
+
+		Record* findLive(const FakeActor* actor)
+		{
+			if (actor->index >= index_to_slot.size() || index_to_slot[actor->index] == 0)
+			{
+				return nullptr;
+			}
+			Record* record = records.find(records.handleOf(index_to_slot[actor->index] - 1));
+			return record && !record->destroyed && record->actor == weakOf(actor) ? record : nullptr;
+		}
+
+		ObjectArray& objects;
+		std::mt19937& rng;
+		tongos::SlotMap<Record> records;
+		std::vector<uint32_t> index_to_slot;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	struct PhaseTimes
+	{
+		double register_initial = 0;
+		double destroy = 0;
+		double spawn = 0;
+		double lookup_guid = 0;
+		double lookup_actor = 0;
+		double iterate = 0;
+		double purge = 0;
+		uint64_t destroy_ops = 0;
+		uint64_t spawn_ops = 0;
+		uint64_t lookup_guid_ops = 0;
+		uint64_t lookup_actor_ops = 0;
+		uint64_t iterate_ops = 0;
+		uint64_t purge_calls = 0;
+		uint64_t checksum = 0;
+	};
+
+	double secondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	template <typename Registry>
+	PhaseTimes run(const char* name)
+	{
+		ObjectArray objects;
+		objects.reserve(static_cast<size_t>(g_options.actors) * 2);
+		std::mt19937 rng(g_options.seed);
+		std::mt19937 guid_rng(g_options.seed + 1);
+		Registry registry(objects, guid_rng);
+		PhaseTimes times;
+
+		std::vector<FakeActor*> live;
+		std::vector<Guid> live_ids;
+		// 最近销毁的 GUID，查询时混入一部分，覆盖查询已销毁对象的路径
+		std::vector<Guid> stale_ids;
+		live.reserve(g_options.actors);
+		live_ids.reserve(g_options.actors);
+
+		auto start = Clock::now();
+		for (int i = 0; i < g_options.actors; ++i)
+		{
+			FakeActor* actor = objects.spawn();
+			live.push_back(actor);
+			live_ids.push_back(registry.registerActor(actor));
+		}
+		times.register_initial = secondsSince(start);
+
+		const int churn = std::max(1, static_cast<int>(g_options.actors * g_options.churn));
+		for (int round = 0; round < g_options.rounds; ++round)
+		{
+			stale_ids.clear();
+			start = Clock::now();
+			for (int i = 0; i < churn; ++i)
+			{
+				const size_t victim = rng() % live.size();
+				registry.markDestroyed(live[victim]);
+				objects.destroy(live[victim]);
+				stale_ids.push_back(live_ids[victim]);
+				live[victim] = live.back();
+				live_ids[victim] = live_ids.back();
+				live.pop_back();
+				live_ids.pop_back();
+			}
+			times.destroy += secondsSince(start);
+			times.destroy_ops += churn;
+
+			start = Clock::now();
+			for (int i = 0; i < churn; ++i)
+			{
+				FakeActor* actor = objects.spawn();
+				live.push_back(actor);
+				live_ids.push_back(registry.registerActor(actor));
+			}
+			times.spawn += secondsSince(start);
+			times.spawn_ops += churn;
+
+			start = Clock::now();
+			for (int i = 0; i < g_options.lookups; ++i)
+			{
+				const Guid& id = (i & 7) == 0 ? stale_ids[rng() % stale_ids.size()] : live_ids[rng() % live_ids.size()];
+				times.checksum += registry.findActor(id) != nullptr;
+			}
+			times.lookup_guid += secondsSince(start);
+			times.lookup_guid_ops += g_options.lookups;
+
+			start = Clock::now();
+			for (int i = 0; i < g_options.lookups; ++i)
+			{
+				times.checksum += registry.findGuid(live[rng() % live.size()]).a & 1u;
+			}
+			times.lookup_actor += secondsSince(start);
+			times.lookup_actor_ops += g_options.lookups;
+
+			// QueryState / SubscribeState 每帧遍历一次
+			start = Clock::now();
+			float sum = 0.f;
+			registry.forEach([&sum, &times](const Guid& id, FakeActor* actor, bool destroyed)
+			{
+				if (actor)
+				{
+					sum += actor->location[0];
+				}
+				times.checksum += destroyed;
+			});
+			times.iterate += secondsSince(start);
+			times.iterate_ops += registry.size();
+			times.checksum += static_cast<uint64_t>(sum);
+
+			start = Clock::now();
+			registry.purge();
+			times.purge += secondsSince(start);
+			++times.purge_calls;
+		}
+
+		auto ns = [](double seconds, uint64_t ops) { return ops ? seconds * 1e9 / static_cast<double>(ops) : 0.0; };
+		std::printf("[%s] actors=%d rounds=%d churn=%d/round lookups=%d/round final_size=%zu\n",
+			name, g_options.actors, g_options.rounds, churn, g_options.lookups, registry.size());
+		std::printf("  register_initial=%.2fms destroy=%.1fns/op spawn=%.1fns/op lookup_guid=%.1fns/op lookup_actor=%.1fns/op\n",
+			times.register_initial * 1e3, ns(times.destroy, times.destroy_ops), ns(times.spawn, times.spawn_ops),
+			ns(times.lookup_guid, times.lookup_guid_ops), ns(times.lookup_actor, times.lookup_actor_ops));
+		std::printf("  iterate=%.2fns/actor (%.1fus/pass) purge=%.1fus/call checksum=%llu\n",
+			ns(times.iterate, times.iterate_ops), times.iterate * 1e6 / g_options.rounds, times.purge * 1e6 / times.purge_calls,
+			static_cast<unsigned long long>(times.checksum));
+		return times;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (!parseOptions(argc, argv, g_options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	const PhaseTimes maps = run<MapRegistry>("hash_maps");
+	const PhaseTimes slots = run<SlotRegistry>("slot_map");
+
+	auto ratio = [](double before, double after) { return after > 0 ? before / after : 0.0; };
+	std::printf("[speedup] spawn=%.1fx destroy=%.1fx lookup_guid=%.1fx lookup_actor=%.1fx iterate=%.1fx purge=%.1fx\n",
+		ratio(maps.spawn, slots.spawn), ratio(maps.destroy, slots.destroy), ratio(maps.lookup_guid, slots.lookup_guid),
+		ratio(maps.lookup_actor, slots.lookup_actor), ratio(maps.iterate, slots.iterate), ratio(maps.purge, slots.purge));
+	return 0;
+}
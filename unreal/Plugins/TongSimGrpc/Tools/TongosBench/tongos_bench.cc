@@ -0,0 +1,627 @@
+// tongos 框架压测：不启动UE，用合成路由 + 模拟的游戏线程 + 进程内客户端测量框架本身的延迟和吞吐
+// 游戏线程按固定频率批量取事件，与 UTSGrpcSubsystem::UpdateRpcRouter 的处理方式一致
+#include "rpc_lane_pool.h"
+#include "rpc_metrics.h"
+#include "rpc_object_pool.h"
+#include "rpc_server.h"
+#include "util/logger.h"
+#include "util/mpsc_channel.h"
+#include "tongsim_lite_protobuf/demo_rl.pb.h"
+
+#include <google/protobuf/wrappers.pb.h>
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/impl/codegen/client_unary_call.h>
+#include <grpcpp/impl/codegen/sync_stream.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 统计进程内operator new的次数，用来对比对象池、arena开关前后每次调用的堆分配数
+// gRPC core走gpr_malloc不在统计内，这里只反映C++层的分配
+static std::atomic<uint64_t> g_operator_new_calls{0};
+
+void* operator new(size_t size)
+{
+	g_operator_new_calls.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size ? size : 1))
+	{
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+namespace
+{
+	using google::protobuf::BytesValue;
+	using tongos::RpcClock;
+	using tongos::RpcLatencyHistogram;
+
+	constexpr const char* kUnaryMethod = "/tongos.bench.Bench/Unary";
+	constexpr const char* kStreamMethod = "/tongos.bench.Bench/ServerStream";
+	constexpr const char* kBidiMethod = "/tongos.bench.Bench/Bidi";
+	constexpr const char* kQueryStateMethod = "/tongos.bench.Bench/QueryState";
+
+	struct BenchOptions
+	{
+		std::string mode = "all";
+		std::string address = "unix:/tmp/tongos_bench.sock";
+		std::string lane = "game";
+		int clients = 8;
+		int seconds = 5;
+		int hz = 60;
+		// 逗号分隔时依次用每个worker数重启server，跑完输出吞吐对比
+		std::vector<int> workers{2};
+		int pending_calls = 4;
+		int lane_threads = 2;
+		int stream_messages = 16;
+		size_t payload = 256;
+		bool pool = true;
+		bool arena = true;
+		// query_state场景每次响应的Actor数
+		int actors = 10000;
+	};
+
+	BenchOptions g_options;
+
+	void printUsage()
+	{
+		std::printf(
+			"usage: tongos_bench [--mode=unary|stream|bidi|query_state|all] [--clients=8] [--seconds=5]\n"
+			"                    [--hz=60] [--lane=game|pool|cq] [--payload=256] [--stream-messages=16]\n"
+			"                    [--workers=2|1,2,4,8] [--pending-calls=4] [--lane-threads=2]\n"
+			"                    [--pool=1] [--arena=1] [--actors=10000] [--address=unix:/tmp/tongos_bench.sock]\n");
+	}
+
+	bool parseIntList(const std::string& value, std::vector<int>& out)
+	{
+		out.clear();
+		size_t begin = 0;
+		while (begin <= value.size())
+		{
+			size_t end = value.find(',', begin);
+			if (end == std::string::npos)
+			{
+				end = value.size();
+			}
+			const int number = std::atoi(value.substr(begin, end - begin).c_str());
+			if (number <= 0)
+			{
+				return false;
+			}
+			out.push_back(number);
+			begin = end + 1;
+		}
+		return !out.empty();
+	}
+
+	bool parseOptions(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const size_t eq = arg.find('=');
+			if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+			{
+				return false;
+			}
+			const std::string key = arg.substr(2, eq - 2);
+			const std::string value = arg.substr(eq + 1);
+			if (key == "mode") options.mode = value;
+			else if (key == "address") options.address = value;
+			else if (key == "lane") options.lane = value;
+			else if (key == "clients") options.clients = std::atoi(value.c_str());
+			else if (key == "seconds") options.seconds = std::atoi(value.c_str());
+			else if (key == "hz") options.hz = std::atoi(value.c_str());
+			else if (key == "workers")
+			{
+				if (!parseIntList(value, options.workers)) return false;
+			}
+			else if (key == "pending-calls") options.pending_calls = std::atoi(value.c_str());
+			else if (key == "lane-threads") options.lane_threads = std::atoi(value.c_str());
+			else if (key == "stream-messages") options.stream_messages = std::atoi(value.c_str());
+			else if (key == "payload") options.payload = static_cast<size_t>(std::atoll(value.c_str()));
+			else if (key == "pool") options.pool = std::atoi(value.c_str()) != 0;
+			else if (key == "arena") options.arena = std::atoi(value.c_str()) != 0;
+			else if (key == "actors") options.actors = std::atoi(value.c_str());
+			else return false;
+		}
+		return options.clients > 0 && options.seconds > 0 && options.hz > 0 && options.actors > 0;
+	}
+
+	tongos::RpcLane parseLane(const std::string& lane)
+	{
+		if (lane == "pool")
+		{
+			return tongos::RpcLane::WORKER_POOL;
+		}
+		if (lane == "cq")
+		{
+			return tongos::RpcLane::CQ_THREAD;
+		}
+		return tongos::RpcLane::GAME_THREAD;
+	}
+
+	/**
+	 * 合成路由
+	 */
+	tongos::ResponseStatus echoUnary(BytesValue& request, BytesValue& response)
+	{
+		response.set_value(request.value());
+		return tongos::ResponseStatus::OK;
+	}
+
+	void echoServerStream(BytesValue& request, tongos::RpcServerStreamingResponder<BytesValue> responder)
+	{
+		for (int i = 0; i < g_options.stream_messages; ++i)
+		{
+			responder->write(request);
+		}
+		responder->finish(tongos::ResponseStatus::OK);
+	}
+
+	// 与 UDemoRLSubsystem::QueryState 填充的字段一致，字符串长度取常见的类路径/名字长度
+	tongos::ResponseStatus queryState(tongsim_lite::common::Empty& request, tongsim_lite::demo_rl::DemoRLState& response)
+	{
+		response.mutable_actor_states()->Reserve(g_options.actors);
+		for (int i = 0; i < g_options.actors; ++i)
+		{
+			auto* state = response.add_actor_states();
+			auto* info = state->mutable_object_info();
+			char guid[16] = {};
+			std::memcpy(guid, &i, sizeof(i));
+			info->mutable_id()->set_guid(guid, sizeof(guid));
+			info->set_class_path("/Game/Blueprints/BP_BenchActor.BP_BenchActor_C");
+			info->set_name("BP_BenchActor_C_" + std::to_string(i));
+			const float x = static_cast<float>(i);
+			auto setVector = [](tongsim_lite::common::Vector3f* vector, float vx, float vy, float vz)
+			{
+				vector->set_x(vx);
+				vector->set_y(vy);
+				vector->set_z(vz);
+			};
+			setVector(state->mutable_location(), x, -x, 100.0f);
+			setVector(state->mutable_unit_forward_vector(), 1.0f, 0.0f, 0.0f);
+			setVector(state->mutable_unit_right_vector(), 0.0f, 1.0f, 0.0f);
+			setVector(state->mutable_bounding_box()->mutable_min_vertex(), x - 50.0f, -x - 50.0f, 0.0f);
+			setVector(state->mutable_bounding_box()->mutable_max_vertex(), x + 50.0f, -x + 50.0f, 200.0f);
+			state->set_tag("bench_actor_tag");
+			state->set_current_speed(0.0f);
+		}
+		return tongos::ResponseStatus::OK;
+	}
+
+	class EchoBidiReactor final : public tongos::RpcReactorBidiStreaming<BytesValue, BytesValue>
+	{
+	protected:
+		void onCall() override
+		{
+		}
+
+		void onRequest(std::optional<BytesValue>& request) override
+		{
+			if (request)
+			{
+				write(request.value());
+			}
+			else
+			{
+				finish(tongos::ResponseStatus::OK);
+			}
+		}
+	};
+
+	/**
+	 * 模拟游戏线程：每帧批量处理管道里的事件，处理完后睡到下一帧
+	 */
+	class FakeGameThread
+	{
+	public:
+		FakeGameThread(tongos::MpscChannel<tongos::RpcEvent>& channel, tongos::RpcRouter& router, int hz)
+			: channel(channel), router(router), period(std::chrono::nanoseconds(1000000000LL / hz))
+		{
+			thread = std::thread(&FakeGameThread::run, this);
+		}
+
+		~FakeGameThread() { stop(); }
+
+		void stop()
+		{
+			running.store(false);
+			if (thread.joinable())
+			{
+				thread.join();
+			}
+		}
+
+		uint64_t frames() const { return frame_count.load(); }
+		uint64_t events() const { return event_count.load(); }
+		RpcLatencyHistogram& frameTime() { return frame_time; }
+
+	private:
+		void run()
+		{
+			std::vector<tongos::RpcEvent> pending;
+			pending.reserve(1024);
+			auto next_frame = RpcClock::now();
+			while (running.load())
+			{
+				const auto frame_start = RpcClock::now();
+				size_t handled = 0;
+				while (channel.try_receive_bulk(pending, 1024) > 0)
+				{
+					for (tongos::RpcEvent& rpc_event : pending)
+					{
+						router.handle(std::move(rpc_event));
+					}
+					handled += pending.size();
+					pending.clear();
+				}
+				frame_time.recordSince(frame_start);
+				event_count.fetch_add(handled);
+				frame_count.fetch_add(1);
+
+				next_frame += period;
+				const auto now = RpcClock::now();
+				if (next_frame < now)
+				{
+					next_frame = now;
+				}
+				std::this_thread::sleep_until(next_frame);
+			}
+		}
+
+		tongos::MpscChannel<tongos::RpcEvent>& channel;
+		tongos::RpcRouter& router;
+		const std::chrono::nanoseconds period;
+		std::atomic<bool> running{true};
+		std::atomic<uint64_t> frame_count{0};
+		std::atomic<uint64_t> event_count{0};
+		RpcLatencyHistogram frame_time;
+		std::thread thread;
+	};
+
+	/**
+	 * 客户端
+	 */
+	struct ClientResult
+	{
+		RpcLatencyHistogram latency;
+		std::atomic<uint64_t> messages{0};
+		std::atomic<uint64_t> errors{0};
+	};
+
+	std::shared_ptr<grpc::Channel> makeChannel(const std::string& address)
+	{
+		grpc::ChannelArguments args;
+		args.SetMaxReceiveMessageSize(-1);
+		args.SetMaxSendMessageSize(-1);
+		// 每个客户端独立连接，避免所有调用挤在同一个HTTP/2连接上
+		args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+		return grpc::CreateCustomChannel(address, grpc::InsecureChannelCredentials(), args);
+	}
+
+	void runUnaryClient(const std::string& address, const BytesValue& request, RpcClock::time_point deadline, ClientResult& result)
+	{
+		auto channel = makeChannel(address);
+		const grpc::internal::RpcMethod method(kUnaryMethod, grpc::internal::RpcMethod::NORMAL_RPC);
+		while (RpcClock::now() < deadline)
+		{
+			grpc::ClientContext context;
+			BytesValue response;
+			const auto start = RpcClock::now();
+			const grpc::Status status = grpc::internal::BlockingUnaryCall<BytesValue, BytesValue>(
+				channel.get(), method, &context, request, &response);
+			if (status.ok() && response.value().size() == request.value().size())
+			{
+				result.latency.recordSince(start);
+				result.messages.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				result.errors.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// 记录整个流（请求到最后一条响应）的耗时
+	void runStreamClient(const std::string& address, const BytesValue& request, RpcClock::time_point deadline, ClientResult& result)
+	{
+		auto channel = makeChannel(address);
+		const grpc::internal::RpcMethod method(kStreamMethod, grpc::internal::RpcMethod::SERVER_STREAMING);
+		while (RpcClock::now() < deadline)
+		{
+			grpc::ClientContext context;
+			const auto start = RpcClock::now();
+			std::unique_ptr<grpc::ClientReader<BytesValue>> reader(
+				grpc::internal::ClientReaderFactory<BytesValue>::Create(channel.get(), method, &context, request));
+			BytesValue response;
+			int received = 0;
+			while (reader->Read(&response))
+			{
+				++received;
+			}
+			const grpc::Status status = reader->Finish();
+			if (status.ok() && received == g_options.stream_messages)
+			{
+				result.latency.recordSince(start);
+				result.messages.fetch_add(received, std::memory_order_relaxed);
+			}
+			else
+			{
+				result.errors.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// 每个客户端一条长连接的流，一问一答，记录单条消息的往返时间
+	void runBidiClient(const std::string& address, const BytesValue& request, RpcClock::time_point deadline, ClientResult& result)
+	{
+		auto channel = makeChannel(address);
+		const grpc::internal::RpcMethod method(kBidiMethod, grpc::internal::RpcMethod::BIDI_STREAMING);
+		grpc::ClientContext context;
+		std::unique_ptr<grpc::ClientReaderWriter<BytesValue, BytesValue>> stream(
+			grpc::internal::ClientReaderWriterFactory<BytesValue, BytesValue>::Create(channel.get(), method, &context));
+		BytesValue response;
+		while (RpcClock::now() < deadline)
+		{
+			const auto start = RpcClock::now();
+			if (!stream->Write(request) || !stream->Read(&response))
+			{
+				result.errors.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+			result.latency.recordSince(start);
+			result.messages.fetch_add(1, std::memory_order_relaxed);
+		}
+		stream->WritesDone();
+		while (stream->Read(&response))
+		{
+		}
+		if (!stream->Finish().ok())
+		{
+			result.errors.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// 响应按原始字节接收，不在客户端反序列化，分配计数主要反映server端
+	void runQueryStateClient(const std::string& address, const BytesValue&, RpcClock::time_point deadline, ClientResult& result)
+	{
+		auto channel = makeChannel(address);
+		const grpc::internal::RpcMethod method(kQueryStateMethod, grpc::internal::RpcMethod::NORMAL_RPC);
+		const tongsim_lite::common::Empty request;
+		while (RpcClock::now() < deadline)
+		{
+			grpc::ClientContext context;
+			grpc::ByteBuffer response;
+			const auto start = RpcClock::now();
+			const grpc::Status status = grpc::internal::BlockingUnaryCall<tongsim_lite::common::Empty, grpc::ByteBuffer>(
+				channel.get(), method, &context, request, &response);
+			if (status.ok() && response.Length() > 0)
+			{
+				result.latency.recordSince(start);
+				result.messages.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				result.errors.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	using ClientFn = void (*)(const std::string&, const BytesValue&, RpcClock::time_point, ClientResult&);
+
+	void printHistogram(const char* name, const RpcLatencyHistogram& histogram)
+	{
+		std::printf("  %-14s count=%-9llu mean=%9.1fus p50=%7lluus p90=%7lluus p99=%7lluus max=%8lluus\n",
+		            name,
+		            static_cast<unsigned long long>(histogram.count()),
+		            histogram.mean(),
+		            static_cast<unsigned long long>(histogram.percentile(0.5)),
+		            static_cast<unsigned long long>(histogram.percentile(0.9)),
+		            static_cast<unsigned long long>(histogram.percentile(0.99)),
+		            static_cast<unsigned long long>(histogram.max()));
+	}
+
+	// 返回每秒完成的调用数
+	double runScenario(const char* name, const char* method, ClientFn client_fn, tongos::RpcRouter& router, int workers)
+	{
+		BytesValue request;
+		request.set_value(std::string(g_options.payload, 'x'));
+
+		router.forEachRouteMetrics([](tongos::RpcRouteMetrics& metrics) { metrics.reset(); });
+
+		ClientResult result;
+		const tongos::RpcObjectPool::Stats pool_before = tongos::RpcObjectPool::stats();
+		const uint64_t new_calls_before = g_operator_new_calls.load(std::memory_order_relaxed);
+		const auto start = RpcClock::now();
+		const auto deadline = start + std::chrono::seconds(g_options.seconds);
+		std::vector<std::thread> clients;
+		for (int i = 0; i < g_options.clients; ++i)
+		{
+			clients.emplace_back(client_fn, std::cref(g_options.address), std::cref(request), deadline, std::ref(result));
+		}
+		for (auto& client : clients)
+		{
+			client.join();
+		}
+		const double elapsed = std::chrono::duration<double>(RpcClock::now() - start).count();
+		const uint64_t new_calls = g_operator_new_calls.load(std::memory_order_relaxed) - new_calls_before;
+		const tongos::RpcObjectPool::Stats pool_after = tongos::RpcObjectPool::stats();
+
+		std::printf("[%s] workers=%d clients=%d payload=%zuB lane=%s hz=%d elapsed=%.2fs\n",
+		            name, workers, g_options.clients, g_options.payload, g_options.lane.c_str(), g_options.hz, elapsed);
+		std::printf("  calls/s=%.1f messages/s=%.1f errors=%llu\n",
+		            result.latency.count() / elapsed, result.messages.load() / elapsed,
+		            static_cast<unsigned long long>(result.errors.load()));
+		// 包含进程内客户端的分配，只用来横向对比
+		const double calls = static_cast<double>(result.latency.count() > 0 ? result.latency.count() : 1);
+		std::printf("  pool=%s arena=%s operator_new/call=%.1f pooled_allocs/call=%.1f pool_heap_allocs/call=%.2f cached_blocks=%llu\n",
+		            g_options.pool ? "on" : "off", g_options.arena ? "on" : "off", new_calls / calls,
+		            (pool_after.pooled_allocs - pool_before.pooled_allocs) / calls,
+		            (pool_after.heap_allocs - pool_before.heap_allocs) / calls,
+		            static_cast<unsigned long long>(pool_after.cached_blocks));
+		printHistogram("client", result.latency);
+		router.forEachRouteMetrics([method](tongos::RpcRouteMetrics& metrics)
+		{
+			if (metrics.method != method)
+			{
+				return;
+			}
+			for (size_t i = 0; i < static_cast<size_t>(tongos::RpcPhase::COUNT); ++i)
+			{
+				const auto phase = static_cast<tongos::RpcPhase>(i);
+				printHistogram(tongos::rpcPhaseName(phase), metrics.phase(phase));
+			}
+		});
+		return result.latency.count() / elapsed;
+	}
+
+	struct Scenario
+	{
+		const char* name;
+		const char* method;
+		ClientFn client_fn;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	if (!parseOptions(argc, argv, g_options))
+	{
+		printUsage();
+		return 1;
+	}
+
+	tongos::LoggerOptions logger_options;
+	logger_options.file_path.clear();
+	logger_options.level = tongos::WARN;
+	tongos::configureLogger(logger_options);
+	tongos::RpcObjectPool::setEnabled(g_options.pool);
+	tongos::setRpcArenaEnabled(g_options.arena);
+
+	const tongos::RpcLane lane = parseLane(g_options.lane);
+	tongos::RpcRouter router;
+	router.registerUnaryHandler(kUnaryMethod, &echoUnary, lane);
+	router.registerServerStreamingHandler(kStreamMethod, &echoServerStream, lane);
+	router.registerReactor<EchoBidiReactor>(kBidiMethod, lane);
+	router.registerUnaryHandler(kQueryStateMethod, &queryState, lane);
+
+	tongos::MpscChannel<tongos::RpcEvent> channel(65536);
+	tongos::RpcLanePool lane_pool(g_options.lane_threads, [&router](tongos::RpcEvent rpc_event)
+	{
+		router.handle(std::move(rpc_event));
+	});
+	FakeGameThread game_thread(channel, router, g_options.hz);
+
+	// 与 UTSGrpcSubsystem::StartGrpcServer 中的分发逻辑一致
+	auto callback = [&](tongos::RpcEvent rpc_event)
+	{
+		size_t slot = 0;
+		switch (router.queryLane(rpc_event, slot))
+		{
+		case tongos::RpcLane::CQ_THREAD:
+			router.handle(std::move(rpc_event));
+			break;
+		case tongos::RpcLane::WORKER_POOL:
+			lane_pool.dispatch(slot, std::move(rpc_event));
+			break;
+		default:
+			channel.send(std::move(rpc_event));
+			break;
+		}
+	};
+
+	const bool all = g_options.mode == "all";
+	std::vector<Scenario> scenarios;
+	if (all || g_options.mode == "unary")
+	{
+		scenarios.push_back({"unary", kUnaryMethod, &runUnaryClient});
+	}
+	if (all || g_options.mode == "stream")
+	{
+		scenarios.push_back({"server_stream", kStreamMethod, &runStreamClient});
+	}
+	if (all || g_options.mode == "bidi")
+	{
+		scenarios.push_back({"bidi", kBidiMethod, &runBidiClient});
+	}
+	// 单次响应较大，不放进all
+	if (g_options.mode == "query_state")
+	{
+		scenarios.push_back({"query_state", kQueryStateMethod, &runQueryStateClient});
+	}
+
+	// calls_per_second[worker下标][场景下标]
+	std::vector<std::vector<double>> calls_per_second;
+	for (const int workers : g_options.workers)
+	{
+		tongos::RpcServerOptions server_options;
+		server_options.address = g_options.address;
+		server_options.max_send_message_size = -1;
+		server_options.max_receive_message_size = -1;
+		tongos::RpcServer server(server_options, router);
+		server.addWorkers(workers, callback, g_options.pending_calls);
+		if (!server.start())
+		{
+			std::fprintf(stderr, "failed to start server on %s\n", g_options.address.c_str());
+			return 1;
+		}
+
+		calls_per_second.emplace_back();
+		for (const Scenario& scenario : scenarios)
+		{
+			calls_per_second.back().push_back(runScenario(scenario.name, scenario.method, scenario.client_fn, router, workers));
+		}
+		server.shutdown();
+	}
+
+	if (g_options.workers.size() > 1)
+	{
+		std::printf("[workers sweep] calls/s, lane=%s clients=%d\n", g_options.lane.c_str(), g_options.clients);
+		std::printf("  %-8s", "workers");
+		for (const Scenario& scenario : scenarios)
+		{
+			std::printf("%15s", scenario.name);
+		}
+		std::printf("\n");
+		for (size_t i = 0; i < g_options.workers.size(); ++i)
+		{
+			std::printf("  %-8d", g_options.workers[i]);
+			for (const double value : calls_per_second[i])
+			{
+				std::printf("%15.1f", value);
+			}
+			std::printf("\n");
+		}
+	}
+
+	std::printf("[game_thread] frames=%llu events=%llu\n",
+	            static_cast<unsigned long long>(game_thread.frames()),
+	            static_cast<unsigned long long>(game_thread.events()));
+	printHistogram("frame_work", game_thread.frameTime());
+
+	// 关闭顺序与 UTSGrpcSubsystem::StopGrpcServer 一致
+	channel.close();
+	lane_pool.stop();
+	game_thread.stop();
+	tongos::closeLogFile();
+	return 0;
+}